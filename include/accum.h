@@ -0,0 +1,62 @@
+#ifndef ACCUM_H
+#define ACCUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sampler.h"
+
+// Running per-pixel radiance sums and sample counts. Samples are seeded by
+// (seed, pixel, sample index), so these two arrays are the whole render
+// state: continuing from count[p] and adding samples in index order yields
+// the same float sums, bit for bit, as an uninterrupted render.
+// A partial buffer (one process of a distributed render) starts at a later
+// sample index; it holds count[p] - first_sample samples of pixel p.
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t first_sample;  // Sums hold samples [first_sample, count[p])
+    float* sum[3];       // Planar R, G, B sums of width * height floats
+    uint32_t* count;     // Samples accumulated per pixel
+    void* data;          // Single allocation backing sum and count
+} Accumulator;
+
+// Render parameters a checkpoint must match to be resumed
+#define CHECKPOINT_SCENE_NAME_SIZE 64
+
+typedef struct {
+    uint32_t samples_per_pixel;  // Target spp (stratified patterns depend on it)
+    uint32_t max_depth;
+    SamplerType sampler;
+    uint64_t seed;
+    char scene[CHECKPOINT_SCENE_NAME_SIZE];
+} CheckpointInfo;
+
+Accumulator* accumulator_create(uint32_t width, uint32_t height);
+void accumulator_destroy(Accumulator* accum);
+
+// Clear the sums and start every pixel at sample index first_sample
+void accumulator_reset(Accumulator* accum, uint32_t first_sample);
+
+// Smallest per-pixel count (samples every pixel already has)
+uint32_t accumulator_min_count(const Accumulator* accum);
+
+// Smallest count over tiles [tile_begin, tile_end) of tile_size pixels in
+// row-major order (tile_end 0 = last tile; UINT32_MAX if the range is empty).
+// Pixels outside the range are never rendered, so a tile-split render is
+// done when this reaches its target.
+uint32_t accumulator_min_count_tiles(const Accumulator* accum, uint32_t tile_size,
+                                     uint32_t tile_begin, uint32_t tile_end);
+
+// Samples accumulated over all pixels
+uint64_t accumulator_total_samples(const Accumulator* accum);
+
+// Checkpoint/partial file ("PTCK"): header, per-pixel counts, then the planar sums.
+// Saving writes FILE.tmp and renames it over FILE, so a crash mid-write
+// keeps the previous checkpoint. Return false / NULL on I/O or format errors.
+bool checkpoint_save(const Accumulator* accum, const CheckpointInfo* info, const char* filename);
+Accumulator* checkpoint_load(const char* filename, CheckpointInfo* info);
+
+// True if `info` describes the same render as `expected` (prints the first mismatch)
+bool checkpoint_info_matches(const CheckpointInfo* info, const CheckpointInfo* expected);
+
+#endif // ACCUM_H
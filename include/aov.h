@@ -0,0 +1,52 @@
+#ifndef AOV_H
+#define AOV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "image.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+// Per-pixel cost AOV. render_parallel fills an RGB32F image whose three
+// channels hold per-sample means, so values do not depend on the spp:
+//   R = CPU cycles, G = BVH nodes visited, B = path length (rays traced)
+typedef enum {
+    COST_AOV_CYCLES,
+    COST_AOV_BVH_NODES,
+    COST_AOV_PATH_LENGTH,
+    COST_AOV_COUNT
+} CostAov;
+
+// Channel names for CLI/GUI ("cycles", "nodes", "path")
+const char* cost_aov_name(CostAov channel);
+bool cost_aov_from_name(const char* name, CostAov* channel);
+
+// 99th percentile of a channel: heatmaps saturate there so a few
+// preempted pixels do not wash out the rest (the maximum if the histogram
+// cannot be allocated)
+float cost_aov_scale(const Image* aov, CostAov channel);
+
+// False-colour (turbo ramp) rendering of channel / scale into `out`
+// (same size, RGB32F, display-ready values in [0, 1])
+void cost_aov_heatmap(const Image* aov, CostAov channel, float scale, Image* out);
+
+// .pfm/.exr keep all three raw channels; anything else writes an 8-bit
+// BMP heatmap of `channel`
+bool cost_aov_save(const Image* aov, CostAov channel, const char* filename);
+
+// Timestamp counter used for the cycles channel (rdtsc on x86, else ns)
+static inline uint64_t cost_cycle_counter(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#endif // AOV_H
@@ -5,13 +5,19 @@
 #include <stdint.h>
 #include <stdlib.h>
 
-// BVH node structure
+// Traversal keeps pending nodes on a fixed stack, which holds at most one
+// entry per level plus one, so builders stop splitting at BVH_MAX_DEPTH
+#define BVH_STACK_SIZE 64
+#define BVH_MAX_DEPTH (BVH_STACK_SIZE - 1)
+
+// BVH node structure. Children are node indices rather than pointers, so a
+// node array can be written to disk and mapped back as-is (scene_cache.h).
 typedef struct BVHNode {
     AABB bounds;
     union {
         struct {
-            struct BVHNode* left;
-            struct BVHNode* right;
+            uint32_t left;
+            uint32_t right;
         };
         struct {
             uint32_t first_prim_idx;
@@ -19,29 +25,93 @@ typedef struct BVHNode {
         };
     };
     bool is_leaf;
+    uint8_t split_axis;  // Internal nodes: left child is on the low side of this
+                         // axis, so traversal visits the child nearer the ray first
 } BVHNode;
 
-// BVH acceleration structure
+// BVH acceleration structure; nodes[0] is the root and children always
+// come after their parent in the node array
 typedef struct {
-    BVHNode* root;
-    Primitive* primitives;
+    Primitive* primitives;  // NULL for BVHs built from bare boxes
     uint32_t prim_count;
     BVHNode* nodes;
     uint32_t node_count;
     uint32_t* indices;  // Primitive indices for reordering
+    uint32_t* refs;     // Spatial-split trees: leaves cover ranges of refs, which hold
+                        // positions in the reordered items (one item may sit in
+                        // several leaves); NULL when leaves cover items directly
+    uint32_t ref_count;
+    const AABB* bounds; // Build input, one box per item (construction only)
+    AABB* end_bounds;   // Per-node bounds at shutter close when primitives move
+                        // (node bounds are then at shutter open); NULL if static
+    float build_cost;   // bvh_sah_cost when built (0 = unknown, e.g. cached)
+    bool borrowed;      // nodes/indices live in a scene cache mapping (not freed)
 } BVH;
 
-// BVH construction
+// BVH construction. bvh_create reorders `primitives` into leaf order. With
+// moving primitives the tree is split on the boxes they sweep over the
+// shutter, and every node keeps its box at shutter open and close; traversal
+// tests the box interpolated to the ray's time, which bounds the moved
+// primitives exactly where the swept box would be loose.
 BVH* bvh_create(Primitive* primitives, uint32_t count);
 void bvh_destroy(BVH* bvh);
 
+// Build over `count` boxes without touching the items they bound. Leaves
+// cover ranges of bvh->indices: item indices[i] belongs at position i, and
+// callers reorder their own arrays to match (see mesh_build_bvh).
+BVH* bvh_create_from_bounds(const AABB* bounds, uint32_t count);
+
+// Spatial-split build (SBVH). Besides the binned object splits, nodes whose
+// best object split leaves overlapping children also try splitting space at
+// bin planes: items straddling the plane are referenced from both children,
+// each reference clipped to its side, so long thin triangles stop
+// stretching boxes over their neighbours. References are capped at
+// `budget` * count (1.3 = up to 30% duplicates); past that, straddling
+// items go whole to the cheaper side. Primitives otherwise keep the
+// bvh_create contract: reordered into first-reference order, bvh->indices
+// the permutation. Scenes with moving primitives get a plain bvh_create.
+BVH* bvh_create_spatial(Primitive* primitives, uint32_t count, float budget);
+
+// Bounds of the parts of item `item` (already clipped to `box`) on either
+// side of the plane at `pos` on `axis`; a side the item misses is left empty
+typedef void (*BVHSplitFn)(const void* user, uint32_t item, AABB box, uint32_t axis, float pos,
+                           AABB* left, AABB* right);
+
+// Spatial-split build over bare boxes, clipping items with `split`. As with
+// bvh_create_from_bounds, callers reorder their items by bvh->indices; the
+// refs then index the reordered items.
+BVH* bvh_create_from_bounds_spatial(const AABB* bounds, uint32_t count, float budget,
+                                    BVHSplitFn split, const void* user);
+
+// BVHSplitFn for a triangle: the clipped polygon's bounds, padded like
+// triangle_bounds
+void triangle_split_bounds(Vec3 v0, Vec3 v1, Vec3 v2, AABB box, uint32_t axis, float pos,
+                           AABB* left, AABB* right);
+
+// Recompute every node's bounds (and end bounds) bottom-up from the
+// primitives' current bounds, keeping the topology (for bvh_create trees, after primitives
+// move). Much cheaper than a rebuild, but the tree degrades as primitives
+// drift away from the neighbours they were grouped with. Spatial-split
+// leaves get their primitives' whole boxes, losing the clipping.
+void bvh_refit(BVH* bvh);
+
+// Tree quality from the SAH cost of its splits: the primitive tests a ray
+// entering each internal node makes in its children, (A_l N_l + A_r N_r) / A,
+// summed over all internal nodes and divided by the N tests each would make
+// on its primitives directly. Unlike the root-relative SAH total, one huge
+// primitive (a ground sphere) does not hide the rest of the tree. Fresh
+// builds score well below 1; refit trees whose children spread over their
+// whole parent approach 1.
+float bvh_sah_cost(const BVH* bvh);
+
 // BVH traversal
 bool bvh_hit(const BVH* bvh, const Ray* ray, float t_min, float t_max,
              HitRecord* rec);
 
-// Build BVH recursively
-BVHNode* bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
-                            uint32_t start, uint32_t end, uint32_t* node_idx);
+// Build BVH recursively; returns the index of the subtree's root node, which
+// sits `depth` levels below the tree's root
+uint32_t bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
+                             uint32_t start, uint32_t end, uint32_t* node_idx, uint32_t depth);
 
 // SAH (Surface Area Heuristic) for optimal splits
 typedef struct {
@@ -4,7 +4,9 @@
 #include "vec3.h"
 #include "ray.h"
 #include "random.h"
+#include "sampler.h"
 #include <math.h>
+#include <stdbool.h>
 
 typedef struct {
     Vec3 origin;
@@ -50,18 +52,109 @@ static inline Camera camera_create(
     return cam;
 }
 
-static inline Ray camera_get_ray(const Camera* cam, float s, float t, RNG* rng) {
-    Vec3 rd = vec3_scale(rng_in_unit_disk(rng), cam->lens_radius);
-    Vec3 offset = vec3_add(vec3_scale(cam->u, rd.x), vec3_scale(cam->v, rd.y));
+// Placement as written in scene files and job requests
+typedef struct {
+    Vec3 lookfrom;
+    Vec3 lookat;
+    Vec3 vup;
+    float vfov;        // Degrees
+    float aperture;
+    float focus_dist;  // 0 = distance from lookfrom to lookat
+} CameraParams;
 
-    Vec3 ray_origin = vec3_add(cam->origin, offset);
+static inline CameraParams camera_params_default(void) {
+    CameraParams params;
+    params.lookfrom = vec3_create(13, 2, 3);
+    params.lookat = vec3_create(0, 0, 0);
+    params.vup = vec3_create(0, 1, 0);
+    params.vfov = 20.0f;
+    params.aperture = 0.1f;
+    params.focus_dist = 10.0f;
+    return params;
+}
+
+static inline Camera camera_from_params(const CameraParams* params, float aspect) {
+    float focus = params->focus_dist > 0.0f ? params->focus_dist :
+                  vec3_length(vec3_sub(params->lookfrom, params->lookat));
+    return camera_create(params->lookfrom, params->lookat, params->vup, params->vfov, aspect,
+                         params->aperture, focus);
+}
+
+// Pinhole cameras (zero aperture) never need a lens sample
+static inline bool camera_is_pinhole(const Camera* cam) {
+    return cam->lens_radius <= 0.0f;
+}
+
+static inline Ray camera_get_ray(const Camera* cam, float s, float t, Sampler* sampler) {
     Vec3 ray_target = vec3_add(
         vec3_add(cam->lower_left_corner, vec3_scale(cam->horizontal, s)),
         vec3_scale(cam->vertical, t)
     );
+    if (camera_is_pinhole(cam)) {
+        return ray_create(cam->origin, vec3_sub(ray_target, cam->origin));
+    }
+
+    float lens_u, lens_v;
+    sampler_2d(sampler, SAMPLER_DIM_LENS, &lens_u, &lens_v);
+    Vec3 rd = vec3_scale(sample_concentric_disk(lens_u, lens_v), cam->lens_radius);
+    Vec3 offset = vec3_add(vec3_scale(cam->u, rd.x), vec3_scale(cam->v, rd.y));
+
+    Vec3 ray_origin = vec3_add(cam->origin, offset);
     Vec3 ray_direction = vec3_sub(ray_target, ray_origin);
 
     return ray_create(ray_origin, ray_direction);
 }
 
-#endif // CAMERA_H
\ No newline at end of file
+// Camera mapped onto the pixel grid of one image. Directions are relative to
+// the camera origin, so a row costs one multiply-add, a pixel another, and a
+// jittered pinhole sample two more with no lens work at all.
+typedef struct {
+    Vec3 origin;
+    Vec3 top_left;    // Film position of pixel (0, 0) minus origin
+    Vec3 pixel_dx;    // Film step per pixel to the right
+    Vec3 pixel_dy;    // Film step per pixel downwards
+    Vec3 lens_u;      // Lens basis scaled by the lens radius
+    Vec3 lens_v;
+    bool pinhole;
+} CameraRaster;
+
+// Matches camera_get_ray(s = x / (width - 1), t = 1 - y / (height - 1))
+static inline CameraRaster camera_raster_create(const Camera* cam, uint32_t width, uint32_t height) {
+    CameraRaster raster;
+    raster.origin = cam->origin;
+    raster.pixel_dx = vec3_scale(cam->horizontal, 1.0f / (float)(width - 1));
+    raster.pixel_dy = vec3_scale(cam->vertical, -1.0f / (float)(height - 1));
+    raster.top_left = vec3_sub(vec3_add(cam->lower_left_corner, cam->vertical), cam->origin);
+    raster.lens_u = vec3_scale(cam->u, cam->lens_radius);
+    raster.lens_v = vec3_scale(cam->v, cam->lens_radius);
+    raster.pinhole = camera_is_pinhole(cam);
+    return raster;
+}
+
+// Direction to the top-left corner of pixel row y
+static inline Vec3 camera_raster_row(const CameraRaster* raster, uint32_t y) {
+    return vec3_add(raster->top_left, vec3_scale(raster->pixel_dy, (float)y));
+}
+
+// Direction to the top-left corner of pixel x in a row from camera_raster_row
+static inline Vec3 camera_raster_pixel(const CameraRaster* raster, Vec3 row, uint32_t x) {
+    return vec3_add(row, vec3_scale(raster->pixel_dx, (float)x));
+}
+
+// Primary ray through (pixel + jitter); draws the lens sample only for thin lenses
+static inline Ray camera_raster_ray(const CameraRaster* raster, Vec3 pixel,
+                                    float jitter_x, float jitter_y, Sampler* sampler) {
+    Vec3 direction = vec3_add(pixel, vec3_add(vec3_scale(raster->pixel_dx, jitter_x),
+                                              vec3_scale(raster->pixel_dy, jitter_y)));
+    if (raster->pinhole) {
+        return ray_create(raster->origin, direction);
+    }
+
+    float lens_x, lens_y;
+    sampler_2d(sampler, SAMPLER_DIM_LENS, &lens_x, &lens_y);
+    Vec3 disk = sample_concentric_disk(lens_x, lens_y);
+    Vec3 offset = vec3_add(vec3_scale(raster->lens_u, disk.x), vec3_scale(raster->lens_v, disk.y));
+    return ray_create(vec3_add(raster->origin, offset), vec3_sub(direction, offset));
+}
+
+#endif // CAMERA_H
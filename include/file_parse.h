@@ -0,0 +1,138 @@
+#ifndef FILE_PARSE_H
+#define FILE_PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Helpers shared by the text and binary file loaders (mesh_io.h,
+// scene_file.h): read-only file mapping and allocation-free ASCII parsing
+// over [p, end) ranges that need not be NUL-terminated.
+
+typedef struct {
+    const char* data;
+    size_t size;
+} MappedFile;
+
+// Map a whole file read-only for sequential parsing; prints the problem and
+// returns false for missing, empty or unmappable files
+bool map_file(const char* path, MappedFile* file);
+void unmap_file(MappedFile* file);
+
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool is_digit(char c) {
+    return (unsigned)(c - '0') < 10u;
+}
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// End of a token or record: whitespace, line end or a trailing comment
+static inline bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '#';
+}
+
+static inline const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) p++;
+    return p;
+}
+
+static inline const char* next_line(const char* p, const char* end) {
+    const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+    return newline ? newline + 1 : end;
+}
+
+// Decimal float with optional sign, fraction and exponent (no inf/nan).
+// Up to 19 significant digits are exact in the integer mantissa and powers of
+// ten up to 1e22 are exact doubles, so the usual %g / %f output of exporters
+// converts with a single double rounding. Advances *p on success.
+static inline bool parse_float(const char** p, const char* end, float* out) {
+    const char* s = *p;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    for (; s < end && is_digit(*s); s++, digits++) {
+        if (mantissa < 1000000000000000000ull) {
+            mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+        } else {
+            exponent++;
+        }
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && is_digit(*s); s++, digits++) {
+            if (mantissa < 1000000000000000000ull) {
+                mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0) return false;
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char* e = s + 1;
+        bool exp_negative = false;
+        if (e < end && (*e == '-' || *e == '+')) {
+            exp_negative = *e == '-';
+            e++;
+        }
+        if (e < end && is_digit(*e)) {
+            int value = 0;
+            for (; e < end && is_digit(*e); e++) {
+                if (value < 10000) value = value * 10 + (*e - '0');
+            }
+            exponent += exp_negative ? -value : value;
+            s = e;
+        }
+    }
+
+    double value = (double)mantissa;
+    if (exponent < 0) {
+        value = exponent >= -22 ? value / POW10[-exponent] : value * pow(10.0, exponent);
+    } else if (exponent > 0) {
+        value = exponent <= 22 ? value * POW10[exponent] : value * pow(10.0, exponent);
+    }
+    *out = (float)(negative ? -value : value);
+    *p = s;
+    return true;
+}
+
+static inline bool parse_int(const char** p, const char* end, int64_t* out) {
+    const char* s = *p;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+    if (s >= end || !is_digit(*s)) return false;
+    int64_t value = 0;
+    for (; s < end && is_digit(*s); s++) {
+        if (value < ((int64_t)1 << 40)) value = value * 10 + (*s - '0');
+    }
+    *out = negative ? -value : value;
+    *p = s;
+    return true;
+}
+
+// Parse `count` blank-separated floats
+static inline bool parse_floats(const char* p, const char* end, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        p = skip_blanks(p, end);
+        if (!parse_float(&p, end, &out[i]) || (p < end && !is_separator(*p))) return false;
+    }
+    return true;
+}
+
+#endif // FILE_PARSE_H
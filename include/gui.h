@@ -18,6 +18,11 @@ typedef struct {
     GtkWidget* samples_spin;
     GtkWidget* depth_spin;
     GtkWidget* threads_spin;
+    GtkWidget* sampler_combo;
+    GtkWidget* tonemap_combo;
+    GtkWidget* exposure_spin;
+    GtkWidget* srgb_check;
+    GtkWidget* view_combo;
     GtkWidget* scene_combo;
     GtkWidget* render_button;
     GtkWidget* save_button;
@@ -26,23 +31,31 @@ typedef struct {
 
     // Image display
     GtkWidget* image_scroll;
-    GtkWidget* image_widget;
+    GtkWidget* display_area;
 
     // Rendering state
     Scene* scene;
     Camera* camera;
     Image* render_image;
-    GdkPixbuf* display_pixbuf;
+    Image* cost_aov;                    // Per-pixel cost of the last render (aov.h)
+    RenderStats* stats;                 // Live counters of the current/last render
+    TileDirtyMap* dirty_tiles;          // Tiles finished since the last display refresh
+    cairo_surface_t* display_surface;   // Persistent 8-bit copy of render_image (RGB24)
+    Accumulator* accum;                 // Sample sums; a cancelled render resumes from them
+    CheckpointInfo accum_info;          // Settings the sums were rendered with
 
     // Threading
     pthread_t render_thread;
     pthread_mutex_t render_mutex;
     volatile bool is_rendering;
-    volatile bool cancel_render;
-    volatile float render_progress;
+    atomic_bool cancel_render;
 
     // Settings
     RenderSettings settings;
+    TonemapSettings tonemap;  // Display/save tonemapping (applied without re-rendering)
+    int view;                 // 0 = beauty, otherwise 1 + CostAov heatmap
+    bool display_stale;       // Tonemap or view changed mid-render: redraw the
+                              // whole frame once the render ends
     char* current_scene_name;
 } GuiApp;
 
@@ -55,15 +68,16 @@ void gui_app_run(GuiApp* app);
 void on_render_clicked(GtkButton* button, gpointer user_data);
 void on_save_clicked(GtkButton* button, gpointer user_data);
 void on_scene_changed(GtkComboBox* combo, gpointer user_data);
+void on_tonemap_changed(GtkWidget* widget, gpointer user_data);
 void on_window_destroy(GtkWidget* widget, gpointer user_data);
 
 // Rendering thread
 void* render_thread_func(void* user_data);
 gboolean update_progress(gpointer user_data);
-void render_progress_callback(float progress);
 
 // Image display
-void update_image_display(GuiApp* app);
-GdkPixbuf* image_to_pixbuf(const Image* img);
+void update_image_display(GuiApp* app);      // Re-tonemap the whole image
+guint update_dirty_tiles(GuiApp* app);       // Re-tonemap finished tiles only
+gboolean on_display_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data);
 
 #endif // GUI_H
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "vec3.h"
+
+// Framebuffer storage formats
+typedef enum {
+    IMAGE_FORMAT_RGB32F,   // Planar float32: separate R, G and B planes (12 bytes/pixel)
+    IMAGE_FORMAT_RGBA16F,  // Interleaved half-float RGBA, alpha = 1 (8 bytes/pixel)
+    IMAGE_FORMAT_COUNT
+} ImageFormat;
+
+// Framebuffer of linear HDR radiance; access pixels via image_get/set_pixel
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    ImageFormat format;
+    void* data;          // Single allocation backing the pixels
+    float* planes[3];    // RGB32F: R, G, B planes of width * height floats
+    uint16_t* half;      // RGBA16F: width * height * 4 halves
+} Image;
+
+// Image functions
+Image* image_create(uint32_t width, uint32_t height);  // RGB32F
+Image* image_create_format(uint32_t width, uint32_t height, ImageFormat format);
+void image_destroy(Image* img);
+
+// Format names for CLI options ("rgb32f", "rgba16f")
+const char* image_format_name(ImageFormat format);
+bool image_format_from_name(const char* name, ImageFormat* format);
+size_t image_bytes_per_pixel(ImageFormat format);
+
+// Row y as interleaved float RGB (3 * width floats)
+void image_read_row(const Image* img, uint32_t y, float* rgb);
+
+// Writers stream a few scanlines at a time, so no full-frame copy is made.
+// BMP is tonemapped 8-bit (NULL settings = tonemap_default()); PFM (float32)
+// and EXR (uncompressed half) keep linear radiance for compositing and ignore
+// the tonemap. All return false on I/O errors.
+struct TonemapSettings;
+bool image_save_bmp(const Image* img, const char* filename, const struct TonemapSettings* tonemap);
+bool image_save_pfm(const Image* img, const char* filename);
+bool image_save_exr(const Image* img, const char* filename);
+
+// Pick the writer from the file extension (.bmp, .pfm, .exr; default BMP)
+bool image_save(const Image* img, const char* filename, const struct TonemapSettings* tonemap);
+
+// True if image_save would keep linear float data (.pfm, .exr)
+bool image_filename_is_hdr(const char* filename);
+
+// IEEE half-float conversion (round to nearest even), F16C when available
+static inline uint16_t half_from_float(float f) {
+#ifdef __F16C__
+    return (uint16_t)_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+    union { float f; uint32_t u; } v = {f};
+    union { float f; uint32_t u; } denorm_magic = {.u = ((127 - 15) + (23 - 10) + 1) << 23};
+    uint32_t sign = v.u & 0x80000000u;
+    uint16_t o;
+
+    v.u ^= sign;
+    if (v.u >= 0x47800000u) {
+        // Overflow to infinity, NaN stays NaN
+        o = (v.u > 0x7F800000u) ? 0x7E00 : 0x7C00;
+    } else if (v.u < 0x38800000u) {
+        // Subnormal or zero: let the FPU round the shifted mantissa
+        v.f += denorm_magic.f;
+        o = (uint16_t)(v.u - denorm_magic.u);
+    } else {
+        uint32_t mant_odd = (v.u >> 13) & 1;
+        v.u += ((uint32_t)(15 - 127) << 23) + 0xFFF;
+        v.u += mant_odd;
+        o = (uint16_t)(v.u >> 13);
+    }
+    return o | (uint16_t)(sign >> 16);
+#endif
+}
+
+static inline float half_to_float(uint16_t h) {
+#ifdef __F16C__
+    return _cvtsh_ss(h);
+#else
+    union { uint32_t u; float f; } magic = {.u = 113u << 23};
+    union { uint32_t u; float f; } o = {.u = (uint32_t)(h & 0x7FFFu) << 13};
+    const uint32_t shifted_exp = 0x7C00u << 13;
+    uint32_t exp = shifted_exp & o.u;
+
+    o.u += (127 - 15) << 23;
+    if (exp == shifted_exp) {
+        o.u += (128 - 16) << 23;  // Inf/NaN
+    } else if (exp == 0) {
+        o.u += 1 << 23;           // Zero/subnormal
+        o.f -= magic.f;
+    }
+    o.u |= (uint32_t)(h & 0x8000u) << 16;
+    return o.f;
+#endif
+}
+
+static inline Vec3 image_get_pixel(const Image* img, uint32_t x, uint32_t y) {
+    size_t idx = (size_t)y * img->width + x;
+    if (img->format == IMAGE_FORMAT_RGBA16F) {
+        const uint16_t* p = img->half + idx * 4;
+        return vec3_create(half_to_float(p[0]), half_to_float(p[1]), half_to_float(p[2]));
+    }
+    return vec3_create(img->planes[0][idx], img->planes[1][idx], img->planes[2][idx]);
+}
+
+static inline void image_set_pixel(Image* img, uint32_t x, uint32_t y, Vec3 color) {
+    size_t idx = (size_t)y * img->width + x;
+    if (img->format == IMAGE_FORMAT_RGBA16F) {
+        uint16_t* p = img->half + idx * 4;
+        p[0] = half_from_float(color.x);
+        p[1] = half_from_float(color.y);
+        p[2] = half_from_float(color.z);
+        p[3] = 0x3C00;  // 1.0
+        return;
+    }
+    img->planes[0][idx] = color.x;
+    img->planes[1][idx] = color.y;
+    img->planes[2][idx] = color.z;
+}
+
+#endif // IMAGE_H
@@ -0,0 +1,27 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <stdbool.h>
+#include "primitive.h"
+#include "transform.h"
+
+// Object instancing. A group is a scene of its own (spheres, triangles,
+// meshes, even further instances) whose BVH is built once; each instance
+// places it with an affine transform and costs one primitive in the parent
+// scene's BVH plus this struct, however large the group is. The parent BVH
+// over instance bounds is the top level, each group's BVH the bottom level:
+// rays are carried into object space at the instance and traced through the
+// shared group BVH there.
+typedef struct Scene Scene;
+
+struct Instance {
+    const Scene* group;     // Owned by the parent scene (scene_add_group)
+    Transform to_object;    // Inverse of the placement transform
+    bool override_material; // Use the instance primitive's material for the whole group
+};
+
+// Closest hit in world space; the material is the group primitive's unless
+// the instance overrides it (set by primitive_hit)
+bool instance_hit(const Instance* instance, const Ray* ray, float t_min, float t_max, HitRecord* rec);
+
+#endif // INSTANCE_H
@@ -0,0 +1,73 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "camera.h"
+#include "sampler.h"
+
+// Render jobs exchanged by pathtracer_server and pathtracer_client over a
+// Unix domain stream socket, one request per connection. Text lines, except
+// for the final image:
+//
+//   client -> server   "RENDER\n", "key value\n" lines (job_request_set keys),
+//                      then an empty line. Or "STATUS\n" / "SHUTDOWN\n".
+//   server -> client   "QUEUED n\n"                      n jobs ahead of this one
+//                      "STARTED hit|miss build_ms\n"     scene cache result
+//                      "PROGRESS fraction elapsed mrays\n" every 250 ms
+//                      "DONE width height elapsed rays\n" followed by
+//                      width * height * 3 floats (RGB, rows top to bottom,
+//                      little-endian, linear radiance)
+//                      "ERROR message\n"
+#define JOB_DEFAULT_SOCKET "/tmp/pathtracer.sock"
+#define JOB_SCENE_NAME_SIZE 64
+#define JOB_LINE_SIZE 256
+
+// Camera fields a request overrides (JobRequest.camera_fields bits)
+enum {
+    JOB_CAMERA_LOOKFROM = 1u << 0,
+    JOB_CAMERA_LOOKAT = 1u << 1,
+    JOB_CAMERA_VUP = 1u << 2,
+    JOB_CAMERA_VFOV = 1u << 3,
+    JOB_CAMERA_APERTURE = 1u << 4,
+    JOB_CAMERA_FOCUS = 1u << 5
+};
+
+typedef struct {
+    char scene[JOB_SCENE_NAME_SIZE];
+    uint32_t width;
+    uint32_t height;
+    uint32_t samples_per_pixel;
+    uint32_t max_depth;
+    uint64_t seed;
+    SamplerType sampler;
+
+    // Camera overrides: only the fields in camera_fields are meaningful,
+    // the rest come from the scene's default camera
+    uint32_t camera_fields;
+    CameraParams camera;
+} JobRequest;
+
+// Same defaults as pathtracer_cli (Cornell Box, 800x600, 100 spp, ...)
+void job_request_init(JobRequest* job);
+
+// Set one field from its protocol key (scene, width, height, spp, depth,
+// seed, sampler, lookfrom, lookat, vup, vfov, aperture, focus); vectors are
+// "x,y,z". Returns false and prints the problem for bad keys or values.
+bool job_request_set(JobRequest* job, const char* key, const char* value);
+
+// `scene_camera` with the request's camera overrides applied
+CameraParams job_request_camera(const JobRequest* job, const CameraParams* scene_camera);
+
+// Full "RENDER" request text; returns false if it does not fit
+bool job_request_format(const JobRequest* job, char* buffer, size_t size);
+
+// Blocking socket I/O. job_read_line strips the newline and fails on EOF or
+// lines longer than size - 1; job_send never raises SIGPIPE.
+bool job_send(int fd, const void* data, size_t size);
+bool job_send_line(int fd, const char* line);
+bool job_recv(int fd, void* data, size_t size);
+bool job_read_line(int fd, char* line, size_t size);
+
+#endif // JOB_H
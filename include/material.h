@@ -4,13 +4,15 @@
 #include "vec3.h"
 #include "ray.h"
 #include "random.h"
+#include "sampler.h"
 
 typedef enum {
     MATERIAL_LAMBERTIAN,
     MATERIAL_METAL,
     MATERIAL_DIELECTRIC,
     MATERIAL_EMISSIVE,
-    MATERIAL_BLEND
+    MATERIAL_BLEND,
+    MATERIAL_TYPE_COUNT
 } MaterialType;
 
 // Blend mode for blended materials
@@ -147,9 +149,15 @@ static inline float schlick(float cosine, float ref_idx) {
     return r0 + (1.0f - r0) * powf(1.0f - cosine, 5.0f);
 }
 
+// Names used by scene files (scene_file.h)
+const char* material_type_name(MaterialType type);
+bool material_type_from_name(const char* name, MaterialType* type);
+const char* blend_mode_name(BlendMode mode);
+bool blend_mode_from_name(const char* name, BlendMode* mode);
+
 // Material scattering
 bool material_scatter(const Material* mat, const Ray* ray_in,
                      const HitRecord* rec, Vec3* attenuation,
-                     Ray* scattered, RNG* rng);
+                     Ray* scattered, Sampler* sampler);
 
 #endif // MATERIAL_H
\ No newline at end of file
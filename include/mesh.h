@@ -0,0 +1,57 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "primitive.h"
+#include "bvh.h"
+
+// Indexed triangle mesh. Vertices are shared between triangles and the
+// material lives once on the scene primitive, so a triangle costs its three
+// 32-bit indices plus its share of the vertices and of the mesh's own BVH
+// (a full Primitive per triangle is 256 bytes before the BVH).
+struct Mesh {
+    Vec3* positions;
+    Vec3* normals;      // Optional per-vertex shading normals (NULL = flat)
+    float* uvs;         // Optional per-vertex (u, v) pairs (NULL = barycentrics)
+    uint32_t* indices;  // Three per triangle; mesh_build_bvh reorders triangles
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+    BVH* bvh;           // Over triangles; leaf ranges index triangles directly, or
+                        // through bvh->refs when built with spatial splits
+    AABB bounds;
+    bool borrowed;      // Buffers live in a scene cache mapping (not freed)
+};
+
+// Uninitialized buffers for the given counts; NULL if allocation fails
+Mesh* mesh_create(uint32_t vertex_count, uint32_t triangle_count, bool with_normals, bool with_uvs);
+// UV sphere with 2 * stacks * slices triangles, shared vertices, normals and UVs
+Mesh* mesh_create_sphere(uint32_t stacks, uint32_t slices, float radius);
+void mesh_destroy(Mesh* mesh);
+
+// Recompute bounds (the union of the padded triangle boxes the BVH uses)
+void mesh_update_bounds(Mesh* mesh);
+
+// (Re)build the triangle BVH and bounds after filling or editing the buffers.
+// A `split_budget` above 1 builds with spatial splits (bvh_create_spatial).
+// On allocation failure mesh->bvh is left NULL and the mesh is never hit.
+void mesh_build_bvh(Mesh* mesh, float split_budget);
+
+// Closest hit; fills t, point, normals and u/v (material is set by the caller)
+bool mesh_hit(const Mesh* mesh, const Ray* ray, float t_min, float t_max, HitRecord* rec);
+
+// Bytes held by the buffers and the BVH
+size_t mesh_memory_bytes(const Mesh* mesh);
+
+static inline Primitive primitive_mesh(const Mesh* mesh, Material mat) {
+    Primitive p;
+    p.type = PRIMITIVE_MESH;
+    p.moving = false;
+    p.mesh = mesh;
+    p.material = mat;
+    p.bounds = mesh->bounds;
+    p.motion = vec3_create(0, 0, 0);
+    return p;
+}
+
+#endif // MESH_H
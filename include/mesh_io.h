@@ -0,0 +1,22 @@
+#ifndef MESH_IO_H
+#define MESH_IO_H
+
+#include "mesh.h"
+
+// Mesh file loaders. Files are memory-mapped and parsed in parallel chunks
+// straight into the mesh buffers: a counting pass sizes every buffer and
+// gives each chunk its output offsets, so nothing grows while parsing.
+// The returned mesh has no BVH yet (scene_add_mesh builds it).
+//
+// OBJ: v, vt, vn and f records; polygons are fan-triangulated and negative
+// (relative) indices are supported. Normals and UVs are kept only when every
+// face indexes them with its position indices; otherwise the mesh is flat.
+// PLY: binary little- or big-endian; vertex x/y/z with optional nx/ny/nz and
+// u/v (or s/t), and a face vertex_indices list of any integer type.
+
+// Picks the format from the extension (.obj or .ply); NULL on error
+Mesh* mesh_load(const char* path);
+Mesh* mesh_load_obj(const char* path);
+Mesh* mesh_load_ply(const char* path);
+
+#endif // MESH_IO_H
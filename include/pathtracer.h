@@ -7,17 +7,50 @@
 #include "material.h"
 #include "camera.h"
 #include "bvh.h"
+#include "mesh.h"
+#include "instance.h"
 #include "random.h"
+#include "sampler.h"
+#include "image.h"
+#include "tonemap.h"
+#include "stats.h"
+#include "aov.h"
+#include "accum.h"
 #include <stdint.h>
+#include <stdatomic.h>
 
 // Scene structure
-typedef struct {
+struct Scene {
     Primitive* primitives;
     uint32_t prim_count;
     uint32_t prim_capacity;
+    Mesh** meshes;  // Owned meshes, referenced by PRIMITIVE_MESH primitives
+    uint32_t mesh_count;
+    Scene** groups;          // Owned instance groups (built), see scene_add_group
+    uint32_t group_count;
+    Instance* instances;     // Referenced by PRIMITIVE_INSTANCE primitives
+    uint32_t instance_count;
+    uint32_t instance_capacity;
     BVH* bvh;
     Vec3 ambient_light;
-} Scene;
+    bool has_motion;      // Something moves: camera rays sample a shutter time
+    float spatial_split_budget;  // Reference budget for spatial-split BVHs built by
+                                 // scene_build_bvh (bvh_create_spatial; 0 = off)
+    void* mapping;        // Scene cache file the arrays above live in (scene_cache.h)
+    size_t mapping_size;
+};
+
+// Side length of the square pixel tiles handed to render threads
+#define RENDER_TILE_SIZE 16
+
+// Per-tile "updated since last look" flags for live preview. The renderer
+// sets a tile's flag (release) after writing its pixels; a display thread
+// claims it with tile_dirty_map_take (acquire) before reading them.
+typedef struct {
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    atomic_uchar* flags;
+} TileDirtyMap;
 
 // Render settings
 typedef struct {
@@ -28,39 +61,86 @@ typedef struct {
     bool use_bvh;
     bool use_nee;  // Next event estimation
     uint32_t num_threads;
-    volatile bool* cancel_flag;  // Pointer to cancel flag for early termination
+    uint64_t seed;  // Base seed; per-sample RNG state is derived from (seed, pixel, sample)
+    SamplerType sampler;  // Sample pattern (random, stratified, Sobol, blue noise)
+    atomic_bool* cancel_flag;    // Optional: set to stop early, see render_parallel
+    TileDirtyMap* dirty_tiles;   // Optional: flag tiles as they complete (NULL = off)
+    RenderStats* stats;          // Optional: live progress/ray counters (NULL = off)
+    Image* cost_aov;             // Optional: per-pixel cost, see aov.h (NULL = off)
+    Accumulator* accum;          // Optional: continue pixels from running sums (accum.h)
+    uint32_t sample_end;         // With accum: stop pixels at this count (0 = samples_per_pixel)
+    uint32_t tile_begin;         // Render only tiles [tile_begin, tile_end) in row-major
+    uint32_t tile_end;           // RENDER_TILE_SIZE order (tile_end 0 = last tile)
 } RenderSettings;
 
-// Image buffer
-typedef struct {
-    Vec3* pixels;
-    uint32_t width;
-    uint32_t height;
-} Image;
-
 // Scene functions
 Scene* scene_create(void);
 void scene_destroy(Scene* scene);
+// Make room for prim_count primitives in total, so loaders with known counts
+// fill the array without regrowing it
+bool scene_reserve(Scene* scene, uint32_t prim_count);
 void scene_add_sphere(Scene* scene, Vec3 center, float radius, Material mat);
 void scene_add_triangle(Scene* scene, Vec3 v0, Vec3 v1, Vec3 v2, Material mat);
+// Takes ownership of `mesh`; its BVH is built by scene_build_bvh if missing
+void scene_add_mesh(Scene* scene, Mesh* mesh, Material mat);
+// Build missing mesh BVHs, then the scene BVH (reorders the primitives),
+// with spatial splits when spatial_split_budget is set
 void scene_build_bvh(Scene* scene);
 
-// Image functions
-Image* image_create(uint32_t width, uint32_t height);
-void image_destroy(Image* img);
-void image_save_bmp(const Image* img, const char* filename);
+// Default spatial_split_budget for SBVH builds: up to 30% duplicate references
+#define SCENE_SPATIAL_SPLIT_BUDGET 1.3f
+
+// Make primitive `prim` (creation order, before scene_build_bvh) move by
+// `motion` over the shutter, for motion blur in a single render
+void scene_set_motion(Scene* scene, uint32_t prim, Vec3 motion);
+
+// Growth of bvh_sah_cost over the freshly built tree past which
+// scene_refit_bvh rebuilds instead (see `pathtracer_bench refit`)
+#define SCENE_REBUILD_THRESHOLD 1.1f
+
+// Update the scene BVH after primitives were moved in place (their bounds
+// updated, e.g. prim->bounds = sphere_bounds(&prim->sphere)). The tree is
+// refit; if its SAH cost has grown past `threshold` times the cost at the
+// last build, it is rebuilt with scene_build_bvh instead, which reorders
+// the primitives again. Returns true if it rebuilt.
+bool scene_refit_bvh(Scene* scene, float threshold);
+
+// Takes ownership of `group`, a scene whose primitives (ambient light aside)
+// become shareable geometry, and builds its BVH. Returns the group for
+// scene_add_instance.
+const Scene* scene_add_group(Scene* scene, Scene* group);
+// Place a copy of `group` with the object-to-world transform `to_world`;
+// `material` replaces every material in the group (NULL keeps them). False
+// if the transform is singular or allocation fails.
+bool scene_add_instance(Scene* scene, const Scene* group, const Transform* to_world,
+                        const Material* material);
+
+// Tile dirty map for an image of the given size (RENDER_TILE_SIZE tiles); NULL
+// if out of memory
+TileDirtyMap* tile_dirty_map_create(uint32_t width, uint32_t height);
+void tile_dirty_map_destroy(TileDirtyMap* map);
+
+// Clear tile's flag; true if it was set (the tile's pixels are then visible)
+// Clean tiles cost a plain load, so scanning the whole map each tick is cheap.
+static inline bool tile_dirty_map_take(TileDirtyMap* map, uint32_t tile) {
+    if (!atomic_load_explicit(&map->flags[tile], memory_order_relaxed)) return false;
+    return atomic_exchange_explicit(&map->flags[tile], 0, memory_order_acquire) != 0;
+}
 
 // Path tracing functions
-Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
+Vec3 trace_ray(const Scene* scene, const Ray* ray, Sampler* sampler,
                uint32_t depth, uint32_t max_depth);
+
+// Render all tiles (or the settings' tile range). Threads pull tiles from a shared counter. Cancellation
+// is checked before every sample, so once *cancel_flag is set each thread
+// stops within one path (at most max_depth bounces) and render_parallel
+// returns; pixels whose samples did not all finish are left untouched.
 void render_parallel(const Scene* scene, const Camera* camera,
                     const RenderSettings* settings, Image* output);
 
-// Utility functions
-Vec3 aces_tonemap(Vec3 color);
-
-// Progress callback
-typedef void (*progress_callback_t)(float progress);
-void set_progress_callback(progress_callback_t callback);
+static inline bool render_cancelled(const RenderSettings* settings) {
+    return settings->cancel_flag &&
+           atomic_load_explicit(settings->cancel_flag, memory_order_relaxed);
+}
 
 #endif // PATHTRACER_H
\ No newline at end of file
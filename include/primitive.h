@@ -12,6 +12,7 @@ typedef struct HitRecord {
     Vec3 point;
     Vec3 normal;
     float t;
+    float u, v;  // Surface coordinates: mesh UVs, else triangle barycentrics (0 on spheres)
     bool front_face;
     const Material* material;
 } HitRecord;
@@ -26,7 +27,9 @@ typedef struct {
 typedef enum {
     PRIMITIVE_SPHERE,
     PRIMITIVE_TRIANGLE,
-    PRIMITIVE_MESH
+    PRIMITIVE_MESH,
+    PRIMITIVE_INSTANCE,
+    PRIMITIVE_TYPE_COUNT
 } PrimitiveType;
 
 // Sphere primitive
@@ -41,15 +44,27 @@ typedef struct {
     Vec3 normal;  // Pre-computed normal
 } Triangle;
 
-// Generic primitive
+// Indexed triangle mesh with shared vertex buffers (mesh.h)
+typedef struct Mesh Mesh;
+
+// Transformed reference to a group of shared primitives (instance.h)
+typedef struct Instance Instance;
+
+// Generic primitive. Moving primitives travel in a straight line during
+// the shutter: their geometry and bounds are the shutter-open (time 0)
+// position, and at time t they are displaced by t * motion.
 typedef struct {
     PrimitiveType type;
+    bool moving;  // motion is non-zero
     union {
         Sphere sphere;
         Triangle triangle;
+        const Mesh* mesh;          // Owned by the scene
+        const Instance* instance;  // Owned by the scene
     };
     Material material;
     AABB bounds;
+    Vec3 motion;  // Displacement from shutter open to close
 } Primitive;
 
 // AABB functions
@@ -90,6 +105,16 @@ static inline AABB aabb_expand(AABB box, Vec3 point) {
     };
 }
 
+static inline AABB aabb_translate(AABB box, Vec3 offset) {
+    return (AABB){vec3_add(box.min, offset), vec3_add(box.max, offset)};
+}
+
+// Box at time t between shutter-open `a` and shutter-close `b`
+static inline AABB aabb_lerp(AABB a, AABB b, float t) {
+    return (AABB){vec3_add(a.min, vec3_scale(vec3_sub(b.min, a.min), t)),
+                  vec3_add(a.max, vec3_scale(vec3_sub(b.max, a.max), t))};
+}
+
 static inline Vec3 aabb_center(AABB box) {
     return vec3_scale(vec3_add(box.min, box.max), 0.5f);
 }
@@ -162,6 +187,43 @@ static inline AABB triangle_bounds(const Triangle* t) {
     return box;
 }
 
+// Möller-Trumbore test against three vertices; on a hit returns the
+// distance and the barycentrics of v1 (u) and v2 (v)
+static inline bool triangle_intersect(Vec3 v0, Vec3 v1, Vec3 v2, const Ray* ray,
+                                      float t_min, float t_max, float* t, float* u, float* v) {
+    const float EPSILON = 0.0000001f;
+
+    Vec3 edge1 = vec3_sub(v1, v0);
+    Vec3 edge2 = vec3_sub(v2, v0);
+    Vec3 h = vec3_cross(ray->direction, edge2);
+    float a = vec3_dot(edge1, h);
+    if (fabsf(a) < EPSILON) {
+        return false;  // Ray parallel to the triangle's plane
+    }
+
+    float f = 1.0f / a;
+    Vec3 s = vec3_sub(ray->origin, v0);
+    float bu = f * vec3_dot(s, h);
+    if (bu < 0.0f || bu > 1.0f) {
+        return false;
+    }
+
+    Vec3 q = vec3_cross(s, edge1);
+    float bv = f * vec3_dot(ray->direction, q);
+    if (bv < 0.0f || bu + bv > 1.0f) {
+        return false;
+    }
+
+    float dist = f * vec3_dot(edge2, q);
+    if (dist < t_min || dist > t_max) {
+        return false;
+    }
+    *t = dist;
+    *u = bu;
+    *v = bv;
+    return true;
+}
+
 // Ray-triangle intersection (Möller-Trumbore algorithm)
 bool triangle_hit(const Triangle* triangle, const Ray* ray, float t_min, float t_max,
                   HitRecord* rec);
@@ -170,21 +232,38 @@ bool triangle_hit(const Triangle* triangle, const Ray* ray, float t_min, float t
 static inline Primitive primitive_sphere(Vec3 center, float radius, Material mat) {
     Primitive p;
     p.type = PRIMITIVE_SPHERE;
+    p.moving = false;
     p.sphere = sphere_create(center, radius);
     p.material = mat;
     p.bounds = sphere_bounds(&p.sphere);
+    p.motion = vec3_create(0, 0, 0);
     return p;
 }
 
 static inline Primitive primitive_triangle(Vec3 v0, Vec3 v1, Vec3 v2, Material mat) {
     Primitive p;
     p.type = PRIMITIVE_TRIANGLE;
+    p.moving = false;
     p.triangle = triangle_create(v0, v1, v2);
     p.material = mat;
     p.bounds = triangle_bounds(&p.triangle);
+    p.motion = vec3_create(0, 0, 0);
     return p;
 }
 
+static inline void primitive_set_motion(Primitive* prim, Vec3 motion) {
+    prim->motion = motion;
+    prim->moving = motion.x != 0.0f || motion.y != 0.0f || motion.z != 0.0f;
+}
+
+// Bounds at shutter close (prim->bounds holds them at shutter open)
+static inline AABB primitive_end_bounds(const Primitive* prim) {
+    return prim->moving ? aabb_translate(prim->bounds, prim->motion) : prim->bounds;
+}
+
+// Lower-case type name ("sphere", "triangle", "mesh", "instance")
+const char* primitive_type_name(PrimitiveType type);
+
 // Generic primitive hit test
 bool primitive_hit(const Primitive* prim, const Ray* ray, float t_min, float t_max,
                    HitRecord* rec);
@@ -31,6 +31,34 @@ static inline uint32_t rng_uint32(RNG* rng) {
     return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
+// SplitMix64 finalizer: decorrelates structured inputs (pixel/sample indices)
+static inline uint64_t rng_hash64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Initialize RNG with explicit state and stream (reference PCG32 seeding)
+static inline void rng_init_stream(RNG* rng, uint64_t initstate, uint64_t initseq) {
+    rng->state = 0u;
+    rng->inc = (initseq << 1u) | 1u;
+    rng_uint32(rng);
+    rng->state += initstate;
+    rng_uint32(rng);
+}
+
+// Initialize RNG for one (pixel, sample) pair of a render.
+// The state depends only on its arguments, never on which thread or in which
+// order the sample is taken, so renders are reproducible for any schedule.
+static inline void rng_init_sample(RNG* rng, uint64_t seed, uint32_t pixel, uint32_t sample) {
+    uint64_t stream = rng_hash64(seed ^ rng_hash64(pixel));
+    uint64_t state = rng_hash64(stream + sample);
+    rng_init_stream(rng, state, stream);
+}
+
 // Generate random float in [0, 1)
 static inline float rng_float(RNG* rng) {
     return (rng_uint32(rng) & 0xFFFFFF) / 16777216.0f;
@@ -41,35 +69,105 @@ static inline float rng_float_range(RNG* rng, float min, float max) {
     return min + (max - min) * rng_float(rng);
 }
 
+// Closed-form warps of uniform [0,1) samples (usable with any sampler).
+// None of them loop or reject, so every call costs a fixed number of draws.
+
+// sin/cos of 2*pi*turns for turns in [-1, 1]: quadrant reduction plus Taylor
+// polynomials on [-pi/4, pi/4] (abs error < 4e-7), branchless
+static inline void fast_sincos_turns(float turns, float* s, float* c) {
+    float t4 = 4.0f * turns;
+    float q = floorf(t4 + 0.5f);
+    float r = (t4 - q) * (float)(M_PI / 2.0);
+    float r2 = r * r;
+    float sr = r * (1.0f + r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f))));
+    float cr = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+
+    int quadrant = (int)q & 3;
+    float sin_val = (quadrant & 1) ? cr : sr;
+    float cos_val = (quadrant & 1) ? sr : cr;
+    *s = (quadrant & 2) ? -sin_val : sin_val;
+    *c = ((quadrant + 1) & 2) ? -cos_val : cos_val;
+}
+
+// Cube root for x in [0, 1]: bit-level estimate refined by two Newton steps
+static inline float fast_cbrt(float x) {
+    if (x <= 0.0f) return 0.0f;
+    union { float f; uint32_t i; } bits = {x};
+    bits.i = bits.i / 3 + 709921077u;
+    float y = bits.f;
+    y = y - (y * y * y - x) / (3.0f * y * y);
+    y = y - (y * y * y - x) / (3.0f * y * y);
+    return y;
+}
+
+// Uniform direction on the unit sphere
+static inline Vec3 sample_uniform_sphere(float u, float v) {
+    float z = 1.0f - 2.0f * u;
+    float r = sqrtf(fmaxf(0.0f, 1.0f - z * z));
+    float sin_phi, cos_phi;
+    fast_sincos_turns(v, &sin_phi, &cos_phi);
+    return vec3_create(r * cos_phi, r * sin_phi, z);
+}
+
+// Uniform point inside the unit ball
+static inline Vec3 sample_uniform_ball(float u, float v, float w) {
+    return vec3_scale(sample_uniform_sphere(u, v), fast_cbrt(w));
+}
+
+// Uniform point on the unit disk (z = 0), Shirley-Chiu concentric mapping.
+// Preserves the stratification of the input, unlike the polar mapping.
+static inline Vec3 sample_concentric_disk(float u, float v) {
+    float ox = 2.0f * u - 1.0f;
+    float oy = 2.0f * v - 1.0f;
+    if (ox == 0.0f && oy == 0.0f) {
+        return vec3_create(0.0f, 0.0f, 0.0f);
+    }
+
+    // Angle in turns: pi/4 * ratio == ratio / 8 turns
+    bool x_major = fabsf(ox) > fabsf(oy);
+    float r = x_major ? ox : oy;
+    float turns = x_major ? 0.125f * (oy / ox) : 0.25f - 0.125f * (ox / oy);
+    float sin_theta, cos_theta;
+    fast_sincos_turns(turns, &sin_theta, &cos_theta);
+    return vec3_create(r * cos_theta, r * sin_theta, 0.0f);
+}
+
+// Orthonormal basis (t, b, n) around unit vector n (Duff et al. 2017, branchless)
+static inline void onb_from_normal(Vec3 n, Vec3* t, Vec3* b) {
+    float sign = copysignf(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float c = n.x * n.y * a;
+    *t = vec3_create(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+    *b = vec3_create(c, sign + n.y * n.y * a, -n.y);
+}
+
+// Cosine-weighted direction in the hemisphere around unit normal n (Malley's method).
+// The result is unit length, so callers need not normalize it.
+static inline Vec3 sample_cosine_hemisphere(Vec3 n, float u, float v) {
+    Vec3 d = sample_concentric_disk(u, v);
+    float z = sqrtf(fmaxf(0.0f, 1.0f - d.x * d.x - d.y * d.y));
+    Vec3 t, b;
+    onb_from_normal(n, &t, &b);
+    return vec3_add(vec3_add(vec3_scale(t, d.x), vec3_scale(b, d.y)), vec3_scale(n, z));
+}
+
 // Generate random vector in unit sphere
 static inline Vec3 rng_in_unit_sphere(RNG* rng) {
-    while (1) {
-        Vec3 p = vec3_create(
-            rng_float_range(rng, -1.0f, 1.0f),
-            rng_float_range(rng, -1.0f, 1.0f),
-            rng_float_range(rng, -1.0f, 1.0f)
-        );
-        if (vec3_length_squared(p) < 1.0f)
-            return p;
-    }
+    float u = rng_float(rng);
+    float v = rng_float(rng);
+    return sample_uniform_ball(u, v, rng_float(rng));
 }
 
 // Generate random unit vector
 static inline Vec3 rng_unit_vector(RNG* rng) {
-    return vec3_normalize(rng_in_unit_sphere(rng));
+    float u = rng_float(rng);
+    return sample_uniform_sphere(u, rng_float(rng));
 }
 
 // Generate random vector in unit disk (for DOF)
 static inline Vec3 rng_in_unit_disk(RNG* rng) {
-    while (1) {
-        Vec3 p = vec3_create(
-            rng_float_range(rng, -1.0f, 1.0f),
-            rng_float_range(rng, -1.0f, 1.0f),
-            0.0f
-        );
-        if (vec3_length_squared(p) < 1.0f)
-            return p;
-    }
+    float u = rng_float(rng);
+    return sample_concentric_disk(u, rng_float(rng));
 }
 
 #endif // RANDOM_H
\ No newline at end of file
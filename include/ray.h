@@ -6,10 +6,11 @@
 typedef struct {
     Vec3 origin;
     Vec3 direction;
+    float time;  // Shutter time in [0, 1) for moving primitives; bounces keep it
 } Ray;
 
 static inline Ray ray_create(Vec3 origin, Vec3 direction) {
-    return (Ray){origin, vec3_normalize(direction)};
+    return (Ray){origin, vec3_normalize(direction), 0.0f};
 }
 
 static inline Vec3 ray_at(Ray r, float t) {
@@ -0,0 +1,131 @@
+#ifndef RNG_BATCH_H
+#define RNG_BATCH_H
+
+#include <stdint.h>
+#include "random.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Eight interleaved xoshiro128+ generators refilled together into a float
+// buffer. With AVX2 one refill is a handful of vector instructions; the
+// scalar fallback runs the same lanes in a loop and yields identical floats.
+#define RNG_BATCH_LANES 8
+
+typedef struct {
+    _Alignas(32) uint32_t s[4][RNG_BATCH_LANES];   // State word w of lane l at s[w][l]
+    _Alignas(32) float buffer[RNG_BATCH_LANES];
+    uint32_t next;                                   // Next unread buffer entry
+} RNGBatch;
+
+// 32-bit integer finalizer (lowbias32) used to expand seeds into lane states
+static inline uint32_t rng_batch_mix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Refill the buffer with the next output of every lane
+static inline void rng_batch_refill(RNGBatch* batch) {
+#ifdef __AVX2__
+    __m256i s0 = _mm256_load_si256((const __m256i*)batch->s[0]);
+    __m256i s1 = _mm256_load_si256((const __m256i*)batch->s[1]);
+    __m256i s2 = _mm256_load_si256((const __m256i*)batch->s[2]);
+    __m256i s3 = _mm256_load_si256((const __m256i*)batch->s[3]);
+
+    __m256i result = _mm256_add_epi32(s0, s3);
+    __m256i t = _mm256_slli_epi32(s1, 9);
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+    _mm256_store_si256((__m256i*)batch->s[0], s0);
+    _mm256_store_si256((__m256i*)batch->s[1], s1);
+    _mm256_store_si256((__m256i*)batch->s[2], s2);
+    _mm256_store_si256((__m256i*)batch->s[3], s3);
+
+    // Top 24 bits (the low bits of xoshiro128+ are weak) scaled to [0, 1)
+    __m256 f = _mm256_cvtepi32_ps(_mm256_srli_epi32(result, 8));
+    _mm256_store_ps(batch->buffer, _mm256_mul_ps(f, _mm256_set1_ps(1.0f / 16777216.0f)));
+#else
+    for (int l = 0; l < RNG_BATCH_LANES; l++) {
+        uint32_t s0 = batch->s[0][l], s1 = batch->s[1][l];
+        uint32_t s2 = batch->s[2][l], s3 = batch->s[3][l];
+        uint32_t result = s0 + s3;
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 11) | (s3 >> 21);
+        batch->s[0][l] = s0;
+        batch->s[1][l] = s1;
+        batch->s[2][l] = s2;
+        batch->s[3][l] = s3;
+        batch->buffer[l] = (result >> 8) / 16777216.0f;
+    }
+#endif
+    batch->next = 0;
+}
+
+// Seed all lanes from a well-mixed 64-bit key (e.g. a rng_hash64 output).
+// Cheap enough to call once per sample.
+static inline void rng_batch_seed(RNGBatch* batch, uint64_t key) {
+    uint32_t lo = (uint32_t)key;
+    uint32_t hi = (uint32_t)(key >> 32);
+#ifdef __AVX2__
+    const __m256i golden = _mm256_set1_epi32((int)0x9E3779B9u);
+    const __m256i m1 = _mm256_set1_epi32(0x7FEB352D);
+    const __m256i m2 = _mm256_set1_epi32((int)0x846CA68Bu);
+    __m256i word = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (int w = 0; w < 4; w++) {
+        __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int)lo), _mm256_mullo_epi32(word, golden));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, m1);
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, m2);
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_xor_si256(x, _mm256_set1_epi32((int)hi));
+        if (w == 0) {
+            x = _mm256_or_si256(x, _mm256_set1_epi32(1));  // An all-zero lane would stay zero
+        }
+        _mm256_store_si256((__m256i*)batch->s[w], x);
+        word = _mm256_add_epi32(word, _mm256_set1_epi32(RNG_BATCH_LANES));
+    }
+#else
+    for (int w = 0; w < 4; w++) {
+        for (int l = 0; l < RNG_BATCH_LANES; l++) {
+            uint32_t word = (uint32_t)(w * RNG_BATCH_LANES + l);
+            batch->s[w][l] = rng_batch_mix32(lo + word * 0x9E3779B9u) ^ hi;
+        }
+    }
+    for (int l = 0; l < RNG_BATCH_LANES; l++) {
+        batch->s[0][l] |= 1u;  // An all-zero lane would stay zero
+    }
+#endif
+    batch->next = RNG_BATCH_LANES;
+}
+
+// Seed for one (pixel, sample) pair; same reproducibility as rng_init_sample
+static inline void rng_batch_init_sample(RNGBatch* batch, uint64_t seed,
+                                         uint32_t pixel, uint32_t sample) {
+    rng_batch_seed(batch, rng_hash64(rng_hash64(seed ^ rng_hash64(pixel)) + sample));
+}
+
+// Next float in [0, 1)
+static inline float rng_batch_float(RNGBatch* batch) {
+    if (batch->next == RNG_BATCH_LANES) {
+        rng_batch_refill(batch);
+    }
+    return batch->buffer[batch->next++];
+}
+
+#endif // RNG_BATCH_H
@@ -0,0 +1,94 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "random.h"
+#include "rng_batch.h"
+
+// Sample pattern used for all per-path random decisions
+typedef enum {
+    SAMPLER_RANDOM,      // Independent samples from the batched xoshiro128+ generator
+    SAMPLER_STRATIFIED,  // Jittered strata, shuffled independently per dimension
+    SAMPLER_SOBOL,       // Owen-scrambled Sobol (0,2)-sequence per dimension pair
+    SAMPLER_BLUE_NOISE,  // Sobol with a per-pixel blue-noise toroidal shift
+    SAMPLER_TYPE_COUNT
+} SamplerType;
+
+// Dimension layout. Every consumer reads a fixed dimension so that
+// low-discrepancy patterns stay aligned across the samples of a pixel.
+#define SAMPLER_DIM_PIXEL 0         // 2D: film jitter
+#define SAMPLER_DIM_LENS 2          // 2D: lens position
+#define SAMPLER_DIM_TIME 0xffff     // 1D: shutter time (only drawn in scenes with motion,
+                                    // so static renders are unchanged)
+#define SAMPLER_DIM_FIRST_BOUNCE 4  // Start of per-bounce dimensions
+#define SAMPLER_DIMS_PER_BOUNCE 4
+
+// Per-bounce offsets (relative to sampler_start_bounce)
+#define SAMPLER_BOUNCE_SCATTER 0    // 2D: scatter direction
+#define SAMPLER_BOUNCE_EXTRA 2      // 1D: fuzz radius / Fresnel choice
+#define SAMPLER_BOUNCE_RR 3         // 1D: Russian roulette
+
+// Per-path sampler state: one instance is (re)started for every (pixel, sample)
+typedef struct {
+    SamplerType type;
+    uint32_t pixel_x;
+    uint32_t pixel_y;
+    uint32_t pixel;
+    uint32_t sample;
+    uint32_t spp;
+    uint32_t bounce_base;
+    uint64_t seed;
+    uint64_t scramble_seed;  // Hash of (seed, pixel) for per-pixel scrambling
+    RNG rng;             // Jitter for stratified
+    RNGBatch batch;      // Draws for SAMPLER_RANDOM
+} Sampler;
+
+// One-time setup for a sampler type (blue-noise mask); call before rendering
+void sampler_prepare(SamplerType type);
+
+// Start a new sample path for pixel (x, y) of an image `width` pixels wide
+void sampler_start(Sampler* sampler, SamplerType type, uint64_t seed,
+                   uint32_t x, uint32_t y, uint32_t width,
+                   uint32_t sample, uint32_t spp);
+
+// Low-discrepancy draws (out of line; random sampling stays inline below)
+float sampler_ld_1d(Sampler* sampler, uint32_t dim);
+void sampler_ld_2d(Sampler* sampler, uint32_t dim, float* u, float* v);
+
+// Sampler names for CLI/GUI
+const char* sampler_type_name(SamplerType type);
+bool sampler_type_from_name(const char* name, SamplerType* type);
+
+// Draw a value in [0, 1) for dimension `dim`
+static inline float sampler_1d(Sampler* sampler, uint32_t dim) {
+    if (sampler->type == SAMPLER_RANDOM) {
+        return rng_batch_float(&sampler->batch);
+    }
+    return sampler_ld_1d(sampler, dim);
+}
+
+// Draw a point in [0, 1)^2 for dimensions (dim, dim + 1)
+static inline void sampler_2d(Sampler* sampler, uint32_t dim, float* u, float* v) {
+    if (sampler->type == SAMPLER_RANDOM) {
+        *u = rng_batch_float(&sampler->batch);
+        *v = rng_batch_float(&sampler->batch);
+        return;
+    }
+    sampler_ld_2d(sampler, dim, u, v);
+}
+
+// Select the dimension block of bounce `depth`
+static inline void sampler_start_bounce(Sampler* sampler, uint32_t depth) {
+    sampler->bounce_base = SAMPLER_DIM_FIRST_BOUNCE + depth * SAMPLER_DIMS_PER_BOUNCE;
+}
+
+static inline float sampler_bounce_1d(Sampler* sampler, uint32_t offset) {
+    return sampler_1d(sampler, sampler->bounce_base + offset);
+}
+
+static inline void sampler_bounce_2d(Sampler* sampler, uint32_t offset, float* u, float* v) {
+    sampler_2d(sampler, sampler->bounce_base + offset, u, v);
+}
+
+#endif // SAMPLER_H
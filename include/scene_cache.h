@@ -0,0 +1,48 @@
+#ifndef SCENE_CACHE_H
+#define SCENE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "pathtracer.h"
+
+// Binary scene cache. One file holds a built scene: the leaf-ordered
+// primitives, every mesh's buffers and the flattened (index-linked) BVH
+// nodes, each section 64-byte aligned. Loading maps the file copy-on-write
+// and points the scene, mesh and BVH structs straight at it. Only the mesh
+// pointers inside PRIMITIVE_MESH primitives are patched, so a cached
+// million-triangle scene is ready in milliseconds instead of re-running the
+// BVH builds.
+//
+// Files are keyed by a 64-bit content hash and written in host byte order
+// with the in-memory struct layouts. A file whose version, key or struct sizes
+// do not match, or whose nodes, mesh indices or primitives point outside it,
+// is ignored and rebuilt, never partially used.
+
+#define SCENE_CACHE_EXTENSION ".ptscene"
+
+// 64-bit hash of a byte range, chained through `seed`
+uint64_t hash_bytes(uint64_t seed, const void* data, size_t size);
+
+// Hash of a file's contents (mapped, not read into memory)
+bool hash_file(const char* path, uint64_t* hash);
+
+// Hash of everything that affects rendering: primitives, materials, mesh
+// buffers and ambient light. Call it before scene_build_bvh, which reorders
+// the primitives and mesh triangles.
+uint64_t scene_content_hash(const Scene* scene);
+
+// Store a built scene (scene_build_bvh done) as DIR/<key in hex>.ptscene,
+// creating DIR if needed. The file is written under a temporary name and
+// renamed, so concurrent renders never map a partial file. Scenes with
+// instances (instance.h) are not stored yet.
+bool scene_cache_save(const Scene* scene, const char* dir, uint64_t key);
+
+// Map the entry for `key`; NULL if it is missing, stale or corrupt
+Scene* scene_cache_load(const char* dir, uint64_t key);
+
+// Replace an unbuilt scene with its cached copy from `dir` if there is one
+// (destroying `scene`), else build its BVHs and store it. *hit reports which.
+Scene* scene_cache_build(Scene* scene, const char* dir, bool* hit);
+
+#endif // SCENE_CACHE_H
@@ -0,0 +1,86 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pathtracer.h"
+#include "sequence.h"
+
+// Text scene descriptions, so new scenes render without recompiling. One
+// record per line; '#' starts a comment and blank lines are ignored:
+//
+//   settings width 800 height 600 spp 100 depth 50 seed 42 sampler sobol
+//   camera lookfrom 13 2 3 lookat 0 0.5 0 vup 0 1 0 vfov 20 aperture 0.1 focus 10
+//   ambient 0.7 0.8 1
+//   material NAME lambertian R G B
+//   material NAME metal R G B FUZZ
+//   material NAME dielectric IOR
+//   material NAME emissive R G B
+//   material NAME blend TYPE1 R G B ROUGHNESS IOR TYPE2 R G B ROUGHNESS IOR MODE MIN MAX
+//   sphere MATERIAL X Y Z RADIUS [motion DX DY DZ]
+//   triangle MATERIAL X0 Y0 Z0 X1 Y1 Z1 X2 Y2 Z2 [motion DX DY DZ]
+//   mesh MATERIAL PATH
+//   frames COUNT
+//   keyframe FRAME camera KEY VALUE...
+//   keyframe FRAME move PRIM X Y Z
+//
+// settings and camera take any subset of their keys. Camera keys not given
+// keep camera_params_default(), and focus 0 focuses on lookat. Materials must
+// be defined before use. Blend modes are vertical, horizontal or radial.
+// Mesh paths (OBJ or PLY, see mesh_io.h) are relative to the scene file and
+// run to the end of the line. motion moves a sphere or triangle by DX DY DZ
+// while the shutter is open (motion blur).
+//
+// frames and keyframe records make the file an animated sequence (see
+// sequence.h); without frames it runs to the last keyframe. Camera keyframes
+// take the camera record's keys, come in frame order and keep the keys they
+// do not give from the previous camera keyframe (the first from the camera
+// record). move offsets the PRIM-th sphere or triangle, counting sphere,
+// triangle and mesh records from 0.
+//
+// The file is mapped and parsed twice: the first pass counts records so the
+// primitive array and material table are allocated once at their final size,
+// the second fills them. Errors are reported as "path:line: problem".
+
+#define SCENE_FILE_EXTENSION ".scene"
+
+// Render settings a scene file can carry (SceneDescription.settings_mask)
+#define SCENE_SETTING_WIDTH   (1u << 0)
+#define SCENE_SETTING_HEIGHT  (1u << 1)
+#define SCENE_SETTING_SPP     (1u << 2)
+#define SCENE_SETTING_DEPTH   (1u << 3)
+#define SCENE_SETTING_SEED    (1u << 4)
+#define SCENE_SETTING_SAMPLER (1u << 5)
+
+typedef struct {
+    Scene* scene;              // Not built yet: scene_build_bvh or scene_cache_build
+    CameraParams camera;
+    RenderSettings settings;   // Only the fields flagged in settings_mask are set
+    uint32_t settings_mask;
+    Sequence sequence;         // frame_count 0 unless the file is animated; sequence_free
+} SceneDescription;
+
+// Load a scene file; false (with the problem printed) on any error. The
+// caller frees desc->sequence along with the scene.
+bool scene_file_load(const char* path, SceneDescription* desc);
+
+// Copy the file's settings into `settings`, except the fields in `keep`
+// (e.g. the ones given on the command line)
+void scene_file_apply_settings(const SceneDescription* desc, RenderSettings* settings,
+                               uint32_t keep);
+
+// Write an unbuilt scene (before scene_build_bvh reorders it) with its camera,
+// optional render settings and optional sequence (frames and keyframes; move
+// keys name primitives in the scene's order). Floats are written with 6
+// significant digits when that reads back exactly and 9 otherwise, so
+// loading the file reproduces the scene bit for bit. Scenes with meshes
+// (whose source files are unknown) or instances cannot be written.
+bool scene_file_save(const char* path, const Scene* scene, const CameraParams* camera,
+                     const RenderSettings* settings, const Sequence* sequence);
+
+// Paths of the *.scene files in `dir`, sorted by name; free with
+// scene_file_list_free. NULL (and *count 0) if the directory cannot be read.
+char** scene_file_list(const char* dir, uint32_t* count);
+void scene_file_list_free(char** paths, uint32_t count);
+
+#endif // SCENE_FILE_H
@@ -0,0 +1,47 @@
+#ifndef SCENE_GEN_H
+#define SCENE_GEN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pathtracer.h"
+
+// Procedural stress-test scenes for measuring BVH build and traversal
+// scaling, from thousands up to tens of millions of primitives. The same
+// spec and seed always produce the same scene.
+//
+//   spheres:N      N random spheres filling a cube sized for constant density
+//   sphere-mesh:N  UV sphere mesh with about N triangles (mesh scene viewer)
+//   terrain:N      Fractal heightfield mesh with about N triangles
+//   grid:N         N instances of one sphere mesh on a cubic lattice, each with
+//                  its own material (many identical splits)
+//   forest:N       N randomly placed, turned and scaled instances of one tree
+//
+// Specs are written NAME:COUNT[:SEED]; COUNT takes a K or M suffix
+// (e.g. "spheres:10M:7") and SEED defaults to 1.
+
+typedef enum {
+    GENERATOR_SPHERES,
+    GENERATOR_SPHERE_MESH,
+    GENERATOR_TERRAIN,
+    GENERATOR_GRID,
+    GENERATOR_FOREST,
+    GENERATOR_TYPE_COUNT
+} GeneratorType;
+
+typedef struct {
+    GeneratorType type;
+    uint32_t count;  // Spheres, triangles (meshes) or instances (grid, forest)
+    uint64_t seed;
+} GeneratorSpec;
+
+const char* generator_type_name(GeneratorType type);
+bool generator_spec_parse(const char* text, GeneratorSpec* spec);
+
+// Unbuilt scene (run scene_build_bvh or scene_cache_build); NULL if it does
+// not fit in memory
+Scene* generate_scene(const GeneratorSpec* spec);
+
+// Pinhole camera framing the generated scene
+CameraParams generator_camera(const GeneratorSpec* spec);
+
+#endif // SCENE_GEN_H
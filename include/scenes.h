@@ -10,5 +10,21 @@ Scene* create_glass_spheres(void);  // Glass spheres with different materials
 Scene* create_metal_spheres(void);  // Metal spheres showcase with reflections
 Scene* create_studio_lighting(void);  // Studio lighting scene with glass and metal materials
 Scene* create_material_blend(void);  // Material blending showcase with gradient materials
+Scene* create_motion_blur(void);  // Bouncing and sweeping objects blurred by the shutter
+
+// Built-in scene names, in the order shown by the GUI scene selector
+#define SCENE_COUNT 7
+extern const char* const SCENE_NAMES[SCENE_COUNT];
+
+// Lookup by name (unknown names fall back to the Cornell Box / default camera)
+Scene* create_scene_by_name(const char* name);
+CameraParams camera_params_for_scene(const char* name);
+Camera create_camera_for_scene(const char* name, float aspect);
+
+// Viewer for a loaded mesh: the mesh is scaled in place to fit a 2-unit box
+// standing on a ground plane under an area light (the scene takes ownership)
+Scene* create_mesh_scene(Mesh* mesh);
+CameraParams camera_params_for_mesh_scene(void);
+Camera create_camera_for_mesh_scene(float aspect);
 
 #endif // SCENES_H
\ No newline at end of file
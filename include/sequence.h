@@ -0,0 +1,78 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pathtracer.h"
+
+// Animated sequences (turntables, fly-throughs): camera and object keyframes
+// rendered to numbered images in one run. The scene, its BVH and the render
+// threads are set up once; between frames only the moved primitives change
+// and the BVH is refit (scene_refit_bvh), and while frame N+1 renders a
+// writer thread tonemaps and encodes frame N.
+//
+// Keys are interpolated linearly between the keyframes around a frame and
+// held before the first and after the last.
+
+typedef struct {
+    uint32_t frame;
+    CameraParams camera;
+} CameraKey;
+
+// Offset of one sphere or triangle from where the scene placed it
+typedef struct {
+    uint32_t frame;
+    uint32_t prim;  // Index in creation order (the scene file's record order)
+    Vec3 offset;
+} MoveKey;
+
+typedef struct {
+    uint32_t frame_count;    // 0 = not a sequence
+    CameraKey* camera_keys;  // Sorted by frame
+    uint32_t camera_key_count;
+    MoveKey* move_keys;      // Sorted by primitive, then frame
+    uint32_t move_key_count;
+} Sequence;
+
+// `frames` frames orbiting `camera` once around the vup axis through lookat
+bool sequence_turntable(Sequence* seq, uint32_t frames, const CameraParams* camera);
+void sequence_free(Sequence* seq);
+
+// Restore the key order after appending keys
+void sequence_sort(Sequence* seq);
+
+// Camera for `frame`; `base` when the sequence has no camera keys
+CameraParams sequence_camera(const Sequence* seq, const CameraParams* base, uint32_t frame);
+
+// True if `pattern` holds exactly one integer conversion for the frame
+// number ("%d", "%04d", ...) and otherwise only "%%"
+bool sequence_pattern_valid(const char* pattern);
+
+typedef struct {
+    const char* pattern;             // Output path, see sequence_pattern_valid
+    const TonemapSettings* tonemap;
+    ImageFormat format;              // Framebuffer format
+    uint32_t frame_begin;            // Render frames [frame_begin, frame_end)
+    uint32_t frame_end;              // (0 = to the last frame)
+    bool verbose;                    // Print a line per frame
+} SequenceOutput;
+
+typedef struct {
+    uint32_t frames;      // Frames written
+    uint32_t rebuilds;    // Full BVH rebuilds among the updates
+    double elapsed;       // Whole sequence, including the last write
+    double render_time;   // In render_parallel
+    double update_time;   // Moving primitives and updating the BVH
+    uint64_t rays;
+} SequenceStats;
+
+// Render and write the frames of `seq`. Frame N uses seed settings->seed + N,
+// so any range of frames renders as it does in the full sequence. Object keys
+// need an unbuilt scene, whose creation order names the primitives; without
+// them a built or cached scene is used as is. Setting settings->cancel_flag
+// stops in the frame in progress, which is not written.
+bool sequence_render(Scene* scene, const Sequence* seq, const CameraParams* base_camera,
+                     const RenderSettings* settings, const SequenceOutput* output,
+                     SequenceStats* stats);
+
+#endif // SEQUENCE_H
@@ -0,0 +1,111 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include "primitive.h"
+#include "material.h"
+
+// Work counters a render thread accumulates privately between publishes
+typedef struct {
+    uint64_t pixels;
+    uint64_t samples;
+    uint64_t rays;       // Scene intersection queries (camera and bounce rays)
+    uint64_t bvh_nodes;  // BVH nodes visited by those queries
+} RenderCounters;
+
+#ifdef PATHTRACER_STATS
+// Detailed hot-path counters, compiled in with `make STATS=1`. Each thread
+// increments its own thread-local copy and merges it once at the end of
+// the render; without PATHTRACER_STATS every STATS_COUNT compiles away.
+#define STATS_DEPTH_BUCKETS 16  // Last bucket collects depth >= 15
+
+typedef struct {
+    uint64_t rays_by_depth[STATS_DEPTH_BUCKETS];
+    uint64_t aabb_tests;                           // BVH nodes whose box was tested
+    uint64_t aabb_hits;                            // ... and entered
+    uint64_t leaf_visits;
+    uint64_t prim_tests[PRIMITIVE_TYPE_COUNT];
+    uint64_t prim_hits[PRIMITIVE_TYPE_COUNT];
+    uint64_t scatters[MATERIAL_TYPE_COUNT];       // material_scatter calls by type
+    uint64_t absorbed;                             // Scatter returned false
+    uint64_t misses;                               // Rays that escaped to the background
+    uint64_t emitter_hits;
+    uint64_t rr_terminations;
+    uint64_t depth_terminations;                   // Paths cut off at max_depth
+} RenderDetailCounters;
+
+extern _Thread_local RenderDetailCounters render_thread_details;
+
+#define STATS_COUNT(field) ((void)render_thread_details.field++)
+#define STATS_ADD(field, n) ((void)(render_thread_details.field += (n)))
+#else
+#define STATS_COUNT(field) ((void)0)
+#define STATS_ADD(field, n) ((void)0)
+#endif
+
+// Published totals of one render thread. Each slot is written by its thread
+// only (plain load + store, no locked read-modify-write) and padded to a
+// cache line so publishers never contend.
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t pixels;
+    atomic_uint_fast64_t samples;
+    atomic_uint_fast64_t rays;
+    atomic_uint_fast64_t bvh_nodes;
+} RenderStatsSlot;
+
+// Live statistics channel for one render. Threads publish at tile ends; any
+// other thread may take snapshots at any time without blocking them.
+typedef struct {
+    uint32_t slot_count;
+    RenderStatsSlot* slots;
+    uint64_t total_pixels;
+    atomic_uint_fast64_t start_ns;  // 0 until render_stats_begin
+    atomic_uint_fast64_t end_ns;    // 0 while the render is running
+#ifdef PATHTRACER_STATS
+    RenderDetailCounters details;   // Merged from all threads at render end
+#endif
+} RenderStats;
+
+// Aggregated view returned to readers
+typedef struct {
+    RenderCounters totals;
+    uint64_t total_pixels;
+    double progress;       // Fraction of pixels finished, [0, 1]
+    double elapsed;        // Seconds since render start (frozen once finished)
+    double mrays_per_sec;  // totals.rays / elapsed
+    bool finished;
+} RenderStatsSnapshot;
+
+// Counters of the calling thread. trace_ray and bvh_hit add to these.
+extern _Thread_local RenderCounters render_thread_counters;
+
+// Channel with one slot per render thread
+RenderStats* render_stats_create(uint32_t thread_count);
+void render_stats_destroy(RenderStats* stats);
+
+// Reset the slots and start/stop the clock (called by render_parallel)
+void render_stats_begin(RenderStats* stats, uint64_t total_pixels);
+void render_stats_end(RenderStats* stats);
+
+// Add `counters` to thread `thread`'s slot and zero them
+void render_stats_publish(RenderStats* stats, uint32_t thread, RenderCounters* counters);
+
+// Lock-free sum over all slots
+void render_stats_snapshot(const RenderStats* stats, RenderStatsSnapshot* out);
+
+// Reset / merge the calling thread's detailed counters (no-ops unless
+// PATHTRACER_STATS). Merging must not run concurrently for one channel.
+void render_stats_thread_begin(void);
+void render_stats_thread_merge(RenderStats* stats);
+
+// Per-render breakdown of the detailed counters; prints nothing unless
+// built with PATHTRACER_STATS
+void render_stats_report(const RenderStats* stats, FILE* out);
+
+// Monotonic clock in nanoseconds
+uint64_t render_stats_now_ns(void);
+
+#endif // STATS_H
@@ -0,0 +1,61 @@
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "vec3.h"
+#include "image.h"
+
+// Tonemapping curve applied after exposure
+typedef enum {
+    TONEMAP_ACES,      // ACES filmic fit (the renderer's historical look)
+    TONEMAP_REINHARD,  // x / (1 + x)
+    TONEMAP_LINEAR,    // Clamp only
+    TONEMAP_OPERATOR_COUNT
+} TonemapOperator;
+
+// Byte order of quantized 8-bit output pixels
+typedef enum {
+    PIXEL_LAYOUT_RGB8,  // GdkPixbuf
+    PIXEL_LAYOUT_BGR8,  // BMP
+    PIXEL_LAYOUT_BGRX8, // Cairo RGB24 on little-endian hosts (padding byte = 0xFF)
+    PIXEL_LAYOUT_COUNT
+} PixelLayout;
+
+typedef struct TonemapSettings {
+    TonemapOperator op;
+    float exposure;  // In stops; radiance is scaled by 2^exposure
+    bool srgb;       // Apply the sRGB transfer curve before quantizing
+} TonemapSettings;
+
+// ACES, no exposure change, no sRGB curve: the earlier look, except that
+// quantizing now rounds to nearest instead of truncating, so 8-bit values
+// can be one code higher than in renders from before the shared kernel
+TonemapSettings tonemap_default(void);
+
+// Operator names for CLI/GUI ("aces", "reinhard", "linear")
+const char* tonemap_operator_name(TonemapOperator op);
+bool tonemap_operator_from_name(const char* name, TonemapOperator* op);
+
+size_t pixel_layout_bytes(PixelLayout layout);
+
+// Tonemap, encode and quantize (round to nearest) one framebuffer row.
+// Uses AVX2 when available; the scalar fallback produces identical bytes.
+void tonemap_row(const TonemapSettings* settings, const Image* img, uint32_t y,
+                 uint8_t* out, PixelLayout layout);
+
+// Rows [y_begin, y_end) in parallel (OpenMP); row y goes to out + (y - y_begin) * stride
+void tonemap_rows(const TonemapSettings* settings, const Image* img,
+                  uint32_t y_begin, uint32_t y_end,
+                  uint8_t* out, size_t stride, PixelLayout layout);
+
+// Rectangle [x0, x1) x [y0, y1); `out` receives pixel (x0, y0), rows `stride` apart
+void tonemap_rect(const TonemapSettings* settings, const Image* img,
+                  uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                  uint8_t* out, size_t stride, PixelLayout layout);
+
+// ACES filmic tonemapping curve (single pixel, no clamp)
+Vec3 aces_tonemap(Vec3 color);
+
+#endif // TONEMAP_H
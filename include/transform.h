@@ -0,0 +1,111 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "vec3.h"
+#include "primitive.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Affine transform as the top three rows of a 4x4 matrix:
+// p' = m[.][0..2] * p + m[.][3]
+typedef struct {
+    float m[3][4];
+} Transform;
+
+static inline Transform transform_identity(void) {
+    return (Transform){{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+}
+
+static inline Transform transform_translate(Vec3 offset) {
+    return (Transform){{{1, 0, 0, offset.x}, {0, 1, 0, offset.y}, {0, 0, 1, offset.z}}};
+}
+
+static inline Transform transform_scale(Vec3 scale) {
+    return (Transform){{{scale.x, 0, 0, 0}, {0, scale.y, 0, 0}, {0, 0, scale.z, 0}}};
+}
+
+// Counter-clockwise rotation by `degrees` about `axis` (Rodrigues)
+static inline Transform transform_rotate(Vec3 axis, float degrees) {
+    Vec3 a = vec3_normalize(axis);
+    float radians = degrees * (float)M_PI / 180.0f;
+    float s = sinf(radians), c = cosf(radians), t = 1.0f - c;
+    return (Transform){{
+        {t * a.x * a.x + c, t * a.x * a.y - s * a.z, t * a.x * a.z + s * a.y, 0},
+        {t * a.x * a.y + s * a.z, t * a.y * a.y + c, t * a.y * a.z - s * a.x, 0},
+        {t * a.x * a.z - s * a.y, t * a.y * a.z + s * a.x, t * a.z * a.z + c, 0}
+    }};
+}
+
+// `a` applied after `b`
+static inline Transform transform_mul(const Transform* a, const Transform* b) {
+    Transform r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            r.m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] + a->m[i][2] * b->m[2][j];
+        }
+        r.m[i][3] += a->m[i][3];
+    }
+    return r;
+}
+
+// Inverse via the adjugate of the linear part; false if it is singular
+static inline bool transform_inverse(const Transform* t, Transform* inverse) {
+    const float (*m)[4] = t->m;
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (fabsf(det) < 1e-12f) return false;
+
+    float inv_det = 1.0f / det;
+    float (*r)[4] = inverse->m;
+    r[0][0] = c00 * inv_det;
+    r[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+    r[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+    r[1][0] = c01 * inv_det;
+    r[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+    r[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+    r[2][0] = c02 * inv_det;
+    r[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+    r[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+    for (int i = 0; i < 3; i++) {
+        r[i][3] = -(r[i][0] * m[0][3] + r[i][1] * m[1][3] + r[i][2] * m[2][3]);
+    }
+    return true;
+}
+
+static inline Vec3 transform_vector(const Transform* t, Vec3 v) {
+    return vec3_create(t->m[0][0] * v.x + t->m[0][1] * v.y + t->m[0][2] * v.z,
+                       t->m[1][0] * v.x + t->m[1][1] * v.y + t->m[1][2] * v.z,
+                       t->m[2][0] * v.x + t->m[2][1] * v.y + t->m[2][2] * v.z);
+}
+
+static inline Vec3 transform_point(const Transform* t, Vec3 p) {
+    Vec3 v = transform_vector(t, p);
+    return vec3_create(v.x + t->m[0][3], v.y + t->m[1][3], v.z + t->m[2][3]);
+}
+
+// Normal mapped by the transform whose inverse is `inverse` (the inverse
+// transpose keeps normals perpendicular under non-uniform scale); unnormalized
+static inline Vec3 transform_normal(const Transform* inverse, Vec3 n) {
+    const float (*m)[4] = inverse->m;
+    return vec3_create(m[0][0] * n.x + m[1][0] * n.y + m[2][0] * n.z,
+                       m[0][1] * n.x + m[1][1] * n.y + m[2][1] * n.z,
+                       m[0][2] * n.x + m[1][2] * n.y + m[2][2] * n.z);
+}
+
+// Box around the transformed corners of `box` (empty stays empty)
+static inline AABB transform_bounds(const Transform* t, AABB box) {
+    if (box.min.x > box.max.x) return box;
+    AABB result = aabb_empty();
+    for (int corner = 0; corner < 8; corner++) {
+        Vec3 p = vec3_create(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                             corner & 4 ? box.max.z : box.min.z);
+        result = aabb_expand(result, transform_point(t, p));
+    }
+    return result;
+}
+
+#endif // TRANSFORM_H
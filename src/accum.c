@@ -0,0 +1,238 @@
+#include "accum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "PTCK"
+#define CHECKPOINT_VERSION 1u
+#define CHECKPOINT_HEADER_SIZE (4 + 7 * 4 + 8 + CHECKPOINT_SCENE_NAME_SIZE)
+
+Accumulator* accumulator_create(uint32_t width, uint32_t height) {
+    size_t count = (size_t)width * height;
+    Accumulator* accum = (Accumulator*)calloc(1, sizeof(Accumulator));
+    if (!accum) return NULL;
+
+    accum->width = width;
+    accum->height = height;
+    accum->data = calloc(count, 3 * sizeof(float) + sizeof(uint32_t));
+    if (!accum->data) {
+        fprintf(stderr, "Failed to allocate %ux%u accumulation buffer\n", width, height);
+        free(accum);
+        return NULL;
+    }
+
+    float* sums = (float*)accum->data;
+    for (int c = 0; c < 3; c++) {
+        accum->sum[c] = sums + c * count;
+    }
+    accum->count = (uint32_t*)(sums + 3 * count);
+    return accum;
+}
+
+void accumulator_destroy(Accumulator* accum) {
+    if (accum) {
+        free(accum->data);
+        free(accum);
+    }
+}
+
+void accumulator_reset(Accumulator* accum, uint32_t first_sample) {
+    size_t count = (size_t)accum->width * accum->height;
+    for (int c = 0; c < 3; c++) {
+        memset(accum->sum[c], 0, count * sizeof(float));
+    }
+    for (size_t i = 0; i < count; i++) {
+        accum->count[i] = first_sample;
+    }
+    accum->first_sample = first_sample;
+}
+
+uint32_t accumulator_min_count(const Accumulator* accum) {
+    size_t count = (size_t)accum->width * accum->height;
+    uint32_t min_count = UINT32_MAX;
+    for (size_t i = 0; i < count; i++) {
+        if (accum->count[i] < min_count) min_count = accum->count[i];
+    }
+    return count ? min_count : 0;
+}
+
+uint32_t accumulator_min_count_tiles(const Accumulator* accum, uint32_t tile_size,
+                                     uint32_t tile_begin, uint32_t tile_end) {
+    uint32_t tiles_x = (accum->width + tile_size - 1) / tile_size;
+    uint32_t tile_count = tiles_x * ((accum->height + tile_size - 1) / tile_size);
+    if (tile_end && tile_end < tile_count) tile_count = tile_end;
+
+    uint32_t min_count = UINT32_MAX;
+    for (uint32_t tile = tile_begin; tile < tile_count; tile++) {
+        uint32_t x0 = (tile % tiles_x) * tile_size;
+        uint32_t y0 = (tile / tiles_x) * tile_size;
+        uint32_t x1 = x0 + tile_size < accum->width ? x0 + tile_size : accum->width;
+        uint32_t y1 = y0 + tile_size < accum->height ? y0 + tile_size : accum->height;
+        for (uint32_t y = y0; y < y1; y++) {
+            const uint32_t* row = accum->count + (size_t)y * accum->width;
+            for (uint32_t x = x0; x < x1; x++) {
+                if (row[x] < min_count) min_count = row[x];
+            }
+        }
+    }
+    return min_count;
+}
+
+uint64_t accumulator_total_samples(const Accumulator* accum) {
+    size_t count = (size_t)accum->width * accum->height;
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) total += accum->count[i] - accum->first_sample;
+    return total;
+}
+
+// Header fields are little-endian; the arrays after it are written in host
+// order, which is little-endian on every platform the renderer targets
+static uint8_t* put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return p + 4;
+}
+
+static uint8_t* put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return p + 8;
+}
+
+static const uint8_t* get_u32(const uint8_t* p, uint32_t* v) {
+    *v = 0;
+    for (int i = 0; i < 4; i++) *v |= (uint32_t)p[i] << (8 * i);
+    return p + 4;
+}
+
+static const uint8_t* get_u64(const uint8_t* p, uint64_t* v) {
+    *v = 0;
+    for (int i = 0; i < 8; i++) *v |= (uint64_t)p[i] << (8 * i);
+    return p + 8;
+}
+
+bool checkpoint_save(const Accumulator* accum, const CheckpointInfo* info, const char* filename) {
+    size_t tmp_len = strlen(filename) + 5;
+    char* tmp = (char*)malloc(tmp_len);
+    if (!tmp) return false;
+    snprintf(tmp, tmp_len, "%s.tmp", filename);
+
+    FILE* f = fopen(tmp, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", tmp);
+        free(tmp);
+        return false;
+    }
+
+    uint8_t header[CHECKPOINT_HEADER_SIZE] = {0};
+    uint8_t* p = header;
+    memcpy(p, CHECKPOINT_MAGIC, 4);
+    p += 4;
+    p = put_u32(p, CHECKPOINT_VERSION);
+    p = put_u32(p, accum->width);
+    p = put_u32(p, accum->height);
+    p = put_u32(p, info->samples_per_pixel);
+    p = put_u32(p, info->max_depth);
+    p = put_u32(p, (uint32_t)info->sampler);
+    p = put_u32(p, accum->first_sample);
+    p = put_u64(p, info->seed);
+    size_t name_len = strlen(info->scene);
+    if (name_len > CHECKPOINT_SCENE_NAME_SIZE - 1) name_len = CHECKPOINT_SCENE_NAME_SIZE - 1;
+    memcpy(p, info->scene, name_len);  // Zero-padded by the initializer
+
+    size_t count = (size_t)accum->width * accum->height;
+    fwrite(header, 1, sizeof(header), f);
+    fwrite(accum->count, sizeof(uint32_t), count, f);
+    for (int c = 0; c < 3; c++) {
+        fwrite(accum->sum[c], sizeof(float), count, f);
+    }
+
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (ok && rename(tmp, filename) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Failed to write checkpoint %s\n", filename);
+        remove(tmp);
+    }
+    free(tmp);
+    return ok;
+}
+
+Accumulator* checkpoint_load(const char* filename, CheckpointInfo* info) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        fprintf(stderr, "Failed to open checkpoint %s\n", filename);
+        return NULL;
+    }
+
+    uint8_t header[CHECKPOINT_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, CHECKPOINT_MAGIC, 4) != 0) {
+        fprintf(stderr, "%s is not a checkpoint file\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    uint32_t version, width, height, sampler, first_sample;
+    const uint8_t* p = get_u32(header + 4, &version);
+    if (version != CHECKPOINT_VERSION) {
+        fprintf(stderr, "Unsupported checkpoint version %u in %s\n", version, filename);
+        fclose(f);
+        return NULL;
+    }
+    p = get_u32(p, &width);
+    p = get_u32(p, &height);
+    p = get_u32(p, &info->samples_per_pixel);
+    p = get_u32(p, &info->max_depth);
+    p = get_u32(p, &sampler);
+    p = get_u32(p, &first_sample);
+    p = get_u64(p, &info->seed);
+    if (sampler >= SAMPLER_TYPE_COUNT) {
+        fprintf(stderr, "Invalid sampler in checkpoint %s\n", filename);
+        fclose(f);
+        return NULL;
+    }
+    info->sampler = (SamplerType)sampler;
+    memcpy(info->scene, p, CHECKPOINT_SCENE_NAME_SIZE);
+    info->scene[CHECKPOINT_SCENE_NAME_SIZE - 1] = '\0';
+
+    Accumulator* accum = accumulator_create(width, height);
+    if (!accum) {
+        fclose(f);
+        return NULL;
+    }
+
+    accum->first_sample = first_sample;
+
+    size_t count = (size_t)width * height;
+    bool ok = fread(accum->count, sizeof(uint32_t), count, f) == count;
+    for (int c = 0; c < 3 && ok; c++) {
+        ok = fread(accum->sum[c], sizeof(float), count, f) == count;
+    }
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "Checkpoint %s is truncated\n", filename);
+        accumulator_destroy(accum);
+        return NULL;
+    }
+    return accum;
+}
+
+bool checkpoint_info_matches(const CheckpointInfo* info, const CheckpointInfo* expected) {
+    if (strcmp(info->scene, expected->scene) != 0) {
+        fprintf(stderr, "Checkpoint scene \"%s\" differs from \"%s\"\n", info->scene, expected->scene);
+        return false;
+    }
+    if (info->samples_per_pixel != expected->samples_per_pixel) {
+        fprintf(stderr, "Checkpoint targets %u spp, not %u\n",
+                info->samples_per_pixel, expected->samples_per_pixel);
+        return false;
+    }
+    if (info->max_depth != expected->max_depth || info->sampler != expected->sampler ||
+        info->seed != expected->seed) {
+        fprintf(stderr, "Checkpoint depth/sampler/seed (%u, %s, %llu) differ from (%u, %s, %llu)\n",
+                info->max_depth, sampler_type_name(info->sampler), (unsigned long long)info->seed,
+                expected->max_depth, sampler_type_name(expected->sampler),
+                (unsigned long long)expected->seed);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+#include "aov.h"
+#include "tonemap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define COST_AOV_HISTOGRAM_BINS 1024
+
+static const char* const COST_AOV_NAMES[COST_AOV_COUNT] = {"cycles", "nodes", "path"};
+
+const char* cost_aov_name(CostAov channel) {
+    return (channel < COST_AOV_COUNT) ? COST_AOV_NAMES[channel] : "unknown";
+}
+
+bool cost_aov_from_name(const char* name, CostAov* channel) {
+    for (int i = 0; i < COST_AOV_COUNT; i++) {
+        if (strcmp(name, COST_AOV_NAMES[i]) == 0) {
+            *channel = (CostAov)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static float cost_aov_value(const Image* aov, CostAov channel, uint32_t x, uint32_t y) {
+    Vec3 v = image_get_pixel(aov, x, y);
+    return (channel == COST_AOV_CYCLES) ? v.x : (channel == COST_AOV_BVH_NODES) ? v.y : v.z;
+}
+
+float cost_aov_scale(const Image* aov, CostAov channel) {
+    float max_value = 0.0f;
+    for (uint32_t y = 0; y < aov->height; y++) {
+        for (uint32_t x = 0; x < aov->width; x++) {
+            float v = cost_aov_value(aov, channel, x, y);
+            if (v > max_value) max_value = v;
+        }
+    }
+    if (max_value <= 0.0f) return 1.0f;
+
+    // Histogram over [0, max], then walk up to the 99th percentile bin
+    uint32_t* histogram = (uint32_t*)calloc(COST_AOV_HISTOGRAM_BINS, sizeof(uint32_t));
+    if (!histogram) return max_value;
+    float to_bin = (COST_AOV_HISTOGRAM_BINS - 1) / max_value;
+    for (uint32_t y = 0; y < aov->height; y++) {
+        for (uint32_t x = 0; x < aov->width; x++) {
+            float v = cost_aov_value(aov, channel, x, y);
+            histogram[(uint32_t)(v > 0.0f ? v * to_bin : 0.0f)]++;
+        }
+    }
+
+    uint64_t target = (uint64_t)aov->width * aov->height * 99 / 100;
+    uint64_t seen = 0;
+    uint32_t bin = 0;
+    for (; bin < COST_AOV_HISTOGRAM_BINS - 1; bin++) {
+        seen += histogram[bin];
+        if (seen >= target) break;
+    }
+    free(histogram);
+    return (bin + 1) / to_bin;
+}
+
+// Polynomial fit of the turbo colormap (display-encoded RGB)
+static Vec3 turbo(float t) {
+    t = (t < 0.0f) ? 0.0f : (t > 1.0f) ? 1.0f : t;
+    float r = 0.13572138f + t * (4.61539260f + t * (-42.66032258f + t * (132.13108234f +
+              t * (-152.94239396f + t * 59.28637943f))));
+    float g = 0.09140261f + t * (2.19418839f + t * (4.84296658f + t * (-14.18503333f +
+              t * (4.27729857f + t * 2.82956604f))));
+    float b = 0.10667330f + t * (12.64194608f + t * (-60.58204836f + t * (110.36276771f +
+              t * (-89.90310912f + t * 27.34824973f))));
+    return vec3_create(fminf(fmaxf(r, 0.0f), 1.0f), fminf(fmaxf(g, 0.0f), 1.0f),
+                       fminf(fmaxf(b, 0.0f), 1.0f));
+}
+
+void cost_aov_heatmap(const Image* aov, CostAov channel, float scale, Image* out) {
+    float inv_scale = (scale > 0.0f) ? 1.0f / scale : 1.0f;
+    #pragma omp parallel for schedule(static)
+    for (uint32_t y = 0; y < aov->height; y++) {
+        for (uint32_t x = 0; x < aov->width; x++) {
+            image_set_pixel(out, x, y, turbo(cost_aov_value(aov, channel, x, y) * inv_scale));
+        }
+    }
+}
+
+bool cost_aov_save(const Image* aov, CostAov channel, const char* filename) {
+    if (image_filename_is_hdr(filename)) {
+        return image_save(aov, filename, NULL);
+    }
+
+    Image* heat = image_create(aov->width, aov->height);
+    if (!heat) return false;
+    cost_aov_heatmap(aov, channel, cost_aov_scale(aov, channel), heat);
+
+    // Colormap values are already display-ready: quantize without a curve
+    TonemapSettings linear = {TONEMAP_LINEAR, 0.0f, false};
+    bool saved = image_save_bmp(heat, filename, &linear);
+    image_destroy(heat);
+    return saved;
+}
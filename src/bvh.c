@@ -1,4 +1,5 @@
 #include "bvh.h"
+#include "stats.h"
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
@@ -6,7 +7,7 @@
 // Comparison function for qsort
 typedef struct {
     uint32_t axis;
-    const Primitive* primitives;
+    const AABB* bounds;
 } SortContext;
 
 static SortContext sort_ctx;
@@ -15,8 +16,8 @@ static int compare_primitives(const void* a, const void* b) {
     uint32_t idx_a = *(const uint32_t*)a;
     uint32_t idx_b = *(const uint32_t*)b;
 
-    Vec3 center_a = aabb_center(sort_ctx.primitives[idx_a].bounds);
-    Vec3 center_b = aabb_center(sort_ctx.primitives[idx_b].bounds);
+    Vec3 center_a = aabb_center(sort_ctx.bounds[idx_a]);
+    Vec3 center_b = aabb_center(sort_ctx.bounds[idx_b]);
 
     float val_a = ((float*)&center_a)[sort_ctx.axis];
     float val_b = ((float*)&center_b)[sort_ctx.axis];
@@ -36,7 +37,7 @@ SplitCandidate bvh_find_best_split(const BVH* bvh, uint32_t* prim_indices,
         // Compute bounds for this subset
         AABB bounds = aabb_empty();
         for (uint32_t i = start; i < end; i++) {
-            bounds = aabb_union(bounds, bvh->primitives[prim_indices[i]].bounds);
+            bounds = aabb_union(bounds, bvh->bounds[prim_indices[i]]);
         }
 
         float axis_min = ((float*)&bounds.min)[axis];
@@ -55,17 +56,17 @@ SplitCandidate bvh_find_best_split(const BVH* bvh, uint32_t* prim_indices,
 
         // Fill bins
         for (uint32_t i = start; i < end; i++) {
-            Vec3 center = aabb_center(bvh->primitives[prim_indices[i]].bounds);
+            Vec3 center = aabb_center(bvh->bounds[prim_indices[i]]);
             float pos = ((float*)&center)[axis];
             uint32_t bin_idx = (uint32_t)((pos - axis_min) / bin_width);
             if (bin_idx >= num_bins) bin_idx = num_bins - 1;
 
             bins[bin_idx].count++;
             if (bins[bin_idx].count == 1) {
-                bins[bin_idx].bounds = bvh->primitives[prim_indices[i]].bounds;
+                bins[bin_idx].bounds = bvh->bounds[prim_indices[i]];
             } else {
                 bins[bin_idx].bounds = aabb_union(bins[bin_idx].bounds,
-                                                  bvh->primitives[prim_indices[i]].bounds);
+                                                  bvh->bounds[prim_indices[i]]);
             }
         }
 
@@ -121,8 +122,8 @@ SplitCandidate bvh_find_best_split(const BVH* bvh, uint32_t* prim_indices,
 }
 
 // Build BVH recursively
-BVHNode* bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
-                            uint32_t start, uint32_t end, uint32_t* node_idx) {
+uint32_t bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
+                             uint32_t start, uint32_t end, uint32_t* node_idx, uint32_t depth) {
     // TODO: Implementasi recursive BVH construction
     // Hint:
     // 1. Alokasi node baru: BVHNode* node = &bvh->nodes[(*node_idx)++]
@@ -138,23 +139,24 @@ BVHNode* bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
     //    - Recursive build right child: node->right = bvh_build_recursive(...)
     // 5. Return node
 
-    BVHNode* node = &bvh->nodes[(*node_idx)++];
+    uint32_t index = (*node_idx)++;
+    BVHNode* node = &bvh->nodes[index];
 
     // TODO: Hitung bounds untuk node ini
     AABB bounds = aabb_empty();
     for (uint32_t i = start; i < end; i++) {
-        bounds = aabb_union(bounds, bvh->primitives[prim_indices[i]].bounds);
+        bounds = aabb_union(bounds, bvh->bounds[prim_indices[i]]);
     }
     node->bounds = bounds;
 
     uint32_t prim_count = end - start;
 
-    // Leaf node condition: few primitives or small area
-    if (prim_count <= 4) {
+    // Leaf node condition: few primitives, or as deep as traversal's stack allows
+    if (prim_count <= 4 || depth >= BVH_MAX_DEPTH) {
         node->is_leaf = true;
         node->first_prim_idx = start;
         node->prim_count = prim_count;
-        return node;
+        return index;
     }
 
     // Cari best split
@@ -165,12 +167,12 @@ BVHNode* bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
         node->is_leaf = true;
         node->first_prim_idx = start;
         node->prim_count = prim_count;
-        return node;
+        return index;
     }
 
     // Partition primitives
     sort_ctx.axis = split.split_axis;
-    sort_ctx.primitives = bvh->primitives;
+    sort_ctx.bounds = bvh->bounds;
     qsort(prim_indices + start, prim_count, sizeof(uint32_t), compare_primitives);
 
     // Pastikan split membuat progress
@@ -180,20 +182,28 @@ BVHNode* bvh_build_recursive(BVH* bvh, uint32_t* prim_indices,
     }
 
     node->is_leaf = false;
-    node->left = bvh_build_recursive(bvh, prim_indices, start, mid, node_idx);
-    node->right = bvh_build_recursive(bvh, prim_indices, mid, end, node_idx);
+    node->split_axis = (uint8_t)split.split_axis;
+    node->left = bvh_build_recursive(bvh, prim_indices, start, mid, node_idx, depth + 1);
+    node->right = bvh_build_recursive(bvh, prim_indices, mid, end, node_idx, depth + 1);
 
-    return node;
+    return index;
 }
 
-// Create BVH
-BVH* bvh_create(Primitive* primitives, uint32_t count) {
+// The worst case (2N - 1 nodes) is allocated up front; keep only the nodes
+// the build used (children are indices, so nothing needs re-pointing)
+static void bvh_shrink_nodes(BVH* bvh) {
+    BVHNode* nodes = (BVHNode*)realloc(bvh->nodes, bvh->node_count * sizeof(BVHNode));
+    if (nodes) bvh->nodes = nodes;
+}
+
+// Create BVH over bare boxes
+BVH* bvh_create_from_bounds(const AABB* bounds, uint32_t count) {
     BVH* bvh = (BVH*)calloc(1, sizeof(BVH));
-    bvh->primitives = primitives;
     bvh->prim_count = count;
+    if (count == 0) return bvh;
 
     // Allocate nodes (worst case: 2N-1 nodes)
-    bvh->nodes = (BVHNode*)calloc(2 * count - 1, sizeof(BVHNode));
+    bvh->nodes = (BVHNode*)calloc(2 * (size_t)count - 1, sizeof(BVHNode));
     bvh->indices = (uint32_t*)malloc(count * sizeof(uint32_t));
 
     // Initialize indices
@@ -203,36 +213,616 @@ BVH* bvh_create(Primitive* primitives, uint32_t count) {
 
     // Build tree
     uint32_t node_idx = 0;
-    bvh->root = bvh_build_recursive(bvh, bvh->indices, 0, count, &node_idx);
+    bvh->bounds = bounds;
+    bvh_build_recursive(bvh, bvh->indices, 0, count, &node_idx, 0);
     bvh->node_count = node_idx;
+    bvh->bounds = NULL;
+    bvh_shrink_nodes(bvh);
+    bvh->build_cost = bvh_sah_cost(bvh);
 
-    // Reorder primitives according to indices
+    return bvh;
+}
+
+// Reorder primitives according to indices
+static void reorder_primitives(Primitive* primitives, const uint32_t* indices, uint32_t count) {
     Primitive* reordered = (Primitive*)malloc(count * sizeof(Primitive));
     for (uint32_t i = 0; i < count; i++) {
-        reordered[i] = primitives[bvh->indices[i]];
+        reordered[i] = primitives[indices[i]];
     }
     memcpy(primitives, reordered, count * sizeof(Primitive));
     free(reordered);
+}
+
+// Create BVH
+BVH* bvh_create(Primitive* primitives, uint32_t count) {
+    if (count == 0) {
+        BVH* bvh = bvh_create_from_bounds(NULL, 0);
+        bvh->primitives = primitives;
+        return bvh;
+    }
+
+    // Moving primitives are placed by the box they sweep over the shutter
+    AABB* bounds = (AABB*)malloc(count * sizeof(AABB));
+    bool moving = false;
+    for (uint32_t i = 0; i < count; i++) {
+        bounds[i] = primitives[i].bounds;
+        if (primitives[i].moving) {
+            bounds[i] = aabb_union(bounds[i], primitive_end_bounds(&primitives[i]));
+            moving = true;
+        }
+    }
+    BVH* bvh = bvh_create_from_bounds(bounds, count);
+    free(bounds);
+    bvh->primitives = primitives;
+    reorder_primitives(primitives, bvh->indices, count);
+
+    // Then each node gets its shutter-open and shutter-close boxes (if that
+    // allocation fails, the swept boxes still bound every time)
+    if (moving) {
+        bvh->end_bounds = (AABB*)malloc(bvh->node_count * sizeof(AABB));
+        if (bvh->end_bounds) {
+            bvh_refit(bvh);
+            bvh->build_cost = bvh_sah_cost(bvh);
+        }
+    }
+
+    return bvh;
+}
+
+// Spatial-split (SBVH) construction. A reference is an item, or the part of
+// one clipped to a box; every node owns an array of them and hands two new
+// arrays to its children.
+
+#define OBJECT_BINS 12           // As bvh_find_best_split
+#define SPATIAL_BINS 16
+#define SPATIAL_MAX_DEPTH 48     // Deeper nodes split on objects only (down to
+                                 // BVH_MAX_DEPTH), so references stop multiplying
+#define SPATIAL_MIN_OVERLAP 1e-5f  // Child overlap (relative to the root's area)
+                                   // past which a node tries spatial splits
+
+typedef struct {
+    AABB box;
+    uint32_t item;
+} BVHRef;
+
+typedef struct {
+    BVH* bvh;
+    BVHSplitFn split;
+    const void* user;
+    uint32_t* leaf_refs;      // Item per reference, in leaf order
+    uint32_t leaf_ref_count;
+    size_t node_capacity;     // Of bvh->nodes, grown as splits add references
+    float min_overlap;
+} SpatialBuild;
+
+typedef struct {
+    float cost;               // FLT_MAX = none
+    uint32_t axis;
+    uint32_t bin;             // Object splits: first bin of the right child
+    float pos;                // Spatial splits: the plane
+    AABB left, right;
+    uint32_t left_count, right_count;
+} RefSplit;
+
+typedef struct {
+    AABB bounds;
+    uint32_t count;  // Object bins: references; spatial bins: references starting here
+    uint32_t exits;  // Spatial bins: references ending here
+} RefBin;
+
+static inline float axis_value(Vec3 v, uint32_t axis) {
+    return ((float*)&v)[axis];
+}
+
+static inline bool aabb_is_empty(AABB box) {
+    return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z;
+}
+
+static inline AABB aabb_intersect(AABB a, AABB b) {
+    return (AABB){
+        vec3_create(fmaxf(a.min.x, b.min.x), fmaxf(a.min.y, b.min.y), fmaxf(a.min.z, b.min.z)),
+        vec3_create(fminf(a.max.x, b.max.x), fminf(a.max.y, b.max.y), fminf(a.max.z, b.max.z))
+    };
+}
+
+static inline uint32_t bin_index(float value, float axis_min, float bin_width, uint32_t bins) {
+    float bin = (value - axis_min) / bin_width;
+    if (bin <= 0.0f) return 0;
+    return bin >= (float)bins ? bins - 1 : (uint32_t)bin;
+}
+
+// Box split for items that cannot be clipped more tightly
+static void split_box(AABB box, uint32_t axis, float pos, AABB* left, AABB* right) {
+    *left = box;
+    *right = box;
+    float* left_max = &((float*)&left->max)[axis];
+    float* right_min = &((float*)&right->min)[axis];
+    *left_max = fminf(*left_max, pos);
+    *right_min = fmaxf(*right_min, pos);
+}
+
+void triangle_split_bounds(Vec3 v0, Vec3 v1, Vec3 v2, AABB box, uint32_t axis, float pos,
+                           AABB* left, AABB* right) {
+    const Vec3 v[3] = {v0, v1, v2};
+    AABB l = aabb_empty(), r = aabb_empty();
+    for (int i = 0; i < 3; i++) {
+        Vec3 a = v[i], b = v[(i + 1) % 3];
+        float pa = axis_value(a, axis), pb = axis_value(b, axis);
+        if (pa <= pos) l = aabb_expand(l, a);
+        if (pa >= pos) r = aabb_expand(r, a);
+        if ((pa < pos && pb > pos) || (pa > pos && pb < pos)) {
+            // Where the edge crosses the plane belongs to both sides
+            Vec3 p = vec3_lerp(a, b, (pos - pa) / (pb - pa));
+            ((float*)&p)[axis] = pos;
+            l = aabb_expand(l, p);
+            r = aabb_expand(r, p);
+        }
+    }
+    Vec3 epsilon = vec3_create(0.0001f, 0.0001f, 0.0001f);
+    l = (AABB){vec3_sub(l.min, epsilon), vec3_add(l.max, epsilon)};
+    r = (AABB){vec3_sub(r.min, epsilon), vec3_add(r.max, epsilon)};
+    split_box(aabb_intersect(l, box), axis, pos, left, &l);
+    split_box(aabb_intersect(r, box), axis, pos, &r, right);
+}
+
+static void split_primitive(const void* user, uint32_t item, AABB box, uint32_t axis, float pos,
+                            AABB* left, AABB* right) {
+    const Primitive* prim = &((const Primitive*)user)[item];
+    if (prim->type == PRIMITIVE_TRIANGLE) {
+        triangle_split_bounds(prim->triangle.v0, prim->triangle.v1, prim->triangle.v2, box, axis,
+                              pos, left, right);
+    } else {
+        split_box(box, axis, pos, left, right);
+    }
+}
+
+// Binned SAH over reference centroids, scored like bvh_find_best_split
+static RefSplit find_object_split(const BVHRef* refs, uint32_t count, AABB bounds) {
+    RefSplit best = {.cost = FLT_MAX};
+    float parent_area = aabb_surface_area(bounds);
+
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        float axis_min = axis_value(bounds.min, axis);
+        float axis_max = axis_value(bounds.max, axis);
+        if (axis_max - axis_min < 0.0001f) continue;
+        float bin_width = (axis_max - axis_min) / OBJECT_BINS;
+
+        RefBin bins[OBJECT_BINS];
+        for (uint32_t b = 0; b < OBJECT_BINS; b++) bins[b] = (RefBin){aabb_empty(), 0, 0};
+        for (uint32_t i = 0; i < count; i++) {
+            float center = axis_value(aabb_center(refs[i].box), axis);
+            RefBin* bin = &bins[bin_index(center, axis_min, bin_width, OBJECT_BINS)];
+            bin->bounds = aabb_union(bin->bounds, refs[i].box);
+            bin->count++;
+        }
+
+        // Right-hand sums, then a left-to-right sweep over the split planes
+        AABB right_bounds[OBJECT_BINS];
+        uint32_t right_counts[OBJECT_BINS];
+        AABB acc = aabb_empty();
+        uint32_t n = 0;
+        for (uint32_t b = OBJECT_BINS; b-- > 1;) {
+            acc = aabb_union(acc, bins[b].bounds);
+            n += bins[b].count;
+            right_bounds[b] = acc;
+            right_counts[b] = n;
+        }
+        acc = aabb_empty();
+        n = 0;
+        for (uint32_t split = 1; split < OBJECT_BINS; split++) {
+            acc = aabb_union(acc, bins[split - 1].bounds);
+            n += bins[split - 1].count;
+            if (n == 0 || right_counts[split] == 0) continue;
+            float cost = 1.0f + (aabb_surface_area(acc) * n +
+                                 aabb_surface_area(right_bounds[split]) * right_counts[split]) /
+                                parent_area;
+            if (cost < best.cost) {
+                best = (RefSplit){cost, axis, split, 0.0f, acc, right_bounds[split], n,
+                                  right_counts[split]};
+            }
+        }
+    }
+    return best;
+}
+
+// Binned SAH over planes through the node's box: every reference is chopped
+// into the bins it spans, so straddling items count on both sides
+static RefSplit find_spatial_split(const SpatialBuild* build, const BVHRef* refs, uint32_t count,
+                                   AABB bounds) {
+    RefSplit best = {.cost = FLT_MAX};
+    float parent_area = aabb_surface_area(bounds);
+
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        float axis_min = axis_value(bounds.min, axis);
+        float axis_max = axis_value(bounds.max, axis);
+        if (axis_max - axis_min < 0.0001f) continue;
+        float bin_width = (axis_max - axis_min) / SPATIAL_BINS;
+
+        RefBin bins[SPATIAL_BINS];
+        for (uint32_t b = 0; b < SPATIAL_BINS; b++) bins[b] = (RefBin){aabb_empty(), 0, 0};
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t first = bin_index(axis_value(refs[i].box.min, axis), axis_min, bin_width,
+                                       SPATIAL_BINS);
+            uint32_t last = bin_index(axis_value(refs[i].box.max, axis), axis_min, bin_width,
+                                      SPATIAL_BINS);
+            AABB rest = refs[i].box;
+            for (uint32_t b = first; b < last && !aabb_is_empty(rest); b++) {
+                AABB part;
+                build->split(build->user, refs[i].item, rest, axis,
+                             axis_min + (b + 1) * bin_width, &part, &rest);
+                if (!aabb_is_empty(part)) bins[b].bounds = aabb_union(bins[b].bounds, part);
+            }
+            if (!aabb_is_empty(rest)) bins[last].bounds = aabb_union(bins[last].bounds, rest);
+            bins[first].count++;
+            bins[last].exits++;
+        }
+
+        AABB right_bounds[SPATIAL_BINS];
+        uint32_t right_counts[SPATIAL_BINS];
+        AABB acc = aabb_empty();
+        uint32_t n = 0;
+        for (uint32_t b = SPATIAL_BINS; b-- > 1;) {
+            acc = aabb_union(acc, bins[b].bounds);
+            n += bins[b].exits;
+            right_bounds[b] = acc;
+            right_counts[b] = n;
+        }
+        acc = aabb_empty();
+        n = 0;
+        for (uint32_t split = 1; split < SPATIAL_BINS; split++) {
+            acc = aabb_union(acc, bins[split - 1].bounds);
+            n += bins[split - 1].count;
+            // A side holding every reference would not make progress
+            if (n == 0 || right_counts[split] == 0 || n == count || right_counts[split] == count) {
+                continue;
+            }
+            float cost = 1.0f + (aabb_surface_area(acc) * n +
+                                 aabb_surface_area(right_bounds[split]) * right_counts[split]) /
+                                parent_area;
+            if (cost < best.cost) {
+                best = (RefSplit){cost, axis, split, axis_min + split * bin_width, acc,
+                                  right_bounds[split], n, right_counts[split]};
+            }
+        }
+    }
+    return best;
+}
+
+static void partition_object(const BVHRef* refs, uint32_t count, AABB bounds, const RefSplit* split,
+                             BVHRef* left, uint32_t* left_count, BVHRef* right,
+                             uint32_t* right_count) {
+    float axis_min = axis_value(bounds.min, split->axis);
+    float bin_width = (axis_value(bounds.max, split->axis) - axis_min) / OBJECT_BINS;
+    for (uint32_t i = 0; i < count; i++) {
+        float center = axis_value(aabb_center(refs[i].box), split->axis);
+        if (bin_index(center, axis_min, bin_width, OBJECT_BINS) < split->bin) {
+            left[(*left_count)++] = refs[i];
+        } else {
+            right[(*right_count)++] = refs[i];
+        }
+    }
+}
+
+// Straddling references are split in two, unless moving one whole to a side
+// is cheaper (reference unsplitting) or the node's `spare` references are
+// spent; returns the references added
+static uint32_t partition_spatial(const SpatialBuild* build, const BVHRef* refs, uint32_t count,
+                                  uint32_t spare, const RefSplit* split, BVHRef* left,
+                                  uint32_t* left_count, BVHRef* right, uint32_t* right_count) {
+    uint32_t added = 0;
+    AABB left_bounds = split->left, right_bounds = split->right;
+    float left_n = (float)split->left_count, right_n = (float)split->right_count;
+    for (uint32_t i = 0; i < count; i++) {
+        const BVHRef* ref = &refs[i];
+        if (axis_value(ref->box.max, split->axis) <= split->pos) {
+            left[(*left_count)++] = *ref;
+            continue;
+        }
+        if (axis_value(ref->box.min, split->axis) >= split->pos) {
+            right[(*right_count)++] = *ref;
+            continue;
+        }
+
+        float left_area = aabb_surface_area(left_bounds);
+        float right_area = aabb_surface_area(right_bounds);
+        float split_cost = left_area * left_n + right_area * right_n;
+        float left_cost = aabb_surface_area(aabb_union(left_bounds, ref->box)) * left_n +
+                          right_area * (right_n - 1.0f);
+        float right_cost = left_area * (left_n - 1.0f) +
+                           aabb_surface_area(aabb_union(right_bounds, ref->box)) * right_n;
+        AABB left_part = aabb_empty(), right_part = aabb_empty();
+        if (added < spare && split_cost <= left_cost &&
+            split_cost <= right_cost) {
+            build->split(build->user, ref->item, ref->box, split->axis, split->pos, &left_part,
+                         &right_part);
+        }
+        if (!aabb_is_empty(left_part) && !aabb_is_empty(right_part)) {
+            left[(*left_count)++] = (BVHRef){left_part, ref->item};
+            right[(*right_count)++] = (BVHRef){right_part, ref->item};
+            added++;
+        } else if (aabb_is_empty(right_part) &&
+                   (!aabb_is_empty(left_part) || left_cost <= right_cost)) {
+            left[(*left_count)++] = *ref;
+            left_bounds = aabb_union(left_bounds, ref->box);
+            right_n -= 1.0f;
+        } else {
+            right[(*right_count)++] = *ref;
+            right_bounds = aabb_union(right_bounds, ref->box);
+            left_n -= 1.0f;
+        }
+    }
+    return added;
+}
+
+static void make_ref_leaf(SpatialBuild* build, BVHNode* node, BVHRef* refs, uint32_t count) {
+    node->is_leaf = true;
+    node->first_prim_idx = build->leaf_ref_count;
+    node->prim_count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        build->leaf_refs[build->leaf_ref_count++] = refs[i].item;
+    }
+    free(refs);
+}
+
+// Room for a node's two children, growing the node array by half when full
+static bool reserve_child_nodes(SpatialBuild* build) {
+    BVH* bvh = build->bvh;
+    if (bvh->node_count + 2 <= build->node_capacity) return true;
+    size_t capacity = build->node_capacity + build->node_capacity / 2 + 2;
+    BVHNode* nodes = (BVHNode*)realloc(bvh->nodes, capacity * sizeof(BVHNode));
+    if (!nodes) return false;
+    bvh->nodes = nodes;
+    build->node_capacity = capacity;
+    return true;
+}
+
+// Build the subtree over `refs` (taking ownership), adding at most `spare`
+// references; returns its root node. Children share what is left in
+// proportion to their sizes, so the first subtrees built cannot spend the
+// whole budget.
+static uint32_t build_spatial_recursive(SpatialBuild* build, BVHRef* refs, uint32_t count,
+                                        uint32_t spare, uint32_t depth) {
+    BVH* bvh = build->bvh;
+    uint32_t index = bvh->node_count++;
+    BVHNode* node = &bvh->nodes[index];
+    memset(node, 0, sizeof(*node));
+
+    AABB bounds = aabb_empty();
+    for (uint32_t i = 0; i < count; i++) {
+        bounds = aabb_union(bounds, refs[i].box);
+    }
+    node->bounds = bounds;
 
+    // Leaf node condition as bvh_build_recursive (or no memory for children)
+    if (count <= 4 || depth >= BVH_MAX_DEPTH || !reserve_child_nodes(build)) {
+        make_ref_leaf(build, node, refs, count);
+        return index;
+    }
+
+    RefSplit split = find_object_split(refs, count, bounds);
+    bool spatial = false;
+    if (depth < SPATIAL_MAX_DEPTH && spare > 0) {
+        AABB overlap = aabb_intersect(split.left, split.right);
+        if (split.cost == FLT_MAX ||
+            (!aabb_is_empty(overlap) && aabb_surface_area(overlap) > build->min_overlap)) {
+            RefSplit candidate = find_spatial_split(build, refs, count, bounds);
+            if (candidate.cost < split.cost) {
+                split = candidate;
+                spatial = true;
+            }
+        }
+    }
+    if (split.cost == FLT_MAX) {
+        make_ref_leaf(build, node, refs, count);
+        return index;
+    }
+
+    BVHRef* left = (BVHRef*)malloc(count * sizeof(BVHRef));
+    BVHRef* right = (BVHRef*)malloc(count * sizeof(BVHRef));
+    if (!left || !right) {
+        free(left);
+        free(right);
+        make_ref_leaf(build, node, refs, count);
+        return index;
+    }
+    uint32_t left_count = 0, right_count = 0;
+    if (spatial) {
+        // Float rounding can still empty a side; fall back to the object split
+        uint32_t added = partition_spatial(build, refs, count, spare, &split, left, &left_count,
+                                           right, &right_count);
+        spare -= added;
+        if (left_count == 0 || right_count == 0 || left_count == count || right_count == count) {
+            spare += added;
+            left_count = right_count = 0;
+            split = find_object_split(refs, count, bounds);
+            spatial = false;
+        }
+    }
+    if (!spatial) {
+        if (split.cost == FLT_MAX) {
+            free(left);
+            free(right);
+            make_ref_leaf(build, node, refs, count);
+            return index;
+        }
+        partition_object(refs, count, bounds, &split, left, &left_count, right, &right_count);
+    }
+    free(refs);
+
+    node->is_leaf = false;
+    node->split_axis = (uint8_t)split.axis;
+    uint32_t left_spare = (uint32_t)((uint64_t)spare * left_count / (left_count + right_count));
+    uint32_t left_index = build_spatial_recursive(build, left, left_count, left_spare, depth + 1);
+    uint32_t right_index = build_spatial_recursive(build, right, right_count, spare - left_spare,
+                                                   depth + 1);
+    bvh->nodes[index].left = left_index;
+    bvh->nodes[index].right = right_index;
+    return index;
+}
+
+BVH* bvh_create_from_bounds_spatial(const AABB* bounds, uint32_t count, float budget,
+                                    BVHSplitFn split, const void* user) {
+    if (count == 0 || !(budget > 1.0f)) return bvh_create_from_bounds(bounds, count);
+
+    double limit = (double)count * budget;
+    uint32_t ref_limit = limit < (double)(UINT32_MAX / 2) ? (uint32_t)limit : UINT32_MAX / 2;
+    // Nodes start with room for a tree without splits and grow on demand
+    size_t node_capacity = 2 * (size_t)count - 1;
+    BVH* bvh = (BVH*)calloc(1, sizeof(BVH));
+    BVHRef* refs = (BVHRef*)malloc(count * sizeof(BVHRef));
+    uint32_t* leaf_refs = (uint32_t*)malloc((size_t)ref_limit * sizeof(uint32_t));
+    uint32_t* position = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (bvh) {
+        bvh->nodes = (BVHNode*)malloc(node_capacity * sizeof(BVHNode));
+        bvh->indices = (uint32_t*)malloc(count * sizeof(uint32_t));
+    }
+    if (!bvh || !refs || !leaf_refs || !position || !bvh->nodes || !bvh->indices) {
+        fprintf(stderr, "Out of memory for a spatial-split BVH over %u items; "
+                        "using object splits\n", count);
+        if (bvh) {
+            free(bvh->nodes);
+            free(bvh->indices);
+            free(bvh);
+        }
+        free(refs);
+        free(leaf_refs);
+        free(position);
+        return bvh_create_from_bounds(bounds, count);
+    }
+    bvh->prim_count = count;
+
+    AABB root = aabb_empty();
+    for (uint32_t i = 0; i < count; i++) {
+        refs[i] = (BVHRef){bounds[i], i};
+        root = aabb_union(root, bounds[i]);
+    }
+    SpatialBuild build = {bvh, split, user, leaf_refs, 0, node_capacity,
+                          SPATIAL_MIN_OVERLAP * aabb_surface_area(root)};
+    build_spatial_recursive(&build, refs, count, ref_limit - count, 0);
+
+    // Items take the order of their first reference, and the references
+    // become positions in that order
+    for (uint32_t i = 0; i < count; i++) position[i] = UINT32_MAX;
+    uint32_t placed = 0;
+    for (uint32_t r = 0; r < build.leaf_ref_count; r++) {
+        uint32_t item = leaf_refs[r];
+        if (position[item] == UINT32_MAX) {
+            position[item] = placed;
+            bvh->indices[placed++] = item;
+        }
+        leaf_refs[r] = position[item];
+    }
+    assert(placed == count);
+    free(position);
+
+    bvh->ref_count = build.leaf_ref_count;
+    uint32_t* refs_used = (uint32_t*)realloc(leaf_refs, bvh->ref_count * sizeof(uint32_t));
+    bvh->refs = refs_used ? refs_used : leaf_refs;
+    bvh_shrink_nodes(bvh);
+    bvh->build_cost = bvh_sah_cost(bvh);
+    return bvh;
+}
+
+BVH* bvh_create_spatial(Primitive* primitives, uint32_t count, float budget) {
+    // Swept boxes cannot be clipped at one time; moving scenes split on objects
+    bool moving = false;
+    for (uint32_t i = 0; i < count && !moving; i++) moving = primitives[i].moving;
+    AABB* bounds = NULL;
+    if (!moving && count > 0 && budget > 1.0f) {
+        bounds = (AABB*)malloc(count * sizeof(AABB));
+        if (!bounds) {
+            fprintf(stderr, "Out of memory for a spatial-split BVH over %u primitives; "
+                            "using object splits\n", count);
+        }
+    }
+    if (!bounds) return bvh_create(primitives, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        bounds[i] = primitives[i].bounds;
+    }
+    BVH* bvh = bvh_create_from_bounds_spatial(bounds, count, budget, split_primitive, primitives);
+    free(bounds);
+    bvh->primitives = primitives;
+    reorder_primitives(primitives, bvh->indices, count);
     return bvh;
 }
 
 // Destroy BVH
 void bvh_destroy(BVH* bvh) {
     if (bvh) {
-        free(bvh->nodes);
-        free(bvh->indices);
+        if (!bvh->borrowed) {
+            free(bvh->nodes);
+            free(bvh->indices);
+            free(bvh->refs);
+        }
+        free(bvh->end_bounds);
         free(bvh);
     }
 }
 
-// BVH traversal (iterative for performance)
-bool bvh_hit(const BVH* bvh, const Ray* ray, float t_min, float t_max,
-             HitRecord* rec) {
+// Children follow their parent, so a reverse sweep sees both children of a
+// node before the node itself
+void bvh_refit(BVH* bvh) {
+    if (!bvh->primitives) return;
+    BVHNode* nodes = bvh->nodes;
+    AABB* end_bounds = bvh->end_bounds;
+    const uint32_t* refs = bvh->refs;
+    for (uint32_t i = bvh->node_count; i-- > 0;) {
+        BVHNode* node = &nodes[i];
+        if (node->is_leaf) {
+            AABB bounds = aabb_empty(), end = aabb_empty();
+            for (uint32_t k = 0; k < node->prim_count; k++) {
+                uint32_t idx = node->first_prim_idx + k;
+                const Primitive* prim = &bvh->primitives[refs ? refs[idx] : idx];
+                bounds = aabb_union(bounds, prim->bounds);
+                if (end_bounds) end = aabb_union(end, primitive_end_bounds(prim));
+            }
+            node->bounds = bounds;
+            if (end_bounds) end_bounds[i] = end;
+        } else {
+            node->bounds = aabb_union(nodes[node->left].bounds, nodes[node->right].bounds);
+            if (end_bounds) end_bounds[i] = aabb_union(end_bounds[node->left], end_bounds[node->right]);
+        }
+    }
+}
+
+float bvh_sah_cost(const BVH* bvh) {
+    uint32_t internal = bvh->node_count / 2;
+    if (internal == 0) return 0.0f;
+    uint32_t* counts = (uint32_t*)malloc(bvh->node_count * sizeof(uint32_t));
+    if (!counts) return 0.0f;
+
+    // Primitives under each node, children first (see bvh_refit)
+    double total = 0.0, weight = 0.0;
+    for (uint32_t i = bvh->node_count; i-- > 0;) {
+        const BVHNode* node = &bvh->nodes[i];
+        if (node->is_leaf) {
+            counts[i] = node->prim_count;
+            continue;
+        }
+        counts[i] = counts[node->left] + counts[node->right];
+        float area = aabb_surface_area(node->bounds);
+        if (area > 0.0f) {
+            float left = aabb_surface_area(bvh->nodes[node->left].bounds) * counts[node->left];
+            float right = aabb_surface_area(bvh->nodes[node->right].bounds) * counts[node->right];
+            total += (left + right) / area;
+            weight += counts[i];
+        }
+    }
+    free(counts);
+    return weight > 0.0 ? (float)(total / weight) : 0.0f;
+}
+
+// BVH traversal (iterative for performance). Inlined once with end_bounds
+// and refs NULL, so static object-split trees pay nothing for motion blur or
+// spatial splits.
+static inline __attribute__((always_inline))
+bool bvh_traverse(const BVH* bvh, const AABB* end_bounds, const uint32_t* refs, const Ray* ray,
+                  float t_min, float t_max, HitRecord* rec) {
     // TODO: Implementasi BVH traversal algorithm
     // Hint:
     // 1. Gunakan stack untuk iterative traversal (sudah disediakan)
-    // 2. Start dengan root node: stack[stack_ptr++] = bvh->root
+    // 2. Start dengan root node: stack[stack_ptr++] = 0 (root)
     // 3. Loop selama stack tidak kosong:
     //    a. Pop node dari stack
     //    b. Test AABB intersection dengan aabb_hit()
@@ -244,37 +834,64 @@ bool bvh_hit(const BVH* bvh, const Ray* ray, float t_min, float t_max,
     // 4. Return true jika ada hit
 
     // Stack untuk iterative traversal (jangan diubah)
-    BVHNode* stack[64];
+    uint32_t stack[BVH_STACK_SIZE];
     int stack_ptr = 0;
 
     bool hit_anything = false;
     float closest_so_far = t_max;
+    uint32_t visited = 0;
 
     // TODO: Implementasi traversal algorithm di sini
-    stack[stack_ptr++] = bvh->root;
+    if (bvh->node_count == 0) return false;
+    const BVHNode* nodes = bvh->nodes;
+    stack[stack_ptr++] = 0;
 
     while (stack_ptr > 0) {
-        BVHNode* node = stack[--stack_ptr];
-
-        // Cek AABB intersection
-        if (!aabb_hit(&node->bounds, ray, t_min, closest_so_far)) {
+        uint32_t index = stack[--stack_ptr];
+        const BVHNode* node = &nodes[index];
+        visited++;
+
+        // Cek AABB intersection (at the ray's time when primitives move)
+        const AABB* box = &node->bounds;
+        AABB moved;
+        if (end_bounds) {
+            moved = aabb_lerp(node->bounds, end_bounds[index], ray->time);
+            box = &moved;
+        }
+        if (!aabb_hit(box, ray, t_min, closest_so_far)) {
             continue;
         }
+        STATS_COUNT(aabb_hits);
 
         if (node->is_leaf) {
+            STATS_COUNT(leaf_visits);
             // Test all primitives in leaf
             for (uint32_t i = 0; i < node->prim_count; i++) {
                 uint32_t idx = node->first_prim_idx + i;
+                if (refs) idx = refs[idx];
                 if (primitive_hit(&bvh->primitives[idx], ray, t_min, closest_so_far, rec)) {
                     hit_anything = true;
                     closest_so_far = rec->t;
                 }
             }
+        } else if (((const float*)&ray->direction)[node->split_axis] < 0.0f) {
+            // Near child on top, so its hits can cull the far one
+            stack[stack_ptr++] = node->left;
+            stack[stack_ptr++] = node->right;
         } else {
             stack[stack_ptr++] = node->right;
             stack[stack_ptr++] = node->left;
         }
     }
 
+    render_thread_counters.bvh_nodes += visited;
+    STATS_ADD(aabb_tests, visited);
     return hit_anything;
-}
\ No newline at end of file
+}
+
+bool bvh_hit(const BVH* bvh, const Ray* ray, float t_min, float t_max,
+             HitRecord* rec) {
+    if (bvh->end_bounds) return bvh_traverse(bvh, bvh->end_bounds, bvh->refs, ray, t_min, t_max, rec);
+    if (bvh->refs) return bvh_traverse(bvh, NULL, bvh->refs, ray, t_min, t_max, rec);
+    return bvh_traverse(bvh, NULL, NULL, ray, t_min, t_max, rec);
+}
@@ -1,10 +1,10 @@
 #include "gui.h"
 #include "scenes.h"
+#include "scene_file.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <sys/time.h>
 
 // Global app pointer for callbacks
 static GuiApp* g_app = NULL;
@@ -16,15 +16,6 @@ typedef struct {
     double render_time;
 } RenderCompleteData;
 
-// Progress callback for pathtracer
-void render_progress_callback(float progress) {
-    if (g_app) {
-        pthread_mutex_lock(&g_app->render_mutex);
-        g_app->render_progress = progress;
-        pthread_mutex_unlock(&g_app->render_mutex);
-    }
-}
-
 // GUI update function called on main thread after render completes
 gboolean render_complete_update_gui(gpointer user_data) {
     RenderCompleteData* data = (RenderCompleteData*)user_data;
@@ -38,8 +29,14 @@ gboolean render_complete_update_gui(gpointer user_data) {
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 1.0);
     gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->progress_bar), "100%");
 
-    // Update image display
-    update_image_display(app);
+    // Pick up the tiles finished since the last timer tick; heatmaps are
+    // normalized over the whole frame, so they are drawn once at the end
+    if (app->view == 0 && !app->display_stale) {
+        update_dirty_tiles(app);
+    } else {
+        update_image_display(app);
+        app->display_stale = false;
+    }
 
     // Free the data
     free(data);
@@ -88,12 +85,15 @@ GuiApp* gui_app_create(void) {
     // Scene selection
     gtk_grid_attach(GTK_GRID(control_grid), gtk_label_new("Scene:"), 0, row, 1, 1);
     app->scene_combo = gtk_combo_box_text_new();
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Cornell Box");
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Random Spheres");
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Glass Spheres");
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Metal Spheres");
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Studio Lighting");
-    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), "Material Blending");
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), SCENE_NAMES[i]);
+    }
+    uint32_t file_count;
+    char** scene_files = scene_file_list("scenes", &file_count);
+    for (uint32_t i = 0; i < file_count; i++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->scene_combo), scene_files[i]);
+    }
+    scene_file_list_free(scene_files, file_count);
     gtk_combo_box_set_active(GTK_COMBO_BOX(app->scene_combo), 0);
     gtk_grid_attach(GTK_GRID(control_grid), app->scene_combo, 1, row++, 1, 1);
 
@@ -124,6 +124,42 @@ GuiApp* gui_app_create(void) {
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->threads_spin), 8);
     gtk_grid_attach(GTK_GRID(control_grid), app->threads_spin, 1, row++, 1, 1);
 
+    gtk_grid_attach(GTK_GRID(control_grid), gtk_label_new("Sampler:"), 0, row, 1, 1);
+    app->sampler_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->sampler_combo), "Random");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->sampler_combo), "Stratified");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->sampler_combo), "Sobol (Owen)");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->sampler_combo), "Blue Noise");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(app->sampler_combo), SAMPLER_RANDOM);
+    gtk_grid_attach(GTK_GRID(control_grid), app->sampler_combo, 1, row++, 1, 1);
+
+    // Display controls (re-tonemap the last render, no re-render needed)
+    gtk_grid_attach(GTK_GRID(control_grid), gtk_label_new("Tonemap:"), 0, row, 1, 1);
+    app->tonemap_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->tonemap_combo), "ACES");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->tonemap_combo), "Reinhard");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->tonemap_combo), "Linear");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(app->tonemap_combo), TONEMAP_ACES);
+    gtk_grid_attach(GTK_GRID(control_grid), app->tonemap_combo, 1, row++, 1, 1);
+
+    gtk_grid_attach(GTK_GRID(control_grid), gtk_label_new("Exposure (EV):"), 0, row, 1, 1);
+    app->exposure_spin = gtk_spin_button_new_with_range(-8.0, 8.0, 0.5);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->exposure_spin), 0.0);
+    gtk_grid_attach(GTK_GRID(control_grid), app->exposure_spin, 1, row++, 1, 1);
+
+    app->srgb_check = gtk_check_button_new_with_label("sRGB output");
+    gtk_grid_attach(GTK_GRID(control_grid), app->srgb_check, 1, row++, 1, 1);
+
+    // Beauty or a per-pixel cost heatmap (index 1 + CostAov)
+    gtk_grid_attach(GTK_GRID(control_grid), gtk_label_new("View:"), 0, row, 1, 1);
+    app->view_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->view_combo), "Beauty");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->view_combo), "Cost: CPU cycles");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->view_combo), "Cost: BVH nodes");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->view_combo), "Cost: path length");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(app->view_combo), 0);
+    gtk_grid_attach(GTK_GRID(control_grid), app->view_combo, 1, row++, 1, 1);
+
     // Separator
     gtk_grid_attach(GTK_GRID(control_grid), gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), 0, row++, 2, 1);
 
@@ -165,14 +201,19 @@ GuiApp* gui_app_create(void) {
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_container_add(GTK_CONTAINER(image_frame), app->image_scroll);
 
-    app->image_widget = gtk_image_new();
-    gtk_container_add(GTK_CONTAINER(app->image_scroll), app->image_widget);
+    app->display_area = gtk_drawing_area_new();
+    gtk_container_add(GTK_CONTAINER(app->image_scroll), app->display_area);
 
     // Connect signals
     g_signal_connect(app->window, "destroy", G_CALLBACK(on_window_destroy), app);
     g_signal_connect(app->render_button, "clicked", G_CALLBACK(on_render_clicked), app);
     g_signal_connect(app->save_button, "clicked", G_CALLBACK(on_save_clicked), app);
+    g_signal_connect(app->display_area, "draw", G_CALLBACK(on_display_draw), app);
     g_signal_connect(app->scene_combo, "changed", G_CALLBACK(on_scene_changed), app);
+    g_signal_connect(app->tonemap_combo, "changed", G_CALLBACK(on_tonemap_changed), app);
+    g_signal_connect(app->exposure_spin, "value-changed", G_CALLBACK(on_tonemap_changed), app);
+    g_signal_connect(app->srgb_check, "toggled", G_CALLBACK(on_tonemap_changed), app);
+    g_signal_connect(app->view_combo, "changed", G_CALLBACK(on_tonemap_changed), app);
 
     // Initialize render settings
     app->settings.width = 800;
@@ -182,9 +223,9 @@ GuiApp* gui_app_create(void) {
     app->settings.num_threads = 8;
     app->settings.use_bvh = true;
     app->settings.use_nee = false;
-
-    // Set progress callback
-    set_progress_callback(render_progress_callback);
+    app->settings.seed = 42;
+    app->settings.sampler = SAMPLER_RANDOM;
+    app->tonemap = tonemap_default();
 
     return app;
 }
@@ -195,7 +236,11 @@ void gui_app_destroy(GuiApp* app) {
         if (app->scene) scene_destroy(app->scene);
         if (app->camera) free(app->camera);
         if (app->render_image) image_destroy(app->render_image);
-        if (app->display_pixbuf) g_object_unref(app->display_pixbuf);
+        if (app->cost_aov) image_destroy(app->cost_aov);
+        if (app->dirty_tiles) tile_dirty_map_destroy(app->dirty_tiles);
+        accumulator_destroy(app->accum);
+        render_stats_destroy(app->stats);
+        if (app->display_surface) cairo_surface_destroy(app->display_surface);
         pthread_mutex_destroy(&app->render_mutex);
         free(app);
         g_app = NULL;
@@ -208,133 +253,89 @@ void gui_app_run(GuiApp* app) {
     gtk_main();
 }
 
-// Convert Image to GdkPixbuf for display
-GdkPixbuf* image_to_pixbuf(const Image* img) {
-    if (!img || !img->pixels) return NULL;
-
-    GdkPixbuf* pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8,
-                                        img->width, img->height);
-    if (!pixbuf) return NULL;
-
-    guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
-    int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
-
-    for (uint32_t y = 0; y < img->height; y++) {
-        for (uint32_t x = 0; x < img->width; x++) {
-            Vec3 color = img->pixels[y * img->width + x];
-
-            // Apply ACES tone mapping
-            color = aces_tonemap(color);
-
-            // Clamp values
-            color.x = fminf(fmaxf(color.x, 0.0f), 1.0f);
-            color.y = fminf(fmaxf(color.y, 0.0f), 1.0f);
-            color.z = fminf(fmaxf(color.z, 0.0f), 1.0f);
-
-            // Convert to 8-bit RGB
-            guchar* p = pixels + y * rowstride + x * 3;
-            p[0] = (guchar)(color.x * 255.99f);
-            p[1] = (guchar)(color.y * 255.99f);
-            p[2] = (guchar)(color.z * 255.99f);
-        }
+// Match the display surface to the render image. Cairo zero-fills new
+// surfaces, so unrendered tiles show black until they are flushed.
+static void ensure_display_surface(GuiApp* app) {
+    const Image* img = app->render_image;
+    if (app->display_surface &&
+        (uint32_t)cairo_image_surface_get_width(app->display_surface) == img->width &&
+        (uint32_t)cairo_image_surface_get_height(app->display_surface) == img->height) {
+        return;
     }
-
-    return pixbuf;
+    if (app->display_surface) cairo_surface_destroy(app->display_surface);
+    app->display_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, img->width, img->height);
+    gtk_widget_set_size_request(app->display_area, img->width, img->height);
 }
 
 // Update image display
 void update_image_display(GuiApp* app) {
-    if (app->render_image) {
-        if (app->display_pixbuf) {
-            g_object_unref(app->display_pixbuf);
-            app->display_pixbuf = NULL;
-        }
-        app->display_pixbuf = image_to_pixbuf(app->render_image);
-        if (app->display_pixbuf) {
-            gtk_image_set_from_pixbuf(GTK_IMAGE(app->image_widget), app->display_pixbuf);
+    if (!app->render_image) return;
+    ensure_display_surface(app);
+
+    unsigned char* pixels = cairo_image_surface_get_data(app->display_surface);
+    size_t stride = (size_t)cairo_image_surface_get_stride(app->display_surface);
+    cairo_surface_flush(app->display_surface);
+
+    if (app->view > 0 && app->cost_aov) {
+        // Cost heatmap: colormap values are display-ready, quantize them as-is
+        // (without memory for it, the surface keeps what it showed)
+        CostAov channel = (CostAov)(app->view - 1);
+        Image* heat = image_create(app->cost_aov->width, app->cost_aov->height);
+        if (heat) {
+            cost_aov_heatmap(app->cost_aov, channel, cost_aov_scale(app->cost_aov, channel), heat);
+            TonemapSettings linear = {TONEMAP_LINEAR, 0.0f, false};
+            tonemap_rows(&linear, heat, 0, heat->height, pixels, stride, PIXEL_LAYOUT_BGRX8);
+            image_destroy(heat);
         }
+    } else {
+        // Shared tonemap kernel, rows in parallel, straight into the surface
+        tonemap_rows(&app->tonemap, app->render_image, 0, app->render_image->height,
+                     pixels, stride, PIXEL_LAYOUT_BGRX8);
     }
+    cairo_surface_mark_dirty(app->display_surface);
+    gtk_widget_queue_draw(app->display_area);
 }
 
-// Create scene based on selection
-static Scene* create_scene(const char* name) {
-    if (strcmp(name, "Cornell Box") == 0) {
-        return create_cornell_box();
-    } else if (strcmp(name, "Random Spheres") == 0) {
-        return create_random_spheres();
-    } else if (strcmp(name, "Glass Spheres") == 0) {
-        return create_glass_spheres();
-    } else if (strcmp(name, "Metal Spheres") == 0) {
-        return create_metal_spheres();
-    } else if (strcmp(name, "Studio Lighting") == 0) {
-        return create_studio_lighting();
-    } else if (strcmp(name, "Material Blending") == 0) {
-        return create_material_blend();
+// Tonemap only the tiles the renderer finished since the last call and
+// invalidate just those rectangles. Returns the number of tiles refreshed.
+guint update_dirty_tiles(GuiApp* app) {
+    TileDirtyMap* map = app->dirty_tiles;
+    const Image* img = app->render_image;
+    if (!map || !img) return 0;
+    ensure_display_surface(app);
+
+    unsigned char* pixels = cairo_image_surface_get_data(app->display_surface);
+    size_t stride = (size_t)cairo_image_surface_get_stride(app->display_surface);
+    guint refreshed = 0;
+
+    cairo_surface_flush(app->display_surface);
+    for (uint32_t tile = 0; tile < map->tiles_x * map->tiles_y; tile++) {
+        if (!tile_dirty_map_take(map, tile)) continue;
+
+        uint32_t x0 = (tile % map->tiles_x) * RENDER_TILE_SIZE;
+        uint32_t y0 = (tile / map->tiles_x) * RENDER_TILE_SIZE;
+        uint32_t x1 = (x0 + RENDER_TILE_SIZE < img->width) ? x0 + RENDER_TILE_SIZE : img->width;
+        uint32_t y1 = (y0 + RENDER_TILE_SIZE < img->height) ? y0 + RENDER_TILE_SIZE : img->height;
+
+        tonemap_rect(&app->tonemap, img, x0, y0, x1, y1,
+                     pixels + (size_t)y0 * stride + (size_t)x0 * 4, stride, PIXEL_LAYOUT_BGRX8);
+        cairo_surface_mark_dirty_rectangle(app->display_surface, x0, y0, x1 - x0, y1 - y0);
+        gtk_widget_queue_draw_area(app->display_area, x0, y0, x1 - x0, y1 - y0);
+        refreshed++;
     }
-
-    return create_cornell_box();
+    return refreshed;
 }
 
-// Create camera for scene
-static Camera* create_camera_for_scene(const char* name, float aspect) {
-    Camera* cam = (Camera*)malloc(sizeof(Camera));
-
-    if (strcmp(name, "Cornell Box") == 0) {
-        *cam = camera_create(
-            vec3_create(278, 278, -800),
-            vec3_create(278, 278, 0),
-            vec3_create(0, 1, 0),
-            40.0f, aspect, 0.0f, 10.0f
-        );
-    } else if (strcmp(name, "Random Spheres") == 0) {
-        // Wide angle view to capture the random field with hero spheres
-        *cam = camera_create(
-            vec3_create(13, 2, 3),
-            vec3_create(0, 0.5f, 0),
-            vec3_create(0, 1, 0),
-            20.0f, aspect, 0.1f, 10.0f
-        );
-    } else if (strcmp(name, "Glass Spheres") == 0) {
-        // Elevated view to see the 7x7 grid pattern
-        *cam = camera_create(
-            vec3_create(-8, 6, 8),
-            vec3_create(0, 1, 0),
-            vec3_create(0, 1, 0),
-            45.0f, aspect, 0.0f, 15.0f
-        );
-    } else if (strcmp(name, "Metal Spheres") == 0) {
-        // Side view to showcase the metallic lineup and reflections
-        *cam = camera_create(
-            vec3_create(0, 2.5f, -10),
-            vec3_create(0, 1, 0),
-            vec3_create(0, 1, 0),
-            50.0f, aspect, 0.0f, 10.0f
-        );
-    } else if (strcmp(name, "Studio Lighting") == 0) {
-        *cam = camera_create(
-            vec3_create(0, 2, 8),
-            vec3_create(0, 1, -2),
-            vec3_create(0, 1, 0),
-            40.0f, aspect, 0.05f, 10.0f
-        );
-    } else if (strcmp(name, "Material Blending") == 0) {
-        *cam = camera_create(
-            vec3_create(0, 2, 10),
-            vec3_create(0, 1, 0),
-            vec3_create(0, 1, 0),
-            45.0f, aspect, 0.1f, 12.0f
-        );
-    } else {
-        // Default camera for any future scenes
-        *cam = camera_create(
-            vec3_create(13, 2, 3),
-            vec3_create(0, 0, 0),
-            vec3_create(0, 1, 0),
-            20.0f, aspect, 0.1f, 10.0f
-        );
-    }
+// Paint the persistent surface; GTK clips to the invalidated area
+gboolean on_display_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data) {
+    (void)widget; // Suppress unused parameter warning
+    GuiApp* app = (GuiApp*)user_data;
 
-    return cam;
+    if (app->display_surface) {
+        cairo_set_source_surface(cr, app->display_surface, 0, 0);
+        cairo_paint(cr);
+    }
+    return FALSE;
 }
 
 // Rendering thread function
@@ -349,28 +350,19 @@ void* render_thread_func(void* user_data) {
     // Set cancel flag pointer for render cancellation
     settings.cancel_flag = &app->cancel_render;
 
-    // Create or resize image
-    if (app->render_image) {
-        if (app->render_image->width != settings.width ||
-            app->render_image->height != settings.height) {
-            image_destroy(app->render_image);
-            app->render_image = image_create(settings.width, settings.height);
-        }
-    } else {
-        app->render_image = image_create(settings.width, settings.height);
-    }
-
-    // Start timer (wall clock time, not CPU time)
-    struct timeval start_time, end_time;
-    gettimeofday(&start_time, NULL);
+    // Finished tiles are flagged for the display timer, and the timer polls
+    // the stats channel for progress
+    settings.dirty_tiles = app->dirty_tiles;
+    settings.stats = app->stats;
+    settings.cost_aov = app->cost_aov;
+    settings.accum = app->accum;
 
-    // Render - this is where progress callbacks happen
     render_parallel(app->scene, app->camera, &settings, app->render_image);
 
-    // Calculate render time (wall clock)
-    gettimeofday(&end_time, NULL);
-    double render_time = (end_time.tv_sec - start_time.tv_sec) +
-                        (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+    RenderStatsSnapshot snap;
+    render_stats_snapshot(app->stats, &snap);
+    double render_time = snap.elapsed;
+    render_stats_report(app->stats, stdout);
 
     // Update status
     pthread_mutex_lock(&app->render_mutex);
@@ -383,14 +375,13 @@ void* render_thread_func(void* user_data) {
     data->render_time = render_time;
 
     // Check if render was cancelled
-    if (app->cancel_render) {
+    if (atomic_load(&app->cancel_render)) {
         snprintf(data->status_text, sizeof(data->status_text),
                  "Render cancelled after %.2f seconds", render_time);
     } else {
         snprintf(data->status_text, sizeof(data->status_text),
                  "Render complete: %.2f seconds (%.2f Mrays/s)",
-                 render_time,
-                 (settings.width * settings.height * settings.samples_per_pixel) / (render_time * 1e6));
+                 render_time, snap.mrays_per_sec);
     }
 
     // Schedule GUI update on main thread
@@ -404,21 +395,31 @@ gboolean update_progress(gpointer user_data) {
     GuiApp* app = (GuiApp*)user_data;
 
     pthread_mutex_lock(&app->render_mutex);
-    float progress = app->render_progress;
     bool is_rendering = app->is_rendering;
     pthread_mutex_unlock(&app->render_mutex);
 
     if (is_rendering) {
-        // Clamp progress to avoid any overflow issues
-        progress = fminf(progress, 1.0f);
-        progress = fmaxf(progress, 0.0f);
+        // Lock-free read of the render threads' published counters
+        RenderStatsSnapshot snap;
+        render_stats_snapshot(app->stats, &snap);
 
-        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), progress);
+        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), snap.progress);
 
         char progress_text[64];
-        snprintf(progress_text, sizeof(progress_text), "%d%%", (int)(progress * 100));
+        snprintf(progress_text, sizeof(progress_text), "%d%%", (int)(snap.progress * 100));
         gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->progress_bar), progress_text);
 
+        char status_text[128];
+        snprintf(status_text, sizeof(status_text), "Rendering... %.1fs, %.2f Mrays/s, %.1f nodes/ray",
+                 snap.elapsed, snap.mrays_per_sec,
+                 snap.totals.rays ? (double)snap.totals.bvh_nodes / snap.totals.rays : 0.0);
+        gtk_label_set_text(GTK_LABEL(app->status_label), status_text);
+
+        // Show the tiles finished since the last tick
+        if (app->view == 0) {
+            update_dirty_tiles(app);
+        }
+
         // Continue updating
         return TRUE;
     }
@@ -427,6 +428,13 @@ gboolean update_progress(gpointer user_data) {
     return FALSE;
 }
 
+// True if a render with `info` continues the samples described by `prev`
+static bool same_render(const CheckpointInfo* prev, const CheckpointInfo* info) {
+    return prev->samples_per_pixel == info->samples_per_pixel && prev->max_depth == info->max_depth &&
+           prev->sampler == info->sampler && prev->seed == info->seed &&
+           strcmp(prev->scene, info->scene) == 0;
+}
+
 // Callbacks
 void on_render_clicked(GtkButton* button, gpointer user_data) {
     GuiApp* app = (GuiApp*)user_data;
@@ -436,10 +444,8 @@ void on_render_clicked(GtkButton* button, gpointer user_data) {
     pthread_mutex_unlock(&app->render_mutex);
 
     if (is_rendering) {
-        // Cancel render
-        pthread_mutex_lock(&app->render_mutex);
-        app->cancel_render = true;
-        pthread_mutex_unlock(&app->render_mutex);
+        // Cancel render; the render thread stops within one path per worker
+        atomic_store(&app->cancel_render, true);
         return;
     }
 
@@ -449,14 +455,35 @@ void on_render_clicked(GtkButton* button, gpointer user_data) {
     app->settings.samples_per_pixel = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->samples_spin));
     app->settings.max_depth = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->depth_spin));
     app->settings.num_threads = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->threads_spin));
+    int sampler_index = gtk_combo_box_get_active(GTK_COMBO_BOX(app->sampler_combo));
+    app->settings.sampler = (sampler_index >= 0 && sampler_index < SAMPLER_TYPE_COUNT) ?
+                            (SamplerType)sampler_index : SAMPLER_RANDOM;
 
     // Get scene name
     const char* scene_name = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(app->scene_combo));
     if (!scene_name) scene_name = "Cornell Box";
 
-    // Create scene and camera
+    // Create scene and camera; entries ending in .scene are scene files
     if (app->scene) scene_destroy(app->scene);
-    app->scene = create_scene(scene_name);
+    app->scene = NULL;
+    CameraParams camera_params = camera_params_default();
+    size_t name_length = strlen(scene_name);
+    size_t extension_length = strlen(SCENE_FILE_EXTENSION);
+    SceneDescription desc;
+    if (name_length > extension_length &&
+        strcmp(scene_name + name_length - extension_length, SCENE_FILE_EXTENSION) == 0) {
+        if (scene_file_load(scene_name, &desc)) {
+            app->scene = desc.scene;
+            camera_params = desc.camera;
+            sequence_free(&desc.sequence);
+        } else {
+            scene_name = "Cornell Box";
+        }
+    }
+    if (!app->scene) {
+        app->scene = create_scene_by_name(scene_name);
+        camera_params = camera_params_for_scene(scene_name);
+    }
 
     // Build BVH
     gtk_label_set_text(GTK_LABEL(app->status_label), "Building BVH...");
@@ -465,18 +492,68 @@ void on_render_clicked(GtkButton* button, gpointer user_data) {
     // Create camera
     if (app->camera) free(app->camera);
     float aspect = (float)app->settings.width / app->settings.height;
-    app->camera = create_camera_for_scene(scene_name, aspect);
+    app->camera = (Camera*)malloc(sizeof(Camera));
+    *app->camera = camera_from_params(&camera_params, aspect);
+
+    // Create or resize the framebuffer and its dirty-tile map here, on the
+    // main thread, so the display never sees them reallocated mid-render
+    if (app->render_image &&
+        (app->render_image->width != (uint32_t)app->settings.width ||
+         app->render_image->height != (uint32_t)app->settings.height)) {
+        image_destroy(app->render_image);
+        app->render_image = NULL;
+        image_destroy(app->cost_aov);
+        app->cost_aov = NULL;
+        tile_dirty_map_destroy(app->dirty_tiles);
+        app->dirty_tiles = NULL;
+    }
+    if (!app->render_image) {
+        app->render_image = image_create(app->settings.width, app->settings.height);
+        app->cost_aov = image_create(app->settings.width, app->settings.height);
+        app->dirty_tiles = tile_dirty_map_create(app->settings.width, app->settings.height);
+    }
+    ensure_display_surface(app);
+
+    // A cancelled render restarted with the same settings keeps its samples;
+    // the renderer continues each pixel from its own count, so a single-pass
+    // render cancelled halfway resumes too
+    CheckpointInfo info = {app->settings.samples_per_pixel, app->settings.max_depth,
+                           app->settings.sampler, app->settings.seed, ""};
+    snprintf(info.scene, sizeof(info.scene), "%s", scene_name);
+    uint64_t pixels = (uint64_t)app->settings.width * app->settings.height;
+    uint64_t target = pixels * app->settings.samples_per_pixel;
+    uint64_t resume_samples = 0;
+    if (app->accum && app->accum->width == (uint32_t)app->settings.width &&
+        app->accum->height == (uint32_t)app->settings.height && same_render(&app->accum_info, &info)) {
+        resume_samples = accumulator_total_samples(app->accum);
+    }
+    if (resume_samples == 0 || resume_samples >= target) {
+        accumulator_destroy(app->accum);
+        app->accum = accumulator_create(app->settings.width, app->settings.height);
+        resume_samples = 0;
+    }
+    app->accum_info = info;
+
+    // Fresh stats channel sized for this render's thread count
+    render_stats_destroy(app->stats);
+    app->stats = render_stats_create(app->settings.num_threads);
 
     // Start rendering
     pthread_mutex_lock(&app->render_mutex);
     app->is_rendering = true;
-    app->cancel_render = false;
-    app->render_progress = 0.0f;
+    atomic_store(&app->cancel_render, false);
     pthread_mutex_unlock(&app->render_mutex);
 
     gtk_button_set_label(GTK_BUTTON(button), "Cancel Render");
     gtk_widget_set_sensitive(app->save_button, FALSE);
-    gtk_label_set_text(GTK_LABEL(app->status_label), "Rendering...");
+    if (resume_samples > 0) {
+        char status_text[64];
+        snprintf(status_text, sizeof(status_text), "Resuming at %.1f%% of the samples...",
+                 100.0 * (double)resume_samples / (double)target);
+        gtk_label_set_text(GTK_LABEL(app->status_label), status_text);
+    } else {
+        gtk_label_set_text(GTK_LABEL(app->status_label), "Rendering...");
+    }
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.0);
 
     // Start render thread
@@ -518,6 +595,16 @@ void on_save_clicked(GtkButton* button, gpointer user_data) {
     gtk_file_filter_add_pattern(filter_bmp, "*.bmp");
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter_bmp);
 
+    GtkFileFilter* filter_exr = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter_exr, "OpenEXR Half-Float (*.exr)");
+    gtk_file_filter_add_pattern(filter_exr, "*.exr");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter_exr);
+
+    GtkFileFilter* filter_pfm = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter_pfm, "Portable Float Map (*.pfm)");
+    gtk_file_filter_add_pattern(filter_pfm, "*.pfm");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter_pfm);
+
     GtkFileFilter* filter_all = gtk_file_filter_new();
     gtk_file_filter_set_name(filter_all, "All Files");
     gtk_file_filter_add_pattern(filter_all, "*");
@@ -526,12 +613,15 @@ void on_save_clicked(GtkButton* button, gpointer user_data) {
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
         char* filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
 
-        // Save image
-        image_save_bmp(app->render_image, filename);
+        // Save image (format from the extension); cost views save the AOV
+        bool saved = (app->view > 0) ?
+                     cost_aov_save(app->cost_aov, (CostAov)(app->view - 1), filename) :
+                     image_save(app->render_image, filename, &app->tonemap);
 
         // Update status
         char status_text[512];
-        snprintf(status_text, sizeof(status_text), "Image saved to: %s", filename);
+        snprintf(status_text, sizeof(status_text), saved ? "Image saved to: %s" : "Failed to save: %s",
+                 filename);
         gtk_label_set_text(GTK_LABEL(app->status_label), status_text);
 
         g_free(filename);
@@ -546,6 +636,29 @@ void on_scene_changed(GtkComboBox* combo, gpointer user_data) {
     // Scene will be recreated when render is clicked
 }
 
+void on_tonemap_changed(GtkWidget* widget, gpointer user_data) {
+    (void)widget; // Suppress unused parameter warning
+    GuiApp* app = (GuiApp*)user_data;
+
+    app->tonemap.op = (TonemapOperator)gtk_combo_box_get_active(GTK_COMBO_BOX(app->tonemap_combo));
+    app->tonemap.exposure = (float)gtk_spin_button_get_value(GTK_SPIN_BUTTON(app->exposure_spin));
+    app->tonemap.srgb = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(app->srgb_check));
+    int view = gtk_combo_box_get_active(GTK_COMBO_BOX(app->view_combo));
+    app->view = (view > 0 && view <= COST_AOV_COUNT) ? view : 0;
+
+    // Re-tonemap the whole frame, unless render threads are still writing
+    // it: tiles finished from now on use the new settings, and the rest are
+    // redrawn when the render completes
+    pthread_mutex_lock(&app->render_mutex);
+    bool is_rendering = app->is_rendering;
+    pthread_mutex_unlock(&app->render_mutex);
+    if (is_rendering) {
+        app->display_stale = true;
+    } else {
+        update_image_display(app);
+    }
+}
+
 void on_window_destroy(GtkWidget* widget, gpointer user_data) {
     (void)widget; // Suppress unused parameter warning
     GuiApp* app = (GuiApp*)user_data;
@@ -553,7 +666,7 @@ void on_window_destroy(GtkWidget* widget, gpointer user_data) {
     // Stop rendering if in progress
     pthread_mutex_lock(&app->render_mutex);
     if (app->is_rendering) {
-        app->cancel_render = true;
+        atomic_store(&app->cancel_render, true);
     }
     pthread_mutex_unlock(&app->render_mutex);
 
@@ -0,0 +1,355 @@
+#include "image.h"
+#include "tonemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Scanlines converted per fwrite by the streaming writers; BMP chunks are
+// larger because their rows are tonemapped in parallel
+#define IMAGE_WRITE_CHUNK_ROWS 16
+#define IMAGE_BMP_CHUNK_ROWS 64
+
+static const char* const FORMAT_NAMES[IMAGE_FORMAT_COUNT] = {"rgb32f", "rgba16f"};
+
+// Image management
+Image* image_create(uint32_t width, uint32_t height) {
+    return image_create_format(width, height, IMAGE_FORMAT_RGB32F);
+}
+
+Image* image_create_format(uint32_t width, uint32_t height, ImageFormat format) {
+    size_t count = (size_t)width * height;
+    Image* img = (Image*)calloc(1, sizeof(Image));
+    if (!img) return NULL;
+
+    img->width = width;
+    img->height = height;
+    img->format = format;
+    img->data = calloc(count, image_bytes_per_pixel(format));
+    if (!img->data) {
+        fprintf(stderr, "Failed to allocate %ux%u %s framebuffer\n",
+                width, height, image_format_name(format));
+        free(img);
+        return NULL;
+    }
+
+    if (format == IMAGE_FORMAT_RGBA16F) {
+        img->half = (uint16_t*)img->data;
+        for (size_t i = 0; i < count; i++) {
+            img->half[i * 4 + 3] = 0x3C00;  // Opaque alpha
+        }
+    } else {
+        float* data = (float*)img->data;
+        for (int c = 0; c < 3; c++) {
+            img->planes[c] = data + c * count;
+        }
+    }
+    return img;
+}
+
+void image_destroy(Image* img) {
+    if (img) {
+        free(img->data);
+        free(img);
+    }
+}
+
+const char* image_format_name(ImageFormat format) {
+    return (format < IMAGE_FORMAT_COUNT) ? FORMAT_NAMES[format] : "unknown";
+}
+
+bool image_format_from_name(const char* name, ImageFormat* format) {
+    for (int i = 0; i < IMAGE_FORMAT_COUNT; i++) {
+        if (strcmp(name, FORMAT_NAMES[i]) == 0) {
+            *format = (ImageFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t image_bytes_per_pixel(ImageFormat format) {
+    return (format == IMAGE_FORMAT_RGBA16F) ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+}
+
+void image_read_row(const Image* img, uint32_t y, float* rgb) {
+    size_t row = (size_t)y * img->width;
+    if (img->format == IMAGE_FORMAT_RGBA16F) {
+        const uint16_t* p = img->half + row * 4;
+        for (uint32_t x = 0; x < img->width; x++) {
+            rgb[x * 3 + 0] = half_to_float(p[x * 4 + 0]);
+            rgb[x * 3 + 1] = half_to_float(p[x * 4 + 1]);
+            rgb[x * 3 + 2] = half_to_float(p[x * 4 + 2]);
+        }
+        return;
+    }
+    for (uint32_t x = 0; x < img->width; x++) {
+        rgb[x * 3 + 0] = img->planes[0][row + x];
+        rgb[x * 3 + 1] = img->planes[1][row + x];
+        rgb[x * 3 + 2] = img->planes[2][row + x];
+    }
+}
+
+// Little-endian field helpers for file headers
+static uint8_t* put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return p + 4;
+}
+
+static uint8_t* put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return p + 8;
+}
+
+static uint8_t* put_f32(uint8_t* p, float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return put_u32(p, bits);
+}
+
+static uint8_t* put_str(uint8_t* p, const char* s) {
+    size_t len = strlen(s) + 1;
+    memcpy(p, s, len);
+    return p + len;
+}
+
+// Open `filename` and allocate the chunk buffer, plus a float row buffer
+// when `row` is not NULL
+static FILE* open_for_write(const char* filename, size_t chunk_bytes, uint8_t** chunk,
+                            const Image* img, float** row) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", filename);
+        return NULL;
+    }
+    *chunk = (uint8_t*)malloc(chunk_bytes);
+    float* row_buffer = row ? (float*)malloc((size_t)img->width * 3 * sizeof(float)) : NULL;
+    if (!*chunk || (row && !row_buffer)) {
+        fprintf(stderr, "Failed to allocate write buffers for %s\n", filename);
+        free(*chunk);
+        free(row_buffer);
+        fclose(f);
+        return NULL;
+    }
+    if (row) *row = row_buffer;
+    return f;
+}
+
+static bool finish_write(FILE* f, const char* filename, uint8_t* chunk, float* row) {
+    free(chunk);
+    free(row);
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Failed to write %s\n", filename);
+    }
+    return ok;
+}
+
+bool image_save_bmp(const Image* img, const char* filename, const TonemapSettings* tonemap) {
+    TonemapSettings defaults = tonemap_default();
+    if (!tonemap) tonemap = &defaults;
+
+    uint32_t row_bytes = (img->width * 3 + 3) & ~3u;
+    uint32_t filesize = 54 + row_bytes * img->height;
+
+    uint8_t* chunk;
+    FILE* f = open_for_write(filename, (size_t)row_bytes * IMAGE_BMP_CHUNK_ROWS, &chunk, img, NULL);
+    if (!f) return false;
+
+    // BITMAPFILEHEADER + BITMAPINFOHEADER, 24-bit uncompressed
+    uint8_t header[54] = {0};
+    uint8_t* p = header;
+    *p++ = 'B';
+    *p++ = 'M';
+    p = put_u32(p, filesize);
+    p = put_u32(p, 0);
+    p = put_u32(p, 54);
+    p = put_u32(p, 40);
+    p = put_u32(p, img->width);
+    p = put_u32(p, img->height);
+    p = put_u16(p, 1);
+    put_u16(p, 24);
+    fwrite(header, 1, sizeof(header), f);
+
+    // BMP rows are BGR and bottom-to-top: tonemap a chunk top-down (rows in
+    // parallel), then write it back to front. Padding bytes stay zero.
+    memset(chunk, 0, (size_t)row_bytes * IMAGE_BMP_CHUNK_ROWS);
+    for (uint32_t y_end = img->height; y_end > 0; ) {
+        uint32_t y_begin = (y_end > IMAGE_BMP_CHUNK_ROWS) ? y_end - IMAGE_BMP_CHUNK_ROWS : 0;
+        tonemap_rows(tonemap, img, y_begin, y_end, chunk, row_bytes, PIXEL_LAYOUT_BGR8);
+        for (uint32_t y = y_end; y > y_begin; y--) {
+            fwrite(chunk + (size_t)(y - 1 - y_begin) * row_bytes, 1, row_bytes, f);
+        }
+        y_end = y_begin;
+    }
+
+    return finish_write(f, filename, chunk, NULL);
+}
+
+bool image_save_pfm(const Image* img, const char* filename) {
+    size_t row_bytes = (size_t)img->width * 3 * sizeof(float);
+
+    uint8_t* chunk;
+    float* row;
+    FILE* f = open_for_write(filename, row_bytes * IMAGE_WRITE_CHUNK_ROWS, &chunk, img, &row);
+    if (!f) return false;
+
+    // Negative scale = little-endian floats; rows are stored bottom-to-top
+    fprintf(f, "PF\n%u %u\n-1.0\n", img->width, img->height);
+
+    uint32_t rows_in_chunk = 0;
+    for (uint32_t n = 0; n < img->height; n++) {
+        image_read_row(img, img->height - 1 - n, row);
+        uint8_t* out = chunk + rows_in_chunk * row_bytes;
+        for (uint32_t i = 0; i < img->width * 3; i++) {
+            out = put_f32(out, row[i]);
+        }
+
+        if (++rows_in_chunk == IMAGE_WRITE_CHUNK_ROWS || n + 1 == img->height) {
+            fwrite(chunk, row_bytes, rows_in_chunk, f);
+            rows_in_chunk = 0;
+        }
+    }
+
+    return finish_write(f, filename, chunk, row);
+}
+
+// EXR attribute: name, type, size, value
+static uint8_t* put_exr_attribute(uint8_t* p, const char* name, const char* type,
+                                  const void* value, uint32_t size) {
+    p = put_str(p, name);
+    p = put_str(p, type);
+    p = put_u32(p, size);
+    memcpy(p, value, size);
+    return p + size;
+}
+
+// Scanline OpenEXR, uncompressed, HALF channels, one scanline per chunk
+bool image_save_exr(const Image* img, const char* filename) {
+    bool has_alpha = img->format == IMAGE_FORMAT_RGBA16F;
+    // Channels must be listed (and stored) in alphabetical order
+    const char* channels[4] = {"A", "B", "G", "R"};
+    const int channel_rgba[4] = {3, 2, 1, 0};
+    int first_channel = has_alpha ? 0 : 1;
+    int channel_count = 4 - first_channel;
+
+    uint32_t line_bytes = 8 + img->width * channel_count * sizeof(uint16_t);
+
+    uint8_t* chunk;
+    float* row;
+    FILE* f = open_for_write(filename, (size_t)line_bytes * IMAGE_WRITE_CHUNK_ROWS, &chunk, img, &row);
+    if (!f) return false;
+
+    uint8_t header[512];
+    uint8_t* p = header;
+    p = put_u32(p, 20000630);  // Magic
+    p = put_u32(p, 2);         // Version 2, single-part scanline
+
+    uint8_t chlist[4 * 18 + 1];  // Name, NUL and 16 bytes of fields per channel
+    uint8_t* c = chlist;
+    for (int ch = first_channel; ch < 4; ch++) {
+        c = put_str(c, channels[ch]);
+        c = put_u32(c, 1);     // HALF
+        c = put_u32(c, 0);     // pLinear + reserved
+        c = put_u32(c, 1);     // xSampling
+        c = put_u32(c, 1);     // ySampling
+    }
+    *c++ = 0;
+    p = put_exr_attribute(p, "channels", "chlist", chlist, (uint32_t)(c - chlist));
+
+    uint8_t compression = 0;   // NO_COMPRESSION
+    p = put_exr_attribute(p, "compression", "compression", &compression, 1);
+
+    uint8_t box[16];
+    uint8_t* b = put_u32(box, 0);
+    b = put_u32(b, 0);
+    b = put_u32(b, img->width - 1);
+    put_u32(b, img->height - 1);
+    p = put_exr_attribute(p, "dataWindow", "box2i", box, sizeof(box));
+    p = put_exr_attribute(p, "displayWindow", "box2i", box, sizeof(box));
+
+    uint8_t line_order = 0;    // INCREASING_Y
+    p = put_exr_attribute(p, "lineOrder", "lineOrder", &line_order, 1);
+
+    uint8_t value[8];
+    put_f32(value, 1.0f);
+    p = put_exr_attribute(p, "pixelAspectRatio", "float", value, 4);
+    put_f32(put_f32(value, 0.0f), 0.0f);
+    p = put_exr_attribute(p, "screenWindowCenter", "v2f", value, 8);
+    put_f32(value, 1.0f);
+    p = put_exr_attribute(p, "screenWindowWidth", "float", value, 4);
+    *p++ = 0;                  // End of header
+    fwrite(header, 1, (size_t)(p - header), f);
+
+    // Offset table: chunk sizes are fixed, so offsets are known up front
+    uint64_t offset = (uint64_t)(p - header) + 8ull * img->height;
+    for (uint32_t y = 0; y < img->height; y++) {
+        uint8_t entry[8];
+        put_u64(entry, offset + (uint64_t)y * line_bytes);
+        fwrite(entry, 1, sizeof(entry), f);
+    }
+
+    uint32_t rows_in_chunk = 0;
+    for (uint32_t y = 0; y < img->height; y++) {
+        uint8_t* out = chunk + (size_t)rows_in_chunk * line_bytes;
+        out = put_u32(out, y);
+        out = put_u32(out, line_bytes - 8);
+
+        if (has_alpha) {
+            // Already half: copy channels straight out of the framebuffer
+            const uint16_t* src = img->half + (size_t)y * img->width * 4;
+            for (int ch = first_channel; ch < 4; ch++) {
+                for (uint32_t x = 0; x < img->width; x++) {
+                    out = put_u16(out, src[x * 4 + channel_rgba[ch]]);
+                }
+            }
+        } else {
+            image_read_row(img, y, row);
+            for (int ch = first_channel; ch < 4; ch++) {
+                for (uint32_t x = 0; x < img->width; x++) {
+                    out = put_u16(out, half_from_float(row[x * 3 + channel_rgba[ch]]));
+                }
+            }
+        }
+
+        if (++rows_in_chunk == IMAGE_WRITE_CHUNK_ROWS || y + 1 == img->height) {
+            fwrite(chunk, line_bytes, rows_in_chunk, f);
+            rows_in_chunk = 0;
+        }
+    }
+
+    return finish_write(f, filename, chunk, row);
+}
+
+static bool has_extension(const char* filename, const char* ext) {
+    size_t len = strlen(filename);
+    size_t ext_len = strlen(ext);
+    if (len < ext_len) return false;
+    const char* tail = filename + len - ext_len;
+    for (size_t i = 0; i < ext_len; i++) {
+        char ch = tail[i];
+        if (ch >= 'A' && ch <= 'Z') ch = (char)(ch - 'A' + 'a');
+        if (ch != ext[i]) return false;
+    }
+    return true;
+}
+
+bool image_filename_is_hdr(const char* filename) {
+    return has_extension(filename, ".pfm") || has_extension(filename, ".exr");
+}
+
+bool image_save(const Image* img, const char* filename, const TonemapSettings* tonemap) {
+    if (has_extension(filename, ".pfm")) {
+        return image_save_pfm(img, filename);
+    }
+    if (has_extension(filename, ".exr")) {
+        return image_save_exr(img, filename);
+    }
+    return image_save_bmp(img, filename, tonemap);
+}
@@ -0,0 +1,18 @@
+#include "instance.h"
+#include "pathtracer.h"
+
+bool instance_hit(const Instance* instance, const Ray* ray, float t_min, float t_max, HitRecord* rec) {
+    const BVH* bvh = instance->group->bvh;
+    if (!bvh) return false;
+
+    // The object-space direction keeps the scale it picks up, so distances
+    // along both rays agree and t needs no conversion
+    Ray local = {transform_point(&instance->to_object, ray->origin),
+                 transform_vector(&instance->to_object, ray->direction), ray->time};
+    if (!bvh_hit(bvh, &local, t_min, t_max, rec)) return false;
+
+    // Facing is preserved: the inverse transpose keeps dot(normal, direction)
+    rec->point = ray_at(*ray, rec->t);
+    rec->normal = vec3_normalize(transform_normal(&instance->to_object, rec->normal));
+    return true;
+}
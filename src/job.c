@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 200809L
+#include "job.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+void job_request_init(JobRequest* job) {
+    memset(job, 0, sizeof(*job));
+    snprintf(job->scene, sizeof(job->scene), "%s", "Cornell Box");
+    job->width = 800;
+    job->height = 600;
+    job->samples_per_pixel = 100;
+    job->max_depth = 50;
+    job->seed = 42;
+    job->sampler = SAMPLER_RANDOM;
+}
+
+static bool parse_vec3(const char* value, Vec3* out) {
+    return sscanf(value, "%f,%f,%f", &out->x, &out->y, &out->z) == 3;
+}
+
+bool job_request_set(JobRequest* job, const char* key, const char* value) {
+    bool ok = true;
+    if (strcmp(key, "scene") == 0) {
+        ok = strlen(value) < sizeof(job->scene);
+        if (ok) snprintf(job->scene, sizeof(job->scene), "%s", value);
+    } else if (strcmp(key, "width") == 0) {
+        job->width = (uint32_t)atoi(value);
+    } else if (strcmp(key, "height") == 0) {
+        job->height = (uint32_t)atoi(value);
+    } else if (strcmp(key, "spp") == 0) {
+        job->samples_per_pixel = (uint32_t)atoi(value);
+    } else if (strcmp(key, "depth") == 0) {
+        job->max_depth = (uint32_t)atoi(value);
+    } else if (strcmp(key, "seed") == 0) {
+        job->seed = strtoull(value, NULL, 10);
+    } else if (strcmp(key, "sampler") == 0) {
+        ok = sampler_type_from_name(value, &job->sampler);
+    } else if (strcmp(key, "lookfrom") == 0) {
+        ok = parse_vec3(value, &job->camera.lookfrom);
+        job->camera_fields |= JOB_CAMERA_LOOKFROM;
+    } else if (strcmp(key, "lookat") == 0) {
+        ok = parse_vec3(value, &job->camera.lookat);
+        job->camera_fields |= JOB_CAMERA_LOOKAT;
+    } else if (strcmp(key, "vup") == 0) {
+        ok = parse_vec3(value, &job->camera.vup);
+        job->camera_fields |= JOB_CAMERA_VUP;
+    } else if (strcmp(key, "vfov") == 0) {
+        job->camera.vfov = (float)atof(value);
+        job->camera_fields |= JOB_CAMERA_VFOV;
+    } else if (strcmp(key, "aperture") == 0) {
+        job->camera.aperture = (float)atof(value);
+        job->camera_fields |= JOB_CAMERA_APERTURE;
+    } else if (strcmp(key, "focus") == 0) {
+        job->camera.focus_dist = (float)atof(value);
+        job->camera_fields |= JOB_CAMERA_FOCUS;
+    } else {
+        fprintf(stderr, "Unknown job key: %s\n", key);
+        return false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Invalid %s: %s\n", key, value);
+    }
+    return ok;
+}
+
+CameraParams job_request_camera(const JobRequest* job, const CameraParams* scene_camera) {
+    CameraParams camera = *scene_camera;
+    if (job->camera_fields & JOB_CAMERA_LOOKFROM) camera.lookfrom = job->camera.lookfrom;
+    if (job->camera_fields & JOB_CAMERA_LOOKAT) camera.lookat = job->camera.lookat;
+    if (job->camera_fields & JOB_CAMERA_VUP) camera.vup = job->camera.vup;
+    if (job->camera_fields & JOB_CAMERA_VFOV) camera.vfov = job->camera.vfov;
+    if (job->camera_fields & JOB_CAMERA_APERTURE) camera.aperture = job->camera.aperture;
+    if (job->camera_fields & JOB_CAMERA_FOCUS) camera.focus_dist = job->camera.focus_dist;
+    return camera;
+}
+
+// printf at buffer + *n; false if the result does not fit in size
+static bool append_format(char* buffer, size_t size, int* n, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int m = vsnprintf(buffer + *n, size - (size_t)*n, format, args);
+    va_end(args);
+    if (m < 0 || (size_t)(*n + m) >= size) return false;
+    *n += m;
+    return true;
+}
+
+bool job_request_format(const JobRequest* job, char* buffer, size_t size) {
+    int n = snprintf(buffer, size,
+                     "RENDER\nscene %s\nwidth %u\nheight %u\nspp %u\ndepth %u\nseed %llu\nsampler %s\n",
+                     job->scene, job->width, job->height, job->samples_per_pixel, job->max_depth,
+                     (unsigned long long)job->seed, sampler_type_name(job->sampler));
+    if (n < 0 || (size_t)n >= size) return false;
+
+    // Only the overridden camera fields, so the server keeps the scene's others
+    const CameraParams* c = &job->camera;
+    uint32_t fields = job->camera_fields;
+    bool ok = true;
+    if (fields & JOB_CAMERA_LOOKFROM) {
+        ok = ok && append_format(buffer, size, &n, "lookfrom %g,%g,%g\n",
+                                 c->lookfrom.x, c->lookfrom.y, c->lookfrom.z);
+    }
+    if (fields & JOB_CAMERA_LOOKAT) {
+        ok = ok && append_format(buffer, size, &n, "lookat %g,%g,%g\n",
+                                 c->lookat.x, c->lookat.y, c->lookat.z);
+    }
+    if (fields & JOB_CAMERA_VUP) {
+        ok = ok && append_format(buffer, size, &n, "vup %g,%g,%g\n", c->vup.x, c->vup.y, c->vup.z);
+    }
+    if (fields & JOB_CAMERA_VFOV) {
+        ok = ok && append_format(buffer, size, &n, "vfov %g\n", c->vfov);
+    }
+    if (fields & JOB_CAMERA_APERTURE) {
+        ok = ok && append_format(buffer, size, &n, "aperture %g\n", c->aperture);
+    }
+    if (fields & JOB_CAMERA_FOCUS) {
+        ok = ok && append_format(buffer, size, &n, "focus %g\n", c->focus_dist);
+    }
+    if (!ok) return false;
+
+    if ((size_t)n + 1 >= size) return false;
+    buffer[n] = '\n';  // Empty line ends the request
+    buffer[n + 1] = '\0';
+    return true;
+}
+
+bool job_send(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool job_send_line(int fd, const char* line) {
+    return job_send(fd, line, strlen(line)) && job_send(fd, "\n", 1);
+}
+
+bool job_recv(int fd, void* data, size_t size) {
+    char* p = (char*)data;
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool job_read_line(int fd, char* line, size_t size) {
+    // Byte at a time: requests and status lines are short, and reading no
+    // further than the newline leaves any binary payload in the socket
+    size_t len = 0;
+    for (;;) {
+        char c;
+        if (!job_recv(fd, &c, 1)) return false;
+        if (c == '\n') break;
+        if (len + 1 >= size) return false;
+        line[len++] = c;
+    }
+    line[len] = '\0';
+    return true;
+}
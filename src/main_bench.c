@@ -0,0 +1,1751 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include "pathtracer.h"
+#include "scenes.h"
+#include "mesh_io.h"
+#include "scene_cache.h"
+#include "scene_file.h"
+#include "scene_gen.h"
+#include "sequence.h"
+#include <omp.h>
+
+// Options shared by all benchmarks (each one uses the subset it needs)
+typedef struct {
+    const char* scene_name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t max_spp;
+    uint32_t reference_spp;
+    uint32_t max_depth;
+    uint32_t threads;
+    const char* mesh_path;
+    uint32_t max_prims;
+    const char* generator;  // NULL = every generator
+} BenchOptions;
+
+typedef struct {
+    const char* name;
+    const char* description;
+    int (*run)(const BenchOptions* options);
+} Benchmark;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static RenderSettings bench_settings(const BenchOptions* options, uint32_t spp,
+                                     SamplerType sampler, uint64_t seed) {
+    RenderSettings settings = {0};
+    settings.width = options->width;
+    settings.height = options->height;
+    settings.samples_per_pixel = spp;
+    settings.max_depth = options->max_depth;
+    settings.num_threads = options->threads;
+    settings.use_bvh = true;
+    settings.seed = seed;
+    settings.sampler = sampler;
+    return settings;
+}
+
+// RMSE of linear radiance (tonemapping would bias low-spp estimates)
+static double image_rmse(const Image* a, const Image* b) {
+    double sum = 0.0;
+    uint32_t count = a->width * a->height;
+    for (uint32_t y = 0; y < a->height; y++) {
+        for (uint32_t x = 0; x < a->width; x++) {
+            Vec3 d = vec3_sub(image_get_pixel(a, x, y), image_get_pixel(b, x, y));
+            sum += (double)vec3_length_squared(d);
+        }
+    }
+    return sqrt(sum / (3.0 * count));
+}
+
+// RMSE against a high-spp reference for every sampler at 1, 2, 4, ... spp
+static int bench_rmse(const BenchOptions* options) {
+    Scene* scene = create_scene_by_name(options->scene_name);
+    scene_build_bvh(scene);
+    Camera camera = create_camera_for_scene(options->scene_name,
+                                            (float)options->width / options->height);
+
+    printf("Scene: %s, %ux%u, depth %u, reference %u spp\n", options->scene_name,
+           options->width, options->height, options->max_depth, options->reference_spp);
+
+    // Independent seed so the reference is not correlated with the random sampler
+    Image* reference = image_create(options->width, options->height);
+    RenderSettings settings = bench_settings(options, options->reference_spp,
+                                             SAMPLER_RANDOM, 0x5EEDULL);
+    double start = now_seconds();
+    render_parallel(scene, &camera, &settings, reference);
+    printf("Reference rendered in %.2f s\n\n", now_seconds() - start);
+
+    printf("%8s", "spp");
+    for (int t = 0; t < SAMPLER_TYPE_COUNT; t++) {
+        printf(" %12s", sampler_type_name((SamplerType)t));
+    }
+    printf("\n");
+
+    Image* image = image_create(options->width, options->height);
+    double sampler_time[SAMPLER_TYPE_COUNT] = {0};
+
+    for (uint32_t spp = 1; spp <= options->max_spp; spp *= 2) {
+        printf("%8u", spp);
+        for (int t = 0; t < SAMPLER_TYPE_COUNT; t++) {
+            settings = bench_settings(options, spp, (SamplerType)t, 42);
+            start = now_seconds();
+            render_parallel(scene, &camera, &settings, image);
+            sampler_time[t] += now_seconds() - start;
+            printf(" %12.5f", image_rmse(image, reference));
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    printf("%8s", "time(s)");
+    for (int t = 0; t < SAMPLER_TYPE_COUNT; t++) {
+        printf(" %12.2f", sampler_time[t]);
+    }
+    printf("\n");
+
+    image_destroy(image);
+    image_destroy(reference);
+    scene_destroy(scene);
+    return 0;
+}
+
+// Rejection-sampling routines that random.h used before the closed-form
+// warps, kept here as the baseline for the sampling micro-benchmark
+static Vec3 legacy_in_unit_sphere(RNG* rng) {
+    while (1) {
+        Vec3 p = vec3_create(
+            rng_float_range(rng, -1.0f, 1.0f),
+            rng_float_range(rng, -1.0f, 1.0f),
+            rng_float_range(rng, -1.0f, 1.0f)
+        );
+        if (vec3_length_squared(p) < 1.0f)
+            return p;
+    }
+}
+
+static Vec3 legacy_in_unit_disk(RNG* rng) {
+    while (1) {
+        Vec3 p = vec3_create(
+            rng_float_range(rng, -1.0f, 1.0f),
+            rng_float_range(rng, -1.0f, 1.0f),
+            0.0f
+        );
+        if (vec3_length_squared(p) < 1.0f)
+            return p;
+    }
+}
+
+static Vec3 legacy_unit_vector(RNG* rng) {
+    return vec3_normalize(legacy_in_unit_sphere(rng));
+}
+
+static Vec3 legacy_cosine_direction(RNG* rng, Vec3 n) {
+    return vec3_normalize(vec3_add(n, legacy_unit_vector(rng)));
+}
+
+static Vec3 closed_cosine_direction(RNG* rng, Vec3 n) {
+    float u = rng_float(rng);
+    return sample_cosine_hemisphere(n, u, rng_float(rng));
+}
+
+typedef enum { SAMPLE_BALL, SAMPLE_DISK, SAMPLE_SPHERE, SAMPLE_COSINE } SampleKind;
+
+// Time `count` calls of one sampling routine; returns samples per ns
+static double time_sampling(SampleKind kind, bool legacy, uint32_t count, const Vec3* normals) {
+    RNG rng;
+    rng_init(&rng, 7);
+    Vec3 sum = vec3_create(0, 0, 0);
+
+    double start = now_seconds();
+    for (uint32_t i = 0; i < count; i++) {
+        Vec3 p;
+        switch (kind) {
+            case SAMPLE_BALL:
+                p = legacy ? legacy_in_unit_sphere(&rng) : rng_in_unit_sphere(&rng);
+                break;
+            case SAMPLE_DISK:
+                p = legacy ? legacy_in_unit_disk(&rng) : rng_in_unit_disk(&rng);
+                break;
+            case SAMPLE_SPHERE:
+                p = legacy ? legacy_unit_vector(&rng) : rng_unit_vector(&rng);
+                break;
+            default:
+                p = legacy ? legacy_cosine_direction(&rng, normals[i & 63])
+                           : closed_cosine_direction(&rng, normals[i & 63]);
+                break;
+        }
+        sum = vec3_add(sum, p);
+    }
+    double elapsed = now_seconds() - start;
+
+    // Keep the result alive so the loop is not optimized away
+    if (sum.x == 12345.0f) printf(" ");
+    return count / (elapsed * 1e9);
+}
+
+// Rejection vs closed-form sampling throughput
+static int bench_sampling(const BenchOptions* options) {
+    (void)options;
+    const uint32_t count = 20000000;
+    const char* names[] = {"unit ball", "unit disk", "unit sphere", "cosine hemisphere"};
+
+    Vec3 normals[64];
+    RNG rng;
+    rng_init(&rng, 3);
+    for (int i = 0; i < 64; i++) {
+        normals[i] = rng_unit_vector(&rng);
+    }
+
+    printf("%-20s %14s %14s %8s\n", "routine", "rejection", "closed-form", "speedup");
+    for (int kind = SAMPLE_BALL; kind <= SAMPLE_COSINE; kind++) {
+        double legacy = time_sampling((SampleKind)kind, true, count, normals);
+        double closed = time_sampling((SampleKind)kind, false, count, normals);
+        printf("%-20s %9.3f /ns %9.3f /ns %7.2fx\n", names[kind], legacy, closed, closed / legacy);
+    }
+    return 0;
+}
+
+// Pearson chi-square of `count` draws over `bins` equal-width bins
+static double chi_square(const uint32_t* histogram, uint32_t bins, uint64_t count) {
+    double expected = (double)count / bins;
+    double chi2 = 0.0;
+    for (uint32_t b = 0; b < bins; b++) {
+        double d = histogram[b] - expected;
+        chi2 += d * d / expected;
+    }
+    return chi2;
+}
+
+static void print_chi_square(const char* label, double chi2, uint32_t bins) {
+    // chi2 ~ N(dof, 2 dof) for large dof; |z| > 4 means the test failed
+    double dof = bins - 1.0;
+    double z = (chi2 - dof) / sqrt(2.0 * dof);
+    printf("  %-34s chi2 %10.1f  dof %6.0f  z %+6.2f  %s\n", label, chi2, dof, z,
+           fabs(z) < 4.0 ? "ok" : "FAIL");
+}
+
+// Scalar PCG vs batched xoshiro128+ throughput, plus chi-square checks
+static int bench_rng(const BenchOptions* options) {
+    (void)options;
+    const uint32_t count = 1u << 26;
+
+#ifdef __AVX2__
+    printf("Batch RNG: %d lanes, AVX2\n\n", RNG_BATCH_LANES);
+#else
+    printf("Batch RNG: %d lanes, scalar fallback\n\n", RNG_BATCH_LANES);
+#endif
+
+    RNG rng;
+    rng_init(&rng, 7);
+    float sum = 0.0f;
+    double start = now_seconds();
+    for (uint32_t i = 0; i < count; i++) {
+        sum += rng_float(&rng);
+    }
+    double pcg_rate = count / ((now_seconds() - start) * 1e9);
+
+    RNGBatch batch;
+    rng_batch_seed(&batch, rng_hash64(7));
+    start = now_seconds();
+    for (uint32_t i = 0; i < count; i++) {
+        sum += rng_batch_float(&batch);
+    }
+    double batch_rate = count / ((now_seconds() - start) * 1e9);
+
+    // Per-sample reseeding cost, as paid by the SAMPLER_RANDOM path
+    const uint32_t seeds = 1u << 22;
+    start = now_seconds();
+    for (uint32_t i = 0; i < seeds; i++) {
+        rng_init_sample(&rng, 42, i >> 6, i & 63);
+        sum += rng_float(&rng);
+    }
+    double pcg_seed_ns = (now_seconds() - start) * 1e9 / seeds;
+    start = now_seconds();
+    for (uint32_t i = 0; i < seeds; i++) {
+        rng_batch_init_sample(&batch, 42, i >> 6, i & 63);
+        sum += rng_batch_float(&batch);
+    }
+    double batch_seed_ns = (now_seconds() - start) * 1e9 / seeds;
+
+    if (sum == 12345.0f) printf(" ");
+    printf("%-22s %12s %12s\n", "", "PCG32", "batch");
+    printf("%-22s %9.3f /ns %9.3f /ns  (%.2fx)\n", "floats", pcg_rate, batch_rate, batch_rate / pcg_rate);
+    printf("%-22s %9.1f ns %9.1f ns\n\n", "seed + first draw", pcg_seed_ns, batch_seed_ns);
+
+    // Statistical sanity: 1D histogram, 2D histogram of consecutive pairs,
+    // and the first draw after reseeding for consecutive (pixel, sample) keys
+    enum { BINS_1D = 4096, BINS_2D = 64 };
+    uint32_t* histogram = calloc(BINS_2D * BINS_2D, sizeof(uint32_t));
+
+    printf("Chi-square (batch RNG, %u draws):\n", count);
+    memset(histogram, 0, BINS_1D * sizeof(uint32_t));
+    rng_batch_seed(&batch, rng_hash64(11));
+    for (uint32_t i = 0; i < count; i++) {
+        histogram[(uint32_t)(rng_batch_float(&batch) * BINS_1D)]++;
+    }
+    print_chi_square("1D uniformity", chi_square(histogram, BINS_1D, count), BINS_1D);
+
+    memset(histogram, 0, BINS_2D * BINS_2D * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count / 2; i++) {
+        uint32_t x = (uint32_t)(rng_batch_float(&batch) * BINS_2D);
+        uint32_t y = (uint32_t)(rng_batch_float(&batch) * BINS_2D);
+        histogram[y * BINS_2D + x]++;
+    }
+    print_chi_square("2D consecutive pairs", chi_square(histogram, BINS_2D * BINS_2D, count / 2),
+                     BINS_2D * BINS_2D);
+
+    memset(histogram, 0, BINS_2D * BINS_2D * sizeof(uint32_t));
+    for (uint32_t i = 0; i < seeds; i++) {
+        rng_batch_init_sample(&batch, 42, i >> 6, i & 63);
+        uint32_t x = (uint32_t)(rng_batch_float(&batch) * BINS_2D);
+        uint32_t y = (uint32_t)(rng_batch_float(&batch) * BINS_2D);
+        histogram[y * BINS_2D + x]++;
+    }
+    print_chi_square("2D first pair after reseeding", chi_square(histogram, BINS_2D * BINS_2D, seeds),
+                     BINS_2D * BINS_2D);
+
+    free(histogram);
+    return 0;
+}
+
+// camera_get_ray as it was before the pinhole fast path: every sample draws
+// and warps a lens position, and s/t are recomputed per sample
+static Ray legacy_camera_get_ray(const Camera* cam, float s, float t, Sampler* sampler) {
+    float lens_u, lens_v;
+    sampler_2d(sampler, SAMPLER_DIM_LENS, &lens_u, &lens_v);
+    Vec3 rd = vec3_scale(sample_concentric_disk(lens_u, lens_v), cam->lens_radius);
+    Vec3 offset = vec3_add(vec3_scale(cam->u, rd.x), vec3_scale(cam->v, rd.y));
+
+    Vec3 ray_origin = vec3_add(cam->origin, offset);
+    Vec3 ray_target = vec3_add(
+        vec3_add(cam->lower_left_corner, vec3_scale(cam->horizontal, s)),
+        vec3_scale(cam->vertical, t)
+    );
+    return ray_create(ray_origin, vec3_sub(ray_target, ray_origin));
+}
+
+// Time primary-ray setup (sampler start, jitter, ray) for one camera; ns/ray
+static double time_primary_rays(const Camera* camera, uint32_t width, uint32_t height,
+                                uint32_t spp, bool legacy) {
+    CameraRaster raster = camera_raster_create(camera, width, height);
+    Sampler sampler;
+    Vec3 sum = vec3_create(0, 0, 0);
+
+    double start = now_seconds();
+    for (uint32_t j = 0; j < height; j++) {
+        Vec3 row = camera_raster_row(&raster, j);
+        for (uint32_t i = 0; i < width; i++) {
+            Vec3 pixel = camera_raster_pixel(&raster, row, i);
+            for (uint32_t s = 0; s < spp; s++) {
+                sampler_start(&sampler, SAMPLER_RANDOM, 42, i, j, width, s, spp);
+                float jitter_u, jitter_v;
+                sampler_2d(&sampler, SAMPLER_DIM_PIXEL, &jitter_u, &jitter_v);
+
+                Ray ray;
+                if (legacy) {
+                    float u = (i + jitter_u) / (float)(width - 1);
+                    float v = 1.0f - (j + jitter_v) / (float)(height - 1);
+                    ray = legacy_camera_get_ray(camera, u, v, &sampler);
+                } else {
+                    ray = camera_raster_ray(&raster, pixel, jitter_u, jitter_v, &sampler);
+                }
+                sum = vec3_add(sum, vec3_add(ray.origin, ray.direction));
+            }
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    if (sum.x == 12345.0f) printf(" ");
+    return elapsed * 1e9 / ((double)width * height * spp);
+}
+
+// Primary-ray generation cost for every built-in camera
+static int bench_camera(const BenchOptions* options) {
+    (void)options;
+    const uint32_t width = 640, height = 480, spp = 8;
+    printf("Primary rays: %ux%u, %u spp, random sampler, 1 thread\n\n", width, height, spp);
+    printf("%-20s %8s %12s %12s %8s\n", "camera", "lens", "legacy", "raster", "speedup");
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        Camera camera = create_camera_for_scene(SCENE_NAMES[i], (float)width / height);
+        double legacy = time_primary_rays(&camera, width, height, spp, true);
+        double raster = time_primary_rays(&camera, width, height, spp, false);
+        printf("%-20s %8s %9.2f ns %9.2f ns %7.2fx\n", SCENE_NAMES[i],
+               camera_is_pinhole(&camera) ? "pinhole" : "thin", legacy, raster, legacy / raster);
+    }
+    return 0;
+}
+
+// Framebuffer + writer combinations measured by the memory benchmark
+typedef enum {
+    MEMORY_BASELINE,       // Process with no framebuffer
+    MEMORY_LEGACY_BMP,     // Vec3 pixels (16 B) + full 8-bit copy before writing
+    MEMORY_RGB32F_BMP,
+    MEMORY_RGBA16F_BMP,
+    MEMORY_RGB32F_EXR,
+    MEMORY_RGBA16F_EXR,
+    MEMORY_CASE_COUNT
+} MemoryCase;
+
+static const char* const MEMORY_CASE_NAMES[MEMORY_CASE_COUNT] = {
+    "process baseline", "Vec3 + BMP copy", "rgb32f + BMP", "rgba16f + BMP",
+    "rgb32f + EXR", "rgba16f + EXR"
+};
+
+static Vec3 gradient_pixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    return vec3_create(4.0f * x / width, 4.0f * y / height, 0.5f);
+}
+
+// The pre-framebuffer path: Vec3 array plus a whole-frame 8-bit buffer
+static void legacy_save_bmp(uint32_t width, uint32_t height, const char* filename) {
+    size_t count = (size_t)width * height;
+    Vec3* pixels = (Vec3*)malloc(count * sizeof(Vec3));
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            pixels[(size_t)y * width + x] = gradient_pixel(x, y, width, height);
+        }
+    }
+
+    unsigned char* rgb = (unsigned char*)malloc(count * 3);
+    for (size_t i = 0; i < count; i++) {
+        Vec3 color = aces_tonemap(pixels[i]);
+        rgb[i * 3 + 0] = (unsigned char)(fminf(fmaxf(color.x, 0.0f), 1.0f) * 255.0f);
+        rgb[i * 3 + 1] = (unsigned char)(fminf(fmaxf(color.y, 0.0f), 1.0f) * 255.0f);
+        rgb[i * 3 + 2] = (unsigned char)(fminf(fmaxf(color.z, 0.0f), 1.0f) * 255.0f);
+    }
+
+    FILE* f = fopen(filename, "wb");
+    if (f) {
+        fwrite(rgb, 3, count, f);
+        fclose(f);
+    }
+    free(rgb);
+    free(pixels);
+}
+
+static void run_memory_case(MemoryCase which, uint32_t width, uint32_t height, const char* filename) {
+    if (which == MEMORY_BASELINE) return;
+    if (which == MEMORY_LEGACY_BMP) {
+        legacy_save_bmp(width, height, filename);
+        return;
+    }
+
+    bool half = (which == MEMORY_RGBA16F_BMP || which == MEMORY_RGBA16F_EXR);
+    Image* img = image_create_format(width, height, half ? IMAGE_FORMAT_RGBA16F : IMAGE_FORMAT_RGB32F);
+    if (!img) return;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            image_set_pixel(img, x, y, gradient_pixel(x, y, width, height));
+        }
+    }
+
+    if (which == MEMORY_RGB32F_EXR || which == MEMORY_RGBA16F_EXR) {
+        image_save_exr(img, filename);
+    } else {
+        image_save_bmp(img, filename, NULL);
+    }
+    image_destroy(img);
+}
+
+// Peak RSS of an 8K frame in each framebuffer format; each case runs in a
+// fresh child process because ru_maxrss is a high-water mark
+static int bench_memory(const BenchOptions* options) {
+    (void)options;
+    const uint32_t width = 7680, height = 4320;
+    const char* filename = "/tmp/pathtracer_bench_memory.out";
+
+    printf("Framebuffer + writer peak RSS, %ux%u\n\n", width, height);
+    printf("%-20s %12s %10s\n", "case", "peak RSS", "time");
+    fflush(stdout);
+
+    for (int which = 0; which < MEMORY_CASE_COUNT; which++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            double start = now_seconds();
+            run_memory_case((MemoryCase)which, width, height, filename);
+            double elapsed = now_seconds() - start;
+
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            printf("%-20s %9.1f MB %8.2f s\n", MEMORY_CASE_NAMES[which],
+                   usage.ru_maxrss / 1024.0, elapsed);
+            fflush(stdout);
+            _exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
+
+    unlink(filename);
+    return 0;
+}
+
+// Per-pixel Vec3 tonemap + clamp + quantize, as the BMP writer and GUI did it
+static void legacy_tonemap(const Vec3* pixels, uint32_t width, uint32_t height, uint8_t* out) {
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            Vec3 color = aces_tonemap(pixels[(size_t)y * width + x]);
+            color.x = fminf(fmaxf(color.x, 0.0f), 1.0f);
+            color.y = fminf(fmaxf(color.y, 0.0f), 1.0f);
+            color.z = fminf(fmaxf(color.z, 0.0f), 1.0f);
+
+            uint8_t* p = out + ((size_t)y * width + x) * 3;
+            p[0] = (uint8_t)(color.x * 255.99f);
+            p[1] = (uint8_t)(color.y * 255.99f);
+            p[2] = (uint8_t)(color.z * 255.99f);
+        }
+    }
+}
+
+// Tonemap throughput at 4K: legacy scalar loop vs the shared kernel
+static int bench_tonemap(const BenchOptions* options) {
+    const uint32_t width = 3840, height = 2160, repeats = 10;
+    size_t count = (size_t)width * height;
+
+    Vec3* pixels = (Vec3*)malloc(count * sizeof(Vec3));
+    Image* img = image_create(width, height);
+    uint8_t* out = (uint8_t*)malloc(count * 3);
+    RNG rng;
+    rng_init(&rng, 5);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            // HDR values spanning several stops
+            Vec3 c = vec3_scale(vec3_create(rng_float(&rng), rng_float(&rng), rng_float(&rng)),
+                                4.0f * rng_float(&rng));
+            pixels[(size_t)y * width + x] = c;
+            image_set_pixel(img, x, y, c);
+        }
+    }
+
+#ifdef __AVX2__
+    printf("Tonemap %ux%u, kernel: AVX2\n\n", width, height);
+#else
+    printf("Tonemap %ux%u, kernel: scalar\n\n", width, height);
+#endif
+    printf("%-34s %10s %12s\n", "variant", "ms/frame", "Mpixel/s");
+
+    double start = now_seconds();
+    for (uint32_t r = 0; r < repeats; r++) {
+        legacy_tonemap(pixels, width, height, out);
+    }
+    double legacy = (now_seconds() - start) / repeats;
+    printf("%-34s %10.2f %12.1f\n", "legacy Vec3 loop (1 thread)", legacy * 1e3, count / legacy / 1e6);
+
+    struct { const char* name; TonemapOperator op; bool srgb; } variants[] = {
+        {"aces", TONEMAP_ACES, false},
+        {"aces + sRGB", TONEMAP_ACES, true},
+        {"reinhard", TONEMAP_REINHARD, false},
+        {"linear", TONEMAP_LINEAR, false},
+    };
+    int thread_counts[2] = {1, (int)options->threads};
+
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        TonemapSettings settings = {variants[v].op, 0.5f, variants[v].srgb};
+        for (int t = 0; t < 2; t++) {
+            omp_set_num_threads(thread_counts[t]);
+            tonemap_rows(&settings, img, 0, height, out, (size_t)width * 3, PIXEL_LAYOUT_RGB8);
+            start = now_seconds();
+            for (uint32_t r = 0; r < repeats; r++) {
+                tonemap_rows(&settings, img, 0, height, out, (size_t)width * 3, PIXEL_LAYOUT_RGB8);
+            }
+            double elapsed = (now_seconds() - start) / repeats;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s (%d thread%s)", variants[v].name,
+                     thread_counts[t], thread_counts[t] == 1 ? "" : "s");
+            printf("%-34s %10.2f %12.1f\n", name, elapsed * 1e3, count / elapsed / 1e6);
+        }
+    }
+
+    free(out);
+    image_destroy(img);
+    free(pixels);
+    return 0;
+}
+
+// GUI refresh cost per 100 ms tick at 1080p: the old path re-allocated and
+// re-tonemapped the whole frame; the live preview only converts tiles the
+// renderer flagged since the previous tick into a persistent BGRX buffer
+static int bench_display(const BenchOptions* options) {
+    const uint32_t width = 1920, height = 1080, repeats = 50;
+    size_t count = (size_t)width * height;
+
+    Image* img = image_create(width, height);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            image_set_pixel(img, x, y, vec3_scale(gradient_pixel(x, y, width, height), 2.0f));
+        }
+    }
+    TileDirtyMap* map = tile_dirty_map_create(width, height);
+    uint32_t tile_count = map->tiles_x * map->tiles_y;
+    size_t stride = (size_t)width * 4;
+    uint8_t* surface = (uint8_t*)malloc(stride * height);
+    TonemapSettings settings = tonemap_default();
+
+    printf("Display refresh %ux%u (%u tiles of %u px)\n\n", width, height, tile_count, RENDER_TILE_SIZE);
+    printf("%-40s %10s %12s\n", "variant", "ms/tick", "Mpixel/s");
+
+    omp_set_num_threads((int)options->threads);
+    double start = now_seconds();
+    for (uint32_t r = 0; r < repeats; r++) {
+        uint8_t* pixbuf = (uint8_t*)malloc(count * 3);
+        tonemap_rows(&settings, img, 0, height, pixbuf, (size_t)width * 3, PIXEL_LAYOUT_RGB8);
+        free(pixbuf);
+    }
+    double elapsed = (now_seconds() - start) / repeats;
+    char name[64];
+    snprintf(name, sizeof(name), "full frame + alloc (%u threads)", options->threads);
+    printf("%-40s %10.3f %12.1f\n", name, elapsed * 1e3, count / elapsed / 1e6);
+
+    uint32_t dirty_counts[] = {1, 32, 256, tile_count};
+    for (size_t d = 0; d < sizeof(dirty_counts) / sizeof(dirty_counts[0]); d++) {
+        uint32_t dirty = dirty_counts[d];
+        size_t pixels = 0;
+        double total = 0.0;
+        for (uint32_t r = 0; r < repeats; r++) {
+            // Renderer side: flag `dirty` tiles spread over the frame
+            for (uint32_t i = 0; i < dirty; i++) {
+                uint32_t tile = (uint32_t)(((uint64_t)i * tile_count) / dirty);
+                atomic_store_explicit(&map->flags[tile], 1, memory_order_release);
+            }
+
+            // GUI side: one timer tick, main thread only
+            start = now_seconds();
+            for (uint32_t tile = 0; tile < tile_count; tile++) {
+                if (!tile_dirty_map_take(map, tile)) continue;
+                uint32_t x0 = (tile % map->tiles_x) * RENDER_TILE_SIZE;
+                uint32_t y0 = (tile / map->tiles_x) * RENDER_TILE_SIZE;
+                uint32_t x1 = (x0 + RENDER_TILE_SIZE < width) ? x0 + RENDER_TILE_SIZE : width;
+                uint32_t y1 = (y0 + RENDER_TILE_SIZE < height) ? y0 + RENDER_TILE_SIZE : height;
+                tonemap_rect(&settings, img, x0, y0, x1, y1,
+                             surface + (size_t)y0 * stride + (size_t)x0 * 4, stride, PIXEL_LAYOUT_BGRX8);
+                pixels += (size_t)(x1 - x0) * (y1 - y0);
+            }
+            total += now_seconds() - start;
+        }
+        elapsed = total / repeats;
+        snprintf(name, sizeof(name), "dirty tiles: %u (1 thread)", dirty);
+        printf("%-40s %10.3f %12.1f\n", name, elapsed * 1e3, pixels / total / 1e6);
+    }
+
+    free(surface);
+    tile_dirty_map_destroy(map);
+    image_destroy(img);
+    return 0;
+}
+
+// Render running on a helper thread so the bench can cancel it
+typedef struct {
+    const Scene* scene;
+    const Camera* camera;
+    RenderSettings settings;
+    Image* image;
+} CancelJob;
+
+static void* cancel_render_thread(void* user_data) {
+    CancelJob* job = (CancelJob*)user_data;
+    render_parallel(job->scene, job->camera, &job->settings, job->image);
+    return NULL;
+}
+
+// Time from setting the cancel flag to render_parallel returning, per scene,
+// with the flag raised at several points into a render that would not finish
+static int bench_cancel(const BenchOptions* options) {
+    const uint32_t width = 640, height = 480, spp = 4096, trials = 8;
+    printf("Cancel latency: %ux%u, %u spp, depth %u, %u threads, %u trials per scene\n\n",
+           width, height, spp, options->max_depth, options->threads, trials);
+    printf("%-20s %12s %12s\n", "scene", "mean ms", "max ms");
+
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        Scene* scene = create_scene_by_name(SCENE_NAMES[i]);
+        scene_build_bvh(scene);
+        Camera camera = create_camera_for_scene(SCENE_NAMES[i], (float)width / height);
+        Image* image = image_create(width, height);
+        atomic_bool cancel;
+
+        double total = 0.0, worst = 0.0;
+        for (uint32_t t = 0; t < trials; t++) {
+            atomic_init(&cancel, false);
+            CancelJob job = {scene, &camera, bench_settings(options, spp, SAMPLER_RANDOM, 42), image};
+            job.settings.width = width;
+            job.settings.height = height;
+            job.settings.cancel_flag = &cancel;
+
+            pthread_t thread;
+            pthread_create(&thread, NULL, cancel_render_thread, &job);
+            struct timespec delay = {0, (long)(20 + 15 * t) * 1000000L};
+            nanosleep(&delay, NULL);
+
+            double start = now_seconds();
+            atomic_store(&cancel, true);
+            pthread_join(thread, NULL);
+            double stop = now_seconds() - start;
+
+            total += stop;
+            if (stop > worst) worst = stop;
+        }
+        printf("%-20s %12.3f %12.3f\n", SCENE_NAMES[i], total / trials * 1e3, worst * 1e3);
+
+        image_destroy(image);
+        scene_destroy(scene);
+    }
+    return 0;
+}
+
+// Rays from a shell around the origin towards points near the sphere
+static Ray bench_mesh_ray(RNG* rng) {
+    Vec3 origin = vec3_scale(rng_unit_vector(rng), 3.0f);
+    Vec3 target = vec3_scale(rng_unit_vector(rng), 1.2f * rng_float(rng));
+    return ray_create(origin, vec3_sub(target, origin));
+}
+
+// Cast `count` rays at a scene's BVH; returns Mrays/s and stores hit distances
+static double trace_mesh_rays(const Scene* scene, uint32_t count, float* t_out) {
+    double start = now_seconds();
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (uint32_t i = 0; i < count; i++) {
+        RNG rng;
+        rng_init_sample(&rng, 1000, i, 0);
+        Ray ray = bench_mesh_ray(&rng);
+        HitRecord rec;
+        t_out[i] = bvh_hit(scene->bvh, &ray, 0.001f, FLT_MAX, &rec) ? rec.t : -1.0f;
+    }
+    return count / (now_seconds() - start) * 1e-6;
+}
+
+// Memory, build time and ray throughput of a 1M-triangle sphere stored as an
+// indexed mesh vs as one triangle primitive per face
+static int bench_mesh(const BenchOptions* options) {
+    const uint32_t stacks = 500, slices = 1000, ray_count = 2000000;
+    omp_set_num_threads(options->threads);
+    Material mat = material_lambertian(vec3_create(0.7f, 0.7f, 0.7f));
+
+    double start = now_seconds();
+    Mesh* mesh = mesh_create_sphere(stacks, slices, 1.0f);
+    if (!mesh) return 1;
+    Scene* mesh_scene = scene_create();
+    scene_add_mesh(mesh_scene, mesh, mat);
+    scene_build_bvh(mesh_scene);
+    double mesh_build = now_seconds() - start;
+    size_t mesh_bytes = mesh_memory_bytes(mesh);
+
+    start = now_seconds();
+    Scene* tri_scene = scene_create();
+    for (uint32_t t = 0; t < mesh->triangle_count; t++) {
+        const uint32_t* tri = mesh->indices + 3 * (size_t)t;
+        scene_add_triangle(tri_scene, mesh->positions[tri[0]], mesh->positions[tri[1]],
+                           mesh->positions[tri[2]], mat);
+    }
+    scene_build_bvh(tri_scene);
+    double tri_build = now_seconds() - start;
+    size_t tri_bytes = (size_t)tri_scene->prim_capacity * sizeof(Primitive) +
+                       (size_t)tri_scene->bvh->node_count * sizeof(BVHNode) +
+                       (size_t)tri_scene->prim_count * sizeof(uint32_t);
+
+    float* mesh_t = (float*)malloc(ray_count * sizeof(float));
+    float* tri_t = (float*)malloc(ray_count * sizeof(float));
+    double mesh_rate = trace_mesh_rays(mesh_scene, ray_count, mesh_t);
+    double tri_rate = trace_mesh_rays(tri_scene, ray_count, tri_t);
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < ray_count; i++) {
+        if (fabsf(mesh_t[i] - tri_t[i]) > 1e-5f) mismatches++;
+    }
+
+    printf("Sphere with %u triangles, %u vertices, %u threads, %u rays\n\n",
+           mesh->triangle_count, mesh->vertex_count, options->threads, ray_count);
+    printf("%-12s %12s %10s %10s %12s\n", "storage", "memory", "bytes/tri", "build", "Mrays/s");
+    printf("%-12s %9.1f MB %10.1f %8.2f s %12.2f\n", "triangles", tri_bytes / 1048576.0,
+           (double)tri_bytes / mesh->triangle_count, tri_build, tri_rate);
+    printf("%-12s %9.1f MB %10.1f %8.2f s %12.2f\n", "mesh", mesh_bytes / 1048576.0,
+           (double)mesh_bytes / mesh->triangle_count, mesh_build, mesh_rate);
+    printf("\nMesh uses %.1f%% of the memory; %u of %u rays disagree\n",
+           100.0 * mesh_bytes / tri_bytes, mismatches, ray_count);
+
+    free(mesh_t);
+    free(tri_t);
+    scene_destroy(mesh_scene);
+    scene_destroy(tri_scene);
+    return mismatches == 0 ? 0 : 1;
+}
+
+static bool write_obj(const Mesh* mesh, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        Vec3 p = mesh->positions[i], n = mesh->normals[i];
+        fprintf(f, "v %.9g %.9g %.9g\nvn %.9g %.9g %.9g\nvt %.9g %.9g\n", p.x, p.y, p.z,
+                n.x, n.y, n.z, mesh->uvs[2 * i], mesh->uvs[2 * i + 1]);
+    }
+    for (uint32_t t = 0; t < mesh->triangle_count; t++) {
+        const uint32_t* tri = mesh->indices + 3 * (size_t)t;
+        fprintf(f, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", tri[0] + 1, tri[0] + 1, tri[0] + 1,
+                tri[1] + 1, tri[1] + 1, tri[1] + 1, tri[2] + 1, tri[2] + 1, tri[2] + 1);
+    }
+    return fclose(f) == 0;
+}
+
+static bool write_ply(const Mesh* mesh, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "ply\nformat binary_little_endian 1.0\nelement vertex %u\n"
+               "property float x\nproperty float y\nproperty float z\n"
+               "property float nx\nproperty float ny\nproperty float nz\n"
+               "property float u\nproperty float v\n"
+               "element face %u\nproperty list uchar int vertex_indices\nend_header\n",
+            mesh->vertex_count, mesh->triangle_count);
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        float v[8] = {mesh->positions[i].x, mesh->positions[i].y, mesh->positions[i].z,
+                      mesh->normals[i].x, mesh->normals[i].y, mesh->normals[i].z,
+                      mesh->uvs[2 * i], mesh->uvs[2 * i + 1]};
+        fwrite(v, sizeof(v), 1, f);
+    }
+    for (uint32_t t = 0; t < mesh->triangle_count; t++) {
+        uint8_t n = 3;
+        fwrite(&n, 1, 1, f);
+        fwrite(mesh->indices + 3 * (size_t)t, sizeof(uint32_t), 3, f);
+    }
+    return fclose(f) == 0;
+}
+
+// Line-at-a-time stdio parse into one triangle primitive per face, the only
+// way to get an OBJ into a Scene before mesh_io.h
+static uint32_t legacy_load_obj(const char* path, Scene* scene, Material mat) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    uint32_t capacity = 1024, count = 0, triangles = 0;
+    Vec3* positions = (Vec3*)malloc(capacity * sizeof(Vec3));
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        Vec3 p;
+        int a, b, c;
+        if (sscanf(line, "v %f %f %f", &p.x, &p.y, &p.z) == 3) {
+            if (count == capacity) {
+                capacity *= 2;
+                positions = (Vec3*)realloc(positions, capacity * sizeof(Vec3));
+            }
+            positions[count++] = p;
+        } else if (sscanf(line, "f %d/%*d/%*d %d/%*d/%*d %d", &a, &b, &c) == 3) {
+            scene_add_triangle(scene, positions[a - 1], positions[b - 1], positions[c - 1], mat);
+            triangles++;
+        }
+    }
+    fclose(f);
+    free(positions);
+    return triangles;
+}
+
+// Largest position difference and number of differing indices between meshes
+static float compare_meshes(const Mesh* a, const Mesh* b, uint32_t* index_mismatches) {
+    *index_mismatches = UINT32_MAX;
+    if (a->vertex_count != b->vertex_count || a->triangle_count != b->triangle_count) return INFINITY;
+    float max_error = 0.0f;
+    for (uint32_t i = 0; i < a->vertex_count; i++) {
+        Vec3 d = vec3_sub(a->positions[i], b->positions[i]);
+        max_error = fmaxf(max_error, fmaxf(fabsf(d.x), fmaxf(fabsf(d.y), fabsf(d.z))));
+    }
+    *index_mismatches = 0;
+    for (size_t i = 0; i < 3 * (size_t)a->triangle_count; i++) {
+        if (a->indices[i] != b->indices[i]) (*index_mismatches)++;
+    }
+    return max_error;
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static void print_load_row(const char* name, double bytes, uint32_t triangles, double seconds) {
+    printf("%-28s %10.3f s %10.1f MB/s %10.2f Mtri/s\n", name, seconds, bytes / seconds / 1048576.0,
+           triangles / seconds * 1e-6);
+}
+
+// OBJ and binary PLY load throughput: single- and multi-threaded mmap
+// loaders, and the stdio + per-triangle primitive path for comparison.
+// Uses a generated 1M-triangle sphere unless --mesh names a file.
+static int bench_meshload(const BenchOptions* options) {
+    const char* obj_path = "/tmp/pathtracer_bench_mesh.obj";
+    const char* ply_path = "/tmp/pathtracer_bench_mesh.ply";
+    Mesh* reference = NULL;
+    const char* paths[2] = {obj_path, ply_path};
+    int path_count = 2;
+
+    if (options->mesh_path) {
+        paths[0] = options->mesh_path;
+        path_count = 1;
+    } else {
+        reference = mesh_create_sphere(500, 1000, 1.0f);
+        if (!reference || !write_obj(reference, obj_path) || !write_ply(reference, ply_path)) {
+            fprintf(stderr, "Failed to write the benchmark meshes to /tmp\n");
+            mesh_destroy(reference);
+            return 1;
+        }
+    }
+
+    int status = 0;
+    int thread_counts[2] = {1, (int)options->threads};
+    printf("%-28s %12s %15s %17s\n", "loader", "time", "throughput", "triangles");
+    for (int f = 0; f < path_count; f++) {
+        const char* path = paths[f];
+        double bytes = (double)file_size(path);
+        printf("\n%s (%.1f MB)\n", path, bytes / 1048576.0);
+
+        for (int t = 0; t < 2; t++) {
+            omp_set_num_threads(thread_counts[t]);
+            double start = now_seconds();
+            Mesh* mesh = mesh_load(path);
+            double elapsed = now_seconds() - start;
+            if (!mesh) {
+                status = 1;
+                break;
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "mmap parser (%d thread%s)", thread_counts[t],
+                     thread_counts[t] == 1 ? "" : "s");
+            print_load_row(name, bytes, mesh->triangle_count, elapsed);
+
+            if (reference && t == 0) {
+                uint32_t index_mismatches;
+                float error = compare_meshes(reference, mesh, &index_mismatches);
+                printf("%-28s max position error %g, %u index mismatches\n", "", error,
+                       index_mismatches);
+                if (error > 1e-6f || index_mismatches != 0) status = 1;
+            }
+            mesh_destroy(mesh);
+        }
+
+        if (reference && path == obj_path) {
+            Scene* scene = scene_create();
+            double start = now_seconds();
+            uint32_t triangles = legacy_load_obj(path, scene, material_lambertian(vec3_create(0.7f, 0.7f, 0.7f)));
+            print_load_row("stdio + scene_add_triangle", bytes, triangles, now_seconds() - start);
+            scene_destroy(scene);
+        }
+    }
+
+    if (reference) {
+        unlink(obj_path);
+        unlink(ply_path);
+        mesh_destroy(reference);
+    }
+    return status;
+}
+
+// Startup cost of a 1M-triangle mesh scene: hashing + BVH build + save on a
+// cache miss vs mapping the cached file on a hit
+static int bench_scenecache(const BenchOptions* options) {
+    const char* dir = "/tmp/pathtracer_bench_cache";
+    const uint32_t ray_count = 200000;
+    omp_set_num_threads(options->threads);
+    Material mat = material_lambertian(vec3_create(0.7f, 0.7f, 0.7f));
+
+    Mesh* mesh = mesh_create_sphere(500, 1000, 1.0f);
+    if (!mesh) return 1;
+    Scene* built = scene_create();
+    scene_add_mesh(built, mesh, mat);
+    scene_add_sphere(built, vec3_create(0, -1001, 0), 1000, mat);
+
+    double start = now_seconds();
+    uint64_t key = scene_content_hash(built);
+    double hash_time = now_seconds() - start;
+    start = now_seconds();
+    scene_build_bvh(built);
+    double build_time = now_seconds() - start;
+    start = now_seconds();
+    bool saved = scene_cache_save(built, dir, key);
+    double save_time = now_seconds() - start;
+
+    start = now_seconds();
+    Scene* cached = saved ? scene_cache_load(dir, key) : NULL;
+    double load_time = now_seconds() - start;
+    if (!cached) {
+        scene_destroy(built);
+        return 1;
+    }
+
+    // First traversal of the mapped scene pays its page faults
+    float* built_t = (float*)malloc(ray_count * sizeof(float));
+    float* cached_t = (float*)malloc(ray_count * sizeof(float));
+    start = now_seconds();
+    trace_mesh_rays(cached, ray_count, cached_t);
+    double first_trace = now_seconds() - start;
+    double cached_rate = trace_mesh_rays(cached, ray_count, cached_t);
+    double built_rate = trace_mesh_rays(built, ray_count, built_t);
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < ray_count; i++) {
+        if (cached_t[i] != built_t[i]) mismatches++;
+    }
+
+    printf("Sphere mesh with %u triangles, %u threads\n\n", mesh->triangle_count, options->threads);
+    printf("%-34s %10.1f ms\n", "content hash", hash_time * 1e3);
+    printf("%-34s %10.1f ms\n", "BVH build (cache miss)", build_time * 1e3);
+    printf("%-34s %10.1f ms\n", "save", save_time * 1e3);
+    printf("%-34s %10.1f ms\n", "map cached scene (cache hit)", load_time * 1e3);
+    printf("%-34s %10.1f ms\n", "first 200K rays on mapped scene", first_trace * 1e3);
+    printf("\nMrays/s built %.2f, mapped %.2f; %u of %u rays disagree\n", built_rate, cached_rate,
+           mismatches, ray_count);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%016llx%s", dir, (unsigned long long)key, SCENE_CACHE_EXTENSION);
+    unlink(path);
+    rmdir(dir);
+    free(built_t);
+    free(cached_t);
+    scene_destroy(cached);
+    scene_destroy(built);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Sphere records parsed the obvious way (fgets + sscanf), for comparison
+static uint32_t sscanf_count_spheres(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    char line[512];
+    char material[64];
+    float x, y, z, r;
+    uint32_t count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "sphere %63s %f %f %f %f", material, &x, &y, &z, &r) == 5) count++;
+    }
+    fclose(file);
+    return count;
+}
+
+// Scene file write and parse throughput for 1M spheres sharing 1000
+// materials, checked by reloading to the same content hash
+static int bench_scenefile(const BenchOptions* options) {
+    const char* path = "/tmp/pathtracer_bench.scene";
+    const uint32_t sphere_count = 1000000;
+    const uint32_t material_count = 1000;
+    (void)options;
+
+    RNG rng;
+    rng_init(&rng, 7);
+    Material* materials = (Material*)malloc(material_count * sizeof(Material));
+    for (uint32_t i = 0; i < material_count; i++) {
+        Vec3 color = vec3_create(rng_float(&rng), rng_float(&rng), rng_float(&rng));
+        materials[i] = (i % 3 == 0) ? material_lambertian(color) :
+                       (i % 3 == 1) ? material_metal(color, rng_float(&rng) * 0.5f) :
+                                      material_dielectric(1.3f + rng_float(&rng) * 0.4f);
+    }
+    Scene* scene = scene_create();
+    scene_reserve(scene, sphere_count);
+    for (uint32_t i = 0; i < sphere_count; i++) {
+        Vec3 center = vec3_create(rng_float_range(&rng, -500.0f, 500.0f), rng_float(&rng) * 10.0f,
+                                  rng_float_range(&rng, -500.0f, 500.0f));
+        scene_add_sphere(scene, center, 0.1f + rng_float(&rng), materials[rng_uint32(&rng) % material_count]);
+    }
+    free(materials);
+    CameraParams camera = camera_params_default();
+
+    double start = now_seconds();
+    bool saved = scene_file_save(path, scene, &camera, NULL, NULL);
+    double save_time = now_seconds() - start;
+    SceneDescription desc;
+    start = now_seconds();
+    bool loaded = saved && scene_file_load(path, &desc);
+    double load_time = now_seconds() - start;
+    if (!loaded) {
+        scene_destroy(scene);
+        unlink(path);
+        return 1;
+    }
+    start = now_seconds();
+    uint32_t scanned = sscanf_count_spheres(path);
+    double sscanf_time = now_seconds() - start;
+
+    struct stat st;
+    double megabytes = stat(path, &st) == 0 ? st.st_size / 1e6 : 0.0;
+    bool same = scene_content_hash(scene) == scene_content_hash(desc.scene);
+    printf("%u spheres, %u materials, %.1f MB\n\n", sphere_count, material_count, megabytes);
+    printf("%-34s %10.1f ms %8.1f MB/s\n", "scene_file_save", save_time * 1e3, megabytes / save_time);
+    printf("%-34s %10.1f ms %8.1f MB/s %6.2f M prims/s\n", "scene_file_load", load_time * 1e3,
+           megabytes / load_time, desc.scene->prim_count / load_time * 1e-6);
+    printf("%-34s %10.1f ms %8.1f MB/s (%u records)\n", "fgets + sscanf (parse only)",
+           sscanf_time * 1e3, megabytes / sscanf_time, scanned);
+    printf("\nReloaded scene %s the original\n", same ? "matches" : "DIFFERS from");
+
+    unlink(path);
+    scene_destroy(desc.scene);
+    sequence_free(&desc.sequence);
+    scene_destroy(scene);
+    return same ? 0 : 1;
+}
+
+// Bytes held by a built scene: primitives, top-level BVH and meshes
+static size_t scene_memory_bytes(const Scene* scene) {
+    size_t bytes = (size_t)scene->prim_count * sizeof(Primitive);
+    if (scene->bvh) {
+        bytes += (size_t)scene->bvh->node_count * sizeof(BVHNode);
+        if (scene->bvh->indices) bytes += (size_t)scene->bvh->prim_count * sizeof(uint32_t);
+    }
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        bytes += mesh_memory_bytes(scene->meshes[i]);
+    }
+    bytes += (size_t)scene->instance_count * sizeof(Instance);
+    for (uint32_t i = 0; i < scene->group_count; i++) {
+        bytes += scene_memory_bytes(scene->groups[i]);
+    }
+    return bytes;
+}
+
+// Pinhole rays through random points of the generator's camera; returns
+// Mrays/s and the mean BVH nodes visited per ray
+static double trace_camera_rays(const Scene* scene, const Camera* camera, uint32_t count,
+                                double* nodes_per_ray) {
+    uint64_t nodes = 0;
+    double start = now_seconds();
+    #pragma omp parallel for schedule(dynamic, 4096) reduction(+:nodes)
+    for (uint32_t i = 0; i < count; i++) {
+        RNG rng;
+        rng_init_sample(&rng, 2000, i, 0);
+        Vec3 film = vec3_add(vec3_add(camera->lower_left_corner,
+                                      vec3_scale(camera->horizontal, rng_float(&rng))),
+                             vec3_scale(camera->vertical, rng_float(&rng)));
+        Ray ray = ray_create(camera->origin, vec3_sub(film, camera->origin));
+        HitRecord rec;
+        uint64_t before = render_thread_counters.bvh_nodes;
+        bvh_hit(scene->bvh, &ray, 0.001f, FLT_MAX, &rec);
+        nodes += render_thread_counters.bvh_nodes - before;
+    }
+    double elapsed = now_seconds() - start;
+    *nodes_per_ray = (double)nodes / count;
+    return count / elapsed * 1e-6;
+}
+
+// bvh_create / bvh_hit scaling over the procedural generators, from 10K
+// primitives (or triangles) up to --max-prims in steps of 10x
+static int bench_scaling(const BenchOptions* options) {
+    const uint32_t ray_count = 200000;
+    omp_set_num_threads(options->threads);
+
+    printf("%u threads, %u camera rays per scene\n\n", options->threads, ray_count);
+    printf("%-12s %10s %9s %9s %8s %10s %8s %9s %8s\n", "generator", "prims", "generate",
+           "build", "ns/prim", "memory", "B/prim", "nodes/ray", "Mrays/s");
+    bool ok = true;
+    for (int type = 0; type < GENERATOR_TYPE_COUNT; type++) {
+        const char* name = generator_type_name((GeneratorType)type);
+        if (options->generator && strcmp(options->generator, name) != 0) continue;
+
+        for (uint64_t count = 10000; count <= options->max_prims; count *= 10) {
+            GeneratorSpec spec = {(GeneratorType)type, (uint32_t)count, 1};
+            double start = now_seconds();
+            Scene* scene = generate_scene(&spec);
+            double generate_time = now_seconds() - start;
+            if (!scene) {
+                printf("%-12s %10llu  out of memory\n", name, (unsigned long long)count);
+                ok = false;
+                break;
+            }
+            start = now_seconds();
+            scene_build_bvh(scene);
+            double build_time = now_seconds() - start;
+
+            CameraParams params = generator_camera(&spec);
+            Camera camera = camera_from_params(&params, 1.0f);
+            double nodes_per_ray;
+            double rate = trace_camera_rays(scene, &camera, ray_count, &nodes_per_ray);
+            size_t bytes = scene_memory_bytes(scene);
+            printf("%-12s %10llu %7.3f s %7.3f s %8.0f %7.1f MB %8.0f %9.1f %8.2f\n", name,
+                   (unsigned long long)count, generate_time, build_time, build_time / count * 1e9,
+                   bytes / 1048576.0, (double)bytes / count, nodes_per_ray, rate);
+            fflush(stdout);
+            scene_destroy(scene);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// Path of one Random Spheres ball, kept in step with the primitive array
+typedef struct {
+    Vec3 start;
+    Vec3 velocity;  // Drift across the ground plane
+    float phase;    // Bounce phase (small balls only; large ones just drift)
+} SphereMotion;
+
+typedef struct {
+    const char* name;
+    float threshold;  // For scene_refit_bvh
+} RefitStrategy;
+
+// Move every ball except the ground to its position at `time` seconds
+static void move_spheres(Scene* scene, const SphereMotion* motion, float time) {
+    for (uint32_t i = 0; i < scene->prim_count; i++) {
+        Primitive* prim = &scene->primitives[i];
+        if (prim->sphere.radius > 10.0f) continue;
+        Vec3 center = vec3_add(motion[i].start, vec3_scale(motion[i].velocity, time));
+        if (prim->sphere.radius < 0.5f) {
+            center.y += 0.8f * fabsf(sinf(3.0f * time + motion[i].phase));
+        }
+        prim->sphere.center = center;
+        prim->bounds = sphere_bounds(&prim->sphere);
+    }
+}
+
+// Follow a rebuild's reordering of the primitives (bvh->indices)
+static void permute_motion(const BVH* bvh, SphereMotion** motion, SphereMotion** scratch) {
+    for (uint32_t i = 0; i < bvh->prim_count; i++) {
+        (*scratch)[i] = (*motion)[bvh->indices[i]];
+    }
+    SphereMotion* swap = *motion;
+    *motion = *scratch;
+    *scratch = swap;
+}
+
+// Random Spheres animated for `frames` frames at 24 fps with the balls
+// drifting apart: BVH update cost vs ray throughput when rebuilding every
+// frame, refitting only, or refitting until the SAH cost passes a threshold
+static int bench_refit(const BenchOptions* options) {
+    const uint32_t frames = 240, ray_count = 20000;
+    const RefitStrategy strategies[] = {
+        {"rebuild", 0.0f},
+        {"refit 1.1x", SCENE_REBUILD_THRESHOLD},
+        {"refit 1.2x", 1.2f},
+        {"refit 1.3x", 1.3f},
+        {"refit only", FLT_MAX},
+    };
+    omp_set_num_threads(options->threads);
+
+    Camera camera = create_camera_for_scene("Random Spheres", 16.0f / 9.0f);
+    printf("Random Spheres, %u frames, %u camera rays per frame, %u threads\n\n", frames, ray_count,
+           options->threads);
+    printf("%-11s %9s %14s %13s %10s %10s %9s\n", "strategy", "rebuilds", "update us/fr", "trace ms/fr",
+           "frame ms", "nodes/ray", "SAH end");
+    for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        Scene* scene = create_random_spheres();
+        SphereMotion* motion = (SphereMotion*)malloc(scene->prim_count * sizeof(SphereMotion));
+        SphereMotion* scratch = (SphereMotion*)malloc(scene->prim_count * sizeof(SphereMotion));
+        RNG rng;
+        rng_init(&rng, 7);
+        for (uint32_t i = 0; i < scene->prim_count; i++) {
+            float heading = rng_float_range(&rng, 0.0f, 2.0f * (float)M_PI);
+            float speed = rng_float_range(&rng, 0.3f, 1.5f);
+            motion[i].start = scene->primitives[i].sphere.center;
+            motion[i].velocity = vec3_create(speed * cosf(heading), 0.0f, speed * sinf(heading));
+            motion[i].phase = rng_float_range(&rng, 0.0f, (float)M_PI);
+        }
+        scene_build_bvh(scene);
+        permute_motion(scene->bvh, &motion, &scratch);
+
+        uint32_t rebuilds = 0;
+        double update_time = 0.0, trace_time = 0.0, nodes = 0.0;
+        for (uint32_t frame = 1; frame <= frames; frame++) {
+            move_spheres(scene, motion, frame / 24.0f);
+            double start = now_seconds();
+            bool rebuilt = scene_refit_bvh(scene, strategies[s].threshold);
+            update_time += now_seconds() - start;
+            if (rebuilt) {
+                rebuilds++;
+                permute_motion(scene->bvh, &motion, &scratch);
+            }
+
+            double nodes_per_ray;
+            start = now_seconds();
+            trace_camera_rays(scene, &camera, ray_count, &nodes_per_ray);
+            trace_time += now_seconds() - start;
+            nodes += nodes_per_ray;
+        }
+        printf("%-11s %9u %14.1f %13.2f %10.2f %10.1f %8.2fx\n", strategies[s].name, rebuilds,
+               update_time / frames * 1e6, trace_time / frames * 1e3,
+               (update_time + trace_time) / frames * 1e3, nodes / frames,
+               bvh_sah_cost(scene->bvh) / scene->bvh->build_cost);
+        free(motion);
+        free(scratch);
+        scene_destroy(scene);
+    }
+    return 0;
+}
+
+// Random Spheres turntable with every eighth small ball hopping, as a
+// keyframed sequence
+static bool bench_sequence_keys(const Scene* scene, uint32_t frames, Sequence* seq) {
+    CameraParams camera = camera_params_for_scene("Random Spheres");
+    if (!sequence_turntable(seq, frames, &camera)) return false;
+    uint32_t hops = 0;
+    for (uint32_t i = 0; i < scene->prim_count; i += 8) hops++;
+    seq->move_keys = (MoveKey*)malloc(hops * 3 * sizeof(MoveKey));
+    if (!seq->move_keys) return false;
+    for (uint32_t i = 0; i < scene->prim_count; i += 8) {
+        if (scene->primitives[i].sphere.radius >= 0.5f) continue;
+        MoveKey* key = &seq->move_keys[seq->move_key_count];
+        key[0] = (MoveKey){0, i, vec3_create(0, 0, 0)};
+        key[1] = (MoveKey){frames / 2, i, vec3_create(0, 0.6f, 0)};
+        key[2] = (MoveKey){frames - 1, i, vec3_create(0, 0, 0)};
+        seq->move_key_count += 3;
+    }
+    sequence_sort(seq);
+    return true;
+}
+
+// One frame the way a script re-running the CLI per frame would: a fresh
+// process that creates the scene, builds its BVH, renders and writes
+static bool render_frame_process(const RenderSettings* settings, uint32_t frames, uint32_t frame,
+                                 const SequenceOutput* output) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        Scene* scene = create_random_spheres();
+        Sequence seq = {0};
+        SequenceOutput one = *output;
+        one.frame_begin = frame;
+        one.frame_end = frame + 1;
+        SequenceStats stats;
+        CameraParams camera = camera_params_for_scene("Random Spheres");
+        bool ok = bench_sequence_keys(scene, frames, &seq) &&
+                  sequence_render(scene, &seq, &camera, settings, &one, &stats);
+        _exit(ok ? 0 : 1);
+    }
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool files_equal(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    bool equal = fa && fb;
+    while (equal) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        equal = ca == cb;
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return equal;
+}
+
+// Frames/hour of an animated Random Spheres turntable rendered as one
+// sequence (scene, BVH and threads reused, writes overlapped with the next
+// frame) vs one process per frame
+static int bench_sequence(const BenchOptions* options) {
+    const uint32_t frames = 24;
+    const char* patterns[] = {"/tmp/pathtracer_bench_frame_%04d.bmp",
+                              "/tmp/pathtracer_bench_sequence_%04d.bmp"};
+    RenderSettings settings = bench_settings(options, 16, SAMPLER_RANDOM, 42);
+    TonemapSettings tonemap = tonemap_default();
+    printf("Random Spheres turntable with hopping balls, %u frames, %ux%u, %u spp, %u threads\n\n",
+           frames, settings.width, settings.height, settings.samples_per_pixel, settings.num_threads);
+    printf("%-34s %9s %10s %12s\n", "mode", "seconds", "ms/frame", "frames/hour");
+
+    // Processes first, so they fork before this one starts a thread pool
+    SequenceOutput output = {patterns[0], &tonemap, IMAGE_FORMAT_RGB32F, 0, 0, false};
+    bool ok = true;
+    double start = now_seconds();
+    for (uint32_t frame = 0; ok && frame < frames; frame++) {
+        ok = render_frame_process(&settings, frames, frame, &output);
+    }
+    double process_time = now_seconds() - start;
+    if (ok) {
+        printf("%-34s %9.2f %10.1f %12.0f\n", "process per frame", process_time,
+               process_time / frames * 1e3, frames / process_time * 3600.0);
+    }
+
+    Scene* scene = create_random_spheres();
+    Sequence seq = {0};
+    CameraParams camera = camera_params_for_scene("Random Spheres");
+    SequenceStats stats = {0};
+    output.pattern = patterns[1];
+    ok = ok && bench_sequence_keys(scene, frames, &seq) &&
+         sequence_render(scene, &seq, &camera, &settings, &output, &stats);
+    if (ok) {
+        printf("%-34s %9.2f %10.1f %12.0f\n", "sequence (reuse + pipelined writes)", stats.elapsed,
+               stats.elapsed / frames * 1e3, frames / stats.elapsed * 3600.0);
+        printf("\nSequence: %.2f s rendering, %.3f s BVH updates (%u rebuilds); %.2fx frames/hour\n",
+               stats.render_time, stats.update_time, stats.rebuilds, process_time / stats.elapsed);
+    }
+
+    uint32_t mismatched = 0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        char paths[2][64];
+        for (int i = 0; i < 2; i++) snprintf(paths[i], sizeof(paths[i]), patterns[i], (int)frame);
+        if (ok && !files_equal(paths[0], paths[1])) mismatched++;
+        unlink(paths[0]);
+        unlink(paths[1]);
+    }
+    if (ok) printf("Frames %s\n", mismatched ? "DIFFER between the modes" : "match between the modes");
+    sequence_free(&seq);
+    scene_destroy(scene);
+    return ok && mismatched == 0 ? 0 : 1;
+}
+
+// The Motion Blur scene frozen at shutter time t: moving primitives placed
+// where they are at t and made static
+static Scene* motion_snapshot(float t) {
+    Scene* scene = create_motion_blur();
+    for (uint32_t i = 0; i < scene->prim_count; i++) {
+        Primitive* prim = &scene->primitives[i];
+        if (!prim->moving) continue;
+        Vec3 offset = vec3_scale(prim->motion, t);
+        if (prim->type == PRIMITIVE_SPHERE) {
+            prim->sphere.center = vec3_add(prim->sphere.center, offset);
+        } else {
+            prim->triangle.v0 = vec3_add(prim->triangle.v0, offset);
+            prim->triangle.v1 = vec3_add(prim->triangle.v1, offset);
+            prim->triangle.v2 = vec3_add(prim->triangle.v2, offset);
+        }
+        prim->bounds = aabb_translate(prim->bounds, offset);
+        primitive_set_motion(prim, vec3_create(0, 0, 0));
+    }
+    scene->has_motion = false;
+    scene_build_bvh(scene);
+    return scene;
+}
+
+// Averaging `count` full renders of static snapshots at stratified shutter
+// times, each at `spp`
+static double render_snapshots(const BenchOptions* options, const Camera* camera, uint32_t count,
+                               uint32_t spp, Image* output) {
+    Image* frame = image_create(options->width, options->height);
+    for (uint32_t y = 0; y < options->height; y++) {
+        for (uint32_t x = 0; x < options->width; x++) {
+            image_set_pixel(output, x, y, vec3_create(0, 0, 0));
+        }
+    }
+    double start = now_seconds();
+    for (uint32_t k = 0; k < count; k++) {
+        Scene* scene = motion_snapshot((k + 0.5f) / count);
+        RenderSettings settings = bench_settings(options, spp, SAMPLER_RANDOM, 42 + k);
+        render_parallel(scene, camera, &settings, frame);
+        scene_destroy(scene);
+        for (uint32_t y = 0; y < options->height; y++) {
+            for (uint32_t x = 0; x < options->width; x++) {
+                Vec3 sum = vec3_add(image_get_pixel(output, x, y),
+                                    vec3_scale(image_get_pixel(frame, x, y), 1.0f / count));
+                image_set_pixel(output, x, y, sum);
+            }
+        }
+    }
+    image_destroy(frame);
+    return now_seconds() - start;
+}
+
+// Motion Blur scene: one render with time-sampled rays through the
+// motion-aware BVH vs averaging static snapshot renders, as time and RMSE
+// against a time-sampled reference
+static int bench_motionblur(const BenchOptions* options) {
+    const uint32_t snapshot_counts[] = {4, 16};
+    Camera camera = create_camera_for_scene("Motion Blur", (float)options->width / options->height);
+    Scene* scene = create_motion_blur();
+    scene_build_bvh(scene);
+    printf("Motion Blur, %ux%u, depth %u, reference %u spp, %u threads\n", options->width,
+           options->height, options->max_depth, options->reference_spp, options->threads);
+
+    Image* reference = image_create(options->width, options->height);
+    RenderSettings settings = bench_settings(options, options->reference_spp, SAMPLER_RANDOM, 0x5EEDULL);
+    double start = now_seconds();
+    render_parallel(scene, &camera, &settings, reference);
+    printf("Reference rendered in %.2f s\n\n", now_seconds() - start);
+
+    printf("%-30s %8s %9s %10s\n", "mode", "spp", "seconds", "RMSE");
+    Image* image = image_create(options->width, options->height);
+    uint32_t spp = options->max_spp;
+    settings = bench_settings(options, spp, SAMPLER_RANDOM, 42);
+    start = now_seconds();
+    render_parallel(scene, &camera, &settings, image);
+    double time_sampled = now_seconds() - start;
+    printf("%-30s %8u %9.2f %10.5f\n", "time-sampled rays", spp, time_sampled,
+           image_rmse(image, reference));
+
+    for (size_t i = 0; i < sizeof(snapshot_counts) / sizeof(snapshot_counts[0]); i++) {
+        uint32_t count = snapshot_counts[i];
+        char label[48];
+        // Same total samples, then a full render per snapshot as before
+        uint32_t budgets[2] = {spp / count > 0 ? spp / count : 1, spp};
+        for (int b = 0; b < 2; b++) {
+            snprintf(label, sizeof(label), "%u snapshots x %u spp", count, budgets[b]);
+            double seconds = render_snapshots(options, &camera, count, budgets[b], image);
+            printf("%-30s %8u %9.2f %10.5f  (%.1fx time)\n", label, count * budgets[b], seconds,
+                   image_rmse(image, reference), seconds / time_sampled);
+        }
+    }
+
+    image_destroy(image);
+    image_destroy(reference);
+    scene_destroy(scene);
+    return 0;
+}
+
+// One mesh mixing a room's huge wall, floor and ceiling triangles, long thin
+// beams running diagonally across it and small triangles of clutter, like an
+// architectural model loaded from a single file
+static Scene* sbvh_room_scene(CameraParams* camera) {
+    const uint32_t beams = 2000, clutter = 20000;
+    uint32_t triangles = 12 + beams + clutter;
+    Mesh* mesh = mesh_create(3 * triangles, triangles, false, false);
+    if (!mesh) return NULL;
+
+    const Vec3 lo = vec3_create(-4, 0, -4), hi = vec3_create(4, 3, 4);
+    Vec3 corners[8];
+    for (int c = 0; c < 8; c++) {
+        corners[c] = vec3_create(c == 1 || c == 2 || c == 5 || c == 6 ? hi.x : lo.x,
+                                 c == 2 || c == 3 || c == 6 || c == 7 ? hi.y : lo.y,
+                                 c >= 4 ? hi.z : lo.z);
+    }
+    const uint8_t faces[6][4] = {
+        {0, 1, 2, 3}, {5, 4, 7, 6}, {4, 0, 3, 7}, {1, 5, 6, 2}, {4, 5, 1, 0}, {3, 2, 6, 7},
+    };
+    Vec3* v = mesh->positions;
+    for (int f = 0; f < 6; f++) {
+        const uint8_t* q = faces[f];
+        Vec3 quad[6] = {corners[q[0]], corners[q[1]], corners[q[2]],
+                        corners[q[0]], corners[q[2]], corners[q[3]]};
+        memcpy(v, quad, sizeof(quad));
+        v += 6;
+    }
+    RNG rng;
+    rng_init(&rng, 11);
+    for (uint32_t b = 0; b < beams; b++) {
+        float y = 2.2f + 0.7f * rng_float(&rng);
+        float z0 = rng_float_range(&rng, -4.0f, 4.0f), z1 = rng_float_range(&rng, -4.0f, 4.0f);
+        *v++ = vec3_create(-4.0f, y, z0);
+        *v++ = vec3_create(4.0f, y, z1);
+        *v++ = vec3_create(4.0f, y + 0.08f, z1);
+    }
+    for (uint32_t c = 0; c < clutter; c++) {
+        Vec3 p = vec3_create(rng_float_range(&rng, -3.8f, 3.8f), 1.5f * rng_float(&rng) * rng_float(&rng),
+                             rng_float_range(&rng, -3.8f, 3.8f));
+        *v++ = p;
+        *v++ = vec3_add(p, vec3_create(rng_float_range(&rng, -0.05f, 0.05f), 0.05f, 0.0f));
+        *v++ = vec3_add(p, vec3_create(0.0f, rng_float_range(&rng, -0.05f, 0.05f), 0.05f));
+    }
+    for (uint32_t i = 0; i < 3 * triangles; i++) mesh->indices[i] = i;
+
+    Scene* scene = scene_create();
+    scene_add_mesh(scene, mesh, material_lambertian(vec3_create(0.7f, 0.7f, 0.7f)));
+    *camera = camera_params_default();
+    camera->lookfrom = vec3_create(3.5f, 1.7f, 3.5f);
+    camera->lookat = vec3_create(-1.0f, 0.8f, -1.0f);
+    camera->vfov = 70.0f;
+    return scene;
+}
+
+// Unbuilt scene `index` of the sbvh benchmark; NULL past the last one
+static Scene* sbvh_scene(const BenchOptions* options, int index, const char** name,
+                         CameraParams* camera) {
+    static const char* const GENERATED[] = {"terrain:100K", "sphere-mesh:100K"};
+    switch (index) {
+    case 0:
+        *name = "Cornell Box";
+        *camera = camera_params_for_scene(*name);
+        return create_scene_by_name(*name);
+    case 1:
+        *name = "room (beams, clutter)";
+        return sbvh_room_scene(camera);
+    case 2:
+    case 3: {
+        GeneratorSpec spec;
+        *name = GENERATED[index - 2];
+        generator_spec_parse(*name, &spec);
+        *camera = generator_camera(&spec);
+        return generate_scene(&spec);
+    }
+    case 4:
+        if (!options->mesh_path) return NULL;
+        Mesh* mesh = mesh_load(options->mesh_path);
+        if (!mesh) return NULL;
+        *name = options->mesh_path;
+        *camera = camera_params_for_mesh_scene();
+        return create_mesh_scene(mesh);
+    default:
+        return NULL;
+    }
+}
+
+// Items (primitives and mesh triangles) and the leaf references to them
+static void count_references(const Scene* scene, uint64_t* items, uint64_t* refs, uint64_t* nodes) {
+    const BVH* bvh = scene->bvh;
+    *items += bvh->prim_count;
+    *refs += bvh->refs ? bvh->ref_count : bvh->prim_count;
+    *nodes += bvh->node_count;
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        bvh = scene->meshes[i]->bvh;
+        *items += bvh->prim_count;
+        *refs += bvh->refs ? bvh->ref_count : bvh->prim_count;
+        *nodes += bvh->node_count;
+    }
+}
+
+// The scene's BVH over the most items (a mesh's, for the mesh scenes)
+static const BVH* largest_bvh(const Scene* scene) {
+    const BVH* largest = scene->bvh;
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        if (scene->meshes[i]->bvh->prim_count > largest->prim_count) largest = scene->meshes[i]->bvh;
+    }
+    return largest;
+}
+
+// Binned SAH vs spatial splits at several reference budgets on triangle
+// scenes: build time, duplicated references, SAH cost, BVH nodes per
+// camera ray and Mrays/s
+static int bench_sbvh(const BenchOptions* options) {
+    const uint32_t ray_count = 200000;
+    const float budgets[] = {0.0f, 1.1f, SCENE_SPATIAL_SPLIT_BUDGET, 2.0f};
+    omp_set_num_threads(options->threads);
+
+    printf("%u threads, %u camera rays per scene\n\n", options->threads, ray_count);
+    printf("%-22s %-10s %9s %9s %8s %7s %10s %8s %8s\n", "scene", "builder", "build", "nodes",
+           "refs", "SAH", "nodes/ray", "Mrays/s", "speedup");
+    for (int index = 0;; index++) {
+        double base_rate = 0.0;
+        const char* name = NULL;
+        for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+            CameraParams params;
+            Scene* scene = sbvh_scene(options, index, &name, &params);
+            if (!scene) break;
+            scene->spatial_split_budget = budgets[b];
+            double start = now_seconds();
+            scene_build_bvh(scene);
+            double build_time = now_seconds() - start;
+
+            uint64_t items = 0, refs = 0, nodes = 0;
+            count_references(scene, &items, &refs, &nodes);
+            Camera camera = camera_from_params(&params, 1.0f);
+            double nodes_per_ray;
+            double rate = trace_camera_rays(scene, &camera, ray_count, &nodes_per_ray);
+            if (b == 0) base_rate = rate;
+
+            char builder[16];
+            if (budgets[b] > 0.0f) {
+                snprintf(builder, sizeof(builder), "SBVH %.1f", budgets[b]);
+            } else {
+                snprintf(builder, sizeof(builder), "binned SAH");
+            }
+            printf("%-22s %-10s %7.3f s %9llu %+7.1f%% %7.3f %10.1f %8.2f %7.2fx\n", name, builder,
+                   build_time, (unsigned long long)nodes, 100.0 * ((double)refs / items - 1.0),
+                   bvh_sah_cost(largest_bvh(scene)), nodes_per_ray, rate, rate / base_rate);
+            fflush(stdout);
+            scene_destroy(scene);
+        }
+        if (!name) break;
+        printf("\n");
+    }
+    return 0;
+}
+
+static const Benchmark BENCHMARKS[] = {
+    {"rmse", "RMSE vs spp for each sampler against a high-spp reference", bench_rmse},
+    {"sampling", "Rejection vs closed-form sample warps (samples/ns)", bench_sampling},
+    {"rng", "Scalar PCG vs batched SIMD RNG throughput and chi-square", bench_rng},
+    {"camera", "Primary-ray generation cost for every built-in camera", bench_camera},
+    {"tonemap", "4K tonemap throughput: legacy loop vs shared SIMD kernel", bench_tonemap},
+    {"display", "GUI refresh per tick: full frame vs dirty tiles", bench_display},
+    {"cancel", "Time from cancel request to render_parallel returning", bench_cancel},
+    {"memory", "Peak RSS of an 8K framebuffer and writer per format", bench_memory},
+    {"mesh", "1M-triangle mesh vs triangle primitives: memory, build, Mrays/s", bench_mesh},
+    {"meshload", "OBJ / binary PLY load throughput (MB/s, triangles/s)", bench_meshload},
+    {"scenecache", "1M-triangle scene startup: BVH build vs mapped scene cache", bench_scenecache},
+    {"scenefile", "Scene file write / parse throughput for 1M spheres", bench_scenefile},
+    {"scaling", "BVH build / traversal scaling over generated scenes (10K..--max-prims)", bench_scaling},
+    {"refit", "Animated Random Spheres: BVH rebuild vs refit vs SAH-triggered rebuild", bench_refit},
+    {"sequence", "Animated turntable frames/hour: one sequence vs a process per frame", bench_sequence},
+    {"motionblur", "Motion blur: time-sampled rays vs averaging static snapshot renders", bench_motionblur},
+    {"sbvh", "Binned SAH vs spatial-split BVHs on triangle scenes (--mesh adds one)", bench_sbvh},
+};
+
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s <benchmark> [options]\n\n", prog);
+    printf("Benchmarks:\n");
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        printf("  %-14s %s\n", BENCHMARKS[i].name, BENCHMARKS[i].description);
+    }
+    printf("\nOptions:\n");
+    printf("  --scene NAME     Built-in scene (default: \"Cornell Box\")\n");
+    printf("  --width N        Image width (default: 64)\n");
+    printf("  --height N       Image height (default: 48)\n");
+    printf("  --max-spp N      Largest spp in sweeps (default: 256)\n");
+    printf("  --ref-spp N      Reference spp (default: 4096)\n");
+    printf("  --depth N        Max ray depth (default: 50)\n");
+    printf("  --threads N      Render threads (default: 8)\n");
+    printf("  --mesh FILE      Mesh for meshload (default: a generated 1M-triangle sphere),\n");
+    printf("                   or an extra scene for sbvh\n");
+    printf("  --max-prims N    Largest generated scene for scaling (default: 1000000)\n");
+    printf("  --generator NAME Only this generator for scaling: spheres, sphere-mesh,\n");
+    printf("                   terrain, grid, forest (default: all)\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
+        print_usage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    BenchOptions options = {
+        .scene_name = SCENE_NAMES[0],
+        .width = 64,
+        .height = 48,
+        .max_spp = 256,
+        .reference_spp = 4096,
+        .max_depth = 50,
+        .threads = 8,
+        .max_prims = 1000000
+    };
+
+    for (int i = 2; i < argc; i += 2) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--scene") == 0) {
+            options.scene_name = value;
+        } else if (strcmp(arg, "--width") == 0) {
+            options.width = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--height") == 0) {
+            options.height = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--max-spp") == 0) {
+            options.max_spp = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--ref-spp") == 0) {
+            options.reference_spp = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--depth") == 0) {
+            options.max_depth = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--threads") == 0) {
+            options.threads = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--mesh") == 0) {
+            options.mesh_path = value;
+        } else if (strcmp(arg, "--max-prims") == 0) {
+            options.max_prims = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--generator") == 0) {
+            options.generator = value;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        if (strcmp(argv[1], BENCHMARKS[i].name) == 0) {
+            return BENCHMARKS[i].run(&options);
+        }
+    }
+
+    fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,764 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include "pathtracer.h"
+#include "scenes.h"
+#include "mesh_io.h"
+#include "scene_cache.h"
+#include "scene_file.h"
+#include "scene_gen.h"
+#include "sequence.h"
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --scene NAME     Built-in scene (default: \"Cornell Box\")\n");
+    printf("  --mesh FILE      Render a .obj or binary .ply mesh instead of a built-in scene\n");
+    printf("  --generate SPEC  Procedural stress-test scene: spheres:N, sphere-mesh:N,\n");
+    printf("                   terrain:N or grid:N, optionally :SEED (N takes K/M suffixes)\n");
+    printf("  --scene-file FILE  Render a text scene description (see scene_file.h); its\n");
+    printf("                   settings apply unless given on the command line\n");
+    printf("  --batch DIR      Render every *.scene file in DIR to --output, where %%s stands\n");
+    printf("                   for the scene file name (default: output/%%s.bmp)\n");
+    printf("  --export-scene FILE  Write the selected scene, camera, settings and keyframes\n");
+    printf("                   as a scene file instead of rendering\n");
+    printf("  --turntable N    Render N frames orbiting the camera once around the scene\n");
+    printf("  --frames A:B | K/N  Render frames [A, B), or share K of N, of a sequence\n");
+    printf("                   (--turntable or a scene file with keyframes); --output then\n");
+    printf("                   needs %%d for the frame number (default: output/frame_%%04d.bmp)\n");
+    printf("  --scene-cache DIR  Reuse built scenes (primitives + BVH) stored in DIR, keyed\n");
+    printf("                   on scene content; a hit maps the file instead of rebuilding\n");
+    printf("  --sbvh           Build BVHs with spatial splits (SBVH): slower builds, fewer\n");
+    printf("                   nodes per ray on scenes with long or overlapping triangles\n");
+    printf("  --sbvh-budget F  SBVH with up to F references per primitive (default: %.1f)\n",
+           SCENE_SPATIAL_SPLIT_BUDGET);
+    printf("  --width N        Image width (default: 800)\n");
+    printf("  --height N       Image height (default: 600)\n");
+    printf("  --spp N          Samples per pixel (default: 100)\n");
+    printf("  --depth N        Max ray depth (default: 50)\n");
+    printf("  --threads N      Render threads (default: 8)\n");
+    printf("  --seed N         Sampling seed (default: 42)\n");
+    printf("  --sampler NAME   random, stratified, sobol, bluenoise (default: random)\n");
+    printf("  --tonemap NAME   aces, reinhard, linear (default: aces)\n");
+    printf("  --exposure EV    Exposure in stops (default: 0)\n");
+    printf("  --srgb           Apply the sRGB transfer curve to 8-bit output\n");
+    printf("  --format NAME    Framebuffer format: rgb32f, rgba16f (default: rgb32f)\n");
+    printf("  --output FILE    Output .bmp, .pfm or .exr file (default: output/render.bmp)\n");
+    printf("  --progress       Print live progress and ray throughput to stderr\n");
+    printf("  --cost-aov FILE  Also write per-pixel cost: .pfm/.exr = raw cycles, nodes, path\n");
+    printf("                   length per sample; otherwise a BMP heatmap of --cost-channel\n");
+    printf("  --cost-channel NAME  cycles, nodes, path (default: cycles)\n");
+    printf("  --checkpoint FILE    Render in passes, saving the accumulation buffer after\n");
+    printf("                       each pass and on Ctrl-C\n");
+    printf("  --checkpoint-spp N   Samples per pixel per pass (default: 16)\n");
+    printf("  --resume FILE        Continue a checkpointed render (same scene and settings)\n");
+    printf("  --partial FILE       Write the sample sums to FILE for pathtracer_merge instead\n");
+    printf("                       of an image (saved after every pass, like --checkpoint)\n");
+    printf("  --tiles A:B | K/N    Render tiles [A, B), or share K of N, of the 16x16 tiles\n");
+    printf("                       in row-major order\n");
+    printf("  --samples A:B | K/N  Render sample indices [A, B), or share K of N, of --spp\n");
+    printf("                       (needs --partial)\n");
+    printf("\nScenes:\n");
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        printf("  %s\n", SCENE_NAMES[i]);
+    }
+}
+
+// Parse "A:B" (range [A, B)) or "K/N" (K-th of N equal shares) of [0, total)
+static bool parse_range(const char* text, uint32_t total, uint32_t* begin, uint32_t* end) {
+    unsigned long long a, b;
+    char sep;
+    if (sscanf(text, "%llu%c%llu", &a, &sep, &b) != 3) return false;
+    if (sep == '/') {
+        if (b == 0 || a >= b) return false;
+        *begin = (uint32_t)(total * a / b);
+        *end = (uint32_t)(total * (a + 1) / b);
+        return *begin < *end;  // More shares than items leaves some empty
+    }
+    if (sep != ':' || a >= b || b > total) return false;
+    *begin = (uint32_t)a;
+    *end = (uint32_t)b;
+    return true;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Ctrl-C during a checkpointed render: stop at the next sample, then save
+static atomic_bool g_interrupted;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    atomic_store(&g_interrupted, true);
+}
+
+// Polls the render's stats channel and redraws a status line until the render ends
+typedef struct {
+    const RenderStats* stats;
+    atomic_bool done;
+} ProgressPoller;
+
+static void print_stats_line(const RenderStatsSnapshot* snap) {
+    double nodes_per_ray = snap->totals.rays ? (double)snap->totals.bvh_nodes / snap->totals.rays : 0.0;
+    fprintf(stderr, "\r%5.1f%%  %6.1fs  %8.2f Mrays/s  %12llu rays  %5.1f nodes/ray",
+            snap->progress * 100.0, snap->elapsed, snap->mrays_per_sec,
+            (unsigned long long)snap->totals.rays, nodes_per_ray);
+}
+
+static void* progress_thread_func(void* user_data) {
+    ProgressPoller* poller = (ProgressPoller*)user_data;
+    const struct timespec interval = {0, 250 * 1000 * 1000};
+
+    while (!atomic_load(&poller->done)) {
+        RenderStatsSnapshot snap;
+        render_stats_snapshot(poller->stats, &snap);
+        print_stats_line(&snap);
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+// Mesh triangles a scene renders, each instance counting its group's again
+static uint64_t scene_triangle_count(const Scene* scene) {
+    uint64_t triangles = 0;
+    for (uint32_t i = 0; i < scene->mesh_count; i++) triangles += scene->meshes[i]->triangle_count;
+    for (uint32_t i = 0; i < scene->instance_count; i++) {
+        triangles += scene_triangle_count(scene->instances[i].group);
+    }
+    return triangles;
+}
+
+// Scene file loaded and built, through the scene cache when one is given
+static Scene* load_scene_file(const char* path, const char* cache_dir, float split_budget,
+                              SceneDescription* desc, bool* cache_hit) {
+    *cache_hit = false;
+    if (!scene_file_load(path, desc)) return NULL;
+    if (cache_dir) return scene_cache_build(desc->scene, cache_dir, cache_hit);
+    desc->scene->spatial_split_budget = split_budget;
+    scene_build_bvh(desc->scene);
+    return desc->scene;
+}
+
+// Render a sequence into numbered images, reusing the scene, BVH and render
+// threads from frame to frame
+static int render_sequence(Scene* scene, const Sequence* seq, const CameraParams* camera,
+                           RenderSettings* settings, const SequenceOutput* output,
+                           const char* scene_name) {
+    uint32_t frame_end = output->frame_end ? output->frame_end : seq->frame_count;
+    printf("Rendering %s frames %u-%u of %u: %ux%u, %u spp, depth %u, %u threads, seed %llu+frame, "
+           "%s sampler\n", scene_name, output->frame_begin, frame_end - 1, seq->frame_count,
+           settings->width, settings->height, settings->samples_per_pixel, settings->max_depth,
+           settings->num_threads, (unsigned long long)settings->seed,
+           sampler_type_name(settings->sampler));
+    fflush(stdout);
+    settings->cancel_flag = &g_interrupted;
+    signal(SIGINT, on_interrupt);
+
+    SequenceStats stats;
+    bool ok = sequence_render(scene, seq, camera, settings, output, &stats);
+    if (!ok && stats.frames == 0) return 1;
+    double hours = stats.elapsed / 3600.0;
+    printf("Sequence: %u frames in %.2f s (%.0f frames/hour; rendering %.2f s, %.2f Mrays/s; "
+           "BVH updates %.3f s, %u rebuilds)\n", stats.frames, stats.elapsed,
+           hours > 0.0 ? stats.frames / hours : 0.0, stats.render_time,
+           stats.render_time > 0.0 ? stats.rays / stats.render_time * 1e-6 : 0.0,
+           stats.update_time, stats.rebuilds);
+    if (atomic_load(&g_interrupted)) {
+        printf("Interrupted; continue with --frames %u:%u\n", output->frame_begin + stats.frames,
+               frame_end);
+        return 130;
+    }
+    return ok ? 0 : 1;
+}
+
+// Batch output path: the first "%s" in `pattern` becomes the scene file's
+// name without directory or extension
+static bool batch_output_path(const char* pattern, const char* scene_path, char* out, size_t size) {
+    const char* slot = strstr(pattern, "%s");
+    if (!slot) return false;
+    const char* name = strrchr(scene_path, '/');
+    name = name ? name + 1 : scene_path;
+    int name_length = (int)(strlen(name) - strlen(SCENE_FILE_EXTENSION));
+    int n = snprintf(out, size, "%.*s%.*s%s", (int)(slot - pattern), pattern, name_length, name,
+                     slot + 2);
+    return n >= 0 && (size_t)n < size;
+}
+
+// Render every scene file in `dir`, in name order. Settings flagged in
+// cli_mask were given on the command line and override the files'.
+static int render_batch(const char* dir, const char* output_pattern,
+                        const RenderSettings* defaults, uint32_t cli_mask,
+                        const TonemapSettings* tonemap, ImageFormat format,
+                        const char* cache_dir, float split_budget) {
+    uint32_t count;
+    char** paths = scene_file_list(dir, &count);
+    if (!paths) {
+        fprintf(stderr, "Cannot read scene directory %s\n", dir);
+        return 1;
+    }
+    if (count == 0) {
+        fprintf(stderr, "No %s files in %s\n", SCENE_FILE_EXTENSION, dir);
+        scene_file_list_free(paths, count);
+        return 1;
+    }
+
+    double batch_start = now_seconds();
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        char output[1024];
+        SceneDescription desc;
+        bool cache_hit;
+        if (!batch_output_path(output_pattern, paths[i], output, sizeof(output))) {
+            fprintf(stderr, "Output path for %s is too long\n", paths[i]);
+            failed++;
+            continue;
+        }
+        Scene* scene = load_scene_file(paths[i], cache_dir, split_budget, &desc, &cache_hit);
+        if (!scene) {
+            failed++;
+            continue;
+        }
+
+        RenderSettings settings = *defaults;
+        scene_file_apply_settings(&desc, &settings, cli_mask);
+        Camera camera = camera_from_params(&desc.camera, (float)settings.width / settings.height);
+        Image* image = image_create_format(settings.width, settings.height, format);
+        RenderStats* stats = render_stats_create(settings.num_threads);
+        settings.stats = stats;
+        if (!image) {
+            render_stats_destroy(stats);
+            scene_destroy(scene);
+            sequence_free(&desc.sequence);
+            failed++;
+            continue;
+        }
+
+        printf("[%u/%u] Rendering %s%s: %ux%u, %u spp, depth %u, seed %llu, %s sampler\n",
+               i + 1, count, paths[i], cache_hit ? " (cached)" : "", settings.width,
+               settings.height, settings.samples_per_pixel, settings.max_depth,
+               (unsigned long long)settings.seed, sampler_type_name(settings.sampler));
+        fflush(stdout);
+        render_parallel(scene, &camera, &settings, image);
+
+        RenderStatsSnapshot snap;
+        render_stats_snapshot(stats, &snap);
+        printf("Render complete: %.2f seconds (%.2f Mrays/s)\n", snap.elapsed, snap.mrays_per_sec);
+        if (image_save(image, output, tonemap)) {
+            printf("Saved %s\n", output);
+        } else {
+            failed++;
+        }
+
+        render_stats_destroy(stats);
+        image_destroy(image);
+        scene_destroy(scene);
+        sequence_free(&desc.sequence);
+    }
+
+    printf("Batch: %u of %u scenes rendered in %.2f s\n", count - failed, count,
+           now_seconds() - batch_start);
+    scene_file_list_free(paths, count);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    const char* scene_name = SCENE_NAMES[0];
+    const char* mesh_path = NULL;
+    const char* scene_file = NULL;
+    const char* generate_arg = NULL;
+    const char* batch_dir = NULL;
+    const char* export_path = NULL;
+    const char* cache_dir = NULL;
+    const char* output = NULL;
+    ImageFormat format = IMAGE_FORMAT_RGB32F;
+    TonemapSettings tonemap = tonemap_default();
+    bool show_progress = false;
+    const char* cost_output = NULL;
+    CostAov cost_channel = COST_AOV_CYCLES;
+    const char* checkpoint_path = NULL;
+    const char* resume_path = NULL;
+    uint32_t checkpoint_spp = 16;
+    const char* partial_path = NULL;
+    const char* tiles_arg = NULL;
+    const char* samples_arg = NULL;
+    uint32_t turntable_frames = 0;
+    const char* frames_arg = NULL;
+    float split_budget = 0.0f;  // Scene.spatial_split_budget
+
+    RenderSettings settings = {0};
+    settings.width = 800;
+    settings.height = 600;
+    settings.samples_per_pixel = 100;
+    settings.max_depth = 50;
+    settings.num_threads = 8;
+    settings.use_bvh = true;
+    settings.seed = 42;
+    settings.sampler = SAMPLER_RANDOM;
+    uint32_t cli_settings = 0;  // SCENE_SETTING_* given as options, kept over scene files
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(arg, "--srgb") == 0) {
+            tonemap.srgb = true;
+            continue;
+        }
+        if (strcmp(arg, "--progress") == 0) {
+            show_progress = true;
+            continue;
+        }
+        if (strcmp(arg, "--sbvh") == 0) {
+            split_budget = SCENE_SPATIAL_SPLIT_BUDGET;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--scene") == 0) {
+            scene_name = value;
+        } else if (strcmp(arg, "--mesh") == 0) {
+            mesh_path = value;
+        } else if (strcmp(arg, "--generate") == 0) {
+            generate_arg = value;
+        } else if (strcmp(arg, "--scene-file") == 0) {
+            scene_file = value;
+        } else if (strcmp(arg, "--batch") == 0) {
+            batch_dir = value;
+        } else if (strcmp(arg, "--export-scene") == 0) {
+            export_path = value;
+        } else if (strcmp(arg, "--turntable") == 0) {
+            turntable_frames = (uint32_t)atoi(value);
+            if (turntable_frames == 0) {
+                fprintf(stderr, "Invalid --turntable %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--frames") == 0) {
+            frames_arg = value;
+        } else if (strcmp(arg, "--sbvh-budget") == 0) {
+            split_budget = (float)atof(value);
+            if (!(split_budget > 1.0f)) {
+                fprintf(stderr, "--sbvh-budget must be above 1\n");
+                return 1;
+            }
+        } else if (strcmp(arg, "--scene-cache") == 0) {
+            cache_dir = value;
+        } else if (strcmp(arg, "--width") == 0) {
+            settings.width = (uint32_t)atoi(value);
+            cli_settings |= SCENE_SETTING_WIDTH;
+        } else if (strcmp(arg, "--height") == 0) {
+            settings.height = (uint32_t)atoi(value);
+            cli_settings |= SCENE_SETTING_HEIGHT;
+        } else if (strcmp(arg, "--spp") == 0) {
+            settings.samples_per_pixel = (uint32_t)atoi(value);
+            cli_settings |= SCENE_SETTING_SPP;
+        } else if (strcmp(arg, "--depth") == 0) {
+            settings.max_depth = (uint32_t)atoi(value);
+            cli_settings |= SCENE_SETTING_DEPTH;
+        } else if (strcmp(arg, "--threads") == 0) {
+            settings.num_threads = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            settings.seed = strtoull(value, NULL, 10);
+            cli_settings |= SCENE_SETTING_SEED;
+        } else if (strcmp(arg, "--sampler") == 0) {
+            if (!sampler_type_from_name(value, &settings.sampler)) {
+                fprintf(stderr, "Unknown sampler: %s\n", value);
+                return 1;
+            }
+            cli_settings |= SCENE_SETTING_SAMPLER;
+        } else if (strcmp(arg, "--tonemap") == 0) {
+            if (!tonemap_operator_from_name(value, &tonemap.op)) {
+                fprintf(stderr, "Unknown tonemap operator: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--exposure") == 0) {
+            tonemap.exposure = (float)atof(value);
+        } else if (strcmp(arg, "--format") == 0) {
+            if (!image_format_from_name(value, &format)) {
+                fprintf(stderr, "Unknown framebuffer format: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--output") == 0) {
+            output = value;
+        } else if (strcmp(arg, "--checkpoint") == 0) {
+            checkpoint_path = value;
+        } else if (strcmp(arg, "--checkpoint-spp") == 0) {
+            checkpoint_spp = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--resume") == 0) {
+            resume_path = value;
+        } else if (strcmp(arg, "--partial") == 0) {
+            partial_path = value;
+        } else if (strcmp(arg, "--tiles") == 0) {
+            tiles_arg = value;
+        } else if (strcmp(arg, "--samples") == 0) {
+            samples_arg = value;
+        } else if (strcmp(arg, "--cost-aov") == 0) {
+            cost_output = value;
+        } else if (strcmp(arg, "--cost-channel") == 0) {
+            if (!cost_aov_from_name(value, &cost_channel)) {
+                fprintf(stderr, "Unknown cost channel: %s\n", value);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (settings.width < 2 || settings.height < 2 ||
+        settings.samples_per_pixel == 0 || settings.num_threads == 0 || checkpoint_spp == 0) {
+        fprintf(stderr, "Invalid render settings\n");
+        return 1;
+    }
+    if ((mesh_path != NULL) + (scene_file != NULL) + (batch_dir != NULL) + (generate_arg != NULL) > 1) {
+        fprintf(stderr, "--mesh, --scene-file, --generate and --batch are alternatives\n");
+        return 1;
+    }
+    if (cache_dir && split_budget > 0.0f) {
+        fprintf(stderr, "Spatial-split BVHs are not cached; drop --scene-cache or --sbvh\n");
+        return 1;
+    }
+    GeneratorSpec generator;
+    if (generate_arg && !generator_spec_parse(generate_arg, &generator)) {
+        fprintf(stderr, "Invalid --generate %s\n", generate_arg);
+        return 1;
+    }
+
+    if (batch_dir) {
+        if (checkpoint_path || resume_path || partial_path || tiles_arg || samples_arg ||
+            cost_output || export_path) {
+            fprintf(stderr, "--batch renders whole images; drop the checkpoint, partial, "
+                            "cost AOV and export options\n");
+            return 1;
+        }
+        if (output && !strstr(output, "%s")) {
+            fprintf(stderr, "--output for --batch needs %%s for the scene name\n");
+            return 1;
+        }
+        return render_batch(batch_dir, output ? output : "output/%s.bmp", &settings,
+                            cli_settings, &tonemap, format, cache_dir, split_budget);
+    }
+
+    // Scene files are loaded up front, as their settings size the image
+    double setup_start = now_seconds();
+    SceneDescription desc = {0};
+    if (scene_file) {
+        if (!scene_file_load(scene_file, &desc)) return 1;
+        scene_file_apply_settings(&desc, &settings, cli_settings);
+    }
+
+    // Sequences: a turntable or a scene file with keyframes
+    Sequence* sequence = &desc.sequence;
+    bool animated = turntable_frames > 0 || sequence->frame_count > 0;
+    if (animated && (checkpoint_path || resume_path || partial_path || tiles_arg || samples_arg ||
+                     cost_output)) {
+        fprintf(stderr, "Sequences render whole frames; drop the checkpoint, partial and cost "
+                        "AOV options\n");
+        return 1;
+    }
+    if (turntable_frames && sequence->frame_count) {
+        fprintf(stderr, "%s is already a sequence; drop --turntable\n", scene_file);
+        return 1;
+    }
+    if (cache_dir && sequence->move_key_count) {
+        fprintf(stderr, "Scenes with object keyframes are not cached; drop --scene-cache\n");
+        return 1;
+    }
+    if (frames_arg && !animated) {
+        fprintf(stderr, "--frames needs --turntable or a scene file with keyframes\n");
+        return 1;
+    }
+    if (!output) output = animated ? "output/frame_%04d.bmp" : "output/render.bmp";
+    if (animated && !sequence_pattern_valid(output)) {
+        fprintf(stderr, "--output for a sequence needs one %%d for the frame number\n");
+        return 1;
+    }
+
+    if (export_path) {
+        Scene* source = scene_file ? desc.scene :
+                        generate_arg ? generate_scene(&generator) : create_scene_by_name(scene_name);
+        CameraParams camera = scene_file ? desc.camera :
+                              generate_arg ? generator_camera(&generator) :
+                              camera_params_for_scene(scene_name);
+        // A turntable is written as its camera keyframes
+        bool keyed = !turntable_frames || sequence_turntable(sequence, turntable_frames, &camera);
+        bool written = !mesh_path && source && keyed &&
+                       scene_file_save(export_path, source, &camera, &settings, sequence);
+        if (mesh_path) fprintf(stderr, "--export-scene takes a built-in scene or a scene file\n");
+        if (written) printf("Wrote %s\n", export_path);
+        scene_destroy(source);
+        sequence_free(sequence);
+        return written ? 0 : 1;
+    }
+
+    // Work ranges for distributed renders
+    uint32_t sample_first = 0;
+    uint32_t sample_last = settings.samples_per_pixel;
+    if (samples_arg && (!partial_path ||
+                        !parse_range(samples_arg, settings.samples_per_pixel, &sample_first, &sample_last))) {
+        fprintf(stderr, "Invalid --samples %s (needs --partial)\n", samples_arg);
+        return 1;
+    }
+    if (tiles_arg) {
+        uint32_t tiles_x = (settings.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+        uint32_t tiles_y = (settings.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+        if (!parse_range(tiles_arg, tiles_x * tiles_y, &settings.tile_begin, &settings.tile_end)) {
+            fprintf(stderr, "Invalid --tiles %s (%u tiles)\n", tiles_arg, tiles_x * tiles_y);
+            return 1;
+        }
+    }
+    if (partial_path) {
+        if (resume_path || checkpoint_path) {
+            fprintf(stderr, "--partial cannot be combined with --checkpoint or --resume\n");
+            return 1;
+        }
+        checkpoint_path = partial_path;
+    }
+
+    float aspect = (float)settings.width / settings.height;
+    Scene* scene = NULL;
+    CameraParams camera_params;
+    bool cache_hit = false;
+    if (mesh_path) {
+        // Keyed on the file's bytes, so a cache hit skips parsing as well
+        uint64_t key = 0;
+        bool keyed = cache_dir && hash_file(mesh_path, &key);
+        if (keyed) {
+            key = hash_bytes(key, "mesh scene", 10);
+            scene = scene_cache_load(cache_dir, key);
+            cache_hit = scene != NULL;
+        }
+        if (!scene) {
+            double load_start = now_seconds();
+            Mesh* mesh = mesh_load(mesh_path);
+            if (!mesh) return 1;
+            printf("Loaded %s: %u vertices, %u triangles in %.3f s\n", mesh_path, mesh->vertex_count,
+                   mesh->triangle_count, now_seconds() - load_start);
+            scene = create_mesh_scene(mesh);
+            scene->spatial_split_budget = split_budget;
+            scene_build_bvh(scene);
+            if (keyed) scene_cache_save(scene, cache_dir, key);
+        }
+        camera_params = camera_params_for_mesh_scene();
+        scene_name = mesh_path;
+    } else if (generate_arg) {
+        double generate_start = now_seconds();
+        scene = generate_scene(&generator);
+        if (!scene) return 1;
+        printf("Generated %s: %u primitives (%u instances), %llu mesh triangles in %.3f s\n",
+               generate_arg, scene->prim_count, scene->instance_count,
+               (unsigned long long)scene_triangle_count(scene), now_seconds() - generate_start);
+        scene->spatial_split_budget = split_budget;
+        if (cache_dir) {
+            scene = scene_cache_build(scene, cache_dir, &cache_hit);
+        } else {
+            scene_build_bvh(scene);
+        }
+        camera_params = generator_camera(&generator);
+        scene_name = generate_arg;
+    } else if (scene_file) {
+        // Moving objects are named by creation order, so sequence_render builds
+        desc.scene->spatial_split_budget = split_budget;
+        scene = cache_dir ? scene_cache_build(desc.scene, cache_dir, &cache_hit) : desc.scene;
+        if (!cache_dir && !sequence->move_key_count) scene_build_bvh(scene);
+        camera_params = desc.camera;
+        scene_name = scene_file;
+    } else {
+        scene = create_scene_by_name(scene_name);
+        scene->spatial_split_budget = split_budget;
+        if (cache_dir) {
+            scene = scene_cache_build(scene, cache_dir, &cache_hit);
+        } else {
+            scene_build_bvh(scene);
+        }
+        camera_params = camera_params_for_scene(scene_name);
+    }
+    if (cache_dir) {
+        printf("Scene ready in %.1f ms (%s)\n", (now_seconds() - setup_start) * 1e3,
+               cache_hit ? "mapped from scene cache" : "built");
+    }
+
+    if (animated) {
+        if (turntable_frames && !sequence_turntable(sequence, turntable_frames, &camera_params)) {
+            scene_destroy(scene);
+            return 1;
+        }
+        SequenceOutput sequence_output = {output, &tonemap, format, 0, 0, true};
+        int status = 0;
+        if (frames_arg && !parse_range(frames_arg, sequence->frame_count,
+                                       &sequence_output.frame_begin, &sequence_output.frame_end)) {
+            fprintf(stderr, "Invalid --frames %s (%u frames)\n", frames_arg, sequence->frame_count);
+            status = 1;
+        } else {
+            status = render_sequence(scene, sequence, &camera_params, &settings, &sequence_output,
+                                     scene_name);
+        }
+        sequence_free(sequence);
+        scene_destroy(scene);
+        return status;
+    }
+    Camera camera = camera_from_params(&camera_params, aspect);
+    Image* image = image_create_format(settings.width, settings.height, format);
+    if (!image) {
+        scene_destroy(scene);
+        return 1;
+    }
+
+    // Checkpointed renders run in passes over an accumulation buffer
+    CheckpointInfo info = {settings.samples_per_pixel, settings.max_depth, settings.sampler,
+                           settings.seed, ""};
+    snprintf(info.scene, sizeof(info.scene), "%s", scene_name);
+    Accumulator* accum = NULL;
+    if (resume_path) {
+        CheckpointInfo saved_info;
+        accum = checkpoint_load(resume_path, &saved_info);
+        if (accum && (accum->width != settings.width || accum->height != settings.height)) {
+            fprintf(stderr, "Checkpoint is %ux%u, not %ux%u\n", accum->width, accum->height,
+                    settings.width, settings.height);
+            accumulator_destroy(accum);
+            accum = NULL;
+        } else if (accum && accum->first_sample != 0) {
+            fprintf(stderr, "%s is a partial buffer; merge it with pathtracer_merge\n", resume_path);
+            accumulator_destroy(accum);
+            accum = NULL;
+        } else if (accum && !checkpoint_info_matches(&saved_info, &info)) {
+            accumulator_destroy(accum);
+            accum = NULL;
+        }
+        if (!accum) {
+            image_destroy(image);
+            scene_destroy(scene);
+            return 1;
+        }
+        if (!checkpoint_path) checkpoint_path = resume_path;  // Keep updating the same file
+        printf("Resuming %s at %u of %u spp\n", resume_path,
+               accumulator_min_count_tiles(accum, RENDER_TILE_SIZE, settings.tile_begin,
+                                           settings.tile_end),
+               settings.samples_per_pixel);
+    } else if (checkpoint_path) {
+        accum = accumulator_create(settings.width, settings.height);
+        if (!accum) {
+            image_destroy(image);
+            scene_destroy(scene);
+            return 1;
+        }
+        accumulator_reset(accum, sample_first);
+    }
+    if (accum) {
+        settings.accum = accum;
+        settings.cancel_flag = &g_interrupted;
+        signal(SIGINT, on_interrupt);
+    }
+
+    printf("Rendering %s: %ux%u, %u spp, depth %u, %u threads, seed %llu, %s sampler\n",
+           scene_name, settings.width, settings.height, settings.samples_per_pixel,
+           settings.max_depth, settings.num_threads, (unsigned long long)settings.seed,
+           sampler_type_name(settings.sampler));
+
+    RenderStats* stats = render_stats_create(settings.num_threads);
+    settings.stats = stats;
+    Image* cost_aov = cost_output ? image_create(settings.width, settings.height) : NULL;
+    settings.cost_aov = cost_aov;
+
+    fflush(stdout);
+    ProgressPoller poller = {stats, false};
+    pthread_t progress_thread;
+    bool polling = show_progress &&
+                   pthread_create(&progress_thread, NULL, progress_thread_func, &poller) == 0;
+
+    if (partial_path) {
+        printf("Partial buffer: samples %u-%u, tiles %u-%u\n", sample_first, sample_last,
+               settings.tile_begin, settings.tile_end);
+    }
+
+    // One pass without a checkpoint; otherwise checkpoint_spp at a time
+    RenderStatsSnapshot snap = {0};
+    bool checkpoint_saved = true;
+    // Only pixels in the tile range are rendered, so only they count as done
+    uint32_t spp_done = accum ? accumulator_min_count_tiles(accum, RENDER_TILE_SIZE,
+                                                            settings.tile_begin, settings.tile_end) : 0;
+    do {
+        if (accum) {
+            settings.sample_end = spp_done + checkpoint_spp < sample_last ?
+                                  spp_done + checkpoint_spp : sample_last;
+        }
+        render_parallel(scene, &camera, &settings, image);
+
+        RenderStatsSnapshot pass;
+        render_stats_snapshot(stats, &pass);
+        snap.totals.rays += pass.totals.rays;
+        snap.totals.bvh_nodes += pass.totals.bvh_nodes;
+        snap.elapsed += pass.elapsed;
+
+        if (accum) {
+            // An interrupted pass leaves pixels short of sample_end
+            checkpoint_saved = checkpoint_save(accum, &info, checkpoint_path);
+            spp_done = accumulator_min_count_tiles(accum, RENDER_TILE_SIZE, settings.tile_begin,
+                                                   settings.tile_end);
+        }
+    } while (accum && spp_done < sample_last && !atomic_load(&g_interrupted));
+    snap.progress = 1.0;
+    snap.mrays_per_sec = snap.elapsed > 0.0 ? snap.totals.rays / snap.elapsed * 1e-6 : 0.0;
+
+    if (polling) {
+        atomic_store(&poller.done, true);
+        pthread_join(progress_thread, NULL);
+        print_stats_line(&snap);
+        fputc('\n', stderr);
+    }
+
+    printf("Render complete: %.2f seconds (%.2f Mrays/s, %llu rays, %.1f BVH nodes/ray)\n",
+           snap.elapsed, snap.mrays_per_sec, (unsigned long long)snap.totals.rays,
+           snap.totals.rays ? (double)snap.totals.bvh_nodes / snap.totals.rays : 0.0);
+    render_stats_report(stats, stdout);
+    render_stats_destroy(stats);
+
+    // Interrupted or partial renders end with the accumulation buffer on disk
+    bool interrupted = atomic_load(&g_interrupted);
+    accumulator_destroy(accum);
+    if (interrupted && partial_path) {
+        printf("Interrupted; %s holds the samples rendered so far\n", partial_path);
+    } else if (interrupted) {
+        printf("Interrupted at %u of %u spp; resume with --resume %s\n",
+               spp_done, settings.samples_per_pixel, checkpoint_path);
+    } else if (partial_path && checkpoint_saved) {
+        printf("Saved partial %s\n", partial_path);
+    }
+    if (interrupted || partial_path) {
+        image_destroy(image);
+        image_destroy(cost_aov);
+        scene_destroy(scene);
+        return interrupted ? 130 : checkpoint_saved ? 0 : 1;
+    }
+
+    bool saved = image_save(image, output, &tonemap);
+    if (saved) {
+        printf("Saved %s\n", output);
+    }
+    if (cost_aov) {
+        if (cost_aov_save(cost_aov, cost_channel, cost_output)) {
+            printf("Saved %s (cost AOV, %s)\n", cost_output, cost_aov_name(cost_channel));
+        } else {
+            saved = false;
+        }
+        image_destroy(cost_aov);
+    }
+
+    image_destroy(image);
+    scene_destroy(scene);
+    return saved ? 0 : 1;
+}
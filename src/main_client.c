@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pathtracer.h"
+#include "job.h"
+
+// Submits one render job to pathtracer_server, prints its progress and saves
+// the returned image (or queries / stops the server)
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --socket PATH    Server socket (default: %s)\n", JOB_DEFAULT_SOCKET);
+    printf("  --status         Print the server's queue and cache state\n");
+    printf("  --shutdown       Stop the server (queued and running jobs are cancelled)\n");
+    printf("  --scene NAME     Built-in scene (default: \"Cornell Box\")\n");
+    printf("  --width N        Image width (default: 800)\n");
+    printf("  --height N       Image height (default: 600)\n");
+    printf("  --spp N          Samples per pixel (default: 100)\n");
+    printf("  --depth N        Max ray depth (default: 50)\n");
+    printf("  --seed N         Sampling seed (default: 42)\n");
+    printf("  --sampler NAME   random, stratified, sobol, bluenoise (default: random)\n");
+    printf("  --lookfrom X,Y,Z --lookat X,Y,Z  Camera overrides (default: the scene's camera)\n");
+    printf("  --vup X,Y,Z --vfov DEG --aperture A --focus DIST  Further camera overrides; each\n");
+    printf("                   replaces only that field of the scene's camera\n");
+    printf("  --tonemap NAME   aces, reinhard, linear (default: aces)\n");
+    printf("  --exposure EV    Exposure in stops (default: 0)\n");
+    printf("  --srgb           Apply the sRGB transfer curve to 8-bit output\n");
+    printf("  --output FILE    Output .bmp, .pfm or .exr file (default: output/render.bmp)\n");
+}
+
+static int connect_server(const char* socket_path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Failed to connect to %s: %s\n", socket_path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read the DONE payload into a new image
+static Image* receive_image(int fd, uint32_t width, uint32_t height) {
+    Image* image = image_create(width, height);
+    float* row = (float*)malloc((size_t)width * 3 * sizeof(float));
+    bool ok = image && row;
+    for (uint32_t y = 0; y < height && ok; y++) {
+        ok = job_recv(fd, row, (size_t)width * 3 * sizeof(float));
+        for (uint32_t x = 0; x < width && ok; x++) {
+            image_set_pixel(image, x, y, vec3_create(row[3 * x], row[3 * x + 1], row[3 * x + 2]));
+        }
+    }
+    free(row);
+    if (!ok) {
+        fprintf(stderr, "Connection lost while receiving the image\n");
+        image_destroy(image);
+        return NULL;
+    }
+    return image;
+}
+
+int main(int argc, char** argv) {
+    const char* socket_path = JOB_DEFAULT_SOCKET;
+    const char* output = "output/render.bmp";
+    const char* command = NULL;
+    TonemapSettings tonemap = tonemap_default();
+    JobRequest job;
+    job_request_init(&job);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(arg, "--srgb") == 0) {
+            tonemap.srgb = true;
+            continue;
+        }
+        if (strcmp(arg, "--status") == 0 || strcmp(arg, "--shutdown") == 0) {
+            command = (arg[2] == 's' && arg[3] == 't') ? "STATUS" : "SHUTDOWN";
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--socket") == 0) {
+            socket_path = value;
+        } else if (strcmp(arg, "--output") == 0) {
+            output = value;
+        } else if (strcmp(arg, "--tonemap") == 0) {
+            if (!tonemap_operator_from_name(value, &tonemap.op)) {
+                fprintf(stderr, "Unknown tonemap operator: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--exposure") == 0) {
+            tonemap.exposure = (float)atof(value);
+        } else if (strncmp(arg, "--", 2) != 0 || !job_request_set(&job, arg + 2, value)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    int fd = connect_server(socket_path);
+    if (fd < 0) return 1;
+
+    char line[JOB_LINE_SIZE];
+    if (command) {
+        bool ok = job_send_line(fd, command) && job_read_line(fd, line, sizeof(line));
+        if (ok) printf("%s\n", line);
+        close(fd);
+        return ok ? 0 : 1;
+    }
+
+    char request[1024];
+    if (!job_request_format(&job, request, sizeof(request)) ||
+        !job_send(fd, request, strlen(request))) {
+        fprintf(stderr, "Failed to send the job\n");
+        close(fd);
+        return 1;
+    }
+
+    Image* image = NULL;
+    bool progress_shown = false;
+    while (!image && job_read_line(fd, line, sizeof(line))) {
+        unsigned ahead, width, height;
+        char cache[8];
+        double progress, elapsed, mrays, build_ms;
+        unsigned long long rays;
+
+        if (sscanf(line, "QUEUED %u", &ahead) == 1) {
+            printf("Queued (%u job%s ahead)\n", ahead, ahead == 1 ? "" : "s");
+        } else if (sscanf(line, "STARTED %7s %lf", cache, &build_ms) == 2) {
+            if (strcmp(cache, "hit") == 0) {
+                printf("Rendering %s: %ux%u, %u spp (cached scene)\n", job.scene, job.width,
+                       job.height, job.samples_per_pixel);
+            } else {
+                printf("Rendering %s: %ux%u, %u spp (scene built in %.1f ms)\n", job.scene,
+                       job.width, job.height, job.samples_per_pixel, build_ms);
+            }
+            fflush(stdout);
+        } else if (sscanf(line, "PROGRESS %lf %lf %lf", &progress, &elapsed, &mrays) == 3) {
+            fprintf(stderr, "\r%5.1f%%  %6.1fs  %8.2f Mrays/s", progress * 100.0, elapsed, mrays);
+            progress_shown = true;
+        } else if (sscanf(line, "DONE %u %u %lf %llu", &width, &height, &elapsed, &rays) == 4) {
+            if (progress_shown) fputc('\n', stderr);
+            printf("Render complete: %.2f seconds (%.2f Mrays/s, %llu rays)\n", elapsed,
+                   elapsed > 0.0 ? rays / elapsed * 1e-6 : 0.0, rays);
+            image = receive_image(fd, width, height);
+            if (!image) break;
+        } else {
+            if (progress_shown) fputc('\n', stderr);
+            fprintf(stderr, "Server: %s\n", line);
+            break;
+        }
+    }
+    close(fd);
+    if (!image) return 1;
+
+    bool saved = image_save(image, output, &tonemap);
+    if (saved) {
+        printf("Saved %s\n", output);
+    }
+    image_destroy(image);
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pathtracer.h"
+
+// Combines partial buffers written by `pathtracer_cli --partial` into the
+// final image. Each pixel is the sum of its partial sums divided by the total
+// number of samples they hold, so tile splits, sample splits and partials
+// cut short by Ctrl-C all merge the same way.
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options] PARTIAL...\n", prog);
+    printf("  --output FILE    Output .bmp, .pfm or .exr file (default: output/render.bmp)\n");
+    printf("  --tonemap NAME   aces, reinhard, linear (default: aces)\n");
+    printf("  --exposure EV    Exposure in stops (default: 0)\n");
+    printf("  --srgb           Apply the sRGB transfer curve to 8-bit output\n");
+}
+
+// Add one partial's samples into the merged sums; counts become sample totals
+static bool merge_partial(Accumulator* merged, const CheckpointInfo* merged_info,
+                          const char* filename) {
+    CheckpointInfo info;
+    Accumulator* part = checkpoint_load(filename, &info);
+    if (!part) return false;
+
+    if (part->width != merged->width || part->height != merged->height) {
+        fprintf(stderr, "%s is %ux%u, not %ux%u\n", filename, part->width, part->height,
+                merged->width, merged->height);
+        accumulator_destroy(part);
+        return false;
+    }
+    if (!checkpoint_info_matches(&info, merged_info)) {
+        fprintf(stderr, "%s belongs to a different render\n", filename);
+        accumulator_destroy(part);
+        return false;
+    }
+
+    // Checked before merging anything, so a corrupt part leaves no trace
+    size_t count = (size_t)part->width * part->height;
+    for (size_t i = 0; i < count; i++) {
+        if (part->count[i] < part->first_sample) {
+            fprintf(stderr, "%s is corrupt: pixel %zu has count %u below its first sample %u\n",
+                    filename, i, part->count[i], part->first_sample);
+            accumulator_destroy(part);
+            return false;
+        }
+    }
+
+    uint64_t samples = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t n = part->count[i] - part->first_sample;
+        if (n == 0) continue;
+        for (int c = 0; c < 3; c++) {
+            merged->sum[c][i] += part->sum[c][i];
+        }
+        merged->count[i] += n;
+        samples += n;
+    }
+    printf("  %s: %llu samples from index %u\n", filename, (unsigned long long)samples,
+           part->first_sample);
+    accumulator_destroy(part);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* output = "output/render.bmp";
+    TonemapSettings tonemap = tonemap_default();
+    const char** inputs = (const char**)calloc((size_t)argc, sizeof(const char*));
+    int input_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            free(inputs);
+            return 0;
+        }
+        if (strcmp(arg, "--srgb") == 0) {
+            tonemap.srgb = true;
+            continue;
+        }
+        if (strncmp(arg, "--", 2) != 0) {
+            inputs[input_count++] = arg;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            free(inputs);
+            return 1;
+        }
+
+        if (strcmp(arg, "--output") == 0) {
+            output = value;
+        } else if (strcmp(arg, "--tonemap") == 0) {
+            if (!tonemap_operator_from_name(value, &tonemap.op)) {
+                fprintf(stderr, "Unknown tonemap operator: %s\n", value);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(arg, "--exposure") == 0) {
+            tonemap.exposure = (float)atof(value);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage(argv[0]);
+            free(inputs);
+            return 1;
+        }
+        i++;
+    }
+
+    if (input_count == 0) {
+        print_usage(argv[0]);
+        free(inputs);
+        return 1;
+    }
+
+    // The first partial fixes the render every other one must match
+    CheckpointInfo merged_info;
+    Accumulator* first = checkpoint_load(inputs[0], &merged_info);
+    if (!first) {
+        free(inputs);
+        return 1;
+    }
+    Accumulator* merged = accumulator_create(first->width, first->height);
+    accumulator_destroy(first);
+    if (!merged) {
+        free(inputs);
+        return 1;
+    }
+
+    printf("Merging %d partials of %s: %ux%u, %u spp\n", input_count, merged_info.scene,
+           merged->width, merged->height, merged_info.samples_per_pixel);
+    for (int i = 0; i < input_count; i++) {
+        if (!merge_partial(merged, &merged_info, inputs[i])) {
+            accumulator_destroy(merged);
+            free(inputs);
+            return 1;
+        }
+    }
+    free(inputs);
+
+    Image* image = image_create(merged->width, merged->height);
+    if (!image) {
+        accumulator_destroy(merged);
+        return 1;
+    }
+    uint64_t missing = 0, overlapping = 0;
+    for (uint32_t y = 0; y < merged->height; y++) {
+        for (uint32_t x = 0; x < merged->width; x++) {
+            size_t i = (size_t)y * merged->width + x;
+            uint32_t n = merged->count[i];
+            if (n == 0) {
+                missing++;
+                continue;
+            }
+            if (n > merged_info.samples_per_pixel) overlapping++;
+            Vec3 sum = vec3_create(merged->sum[0][i], merged->sum[1][i], merged->sum[2][i]);
+            image_set_pixel(image, x, y, vec3_div(sum, (float)n));
+        }
+    }
+    accumulator_destroy(merged);
+
+    if (missing > 0) {
+        fprintf(stderr, "Warning: %llu pixels have no samples (left black)\n",
+                (unsigned long long)missing);
+    }
+    if (overlapping > 0) {
+        fprintf(stderr, "Warning: %llu pixels have more than %u samples (overlapping ranges?)\n",
+                (unsigned long long)overlapping, merged_info.samples_per_pixel);
+    }
+
+    bool saved = image_save(image, output, &tonemap);
+    if (saved) {
+        printf("Saved %s\n", output);
+    }
+    image_destroy(image);
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,543 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pathtracer.h"
+#include "scenes.h"
+#include "job.h"
+
+// Long-lived render daemon. Connections are served by their own threads,
+// which queue jobs and stream progress; a single worker thread renders the
+// queue in order, so every job gets the whole OpenMP team and the team's
+// threads stay alive between jobs. Built scenes (with their BVH) are kept
+// in a small LRU cache owned by the worker.
+
+#define SERVER_PROGRESS_INTERVAL_MS 250
+
+// Largest job accepted, so a client cannot make the daemon allocate a huge
+// framebuffer or queue a render that never finishes
+#define SERVER_MAX_DIM 16384
+#define SERVER_MAX_SPP 10000
+#define SERVER_MAX_DEPTH 100
+
+typedef enum {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE
+} JobState;
+
+typedef struct Job {
+    JobRequest request;
+    RenderStats* stats;     // Progress, read lock-free by the connection thread
+    atomic_bool cancel;     // Client gone or server shutting down
+    JobState state;         // Guarded by Server.mutex
+    struct Job* next;       // Queue link
+
+    // Results, valid once state == JOB_DONE
+    Image* image;           // NULL on error
+    char error[128];
+    bool cache_hit;
+    double build_ms;
+} Job;
+
+typedef struct {
+    char name[JOB_SCENE_NAME_SIZE];
+    Scene* scene;
+    uint64_t last_used;
+} CachedScene;
+
+typedef struct {
+    uint32_t num_threads;
+    int listen_fd;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;     // Queue, job state or connection count changed
+    Job* head;
+    Job* tail;
+    Job* running;
+    int* client_fds;            // Open connections, shut down on stop
+    uint32_t connections;
+    uint32_t client_capacity;
+    uint64_t jobs_done;
+    bool shutting_down;
+
+    // Scene cache: touched only by the worker thread (count read for STATUS)
+    CachedScene* cache;
+    uint32_t cache_capacity;
+    uint32_t cache_count;
+    uint64_t cache_clock;
+} Server;
+
+static Server g_server;
+static atomic_bool g_stop;  // Set by SIGINT/SIGTERM or a SHUTDOWN request
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    atomic_store(&g_stop, true);
+}
+
+static bool scene_name_known(const char* name) {
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        if (strcmp(name, SCENE_NAMES[i]) == 0) return true;
+    }
+    return false;
+}
+
+// Cached scene by name, building (and evicting the least recently used) on a miss
+static Scene* server_get_scene(Server* server, const char* name, bool* hit, double* build_ms) {
+    server->cache_clock++;
+    for (uint32_t i = 0; i < server->cache_count; i++) {
+        if (strcmp(server->cache[i].name, name) == 0) {
+            server->cache[i].last_used = server->cache_clock;
+            *hit = true;
+            *build_ms = 0.0;
+            return server->cache[i].scene;
+        }
+    }
+
+    uint64_t start = render_stats_now_ns();
+    Scene* scene = create_scene_by_name(name);
+    scene_build_bvh(scene);
+    *build_ms = (double)(render_stats_now_ns() - start) * 1e-6;
+    *hit = false;
+
+    uint32_t slot = server->cache_count;
+    if (slot == server->cache_capacity) {
+        slot = 0;
+        for (uint32_t i = 1; i < server->cache_count; i++) {
+            if (server->cache[i].last_used < server->cache[slot].last_used) slot = i;
+        }
+        scene_destroy(server->cache[slot].scene);
+    } else {
+        server->cache_count++;
+    }
+    snprintf(server->cache[slot].name, sizeof(server->cache[slot].name), "%s", name);
+    server->cache[slot].scene = scene;
+    server->cache[slot].last_used = server->cache_clock;
+    return scene;
+}
+
+static void render_job(Server* server, Job* job) {
+    const JobRequest* req = &job->request;
+    if (atomic_load(&job->cancel)) {
+        snprintf(job->error, sizeof(job->error), "cancelled");
+        return;
+    }
+
+    Scene* scene = server_get_scene(server, req->scene, &job->cache_hit, &job->build_ms);
+
+    float aspect = (float)req->width / req->height;
+    CameraParams scene_camera = camera_params_for_scene(req->scene);
+    CameraParams camera_params = job_request_camera(req, &scene_camera);
+    Camera camera = camera_from_params(&camera_params, aspect);
+
+    job->image = image_create(req->width, req->height);
+    if (!job->image) {
+        snprintf(job->error, sizeof(job->error), "out of memory for %ux%u image",
+                 req->width, req->height);
+        return;
+    }
+
+    RenderSettings settings = {0};
+    settings.width = req->width;
+    settings.height = req->height;
+    settings.samples_per_pixel = req->samples_per_pixel;
+    settings.max_depth = req->max_depth;
+    settings.use_bvh = true;
+    settings.num_threads = server->num_threads;
+    settings.seed = req->seed;
+    settings.sampler = req->sampler;
+    settings.cancel_flag = &job->cancel;
+    settings.stats = job->stats;
+    render_parallel(scene, &camera, &settings, job->image);
+
+    if (atomic_load(&job->cancel)) {
+        image_destroy(job->image);
+        job->image = NULL;
+        snprintf(job->error, sizeof(job->error), "cancelled");
+    }
+}
+
+static void* worker_thread_func(void* user_data) {
+    Server* server = (Server*)user_data;
+
+    pthread_mutex_lock(&server->mutex);
+    for (;;) {
+        while (!server->head && !server->shutting_down) {
+            pthread_cond_wait(&server->changed, &server->mutex);
+        }
+        Job* job = server->head;
+        if (!job) break;  // Shutting down with an empty queue
+
+        server->head = job->next;
+        if (!server->head) server->tail = NULL;
+        job->state = JOB_RUNNING;
+        server->running = job;
+        pthread_cond_broadcast(&server->changed);
+        pthread_mutex_unlock(&server->mutex);
+
+        render_job(server, job);
+
+        pthread_mutex_lock(&server->mutex);
+        job->state = JOB_DONE;
+        server->running = NULL;
+        server->jobs_done++;
+        pthread_cond_broadcast(&server->changed);
+    }
+    pthread_mutex_unlock(&server->mutex);
+    return NULL;
+}
+
+// True once the peer has closed its end (a readable socket with no data)
+static bool client_gone(int fd) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) <= 0) return false;
+    char c;
+    return recv(fd, &c, 1, MSG_PEEK) <= 0;
+}
+
+static void add_ms(struct timespec* ts, long ms) {
+    ts->tv_nsec += ms * 1000000L;
+    ts->tv_sec += ts->tv_nsec / 1000000000L;
+    ts->tv_nsec %= 1000000000L;
+}
+
+static bool send_result(int fd, Job* job) {
+    char line[JOB_LINE_SIZE];
+    if (!job->image) {
+        snprintf(line, sizeof(line), "ERROR %s", job->error);
+        return job_send_line(fd, line);
+    }
+
+    RenderStatsSnapshot snap;
+    render_stats_snapshot(job->stats, &snap);
+    const Image* img = job->image;
+    snprintf(line, sizeof(line), "DONE %u %u %.3f %llu", img->width, img->height, snap.elapsed,
+             (unsigned long long)snap.totals.rays);
+    if (!job_send_line(fd, line)) return false;
+
+    float* row = (float*)malloc((size_t)img->width * 3 * sizeof(float));
+    bool ok = row != NULL;
+    for (uint32_t y = 0; y < img->height && ok; y++) {
+        for (uint32_t x = 0; x < img->width; x++) {
+            Vec3 c = image_get_pixel(img, x, y);
+            row[3 * x + 0] = c.x;
+            row[3 * x + 1] = c.y;
+            row[3 * x + 2] = c.z;
+        }
+        ok = job_send(fd, row, (size_t)img->width * 3 * sizeof(float));
+    }
+    free(row);
+    return ok;
+}
+
+// Queue a parsed job and report on it until the worker is done with it
+static void serve_job(Server* server, int fd, Job* job) {
+    pthread_mutex_lock(&server->mutex);
+    if (server->shutting_down) {
+        pthread_mutex_unlock(&server->mutex);
+        job_send_line(fd, "ERROR server shutting down");
+        return;
+    }
+    uint32_t ahead = server->running ? 1 : 0;
+    for (Job* j = server->head; j; j = j->next) ahead++;
+    if (server->tail) {
+        server->tail->next = job;
+    } else {
+        server->head = job;
+    }
+    server->tail = job;
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->mutex);
+
+    char line[JOB_LINE_SIZE];
+    snprintf(line, sizeof(line), "QUEUED %u", ahead);
+    bool connected = job_send_line(fd, line);
+    bool started = false;
+
+    pthread_mutex_lock(&server->mutex);
+    while (job->state != JOB_DONE) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        add_ms(&deadline, SERVER_PROGRESS_INTERVAL_MS);
+        pthread_cond_timedwait(&server->changed, &server->mutex, &deadline);
+        JobState state = job->state;
+        pthread_mutex_unlock(&server->mutex);
+
+        if (connected && state != JOB_QUEUED && !started) {
+            // The cache result is set before the first tile is rendered
+            RenderStatsSnapshot snap;
+            render_stats_snapshot(job->stats, &snap);
+            if (snap.total_pixels > 0 || state == JOB_DONE) {
+                snprintf(line, sizeof(line), "STARTED %s %.2f", job->cache_hit ? "hit" : "miss",
+                         job->build_ms);
+                connected = job_send_line(fd, line);
+                started = true;
+            }
+        }
+        if (connected && state == JOB_RUNNING && started) {
+            RenderStatsSnapshot snap;
+            render_stats_snapshot(job->stats, &snap);
+            snprintf(line, sizeof(line), "PROGRESS %.4f %.2f %.2f", snap.progress, snap.elapsed,
+                     snap.mrays_per_sec);
+            connected = job_send_line(fd, line);
+        }
+        if (connected && client_gone(fd)) connected = false;
+        if (!connected) atomic_store(&job->cancel, true);
+
+        pthread_mutex_lock(&server->mutex);
+    }
+    pthread_mutex_unlock(&server->mutex);
+
+    if (connected) send_result(fd, job);
+}
+
+static void serve_status(Server* server, int fd) {
+    char line[JOB_LINE_SIZE];
+    pthread_mutex_lock(&server->mutex);
+    uint32_t queued = 0;
+    for (Job* j = server->head; j; j = j->next) queued++;
+    snprintf(line, sizeof(line), "STATUS running %d queued %u done %llu cached %u/%u threads %u",
+             server->running ? 1 : 0, queued, (unsigned long long)server->jobs_done,
+             server->cache_count, server->cache_capacity, server->num_threads);
+    pthread_mutex_unlock(&server->mutex);
+    job_send_line(fd, line);
+}
+
+// Forget and close a connection. Closed under the lock, so the shutdown on
+// stop never reaches a descriptor number that has been reused.
+static void server_close_client(Server* server, int fd) {
+    pthread_mutex_lock(&server->mutex);
+    for (uint32_t i = 0; i < server->connections; i++) {
+        if (server->client_fds[i] == fd) {
+            server->client_fds[i] = server->client_fds[--server->connections];
+            break;
+        }
+    }
+    close(fd);
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->mutex);
+}
+
+static void* connection_thread_func(void* user_data) {
+    Server* server = &g_server;
+    int fd = (int)(intptr_t)user_data;
+    char line[JOB_LINE_SIZE];
+
+    if (job_read_line(fd, line, sizeof(line))) {
+        if (strcmp(line, "STATUS") == 0) {
+            serve_status(server, fd);
+        } else if (strcmp(line, "SHUTDOWN") == 0) {
+            atomic_store(&g_stop, true);
+            shutdown(server->listen_fd, SHUT_RDWR);  // Wakes the accept loop
+            job_send_line(fd, "OK");
+        } else if (strcmp(line, "RENDER") == 0) {
+            Job* job = (Job*)calloc(1, sizeof(Job));
+            if (!job) {
+                job_send_line(fd, "ERROR out of memory");
+                goto done;
+            }
+            job_request_init(&job->request);
+            bool ok = true;
+            while (ok && (ok = job_read_line(fd, line, sizeof(line))) && line[0] != '\0') {
+                char* value = strchr(line, ' ');
+                if (value) *value++ = '\0';
+                ok = value && job_request_set(&job->request, line, value);
+                if (!ok) {
+                    char reply[JOB_LINE_SIZE];
+                    snprintf(reply, sizeof(reply), "ERROR bad request line: %.200s", line);
+                    job_send_line(fd, reply);
+                }
+            }
+
+            const JobRequest* req = &job->request;
+            if (ok && !scene_name_known(req->scene)) {
+                job_send_line(fd, "ERROR unknown scene");
+            } else if (ok && (req->width < 2 || req->height < 2 || req->width > SERVER_MAX_DIM ||
+                              req->height > SERVER_MAX_DIM)) {
+                char reply[JOB_LINE_SIZE];
+                snprintf(reply, sizeof(reply), "ERROR image size must be 2 to %d pixels a side",
+                         SERVER_MAX_DIM);
+                job_send_line(fd, reply);
+            } else if (ok && (req->samples_per_pixel == 0 || req->samples_per_pixel > SERVER_MAX_SPP ||
+                              req->max_depth == 0 || req->max_depth > SERVER_MAX_DEPTH)) {
+                char reply[JOB_LINE_SIZE];
+                snprintf(reply, sizeof(reply), "ERROR spp must be 1 to %d and depth 1 to %d",
+                         SERVER_MAX_SPP, SERVER_MAX_DEPTH);
+                job_send_line(fd, reply);
+            } else if (ok) {
+                job->stats = render_stats_create(server->num_threads);
+                atomic_init(&job->cancel, false);
+                serve_job(server, fd, job);
+                render_stats_destroy(job->stats);
+                image_destroy(job->image);
+            }
+            free(job);
+        } else {
+            job_send_line(fd, "ERROR unknown command");
+        }
+    }
+
+done:
+    server_close_client(server, fd);
+    return NULL;
+}
+
+// Track an accepted connection; false if out of memory
+static bool server_add_client(Server* server, int fd) {
+    pthread_mutex_lock(&server->mutex);
+    bool ok = true;
+    if (server->connections == server->client_capacity) {
+        uint32_t capacity = server->client_capacity ? 2 * server->client_capacity : 16;
+        int* fds = (int*)realloc(server->client_fds, capacity * sizeof(int));
+        if (fds) {
+            server->client_fds = fds;
+            server->client_capacity = capacity;
+        } else {
+            ok = false;
+        }
+    }
+    if (ok) server->client_fds[server->connections++] = fd;
+    pthread_mutex_unlock(&server->mutex);
+    return ok;
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --socket PATH    Unix socket to listen on (default: %s)\n", JOB_DEFAULT_SOCKET);
+    printf("  --threads N      Render threads per job (default: 8)\n");
+    printf("  --cache N        Built scenes kept between jobs (default: 4)\n");
+}
+
+int main(int argc, char** argv) {
+    const char* socket_path = JOB_DEFAULT_SOCKET;
+    Server* server = &g_server;
+    server->num_threads = 8;
+    server->cache_capacity = 4;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--socket") == 0) {
+            socket_path = value;
+        } else if (strcmp(arg, "--threads") == 0) {
+            server->num_threads = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--cache") == 0) {
+            server->cache_capacity = (uint32_t)atoi(value);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (server->num_threads == 0 || server->cache_capacity == 0) {
+        fprintf(stderr, "Invalid server settings\n");
+        return 1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (server->listen_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 16) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", socket_path, strerror(errno));
+        return 1;
+    }
+
+    // No SA_RESTART: a signal interrupts accept() so the loop can exit
+    struct sigaction sa = {0};
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    server->cache = (CachedScene*)calloc(server->cache_capacity, sizeof(CachedScene));
+    pthread_mutex_init(&server->mutex, NULL);
+    pthread_cond_init(&server->changed, NULL);
+    pthread_t worker;
+    pthread_create(&worker, NULL, worker_thread_func, server);
+
+    printf("Listening on %s (%u threads, %u cached scenes)\n", socket_path, server->num_threads,
+           server->cache_capacity);
+    fflush(stdout);
+
+    while (!atomic_load(&g_stop)) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno != EINTR && !atomic_load(&g_stop)) {
+                fprintf(stderr, "accept failed: %s\n", strerror(errno));
+            }
+            continue;
+        }
+
+        if (!server_add_client(server, fd)) {
+            close(fd);
+            continue;
+        }
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread_func, (void*)(intptr_t)fd) == 0) {
+            pthread_detach(thread);
+        } else {
+            server_close_client(server, fd);
+        }
+    }
+
+    // Cancel queued and running jobs; their connections report the error
+    printf("Shutting down\n");
+    pthread_mutex_lock(&server->mutex);
+    server->shutting_down = true;
+    for (Job* j = server->head; j; j = j->next) atomic_store(&j->cancel, true);
+    if (server->running) atomic_store(&server->running->cancel, true);
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->mutex);
+    pthread_join(worker, NULL);
+
+    // Connection threads may be blocked reading from idle clients
+    pthread_mutex_lock(&server->mutex);
+    for (uint32_t i = 0; i < server->connections; i++) {
+        shutdown(server->client_fds[i], SHUT_RDWR);
+    }
+    while (server->connections > 0) {
+        pthread_cond_wait(&server->changed, &server->mutex);
+    }
+    pthread_mutex_unlock(&server->mutex);
+
+    close(server->listen_fd);
+    unlink(socket_path);
+    for (uint32_t i = 0; i < server->cache_count; i++) {
+        scene_destroy(server->cache[i].scene);
+    }
+    free(server->cache);
+    free(server->client_fds);
+    pthread_cond_destroy(&server->changed);
+    pthread_mutex_destroy(&server->mutex);
+    return 0;
+}
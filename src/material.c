@@ -1,10 +1,63 @@
 #include "material.h"
 #include "primitive.h"
+#include "stats.h"
 #include <math.h>
+#include <string.h>
+
+static const char* const MATERIAL_TYPE_NAMES[MATERIAL_TYPE_COUNT] = {
+    "lambertian",
+    "metal",
+    "dielectric",
+    "emissive",
+    "blend"
+};
+
+static const char* const BLEND_MODE_NAMES[] = {
+    "vertical",
+    "horizontal",
+    "radial"
+};
+
+#define BLEND_MODE_COUNT (sizeof(BLEND_MODE_NAMES) / sizeof(BLEND_MODE_NAMES[0]))
+
+const char* material_type_name(MaterialType type) {
+    if (type < MATERIAL_TYPE_COUNT) {
+        return MATERIAL_TYPE_NAMES[type];
+    }
+    return "unknown";
+}
+
+bool material_type_from_name(const char* name, MaterialType* type) {
+    for (int i = 0; i < MATERIAL_TYPE_COUNT; i++) {
+        if (strcmp(name, MATERIAL_TYPE_NAMES[i]) == 0) {
+            *type = (MaterialType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* blend_mode_name(BlendMode mode) {
+    if ((size_t)mode < BLEND_MODE_COUNT) {
+        return BLEND_MODE_NAMES[mode];
+    }
+    return "unknown";
+}
+
+bool blend_mode_from_name(const char* name, BlendMode* mode) {
+    for (size_t i = 0; i < BLEND_MODE_COUNT; i++) {
+        if (strcmp(name, BLEND_MODE_NAMES[i]) == 0) {
+            *mode = (BlendMode)i;
+            return true;
+        }
+    }
+    return false;
+}
 
 bool material_scatter(const Material* mat, const Ray* ray_in,
                      const HitRecord* rec, Vec3* attenuation,
-                     Ray* scattered, RNG* rng) {
+                     Ray* scattered, Sampler* sampler) {
+    STATS_COUNT(scatters[mat->type]);
     switch (mat->type) {
         case MATERIAL_LAMBERTIAN: {
             // TODO: Implementasi Lambertian diffuse scattering
@@ -17,14 +70,12 @@ bool material_scatter(const Material* mat, const Ray* ray_in,
             // 5. Return true untuk menandakan scatter berhasil
 
             // Cosine-weighted hemisphere sampling
-            Vec3 scatter_direction = vec3_add(rec->normal, rng_unit_vector(rng));
-            
-            // Handle degenerate case (jika scatter_direction hampir nol)
-            if (vec3_length_squared(scatter_direction) < 0.001f) {
-                scatter_direction = rec->normal;
-            }
-            
-            *scattered = ray_create(rec->point, scatter_direction);
+            float u1, u2;
+            sampler_bounce_2d(sampler, SAMPLER_BOUNCE_SCATTER, &u1, &u2);
+            Vec3 scatter_direction = sample_cosine_hemisphere(rec->normal, u1, u2);
+
+            // Direction is already unit length; skip ray_create's normalize
+            *scattered = (Ray){rec->point, scatter_direction, ray_in->time};
             
             // Set attenuation ke albedo material
             *attenuation = mat->albedo;
@@ -45,7 +96,10 @@ bool material_scatter(const Material* mat, const Ray* ray_in,
             Vec3 reflected = vec3_reflect(vec3_normalize(ray_in->direction), rec->normal);
             
             // Tambahkan roughness/fuzz untuk non-perfect reflection
-            Vec3 fuzz = vec3_scale(rng_in_unit_sphere(rng), mat->roughness);
+            float u1, u2;
+            sampler_bounce_2d(sampler, SAMPLER_BOUNCE_SCATTER, &u1, &u2);
+            Vec3 in_ball = sample_uniform_ball(u1, u2, sampler_bounce_1d(sampler, SAMPLER_BOUNCE_EXTRA));
+            Vec3 fuzz = vec3_scale(in_ball, mat->roughness);
             Vec3 scatter_direction = vec3_add(reflected, fuzz);
             
             *scattered = ray_create(rec->point, scatter_direction);
@@ -85,7 +139,8 @@ bool material_scatter(const Material* mat, const Ray* ray_in,
             Vec3 refracted;
             
             // Tentukan reflection atau refraction
-            if (cannot_refract || schlick(cos_theta, refraction_ratio) > rng_float(rng)) {
+            if (cannot_refract ||
+                schlick(cos_theta, refraction_ratio) > sampler_bounce_1d(sampler, SAMPLER_BOUNCE_EXTRA)) {
                 // Reflect
                 direction = vec3_reflect(unit_direction, rec->normal);
             } else {
@@ -145,18 +200,20 @@ bool material_scatter(const Material* mat, const Ray* ray_in,
             // Scatter based on the active material type
             switch (active_type) {
                 case MATERIAL_LAMBERTIAN: {
-                    Vec3 scatter_direction = vec3_add(rec->normal, rng_unit_vector(rng));
-                    if (vec3_length_squared(scatter_direction) < 0.001f) {
-                        scatter_direction = rec->normal;
-                    }
-                    *scattered = ray_create(rec->point, scatter_direction);
+                    float u1, u2;
+                    sampler_bounce_2d(sampler, SAMPLER_BOUNCE_SCATTER, &u1, &u2);
+                    *scattered = (Ray){rec->point, sample_cosine_hemisphere(rec->normal, u1, u2),
+                                       ray_in->time};
                     *attenuation = blended_albedo;
                     return true;
                 }
 
                 case MATERIAL_METAL: {
                     Vec3 reflected = vec3_reflect(vec3_normalize(ray_in->direction), rec->normal);
-                    Vec3 fuzz = vec3_scale(rng_in_unit_sphere(rng), blended_roughness);
+                    float u1, u2;
+                    sampler_bounce_2d(sampler, SAMPLER_BOUNCE_SCATTER, &u1, &u2);
+                    Vec3 in_ball = sample_uniform_ball(u1, u2, sampler_bounce_1d(sampler, SAMPLER_BOUNCE_EXTRA));
+                    Vec3 fuzz = vec3_scale(in_ball, blended_roughness);
                     *scattered = ray_create(rec->point, vec3_add(reflected, fuzz));
                     *attenuation = blended_albedo;
                     return vec3_dot(scattered->direction, rec->normal) > 0;
@@ -171,7 +228,7 @@ bool material_scatter(const Material* mat, const Ray* ray_in,
 
                     if (vec3_refract(unit_direction, rec->normal, refraction_ratio, &refracted)) {
                         float cos_theta = fminf(-vec3_dot(unit_direction, rec->normal), 1.0f);
-                        if (schlick(cos_theta, refraction_ratio) > rng_float(rng)) {
+                        if (schlick(cos_theta, refraction_ratio) > sampler_bounce_1d(sampler, SAMPLER_BOUNCE_EXTRA)) {
                             direction = vec3_reflect(unit_direction, rec->normal);
                         } else {
                             direction = refracted;
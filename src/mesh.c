@@ -0,0 +1,258 @@
+#include "mesh.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+Mesh* mesh_create(uint32_t vertex_count, uint32_t triangle_count, bool with_normals, bool with_uvs) {
+    Mesh* mesh = (Mesh*)calloc(1, sizeof(Mesh));
+    if (!mesh) return NULL;
+
+    mesh->vertex_count = vertex_count;
+    mesh->triangle_count = triangle_count;
+    mesh->bounds = aabb_empty();
+    mesh->positions = (Vec3*)malloc((vertex_count ? vertex_count : 1) * sizeof(Vec3));
+    mesh->indices = (uint32_t*)malloc((triangle_count ? triangle_count : 1) * 3 * sizeof(uint32_t));
+    bool ok = mesh->positions && mesh->indices;
+    if (with_normals) {
+        mesh->normals = (Vec3*)malloc((vertex_count ? vertex_count : 1) * sizeof(Vec3));
+        ok = ok && mesh->normals;
+    }
+    if (with_uvs) {
+        mesh->uvs = (float*)malloc((vertex_count ? vertex_count : 1) * 2 * sizeof(float));
+        ok = ok && mesh->uvs;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate mesh (%u vertices, %u triangles)\n",
+                vertex_count, triangle_count);
+        mesh_destroy(mesh);
+        return NULL;
+    }
+    return mesh;
+}
+
+Mesh* mesh_create_sphere(uint32_t stacks, uint32_t slices, float radius) {
+    uint32_t vertex_count = (stacks + 1) * (slices + 1);
+    Mesh* mesh = mesh_create(vertex_count, 2 * stacks * slices, true, true);
+    if (!mesh) return NULL;
+
+    for (uint32_t i = 0; i <= stacks; i++) {
+        float theta = (float)M_PI * i / stacks;
+        for (uint32_t j = 0; j <= slices; j++) {
+            float phi = 2.0f * (float)M_PI * j / slices;
+            uint32_t v = i * (slices + 1) + j;
+            Vec3 n = vec3_create(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+            mesh->normals[v] = n;
+            mesh->positions[v] = vec3_scale(n, radius);
+            mesh->uvs[2 * v] = (float)j / slices;
+            mesh->uvs[2 * v + 1] = (float)i / stacks;
+        }
+    }
+
+    uint32_t* idx = mesh->indices;
+    for (uint32_t i = 0; i < stacks; i++) {
+        for (uint32_t j = 0; j < slices; j++) {
+            uint32_t a = i * (slices + 1) + j, b = a + slices + 1;
+            *idx++ = a; *idx++ = b; *idx++ = a + 1;
+            *idx++ = a + 1; *idx++ = b; *idx++ = b + 1;
+        }
+    }
+    return mesh;
+}
+
+void mesh_destroy(Mesh* mesh) {
+    if (mesh) {
+        bvh_destroy(mesh->bvh);
+        if (!mesh->borrowed) {
+            free(mesh->positions);
+            free(mesh->normals);
+            free(mesh->uvs);
+            free(mesh->indices);
+        }
+        free(mesh);
+    }
+}
+
+// Same padded boxes as triangle_bounds
+static inline AABB mesh_triangle_bounds(const Mesh* mesh, uint32_t t) {
+    const Vec3 epsilon = vec3_create(0.0001f, 0.0001f, 0.0001f);
+    const uint32_t* tri = mesh->indices + 3 * (size_t)t;
+    AABB box = aabb_empty();
+    box = aabb_expand(box, mesh->positions[tri[0]]);
+    box = aabb_expand(box, mesh->positions[tri[1]]);
+    box = aabb_expand(box, mesh->positions[tri[2]]);
+    box.min = vec3_sub(box.min, epsilon);
+    box.max = vec3_add(box.max, epsilon);
+    return box;
+}
+
+void mesh_update_bounds(Mesh* mesh) {
+    mesh->bounds = aabb_empty();
+    for (uint32_t t = 0; t < mesh->triangle_count; t++) {
+        mesh->bounds = aabb_union(mesh->bounds, mesh_triangle_bounds(mesh, t));
+    }
+}
+
+static void split_mesh_triangle(const void* user, uint32_t item, AABB box, uint32_t axis, float pos,
+                                AABB* left, AABB* right) {
+    const Mesh* mesh = (const Mesh*)user;
+    const uint32_t* tri = mesh->indices + 3 * (size_t)item;
+    triangle_split_bounds(mesh->positions[tri[0]], mesh->positions[tri[1]], mesh->positions[tri[2]],
+                          box, axis, pos, left, right);
+}
+
+void mesh_build_bvh(Mesh* mesh, float split_budget) {
+    bvh_destroy(mesh->bvh);
+    mesh->bvh = NULL;
+
+    uint32_t count = mesh->triangle_count;
+    AABB* bounds = (AABB*)malloc((count ? count : 1) * sizeof(AABB));
+    uint32_t* reordered = (uint32_t*)malloc((count ? count : 1) * 3 * sizeof(uint32_t));
+    if (!bounds || !reordered) {
+        fprintf(stderr, "Failed to allocate BVH build buffers for %u triangles\n", count);
+        free(bounds);
+        free(reordered);
+        return;
+    }
+
+    mesh->bounds = aabb_empty();
+    for (uint32_t t = 0; t < count; t++) {
+        bounds[t] = mesh_triangle_bounds(mesh, t);
+        mesh->bounds = aabb_union(mesh->bounds, bounds[t]);
+    }
+
+    mesh->bvh = split_budget > 1.0f
+                    ? bvh_create_from_bounds_spatial(bounds, count, split_budget, split_mesh_triangle, mesh)
+                    : bvh_create_from_bounds(bounds, count);
+    free(bounds);
+    if (!mesh->bvh) {
+        fprintf(stderr, "Failed to build the BVH for %u triangles\n", count);
+        free(reordered);
+        return;
+    }
+
+    // Store triangles in leaf order so leaves index them without indirection
+    // (spatial-split leaves go through bvh->refs, which follow this order)
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(reordered + 3 * (size_t)i, mesh->indices + 3 * (size_t)mesh->bvh->indices[i],
+               3 * sizeof(uint32_t));
+    }
+    free(mesh->indices);
+    mesh->indices = reordered;
+    free(mesh->bvh->indices);
+    mesh->bvh->indices = NULL;
+}
+
+// Inlined once with refs NULL for object-split trees (see bvh_traverse)
+static inline __attribute__((always_inline))
+bool mesh_traverse(const Mesh* mesh, const uint32_t* refs, const Ray* ray, float t_min, float t_max,
+                   HitRecord* rec) {
+    const BVH* bvh = mesh->bvh;
+
+    // Closest triangle and its barycentrics; the hit record is filled once
+    const BVHNode* nodes = bvh->nodes;
+    uint32_t stack[BVH_STACK_SIZE];
+    int stack_ptr = 0;
+    uint32_t hit_tri = UINT32_MAX;
+    float closest_so_far = t_max;
+    float hit_u = 0.0f, hit_v = 0.0f;
+    uint32_t visited = 0;
+
+    stack[stack_ptr++] = 0;
+    while (stack_ptr > 0) {
+        const BVHNode* node = &nodes[stack[--stack_ptr]];
+        visited++;
+
+        if (!aabb_hit(&node->bounds, ray, t_min, closest_so_far)) {
+            continue;
+        }
+        STATS_COUNT(aabb_hits);
+
+        if (node->is_leaf) {
+            STATS_COUNT(leaf_visits);
+            for (uint32_t i = 0; i < node->prim_count; i++) {
+                uint32_t idx = node->first_prim_idx + i;
+                if (refs) idx = refs[idx];
+                const uint32_t* tri = mesh->indices + 3 * (size_t)idx;
+                float t, u, v;
+                STATS_COUNT(prim_tests[PRIMITIVE_MESH]);
+                if (triangle_intersect(mesh->positions[tri[0]], mesh->positions[tri[1]],
+                                       mesh->positions[tri[2]], ray, t_min, closest_so_far,
+                                       &t, &u, &v)) {
+                    closest_so_far = t;
+                    hit_tri = idx;
+                    hit_u = u;
+                    hit_v = v;
+                }
+            }
+        } else if (((const float*)&ray->direction)[node->split_axis] < 0.0f) {
+            stack[stack_ptr++] = node->left;
+            stack[stack_ptr++] = node->right;
+        } else {
+            stack[stack_ptr++] = node->right;
+            stack[stack_ptr++] = node->left;
+        }
+    }
+
+    render_thread_counters.bvh_nodes += visited;
+    STATS_ADD(aabb_tests, visited);
+    if (hit_tri == UINT32_MAX) return false;
+    STATS_COUNT(prim_hits[PRIMITIVE_MESH]);
+
+    const uint32_t* tri = mesh->indices + 3 * (size_t)hit_tri;
+    Vec3 p0 = mesh->positions[tri[0]];
+    Vec3 p1 = mesh->positions[tri[1]];
+    Vec3 p2 = mesh->positions[tri[2]];
+    float w = 1.0f - hit_u - hit_v;
+
+    rec->t = closest_so_far;
+    rec->point = ray_at(*ray, closest_so_far);
+    Vec3 outward_normal = vec3_normalize(vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0)));
+    rec->front_face = vec3_dot(ray->direction, outward_normal) < 0.0f;
+
+    Vec3 normal = outward_normal;
+    if (mesh->normals) {
+        Vec3 n = vec3_add(vec3_add(vec3_scale(mesh->normals[tri[0]], w),
+                                   vec3_scale(mesh->normals[tri[1]], hit_u)),
+                          vec3_scale(mesh->normals[tri[2]], hit_v));
+        n = vec3_normalize(n);
+        // Keep the shading normal on the geometric side of the surface
+        normal = vec3_dot(n, outward_normal) < 0.0f ? vec3_scale(n, -1.0f) : n;
+    }
+    rec->normal = rec->front_face ? normal : vec3_scale(normal, -1.0f);
+
+    if (mesh->uvs) {
+        const float* uv0 = mesh->uvs + 2 * (size_t)tri[0];
+        const float* uv1 = mesh->uvs + 2 * (size_t)tri[1];
+        const float* uv2 = mesh->uvs + 2 * (size_t)tri[2];
+        rec->u = w * uv0[0] + hit_u * uv1[0] + hit_v * uv2[0];
+        rec->v = w * uv0[1] + hit_u * uv1[1] + hit_v * uv2[1];
+    } else {
+        rec->u = hit_u;
+        rec->v = hit_v;
+    }
+    return true;
+}
+
+bool mesh_hit(const Mesh* mesh, const Ray* ray, float t_min, float t_max, HitRecord* rec) {
+    const BVH* bvh = mesh->bvh;
+    if (!bvh || bvh->node_count == 0) return false;
+    if (bvh->refs) return mesh_traverse(mesh, bvh->refs, ray, t_min, t_max, rec);
+    return mesh_traverse(mesh, NULL, ray, t_min, t_max, rec);
+}
+
+size_t mesh_memory_bytes(const Mesh* mesh) {
+    size_t bytes = sizeof(Mesh);
+    size_t per_vertex = sizeof(Vec3);
+    if (mesh->normals) per_vertex += sizeof(Vec3);
+    if (mesh->uvs) per_vertex += 2 * sizeof(float);
+    bytes += (size_t)mesh->vertex_count * per_vertex;
+    bytes += (size_t)mesh->triangle_count * 3 * sizeof(uint32_t);
+    if (mesh->bvh) {
+        bytes += sizeof(BVH) + (size_t)mesh->bvh->node_count * sizeof(BVHNode);
+        if (mesh->bvh->indices) bytes += (size_t)mesh->bvh->prim_count * sizeof(uint32_t);
+        bytes += (size_t)mesh->bvh->ref_count * sizeof(uint32_t);
+    }
+    return bytes;
+}
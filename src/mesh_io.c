@@ -0,0 +1,714 @@
+#define _POSIX_C_SOURCE 200809L
+#include "mesh_io.h"
+#include "file_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <omp.h>
+
+// Smallest OBJ chunk worth a thread of its own
+#define OBJ_MIN_CHUNK_BYTES (1u << 20)
+// PLY faces per parallel block (variable-length records are walked once to
+// find where each block starts)
+#define PLY_FACE_BLOCK 65536u
+
+// ============================================================================
+// OBJ
+// ============================================================================
+
+// Record type of the line at p: 'v', 'n' (vn), 't' (vt), 'f' or 0. *args
+// points past the keyword.
+static char obj_record(const char* p, const char* end, const char** args) {
+    p = skip_blanks(p, end);
+    if (end - p < 2) return 0;
+    char type = 0;
+    if (p[0] == 'v' && is_blank(p[1])) {
+        type = 'v';
+        p += 1;
+    } else if (p[0] == 'f' && is_blank(p[1])) {
+        type = 'f';
+        p += 1;
+    } else if (p[0] == 'v' && (p[1] == 'n' || p[1] == 't') && end - p > 2 && is_blank(p[2])) {
+        type = p[1];
+        p += 2;
+    }
+    *args = p;
+    return type;
+}
+
+static uint32_t obj_face_vertex_count(const char* p, const char* end) {
+    uint32_t count = 0;
+    for (;;) {
+        p = skip_blanks(p, end);
+        if (p >= end || is_separator(*p)) return count;
+        count++;
+        while (p < end && !is_separator(*p)) p++;
+    }
+}
+
+typedef struct {
+    const char* begin;
+    const char* end;
+    // Counts from the first pass, then the chunk's first output index
+    size_t positions, normals, uvs, triangles, lines;
+    // Every face of the chunk reuses its position index for vt / vn
+    bool uvs_aligned, normals_aligned;
+    size_t error_line;  // 1-based line within the chunk; 0 = no error
+    const char* error;
+} ObjChunk;
+
+static void obj_count_chunk(ObjChunk* chunk) {
+    const char* end = chunk->end;
+    for (const char* p = chunk->begin; p < end; p = next_line(p, end)) {
+        const char* args;
+        switch (obj_record(p, end, &args)) {
+            case 'v': chunk->positions++; break;
+            case 'n': chunk->normals++; break;
+            case 't': chunk->uvs++; break;
+            case 'f': {
+                uint32_t n = obj_face_vertex_count(args, end);
+                if (n >= 3) chunk->triangles += n - 2;
+                break;
+            }
+            default: break;
+        }
+        chunk->lines++;
+    }
+}
+
+typedef struct {
+    Vec3* positions;
+    Vec3* normals;
+    float* uvs;
+    uint32_t* indices;
+    size_t position_count, normal_count, uv_count;
+} ObjTarget;
+
+// 1-based or negative (relative to `defined` records so far) OBJ index
+static bool obj_resolve(int64_t index, size_t defined, size_t total, int64_t* out) {
+    int64_t resolved = index > 0 ? index - 1 : (int64_t)defined + index;
+    if (index == 0 || resolved < 0 || resolved >= (int64_t)total) return false;
+    *out = resolved;
+    return true;
+}
+
+static void obj_parse_chunk(ObjChunk* chunk, const ObjTarget* target) {
+    const char* end = chunk->end;
+    size_t position = chunk->positions, normal = chunk->normals, uv = chunk->uvs;
+    uint32_t* tri = target->indices + 3 * chunk->triangles;
+    size_t line = 0;
+
+    for (const char* p = chunk->begin; p < end && !chunk->error; p = next_line(p, end)) {
+        const char* args;
+        line++;
+        switch (obj_record(p, end, &args)) {
+            case 'v': {
+                float xyz[3];
+                if (!parse_floats(args, end, xyz, 3)) {
+                    chunk->error = "invalid vertex";
+                    break;
+                }
+                target->positions[position++] = vec3_create(xyz[0], xyz[1], xyz[2]);
+                break;
+            }
+            case 'n': {
+                float xyz[3];
+                if (!parse_floats(args, end, xyz, 3)) {
+                    chunk->error = "invalid normal";
+                    break;
+                }
+                target->normals[normal++] = vec3_create(xyz[0], xyz[1], xyz[2]);
+                break;
+            }
+            case 't': {
+                float st[2] = {0.0f, 0.0f};
+                const char* q = skip_blanks(args, end);
+                if (!parse_float(&q, end, &st[0]) || (q < end && !is_separator(*q))) {
+                    chunk->error = "invalid texture coordinate";
+                    break;
+                }
+                q = skip_blanks(q, end);
+                if (q < end && !is_separator(*q) && !parse_floats(q, end, &st[1], 1)) {
+                    chunk->error = "invalid texture coordinate";
+                    break;
+                }
+                target->uvs[2 * uv] = st[0];
+                target->uvs[2 * uv + 1] = st[1];
+                uv++;
+                break;
+            }
+            case 'f': {
+                // v, v/vt, v//vn or v/vt/vn; polygons become triangle fans
+                int64_t first = 0, previous = 0;
+                uint32_t n = 0;
+                const char* q = args;
+                for (;;) {
+                    q = skip_blanks(q, end);
+                    if (q >= end || is_separator(*q)) break;
+                    int64_t raw, v, vt = -1, vn = -1;
+                    if (!parse_int(&q, end, &raw) ||
+                        !obj_resolve(raw, position, target->position_count, &v)) {
+                        chunk->error = "invalid face vertex index";
+                        break;
+                    }
+                    if (q < end && *q == '/') {
+                        q++;
+                        if (q < end && *q != '/' &&
+                            (!parse_int(&q, end, &raw) ||
+                             !obj_resolve(raw, uv, target->uv_count, &vt))) {
+                            chunk->error = "invalid face texture index";
+                            break;
+                        }
+                        if (q < end && *q == '/') {
+                            q++;
+                            if (!parse_int(&q, end, &raw) ||
+                                !obj_resolve(raw, normal, target->normal_count, &vn)) {
+                                chunk->error = "invalid face normal index";
+                                break;
+                            }
+                        }
+                    }
+                    if (q < end && !is_separator(*q)) {
+                        chunk->error = "invalid face";
+                        break;
+                    }
+                    if (vt != v) chunk->uvs_aligned = false;
+                    if (vn != v) chunk->normals_aligned = false;
+
+                    if (n == 0) {
+                        first = v;
+                    } else if (n >= 2) {
+                        tri[0] = (uint32_t)first;
+                        tri[1] = (uint32_t)previous;
+                        tri[2] = (uint32_t)v;
+                        tri += 3;
+                    }
+                    previous = v;
+                    n++;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (chunk->error) chunk->error_line = line;
+}
+
+Mesh* mesh_load_obj(const char* path) {
+    MappedFile file;
+    if (!map_file(path, &file)) return NULL;
+    const char* data = file.data;
+    const char* data_end = data + file.size;
+
+    // Chunks start after a newline so no record straddles two chunks
+    size_t chunk_count = file.size / OBJ_MIN_CHUNK_BYTES;
+    size_t max_chunks = (size_t)omp_get_max_threads() * 8;
+    if (chunk_count > max_chunks) chunk_count = max_chunks;
+    if (chunk_count < 1) chunk_count = 1;
+    ObjChunk* chunks = (ObjChunk*)calloc(chunk_count, sizeof(ObjChunk));
+    if (!chunks) {
+        unmap_file(&file);
+        return NULL;
+    }
+    const char* cursor = data;
+    for (size_t i = 0; i < chunk_count; i++) {
+        const char* split = data + file.size * (i + 1) / chunk_count;
+        if (split < cursor) split = cursor;
+        if (i + 1 < chunk_count && split > data && split[-1] != '\n') split = next_line(split, data_end);
+        chunks[i].begin = cursor;
+        chunks[i].end = i + 1 < chunk_count ? split : data_end;
+        chunks[i].uvs_aligned = chunks[i].normals_aligned = true;
+        cursor = chunks[i].end;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < chunk_count; i++) {
+        obj_count_chunk(&chunks[i]);
+    }
+
+    // Counts become per-chunk output offsets
+    ObjTarget target = {0};
+    size_t triangle_count = 0, line_count = 0;
+    for (size_t i = 0; i < chunk_count; i++) {
+        ObjChunk* c = &chunks[i];
+        size_t counts[5] = {c->positions, c->normals, c->uvs, c->triangles, c->lines};
+        c->positions = target.position_count;
+        c->normals = target.normal_count;
+        c->uvs = target.uv_count;
+        c->triangles = triangle_count;
+        c->lines = line_count;
+        target.position_count += counts[0];
+        target.normal_count += counts[1];
+        target.uv_count += counts[2];
+        triangle_count += counts[3];
+        line_count += counts[4];
+    }
+
+    Mesh* mesh = NULL;
+    if (triangle_count == 0) {
+        fprintf(stderr, "%s: no faces\n", path);
+    } else if (target.position_count > UINT32_MAX || triangle_count > UINT32_MAX / 3) {
+        fprintf(stderr, "%s: too many vertices or faces for 32-bit indices\n", path);
+    } else {
+        mesh = mesh_create((uint32_t)target.position_count, (uint32_t)triangle_count, false, false);
+    }
+    if (mesh) {
+        target.positions = mesh->positions;
+        target.indices = mesh->indices;
+        target.normals = (Vec3*)malloc((target.normal_count ? target.normal_count : 1) * sizeof(Vec3));
+        target.uvs = (float*)malloc((target.uv_count ? target.uv_count : 1) * 2 * sizeof(float));
+        if (!target.normals || !target.uvs) {
+            fprintf(stderr, "%s: out of memory\n", path);
+            mesh_destroy(mesh);
+            mesh = NULL;
+        }
+    }
+
+    if (mesh) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < chunk_count; i++) {
+            obj_parse_chunk(&chunks[i], &target);
+        }
+
+        bool uvs_aligned = true, normals_aligned = true;
+        for (size_t i = 0; i < chunk_count && mesh; i++) {
+            if (chunks[i].error) {
+                fprintf(stderr, "%s:%zu: %s\n", path, chunks[i].lines + chunks[i].error_line,
+                        chunks[i].error);
+                mesh_destroy(mesh);
+                mesh = NULL;
+                break;
+            }
+            uvs_aligned = uvs_aligned && chunks[i].uvs_aligned;
+            normals_aligned = normals_aligned && chunks[i].normals_aligned;
+        }
+
+        // Attributes indexed independently of positions would need vertex
+        // splitting; such meshes are loaded without them
+        if (mesh && target.normal_count > 0) {
+            if (normals_aligned && target.normal_count == target.position_count) {
+                mesh->normals = target.normals;
+                target.normals = NULL;
+            } else {
+                fprintf(stderr, "%s: normals are not indexed like positions; using flat shading\n", path);
+            }
+        }
+        if (mesh && target.uv_count > 0) {
+            if (uvs_aligned && target.uv_count == target.position_count) {
+                mesh->uvs = target.uvs;
+                target.uvs = NULL;
+            } else {
+                fprintf(stderr, "%s: texture coordinates are not indexed like positions; ignoring them\n", path);
+            }
+        }
+    }
+
+    free(target.normals);
+    free(target.uvs);
+    free(chunks);
+    unmap_file(&file);
+    return mesh;
+}
+
+// ============================================================================
+// PLY
+// ============================================================================
+
+typedef enum {
+    PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+    PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+} PlyType;
+
+static const uint32_t PLY_TYPE_SIZE[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+#define PLY_NAME_SIZE 32
+#define PLY_MAX_PROPERTIES 32
+#define PLY_MAX_ELEMENTS 16
+
+typedef struct {
+    char name[PLY_NAME_SIZE];
+    PlyType type;        // Value type (list items for lists)
+    PlyType count_type;  // List length type
+    bool is_list;
+    uint32_t offset;     // Byte offset in fixed-size records
+} PlyProperty;
+
+typedef struct {
+    char name[PLY_NAME_SIZE];
+    uint64_t count;
+    PlyProperty properties[PLY_MAX_PROPERTIES];
+    uint32_t property_count;
+    uint32_t stride;     // Record size when no property is a list
+    bool has_list;
+} PlyElement;
+
+static bool ply_type_from_name(const char* name, PlyType* type) {
+    static const struct { const char* name; PlyType type; } names[] = {
+        {"char", PLY_INT8}, {"int8", PLY_INT8}, {"uchar", PLY_UINT8}, {"uint8", PLY_UINT8},
+        {"short", PLY_INT16}, {"int16", PLY_INT16}, {"ushort", PLY_UINT16}, {"uint16", PLY_UINT16},
+        {"int", PLY_INT32}, {"int32", PLY_INT32}, {"uint", PLY_UINT32}, {"uint32", PLY_UINT32},
+        {"float", PLY_FLOAT32}, {"float32", PLY_FLOAT32}, {"double", PLY_FLOAT64}, {"float64", PLY_FLOAT64},
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i].name) == 0) {
+            *type = names[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Values are stored in file order; big-endian files are byte-swapped on a
+// little-endian host
+static inline double ply_read(const uint8_t* p, PlyType type, bool swap) {
+    uint8_t b[8];
+    uint32_t size = PLY_TYPE_SIZE[type];
+    memcpy(b, p, size);
+    if (swap) {
+        for (uint32_t i = 0; i < size / 2; i++) {
+            uint8_t t = b[i];
+            b[i] = b[size - 1 - i];
+            b[size - 1 - i] = t;
+        }
+    }
+    switch (type) {
+        case PLY_INT8: return (int8_t)b[0];
+        case PLY_UINT8: return b[0];
+        case PLY_INT16: { int16_t v; memcpy(&v, b, 2); return v; }
+        case PLY_UINT16: { uint16_t v; memcpy(&v, b, 2); return v; }
+        case PLY_INT32: { int32_t v; memcpy(&v, b, 4); return v; }
+        case PLY_UINT32: { uint32_t v; memcpy(&v, b, 4); return v; }
+        case PLY_FLOAT32: { float v; memcpy(&v, b, 4); return v; }
+        case PLY_FLOAT64: { double v; memcpy(&v, b, 8); return v; }
+    }
+    return 0.0;
+}
+
+// Size of one record at p, walking list lengths; 0 if it runs past end
+static size_t ply_record_size(const PlyElement* element, const uint8_t* p, const uint8_t* end, bool swap) {
+    if (!element->has_list) {
+        return (size_t)(end - p) >= element->stride ? element->stride : 0;
+    }
+    size_t size = 0;
+    for (uint32_t i = 0; i < element->property_count; i++) {
+        const PlyProperty* prop = &element->properties[i];
+        if (!prop->is_list) {
+            size += PLY_TYPE_SIZE[prop->type];
+            continue;
+        }
+        uint32_t count_size = PLY_TYPE_SIZE[prop->count_type];
+        if ((size_t)(end - p) < size + count_size) return 0;
+        double n = ply_read(p + size, prop->count_type, swap);
+        if (n < 0) return 0;
+        size += count_size + (size_t)n * PLY_TYPE_SIZE[prop->type];
+    }
+    return (size_t)(end - p) >= size ? size : 0;
+}
+
+static int ply_find_property(const PlyElement* element, const char* name) {
+    for (uint32_t i = 0; i < element->property_count; i++) {
+        if (strcmp(element->properties[i].name, name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Parse the text header; *body points at the first data byte
+static bool ply_parse_header(const char* path, const MappedFile* file, bool* big_endian,
+                             PlyElement* elements, uint32_t* element_count, const uint8_t** body) {
+    const char* p = file->data;
+    const char* end = file->data + file->size;
+    bool format_seen = false;
+    *element_count = 0;
+
+    if (file->size < 4 || memcmp(p, "ply", 3) != 0 || (p[3] != '\n' && p[3] != '\r')) {
+        fprintf(stderr, "%s: not a PLY file\n", path);
+        return false;
+    }
+    for (p = next_line(p, end); p < end; p = next_line(p, end)) {
+        char line[256];
+        const char* line_end = (const char*)memchr(p, '\n', (size_t)(end - p));
+        size_t len = (size_t)((line_end ? line_end : end) - p);
+        if (len >= sizeof(line)) len = sizeof(line) - 1;
+        memcpy(line, p, len);
+        line[len] = '\0';
+        if (len > 0 && line[len - 1] == '\r') line[len - 1] = '\0';
+
+        char word[PLY_NAME_SIZE], a[PLY_NAME_SIZE], b[PLY_NAME_SIZE], c[PLY_NAME_SIZE];
+        unsigned long long count;
+        if (strcmp(line, "end_header") == 0) {
+            if (!format_seen) {
+                fprintf(stderr, "%s: missing format line\n", path);
+                return false;
+            }
+            *body = (const uint8_t*)next_line(p, end);
+            return true;
+        } else if (sscanf(line, "format %31s", word) == 1) {
+            if (strcmp(word, "ascii") == 0) {
+                fprintf(stderr, "%s: ASCII PLY is not supported (convert it to binary)\n", path);
+                return false;
+            }
+            if (strcmp(word, "binary_little_endian") != 0 && strcmp(word, "binary_big_endian") != 0) {
+                fprintf(stderr, "%s: unknown PLY format %s\n", path, word);
+                return false;
+            }
+            *big_endian = strcmp(word, "binary_big_endian") == 0;
+            format_seen = true;
+        } else if (sscanf(line, "element %31s %llu", word, &count) == 2) {
+            if (*element_count == PLY_MAX_ELEMENTS) {
+                fprintf(stderr, "%s: too many elements\n", path);
+                return false;
+            }
+            PlyElement* element = &elements[(*element_count)++];
+            memset(element, 0, sizeof(*element));
+            snprintf(element->name, sizeof(element->name), "%s", word);
+            element->count = count;
+        } else if (strncmp(line, "property", 8) == 0) {
+            if (*element_count == 0) {
+                fprintf(stderr, "%s: property before any element\n", path);
+                return false;
+            }
+            PlyElement* element = &elements[*element_count - 1];
+            if (element->property_count == PLY_MAX_PROPERTIES) {
+                fprintf(stderr, "%s: too many properties on %s\n", path, element->name);
+                return false;
+            }
+            PlyProperty* prop = &element->properties[element->property_count];
+            memset(prop, 0, sizeof(*prop));
+            if (sscanf(line, "property list %31s %31s %31s", a, b, c) == 3) {
+                prop->is_list = true;
+                if (!ply_type_from_name(a, &prop->count_type) || !ply_type_from_name(b, &prop->type) ||
+                    prop->count_type == PLY_FLOAT32 || prop->count_type == PLY_FLOAT64) {
+                    fprintf(stderr, "%s: bad list property: %s\n", path, line);
+                    return false;
+                }
+                snprintf(prop->name, sizeof(prop->name), "%s", c);
+                element->has_list = true;
+            } else if (sscanf(line, "property %31s %31s", a, b) == 2 && ply_type_from_name(a, &prop->type)) {
+                snprintf(prop->name, sizeof(prop->name), "%s", b);
+                prop->offset = element->stride;
+                element->stride += PLY_TYPE_SIZE[prop->type];
+            } else {
+                fprintf(stderr, "%s: bad property: %s\n", path, line);
+                return false;
+            }
+            element->property_count++;
+        }
+        // comment, obj_info and unknown lines are ignored
+    }
+    fprintf(stderr, "%s: missing end_header\n", path);
+    return false;
+}
+
+Mesh* mesh_load_ply(const char* path) {
+    MappedFile file;
+    if (!map_file(path, &file)) return NULL;
+
+    PlyElement elements[PLY_MAX_ELEMENTS];
+    uint32_t element_count;
+    bool big_endian = false;
+    const uint8_t* body;
+    if (!ply_parse_header(path, &file, &big_endian, elements, &element_count, &body)) {
+        unmap_file(&file);
+        return NULL;
+    }
+    const bool swap = big_endian;
+    const uint8_t* end = (const uint8_t*)file.data + file.size;
+
+    const PlyElement* vertex = NULL;
+    const PlyElement* face = NULL;
+    const uint8_t* vertex_data = NULL;
+    int face_list = -1;
+    uint32_t face_list_offset = 0;  // Only scalars may precede the index list
+
+    // Faces are variable-length, so walking them once both finds where the
+    // data ends and records where each parallel block starts
+    size_t* block_offsets = NULL;
+    size_t* block_triangles = NULL;
+    size_t block_count = 0;
+    size_t triangle_count = 0;
+    bool ok = true;
+
+    const uint8_t* p = body;
+    for (uint32_t e = 0; e < element_count && ok; e++) {
+        const PlyElement* element = &elements[e];
+        if (strcmp(element->name, "vertex") == 0 && !vertex) {
+            vertex = element;
+            vertex_data = p;
+            if (element->has_list) {
+                fprintf(stderr, "%s: list properties on vertices are not supported\n", path);
+                ok = false;
+            } else if ((uint64_t)(end - p) / (element->stride ? element->stride : 1) < element->count) {
+                fprintf(stderr, "%s: truncated vertex data\n", path);
+                ok = false;
+            } else {
+                p += element->count * element->stride;
+            }
+        } else if (strcmp(element->name, "face") == 0 && !face) {
+            face = element;
+            face_list = ply_find_property(face, "vertex_indices");
+            if (face_list < 0) face_list = ply_find_property(face, "vertex_index");
+            if (face_list < 0 || !face->properties[face_list].is_list ||
+                face->properties[face_list].type >= PLY_FLOAT32) {
+                fprintf(stderr, "%s: face element has no integer vertex_indices list\n", path);
+                ok = false;
+                break;
+            }
+            for (int i = 0; i < face_list && ok; i++) {
+                if (face->properties[i].is_list) {
+                    fprintf(stderr, "%s: list properties before vertex_indices are not supported\n", path);
+                    ok = false;
+                }
+                face_list_offset += PLY_TYPE_SIZE[face->properties[i].type];
+            }
+            if (!ok) break;
+            block_count = (size_t)((face->count + PLY_FACE_BLOCK - 1) / PLY_FACE_BLOCK);
+            block_offsets = (size_t*)malloc((block_count + 1) * sizeof(size_t));
+            block_triangles = (size_t*)malloc((block_count + 1) * sizeof(size_t));
+            if (!block_offsets || !block_triangles) {
+                ok = false;
+                break;
+            }
+            const PlyProperty* list = &face->properties[face_list];
+            for (uint64_t f = 0; f < face->count; f++) {
+                if (f % PLY_FACE_BLOCK == 0) {
+                    block_offsets[f / PLY_FACE_BLOCK] = (size_t)(p - (const uint8_t*)file.data);
+                    block_triangles[f / PLY_FACE_BLOCK] = triangle_count;
+                }
+                size_t size = ply_record_size(face, p, end, swap);
+                if (size == 0) {
+                    fprintf(stderr, "%s: truncated face data\n", path);
+                    ok = false;
+                    break;
+                }
+                double n = ply_read(p + face_list_offset, list->count_type, swap);
+                if (n >= 3) triangle_count += (size_t)n - 2;
+                p += size;
+            }
+        } else {
+            for (uint64_t i = 0; i < element->count && ok; i++) {
+                size_t size = ply_record_size(element, p, end, swap);
+                if (size == 0) {
+                    fprintf(stderr, "%s: truncated %s data\n", path, element->name);
+                    ok = false;
+                }
+                p += size;
+            }
+        }
+    }
+    if (ok && (!vertex || !face)) {
+        fprintf(stderr, "%s: needs vertex and face elements\n", path);
+        ok = false;
+    }
+
+    int px = -1, py = -1, pz = -1, nx = -1, ny = -1, nz = -1, tu = -1, tv = -1;
+    if (ok) {
+        px = ply_find_property(vertex, "x");
+        py = ply_find_property(vertex, "y");
+        pz = ply_find_property(vertex, "z");
+        nx = ply_find_property(vertex, "nx");
+        ny = ply_find_property(vertex, "ny");
+        nz = ply_find_property(vertex, "nz");
+        const char* uv_names[][2] = {{"u", "v"}, {"s", "t"}, {"texture_u", "texture_v"}};
+        for (int i = 0; i < 3 && (tu < 0 || tv < 0); i++) {
+            tu = ply_find_property(vertex, uv_names[i][0]);
+            tv = ply_find_property(vertex, uv_names[i][1]);
+        }
+        if (px < 0 || py < 0 || pz < 0) {
+            fprintf(stderr, "%s: vertices have no x, y, z\n", path);
+            ok = false;
+        } else if (triangle_count == 0) {
+            fprintf(stderr, "%s: no faces\n", path);
+            ok = false;
+        } else if (vertex->count > UINT32_MAX || triangle_count > UINT32_MAX / 3) {
+            fprintf(stderr, "%s: too many vertices or faces for 32-bit indices\n", path);
+            ok = false;
+        }
+    }
+
+    Mesh* mesh = NULL;
+    if (ok) {
+        bool with_normals = nx >= 0 && ny >= 0 && nz >= 0;
+        bool with_uvs = tu >= 0 && tv >= 0;
+        mesh = mesh_create((uint32_t)vertex->count, (uint32_t)triangle_count, with_normals, with_uvs);
+    }
+
+    if (mesh) {
+        const PlyProperty* props = vertex->properties;
+        const uint32_t stride = vertex->stride;
+        const int64_t count = (int64_t)vertex->count;
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; i++) {
+            const uint8_t* v = vertex_data + (size_t)i * stride;
+            mesh->positions[i] = vec3_create((float)ply_read(v + props[px].offset, props[px].type, swap),
+                                             (float)ply_read(v + props[py].offset, props[py].type, swap),
+                                             (float)ply_read(v + props[pz].offset, props[pz].type, swap));
+            if (mesh->normals) {
+                mesh->normals[i] = vec3_create((float)ply_read(v + props[nx].offset, props[nx].type, swap),
+                                               (float)ply_read(v + props[ny].offset, props[ny].type, swap),
+                                               (float)ply_read(v + props[nz].offset, props[nz].type, swap));
+            }
+            if (mesh->uvs) {
+                mesh->uvs[2 * i] = (float)ply_read(v + props[tu].offset, props[tu].type, swap);
+                mesh->uvs[2 * i + 1] = (float)ply_read(v + props[tv].offset, props[tv].type, swap);
+            }
+        }
+
+        const PlyProperty* list = &face->properties[face_list];
+        const uint32_t index_size = PLY_TYPE_SIZE[list->type];
+        const uint32_t count_size = PLY_TYPE_SIZE[list->count_type];
+        const uint8_t* faces = (const uint8_t*)file.data;
+        bool indices_ok = true;
+
+        #pragma omp parallel for schedule(dynamic, 1) reduction(&&:indices_ok)
+        for (size_t b = 0; b < block_count; b++) {
+            const uint8_t* f = faces + block_offsets[b];
+            uint32_t* tri = mesh->indices + 3 * block_triangles[b];
+            uint64_t last = (b + 1) * (uint64_t)PLY_FACE_BLOCK;
+            if (last > face->count) last = face->count;
+            for (uint64_t i = b * (uint64_t)PLY_FACE_BLOCK; i < last; i++) {
+                const uint8_t* items = f + face_list_offset + count_size;
+                uint32_t n = (uint32_t)ply_read(f + face_list_offset, list->count_type, swap);
+                for (uint32_t k = 0; k < n; k++) {
+                    double index = ply_read(items + (size_t)k * index_size, list->type, swap);
+                    if (index < 0 || index >= (double)vertex->count) {
+                        indices_ok = false;
+                        continue;
+                    }
+                    if (k >= 2) {
+                        tri[0] = (uint32_t)ply_read(items, list->type, swap);
+                        tri[1] = (uint32_t)ply_read(items + (size_t)(k - 1) * index_size, list->type, swap);
+                        tri[2] = (uint32_t)index;
+                        tri += 3;
+                    }
+                }
+                f += ply_record_size(face, f, end, swap);
+            }
+        }
+        if (!indices_ok) {
+            fprintf(stderr, "%s: face vertex index out of range\n", path);
+            mesh_destroy(mesh);
+            mesh = NULL;
+        }
+    }
+
+    free(block_offsets);
+    free(block_triangles);
+    unmap_file(&file);
+    return mesh;
+}
+
+Mesh* mesh_load(const char* path) {
+    const char* ext = strrchr(path, '.');
+    if (ext && strcasecmp(ext, ".obj") == 0) {
+        return mesh_load_obj(path);
+    }
+    if (ext && strcasecmp(ext, ".ply") == 0) {
+        return mesh_load_ply(path);
+    }
+    fprintf(stderr, "Unknown mesh format: %s (expected .obj or .ply)\n", path);
+    return NULL;
+}
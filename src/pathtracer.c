@@ -1,20 +1,12 @@
+#define _POSIX_C_SOURCE 200809L
 #include "pathtracer.h"
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <omp.h>
 #include <float.h>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb.h"
-
-// Progress callback
-static progress_callback_t g_progress_callback = NULL;
-
-void set_progress_callback(progress_callback_t callback) {
-    g_progress_callback = callback;
-}
-
 // Scene creation and management
 Scene* scene_create(void) {
     Scene* scene = (Scene*)calloc(1, sizeof(Scene));
@@ -26,24 +18,63 @@ Scene* scene_create(void) {
     return scene;
 }
 
+static bool scene_is_mapped(const Scene* scene, const void* p) {
+    const char* base = (const char*)scene->mapping;
+    return base && (const char*)p >= base && (const char*)p < base + scene->mapping_size;
+}
+
 void scene_destroy(Scene* scene) {
     if (scene) {
         if (scene->bvh) {
             bvh_destroy(scene->bvh);
         }
-        free(scene->primitives);
+        for (uint32_t i = 0; i < scene->mesh_count; i++) {
+            mesh_destroy(scene->meshes[i]);
+        }
+        free(scene->meshes);
+        for (uint32_t i = 0; i < scene->group_count; i++) {
+            scene_destroy(scene->groups[i]);
+        }
+        free(scene->groups);
+        free(scene->instances);
+        if (!scene_is_mapped(scene, scene->primitives)) {
+            free(scene->primitives);
+        }
+        if (scene->mapping) {
+            munmap(scene->mapping, scene->mapping_size);
+        }
         free(scene);
     }
 }
 
+static bool scene_set_capacity(Scene* scene, uint32_t capacity) {
+    Primitive* primitives;
+    if (scene_is_mapped(scene, scene->primitives)) {
+        // Cached scenes hold their primitives in the file mapping
+        primitives = (Primitive*)malloc(capacity * sizeof(Primitive));
+        if (primitives) memcpy(primitives, scene->primitives, scene->prim_count * sizeof(Primitive));
+    } else {
+        primitives = (Primitive*)realloc(scene->primitives, capacity * sizeof(Primitive));
+    }
+    if (!primitives) {
+        fprintf(stderr, "Failed to allocate %u primitives\n", capacity);
+        return false;
+    }
+    scene->primitives = primitives;
+    scene->prim_capacity = capacity;
+    return true;
+}
+
 static void scene_grow_if_needed(Scene* scene) {
     if (scene->prim_count >= scene->prim_capacity) {
-        scene->prim_capacity *= 2;
-        scene->primitives = (Primitive*)realloc(scene->primitives,
-                                                scene->prim_capacity * sizeof(Primitive));
+        scene_set_capacity(scene, scene->prim_capacity ? 2 * scene->prim_capacity : 128);
     }
 }
 
+bool scene_reserve(Scene* scene, uint32_t prim_count) {
+    return prim_count <= scene->prim_capacity || scene_set_capacity(scene, prim_count);
+}
+
 void scene_add_sphere(Scene* scene, Vec3 center, float radius, Material mat) {
     scene_grow_if_needed(scene);
     scene->primitives[scene->prim_count++] = primitive_sphere(center, radius, mat);
@@ -54,85 +85,137 @@ void scene_add_triangle(Scene* scene, Vec3 v0, Vec3 v1, Vec3 v2, Material mat) {
     scene->primitives[scene->prim_count++] = primitive_triangle(v0, v1, v2, mat);
 }
 
-void scene_build_bvh(Scene* scene) {
-    if (scene->bvh) {
-        bvh_destroy(scene->bvh);
+void scene_add_mesh(Scene* scene, Mesh* mesh, Material mat) {
+    if (!mesh->bvh) {
+        mesh_update_bounds(mesh);
     }
-    scene->bvh = bvh_create(scene->primitives, scene->prim_count);
+    scene->meshes = (Mesh**)realloc(scene->meshes, (scene->mesh_count + 1) * sizeof(Mesh*));
+    scene->meshes[scene->mesh_count++] = mesh;
+    scene_grow_if_needed(scene);
+    scene->primitives[scene->prim_count++] = primitive_mesh(mesh, mat);
 }
 
-// Image management
-Image* image_create(uint32_t width, uint32_t height) {
-    Image* img = (Image*)malloc(sizeof(Image));
-    img->width = width;
-    img->height = height;
-    img->pixels = (Vec3*)calloc(width * height, sizeof(Vec3));
-    return img;
+const Scene* scene_add_group(Scene* scene, Scene* group) {
+    scene_build_bvh(group);
+    scene->groups = (Scene**)realloc(scene->groups, (scene->group_count + 1) * sizeof(Scene*));
+    scene->groups[scene->group_count++] = group;
+    return group;
 }
 
-void image_destroy(Image* img) {
-    if (img) {
-        free(img->pixels);
-        free(img);
+// Instance primitives point into the instance array, so it moves by copy
+// and the pointers are rebased while the old array is still valid
+static bool scene_grow_instances(Scene* scene) {
+    uint32_t capacity = scene->instance_capacity ? 2 * scene->instance_capacity : 64;
+    Instance* instances = (Instance*)malloc(capacity * sizeof(Instance));
+    if (!instances) {
+        fprintf(stderr, "Failed to allocate %u instances\n", capacity);
+        return false;
     }
+    if (scene->instance_count > 0) {
+        memcpy(instances, scene->instances, scene->instance_count * sizeof(Instance));
+    }
+    for (uint32_t i = 0; i < scene->prim_count; i++) {
+        Primitive* prim = &scene->primitives[i];
+        if (prim->type == PRIMITIVE_INSTANCE) {
+            prim->instance = instances + (prim->instance - scene->instances);
+        }
+    }
+    free(scene->instances);
+    scene->instances = instances;
+    scene->instance_capacity = capacity;
+    return true;
 }
 
-void image_save_bmp(const Image* img, const char* filename) {
-    // Allocate RGB buffer (3 bytes per pixel)
-    unsigned char* rgb_data = (unsigned char*)malloc(img->width * img->height * 3);
-    if (!rgb_data) {
-        fprintf(stderr, "Failed to allocate memory for BMP conversion\n");
-        return;
+bool scene_add_instance(Scene* scene, const Scene* group, const Transform* to_world,
+                        const Material* material) {
+    Transform to_object;
+    if (!transform_inverse(to_world, &to_object)) {
+        fprintf(stderr, "Ignoring instance with a singular transform\n");
+        return false;
     }
+    if (scene->instance_count == scene->instance_capacity && !scene_grow_instances(scene)) {
+        return false;
+    }
+    scene_grow_if_needed(scene);
+    if (scene->prim_count >= scene->prim_capacity) return false;
+
+    Instance* instance = &scene->instances[scene->instance_count++];
+    instance->group = group;
+    instance->to_object = to_object;
+    instance->override_material = material != NULL;
+
+    Primitive* prim = &scene->primitives[scene->prim_count++];
+    memset(prim, 0, sizeof(Primitive));
+    prim->type = PRIMITIVE_INSTANCE;
+    prim->instance = instance;
+    if (material) prim->material = *material;
+    // A group with moving parts is bounded by the box they sweep
+    const BVH* bvh = group->bvh;
+    AABB bounds = bvh && bvh->node_count ? bvh->nodes[0].bounds : aabb_empty();
+    if (bvh && bvh->node_count && bvh->end_bounds) bounds = aabb_union(bounds, bvh->end_bounds[0]);
+    prim->bounds = transform_bounds(to_world, bounds);
+    if (group->has_motion) scene->has_motion = true;
+    return true;
+}
 
-    // Convert Vec3 HDR pixels to RGB bytes
-    for (uint32_t j = 0; j < img->height; j++) {
-        for (uint32_t i = 0; i < img->width; i++) {
-            Vec3 color = img->pixels[j * img->width + i];
-
-            // ACES tone mapping and clamp
-            color = aces_tonemap(color);
-            color.x = fminf(fmaxf(color.x, 0.0f), 1.0f);
-            color.y = fminf(fmaxf(color.y, 0.0f), 1.0f);
-            color.z = fminf(fmaxf(color.z, 0.0f), 1.0f);
-
-            // Convert to bytes
-            int idx = (j * img->width + i) * 3;
-            rgb_data[idx + 0] = (unsigned char)(color.x * 255.0f);
-            rgb_data[idx + 1] = (unsigned char)(color.y * 255.0f);
-            rgb_data[idx + 2] = (unsigned char)(color.z * 255.0f);
+void scene_build_bvh(Scene* scene) {
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        if (!scene->meshes[i]->bvh) {
+            mesh_build_bvh(scene->meshes[i], scene->spatial_split_budget);
         }
     }
+    if (scene->bvh) {
+        bvh_destroy(scene->bvh);
+    }
+    scene->bvh = scene->spatial_split_budget > 1.0f
+                     ? bvh_create_spatial(scene->primitives, scene->prim_count, scene->spatial_split_budget)
+                     : bvh_create(scene->primitives, scene->prim_count);
+}
 
-    // Write BMP file
-    int result = stbi_write_bmp(filename, img->width, img->height, 3, rgb_data);
+void scene_set_motion(Scene* scene, uint32_t prim, Vec3 motion) {
+    primitive_set_motion(&scene->primitives[prim], motion);
+    if (scene->primitives[prim].moving) scene->has_motion = true;
+}
 
-    if (!result) {
-        fprintf(stderr, "Failed to write BMP file: %s\n", filename);
+bool scene_refit_bvh(Scene* scene, float threshold) {
+    BVH* bvh = scene->bvh;
+    if (!bvh) {
+        scene_build_bvh(scene);
+        return true;
     }
+    // Cached trees carry no build cost; take it before their first refit
+    if (bvh->build_cost == 0.0f) bvh->build_cost = bvh_sah_cost(bvh);
 
-    free(rgb_data);
+    bvh_refit(bvh);
+    if (bvh_sah_cost(bvh) <= threshold * bvh->build_cost) return false;
+    scene_build_bvh(scene);
+    return true;
 }
 
-// Utility functions
-Vec3 aces_tonemap(Vec3 color) {
-    // ACES Filmic Tone Mapping curve
-    const float a = 2.51f;
-    const float b = 0.03f;
-    const float c = 2.43f;
-    const float d = 0.59f;
-    const float e = 0.14f;
-
-    color.x = (color.x * (a * color.x + b)) / (color.x * (c * color.x + d) + e);
-    color.y = (color.y * (a * color.y + b)) / (color.y * (c * color.y + d) + e);
-    color.z = (color.z * (a * color.z + b)) / (color.z * (c * color.z + d) + e);
+TileDirtyMap* tile_dirty_map_create(uint32_t width, uint32_t height) {
+    TileDirtyMap* map = (TileDirtyMap*)malloc(sizeof(TileDirtyMap));
+    if (!map) return NULL;
+    map->tiles_x = (width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    map->tiles_y = (height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    map->flags = (atomic_uchar*)calloc((size_t)map->tiles_x * map->tiles_y, sizeof(atomic_uchar));
+    if (!map->flags) {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
 
-    return color;
+void tile_dirty_map_destroy(TileDirtyMap* map) {
+    if (map) {
+        free(map->flags);
+        free(map);
+    }
 }
 
 // Hit test for scene
 static bool scene_hit(const Scene* scene, const Ray* ray, float t_min, float t_max,
                      HitRecord* rec) {
+    render_thread_counters.rays++;
     if (scene->bvh) {
         return bvh_hit(scene->bvh, ray, t_min, t_max, rec);
     } else {
@@ -152,7 +235,7 @@ static bool scene_hit(const Scene* scene, const Ray* ray, float t_min, float t_m
 }
 
 // Main path tracing function
-Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
+Vec3 trace_ray(const Scene* scene, const Ray* ray, Sampler* sampler,
                uint32_t depth, uint32_t max_depth) {
     // TODO: Implement Russian roulette untuk early termination
     // Hint: Gunakan probabilitas untuk menghentikan ray setelah depth tertentu
@@ -165,23 +248,29 @@ Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
     float p_continue = 1.0f;
 
     if (depth >= max_depth) {
+        STATS_COUNT(depth_terminations);
         return vec3_create(0, 0, 0);
     }
 
+    sampler_start_bounce(sampler, depth);
+
     // Terapkan Russian Roulette setelah beberapa kali memantul
     if (depth >= RR_START_DEPTH) {
         p_continue = 0.95f; 
-        if (rng_float(rng) > p_continue) {
+        if (sampler_bounce_1d(sampler, SAMPLER_BOUNCE_RR) > p_continue) {
+            STATS_COUNT(rr_terminations);
             return vec3_create(0, 0, 0);
         }
     }
 
     HitRecord rec;
+    STATS_COUNT(rays_by_depth[depth < STATS_DEPTH_BUCKETS ? depth : STATS_DEPTH_BUCKETS - 1]);
 
     // Test intersection dengan scene
     if (!scene_hit(scene, ray, 0.001f, FLT_MAX, &rec)) {
         // TODO: Return warna background/sky
         // Hint: Gunakan scene->ambient_light
+        STATS_COUNT(misses);
         return scene->ambient_light;
     }
 
@@ -198,6 +287,7 @@ Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
 
     // Handle material emissive (light source)
     if (rec.material->type == MATERIAL_EMISSIVE) {
+        STATS_COUNT(emitter_hits);
         return rec.material->emission;
     }
 
@@ -211,9 +301,11 @@ Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
     // - Kalikan hasil recursive dengan attenuation menggunakan vec3_mul()
 
     // Scatter ray berdasarkan material
-    if (material_scatter(rec.material, ray, &rec, &attenuation, &scattered, rng)) {
+    if (material_scatter(rec.material, ray, &rec, &attenuation, &scattered, sampler)) {
+        scattered.time = ray->time;  // The whole path sees one instant
+
         // Recursive trace
-        Vec3 incoming = trace_ray(scene, &scattered, rng, depth + 1, max_depth);
+        Vec3 incoming = trace_ray(scene, &scattered, sampler, depth + 1, max_depth);
         
         // Kalikan hasil recursive dengan attenuation
         Vec3 scattered_light = vec3_mul(attenuation, incoming);
@@ -228,73 +320,171 @@ Vec3 trace_ray(const Scene* scene, const Ray* ray, RNG* rng,
     }
 
     // Jika tidak ada scatter (absorbed), return emission
+    STATS_COUNT(absorbed);
     return rec.material->emission;
 }
 
-// Multi-threaded rendering with OpenMP
-void render_parallel(const Scene* scene, const Camera* camera,
-                    const RenderSettings* settings, Image* output) {
-    uint32_t total_pixels = output->width * output->height;
+// Render one tile; returns the number of pixels completed
+static uint32_t render_tile(const Scene* scene, const CameraRaster* raster,
+                            const RenderSettings* settings, Image* output,
+                            Sampler* sampler, uint32_t x0, uint32_t y0,
+                            uint32_t x1, uint32_t y1) {
+    uint32_t done = 0;
+    Accumulator* accum = settings->accum;
 
-    // Set number of threads
-    omp_set_num_threads(settings->num_threads);
+    for (uint32_t j = y0; j < y1; j++) {
+        Vec3 row = camera_raster_row(raster, j);
 
-    // Shared counter for progress tracking
-    uint32_t pixels_done = 0;
+        for (uint32_t i = x0; i < x1; i++) {
+            Vec3 pixel = camera_raster_pixel(raster, row, i);
+            Vec3 color = vec3_create(0, 0, 0);
 
-    #pragma omp parallel
-    {
-        RNG rng;
-        rng_init(&rng, 42 + omp_get_thread_num() * 1000);
-
-        #pragma omp for schedule(dynamic, 16) nowait
-        for (uint32_t pixel_idx = 0; pixel_idx < total_pixels; pixel_idx++) {
-            // Check cancel flag early - skip processing if cancelled
-            if (settings->cancel_flag && *settings->cancel_flag) {
-                continue;  // Skip this pixel
+            // Sample range: all of them, or continue an accumulated pixel
+            size_t idx = (size_t)j * output->width + i;
+            uint32_t sample_begin = 0;
+            uint32_t sample_end = settings->samples_per_pixel;
+            if (accum) {
+                sample_begin = accum->count[idx];
+                if (settings->sample_end && settings->sample_end < sample_end) {
+                    sample_end = settings->sample_end;
+                }
+                color = vec3_create(accum->sum[0][idx], accum->sum[1][idx], accum->sum[2][idx]);
             }
 
-            uint32_t i = pixel_idx % output->width;
-            uint32_t j = pixel_idx / output->width;
-
-            Vec3 color = vec3_create(0, 0, 0);
+            // Cost AOV: counters before the pixel's samples
+            uint64_t cycles_start = 0, nodes_start = 0, rays_start = 0;
+            if (settings->cost_aov) {
+                nodes_start = render_thread_counters.bvh_nodes;
+                rays_start = render_thread_counters.rays;
+                cycles_start = cost_cycle_counter();
+            }
 
             // Multi-sampling
-            for (uint32_t s = 0; s < settings->samples_per_pixel; s++) {
-                // Check cancel during multi-sampling too
-                if (settings->cancel_flag && *settings->cancel_flag) {
-                    break;  // OK to break from inner loop
+            for (uint32_t s = sample_begin; s < sample_end; s++) {
+                // Bounded cancel latency: at most one path per thread after
+                // the flag is set. The partial pixel is dropped, not averaged.
+                if (render_cancelled(settings)) {
+                    return done;
                 }
 
-                float u = (i + rng_float(&rng)) / (float)(output->width - 1);
-                float v = (j + rng_float(&rng)) / (float)(output->height - 1);
+                // Seed per sample so the result is independent of scheduling
+                sampler_start(sampler, settings->sampler, settings->seed,
+                              i, j, output->width, s, settings->samples_per_pixel);
 
-                // Flip v for correct orientation
-                v = 1.0f - v;
+                float jitter_u, jitter_v;
+                sampler_2d(sampler, SAMPLER_DIM_PIXEL, &jitter_u, &jitter_v);
 
-                Ray ray = camera_get_ray(camera, u, v, &rng);
-                Vec3 sample_color = trace_ray(scene, &ray, &rng, 0, settings->max_depth);
+                Ray ray = camera_raster_ray(raster, pixel, jitter_u, jitter_v, sampler);
+                if (scene->has_motion) ray.time = sampler_1d(sampler, SAMPLER_DIM_TIME);
+                Vec3 sample_color = trace_ray(scene, &ray, sampler, 0, settings->max_depth);
                 color = vec3_add(color, sample_color);
+                render_thread_counters.samples++;
             }
 
-            // Average samples
-            color = vec3_div(color, (float)settings->samples_per_pixel);
-            output->pixels[pixel_idx] = color;
-
-            // Update progress every pixel (with atomic increment for thread safety)
-            if (g_progress_callback) {
-                uint32_t current_done;
-                #pragma omp atomic capture
-                current_done = ++pixels_done;
-
-                // Only call callback every 1000 pixels to reduce overhead
-                if (current_done % 1000 == 0) {
-                    #pragma omp critical
-                    {
-                        g_progress_callback((float)current_done / total_pixels);
-                    }
+            // Average samples (same float ops whether or not the sum was resumed)
+            uint32_t sample_count = settings->samples_per_pixel;
+            if (accum) {
+                if (sample_end > sample_begin) {
+                    accum->sum[0][idx] = color.x;
+                    accum->sum[1][idx] = color.y;
+                    accum->sum[2][idx] = color.z;
+                    accum->count[idx] = sample_end;
                 }
+                sample_count = accum->count[idx] - accum->first_sample;
+            }
+            if (sample_count > 0) {
+                color = vec3_div(color, (float)sample_count);
+            }
+            image_set_pixel(output, i, j, color);
+
+            if (settings->cost_aov) {
+                float inv_spp = (sample_end > sample_begin) ? 1.0f / (float)(sample_end - sample_begin) : 0.0f;
+                Vec3 cost = vec3_create((float)(cost_cycle_counter() - cycles_start),
+                                        (float)(render_thread_counters.bvh_nodes - nodes_start),
+                                        (float)(render_thread_counters.rays - rays_start));
+                image_set_pixel(settings->cost_aov, i, j, vec3_scale(cost, inv_spp));
+            }
+            done++;
+        }
+    }
+    return done;
+}
+
+// Multi-threaded rendering with OpenMP over square tiles handed out by an
+// atomic work counter (same order as schedule(dynamic, 1), but a cancelled
+// thread leaves the loop at once instead of stepping over every tile index)
+void render_parallel(const Scene* scene, const Camera* camera,
+                    const RenderSettings* settings, Image* output) {
+    uint32_t tiles_x = (output->width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    uint32_t tiles_y = (output->height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    uint32_t tile_count = tiles_x * tiles_y;
+    uint32_t tile_begin = settings->tile_begin;
+    if (settings->tile_end && settings->tile_end < tile_count) {
+        tile_count = settings->tile_end;
+    }
+
+    // Set number of threads
+    omp_set_num_threads(settings->num_threads);
+
+    sampler_prepare(settings->sampler);
+    CameraRaster raster = camera_raster_create(camera, output->width, output->height);
+
+    RenderStats* stats = settings->stats;
+    if (stats) {
+        uint64_t total_pixels = 0;
+        for (uint32_t tile = tile_begin; tile < tile_count; tile++) {
+            uint32_t x0 = (tile % tiles_x) * RENDER_TILE_SIZE;
+            uint32_t y0 = (tile / tiles_x) * RENDER_TILE_SIZE;
+            uint32_t w = x0 + RENDER_TILE_SIZE < output->width ? RENDER_TILE_SIZE : output->width - x0;
+            uint32_t h = y0 + RENDER_TILE_SIZE < output->height ? RENDER_TILE_SIZE : output->height - y0;
+            total_pixels += (uint64_t)w * h;
+        }
+        render_stats_begin(stats, total_pixels);
+    }
+
+    atomic_uint next_tile;
+    atomic_init(&next_tile, tile_begin);
+
+    #pragma omp parallel
+    {
+        Sampler sampler;
+        uint32_t thread = (uint32_t)omp_get_thread_num();
+        memset(&render_thread_counters, 0, sizeof(render_thread_counters));
+        render_stats_thread_begin();
+
+        while (!render_cancelled(settings)) {
+            uint32_t tile = atomic_fetch_add_explicit(&next_tile, 1, memory_order_relaxed);
+            if (tile >= tile_count) {
+                break;
+            }
+
+            uint32_t x0 = (tile % tiles_x) * RENDER_TILE_SIZE;
+            uint32_t y0 = (tile / tiles_x) * RENDER_TILE_SIZE;
+            uint32_t x1 = x0 + RENDER_TILE_SIZE < output->width ? x0 + RENDER_TILE_SIZE : output->width;
+            uint32_t y1 = y0 + RENDER_TILE_SIZE < output->height ? y0 + RENDER_TILE_SIZE : output->height;
+
+            uint32_t tile_done = render_tile(scene, &raster, settings, output, &sampler,
+                                             x0, y0, x1, y1);
+
+            if (settings->dirty_tiles && tile_done > 0) {
+                atomic_store_explicit(&settings->dirty_tiles->flags[tile], 1, memory_order_release);
+            }
+
+            // Publish this thread's counters once per tile; readers never block us
+            render_thread_counters.pixels += tile_done;
+            if (stats) {
+                render_stats_publish(stats, thread, &render_thread_counters);
             }
         }
+
+        // Detailed counters (STATS=1 builds) are merged once per thread
+        if (stats) {
+            #pragma omp critical(render_stats_merge)
+            render_stats_thread_merge(stats);
+        }
     }
-}
\ No newline at end of file
+
+    if (stats) {
+        render_stats_end(stats);
+    }
+}
@@ -1,6 +1,23 @@
 #include "primitive.h"
+#include "mesh.h"
+#include "instance.h"
+#include "stats.h"
 #include <math.h>
 
+static const char* const PRIMITIVE_TYPE_NAMES[PRIMITIVE_TYPE_COUNT] = {
+    "sphere",
+    "triangle",
+    "mesh",
+    "instance"
+};
+
+const char* primitive_type_name(PrimitiveType type) {
+    if (type < PRIMITIVE_TYPE_COUNT) {
+        return PRIMITIVE_TYPE_NAMES[type];
+    }
+    return "unknown";
+}
+
 // Ray-sphere intersection
 bool sphere_hit(const Sphere* sphere, const Ray* ray, float t_min, float t_max,
                 HitRecord* rec) {
@@ -48,6 +65,8 @@ bool sphere_hit(const Sphere* sphere, const Ray* ray, float t_min, float t_max,
     
     // Isi hit record
     rec->t = root;
+    rec->u = 0.0f;
+    rec->v = 0.0f;
     rec->point = ray_at(*ray, rec->t);
     Vec3 outward_normal = vec3_div(vec3_sub(rec->point, sphere->center), sphere->radius);
     
@@ -78,47 +97,15 @@ bool triangle_hit(const Triangle* triangle, const Ray* ray, float t_min, float t
     // 13. Cek jika t dalam range [t_min, t_max]
     // 14. Isi HitRecord dengan t, point, dan normal
 
-    const float EPSILON = 0.0000001f;
-
-    // Hitung edge vectors
-    Vec3 edge1 = vec3_sub(triangle->v1, triangle->v0);
-    Vec3 edge2 = vec3_sub(triangle->v2, triangle->v0);
-    
-    // Hitung h = d x e2
-    Vec3 h = vec3_cross(ray->direction, edge2);
-    float a = vec3_dot(edge1, h);
-    
-    // Cek parallel (ray sejajar dengan plane triangle)
-    if (fabsf(a) < EPSILON) {
-        return false;
-    }
-    
-    float f = 1.0f / a;
-    Vec3 s = vec3_sub(ray->origin, triangle->v0);
-    
-    // Hitung koordinat barycentric u
-    float u = f * vec3_dot(s, h);
-    if (u < 0.0f || u > 1.0f) {
-        return false;
-    }
-    
-    // Hitung q = s x e1
-    Vec3 q = vec3_cross(s, edge1);
-    
-    // Hitung koordinat barycentric v
-    float v = f * vec3_dot(ray->direction, q);
-    if (v < 0.0f || u + v > 1.0f) {
-        return false;
-    }
-    
-    // Hitung t parameter
-    float t = f * vec3_dot(edge2, q);
-    if (t < t_min || t > t_max) {
+    float t, u, v;
+    if (!triangle_intersect(triangle->v0, triangle->v1, triangle->v2, ray, t_min, t_max, &t, &u, &v)) {
         return false;
     }
-    
+
     // Isi hit record
     rec->t = t;
+    rec->u = u;
+    rec->v = v;
     rec->point = ray_at(*ray, rec->t);
     
     // Normal dari pre-computed triangle normal
@@ -129,11 +116,27 @@ bool triangle_hit(const Triangle* triangle, const Ray* ray, float t_min, float t
     return true;
 }
 
-// Generic primitive hit test
-bool primitive_hit(const Primitive* prim, const Ray* ray, float t_min, float t_max,
-                   HitRecord* rec) {
+// Hit test against the primitive's shutter-open position
+static inline bool primitive_hit_open(const Primitive* prim, const Ray* ray, float t_min,
+                                      float t_max, HitRecord* rec) {
     bool hit = false;
 
+    // Meshes count their own triangle tests
+    if (prim->type == PRIMITIVE_MESH) {
+        if (!mesh_hit(prim->mesh, ray, t_min, t_max, rec)) return false;
+        rec->material = &prim->material;
+        return true;
+    }
+    // Instances count one test; the group's primitives count their own
+    if (prim->type == PRIMITIVE_INSTANCE) {
+        STATS_COUNT(prim_tests[PRIMITIVE_INSTANCE]);
+        if (!instance_hit(prim->instance, ray, t_min, t_max, rec)) return false;
+        STATS_COUNT(prim_hits[PRIMITIVE_INSTANCE]);
+        if (prim->instance->override_material) rec->material = &prim->material;
+        return true;
+    }
+
+    STATS_COUNT(prim_tests[prim->type]);
     switch (prim->type) {
         case PRIMITIVE_SPHERE:
             hit = sphere_hit(&prim->sphere, ray, t_min, t_max, rec);
@@ -146,8 +149,23 @@ bool primitive_hit(const Primitive* prim, const Ray* ray, float t_min, float t_m
     }
 
     if (hit) {
+        STATS_COUNT(prim_hits[prim->type]);
         rec->material = &prim->material;
     }
 
     return hit;
-}
\ No newline at end of file
+}
+
+// Generic primitive hit test
+bool primitive_hit(const Primitive* prim, const Ray* ray, float t_min, float t_max,
+                   HitRecord* rec) {
+    if (!prim->moving) return primitive_hit_open(prim, ray, t_min, t_max, rec);
+
+    // Moving: shift the ray back by the distance the primitive has travelled
+    // since shutter open, then carry the hit point along with it
+    Vec3 shift = vec3_scale(prim->motion, ray->time);
+    Ray local = {vec3_sub(ray->origin, shift), ray->direction, ray->time};
+    if (!primitive_hit_open(prim, &local, t_min, t_max, rec)) return false;
+    rec->point = vec3_add(rec->point, shift);
+    return true;
+}
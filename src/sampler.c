@@ -0,0 +1,351 @@
+#include "sampler.h"
+#include <math.h>
+#include <string.h>
+
+#define ONE_MINUS_EPSILON 0x1.fffffep-1f
+
+// Blue-noise mask (void-and-cluster), tiled over the image
+#define BLUE_NOISE_SIZE 64
+#define BLUE_NOISE_PIXELS (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE)
+
+static float g_blue_noise[BLUE_NOISE_PIXELS];
+static bool g_blue_noise_ready = false;
+
+static const char* const SAMPLER_NAMES[SAMPLER_TYPE_COUNT] = {
+    "random",
+    "stratified",
+    "sobol",
+    "bluenoise"
+};
+
+const char* sampler_type_name(SamplerType type) {
+    if (type < SAMPLER_TYPE_COUNT) {
+        return SAMPLER_NAMES[type];
+    }
+    return "unknown";
+}
+
+bool sampler_type_from_name(const char* name, SamplerType* type) {
+    for (int i = 0; i < SAMPLER_TYPE_COUNT; i++) {
+        if (strcmp(name, SAMPLER_NAMES[i]) == 0) {
+            *type = (SamplerType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Bit and hash helpers
+static inline uint32_t reverse_bits32(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    return __builtin_bswap32(x);
+}
+
+static inline uint32_t hash32(uint64_t x) {
+    return (uint32_t)rng_hash64(x);
+}
+
+static inline float u32_to_float(uint32_t x) {
+    return (x >> 8) * 0x1p-24f;
+}
+
+// Laine-Karras style permutation (Burley 2020, "Practical Hash-based Owen Scrambling")
+static inline uint32_t laine_karras_permutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scrambling of a 32-bit fixed-point value
+static inline uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) {
+    x = reverse_bits32(x);
+    x = laine_karras_permutation(x, seed);
+    return reverse_bits32(x);
+}
+
+// Second Sobol dimension in bit-reversed order (the first dimension is the
+// bit-reversed index itself), so scrambling can skip one reversal
+static inline uint32_t sobol_dim1_reversed(uint32_t index) {
+    uint32_t result = 0;
+    for (uint32_t v = 1; index; index >>= 1, v ^= v << 1) {
+        result ^= v & (0u - (index & 1));
+    }
+    return result;
+}
+
+// Shuffled, Owen-scrambled Sobol point for one dimension pair
+// (seed is already hashed, so cheap xor constants suffice to derive sub-seeds)
+static void sobol_2d(uint32_t index, uint32_t seed, uint32_t* x, uint32_t* y) {
+    uint32_t shuffled = nested_uniform_scramble(index, seed);
+    *x = reverse_bits32(laine_karras_permutation(shuffled, seed ^ 0xa511e9b3u));
+    *y = reverse_bits32(laine_karras_permutation(sobol_dim1_reversed(shuffled), seed ^ 0x63d83595u));
+}
+
+static uint32_t sobol_1d(uint32_t index, uint32_t seed) {
+    uint32_t shuffled = nested_uniform_scramble(index, seed);
+    return reverse_bits32(laine_karras_permutation(shuffled, seed ^ 0xa511e9b3u));
+}
+
+// Kensler's hash-based permutation of [0, length)
+static uint32_t permute_index(uint32_t i, uint32_t length, uint32_t p) {
+    uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do {
+        i ^= p;
+        i *= 0xe170893d;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8;
+        i *= 0x0929eb3f;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | p >> 27;
+        i *= 0x6935fa69;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3df;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + p) % length;
+}
+
+// Scramble seed for one dimension of this pixel
+static inline uint32_t pixel_dim_seed(const Sampler* sampler, uint32_t dim) {
+    return hash32(sampler->scramble_seed + dim);
+}
+
+// Scramble seed shared by all pixels (blue noise decorrelates pixels instead)
+static inline uint32_t global_dim_seed(const Sampler* sampler, uint32_t dim) {
+    return hash32(sampler->seed ^ rng_hash64(dim));
+}
+
+// Blue-noise value for this pixel, decorrelated per dimension by a tile offset
+static inline float blue_noise_shift(const Sampler* sampler, uint32_t dim) {
+    uint32_t h = hash32(0x9E3779B97F4A7C15ULL * (dim + 1));
+    uint32_t x = (sampler->pixel_x + h) & (BLUE_NOISE_SIZE - 1);
+    uint32_t y = (sampler->pixel_y + (h >> 8)) & (BLUE_NOISE_SIZE - 1);
+    return g_blue_noise[y * BLUE_NOISE_SIZE + x];
+}
+
+static inline float wrap01(float x) {
+    if (x >= 1.0f) x -= 1.0f;
+    return fminf(x, ONE_MINUS_EPSILON);
+}
+
+void sampler_start(Sampler* sampler, SamplerType type, uint64_t seed,
+                   uint32_t x, uint32_t y, uint32_t width,
+                   uint32_t sample, uint32_t spp) {
+    sampler->type = type;
+    sampler->pixel_x = x;
+    sampler->pixel_y = y;
+    sampler->pixel = y * width + x;
+    sampler->sample = sample;
+    sampler->spp = spp;
+    sampler->seed = seed;
+    sampler->bounce_base = SAMPLER_DIM_FIRST_BOUNCE;
+
+    if (type == SAMPLER_RANDOM) {
+        rng_batch_init_sample(&sampler->batch, seed, sampler->pixel, sample);
+    } else if (type == SAMPLER_STRATIFIED) {
+        rng_init_sample(&sampler->rng, seed, sampler->pixel, sample);
+    }
+    if (type != SAMPLER_RANDOM) {
+        sampler->scramble_seed = rng_hash64(seed ^ rng_hash64(((uint64_t)sampler->pixel << 32) | 0xC0FFEEu));
+    }
+}
+
+float sampler_ld_1d(Sampler* sampler, uint32_t dim) {
+    switch (sampler->type) {
+        case SAMPLER_STRATIFIED: {
+            uint32_t stratum = permute_index(sampler->sample, sampler->spp,
+                                             pixel_dim_seed(sampler, dim));
+            float u = (stratum + rng_float(&sampler->rng)) / (float)sampler->spp;
+            return fminf(u, ONE_MINUS_EPSILON);
+        }
+
+        case SAMPLER_SOBOL:
+            return u32_to_float(sobol_1d(sampler->sample, pixel_dim_seed(sampler, dim)));
+
+        case SAMPLER_BLUE_NOISE: {
+            float u = u32_to_float(sobol_1d(sampler->sample, global_dim_seed(sampler, dim)));
+            return wrap01(u + blue_noise_shift(sampler, dim));
+        }
+
+        default:
+            return rng_batch_float(&sampler->batch);
+    }
+}
+
+void sampler_ld_2d(Sampler* sampler, uint32_t dim, float* u, float* v) {
+    switch (sampler->type) {
+        case SAMPLER_STRATIFIED: {
+            // Jittered grid with at least spp cells; a per-pixel permutation
+            // assigns each sample its own cell
+            uint32_t nx = (uint32_t)ceilf(sqrtf((float)sampler->spp));
+            uint32_t ny = (sampler->spp + nx - 1) / nx;
+            uint32_t stratum = permute_index(sampler->sample, nx * ny,
+                                             pixel_dim_seed(sampler, dim));
+            *u = fminf(((stratum % nx) + rng_float(&sampler->rng)) / (float)nx, ONE_MINUS_EPSILON);
+            *v = fminf(((stratum / nx) + rng_float(&sampler->rng)) / (float)ny, ONE_MINUS_EPSILON);
+            return;
+        }
+
+        case SAMPLER_SOBOL: {
+            uint32_t x, y;
+            sobol_2d(sampler->sample, pixel_dim_seed(sampler, dim), &x, &y);
+            *u = u32_to_float(x);
+            *v = u32_to_float(y);
+            return;
+        }
+
+        case SAMPLER_BLUE_NOISE: {
+            uint32_t x, y;
+            sobol_2d(sampler->sample, global_dim_seed(sampler, dim), &x, &y);
+            *u = wrap01(u32_to_float(x) + blue_noise_shift(sampler, dim));
+            *v = wrap01(u32_to_float(y) + blue_noise_shift(sampler, dim + 1));
+            return;
+        }
+
+        default:
+            *u = rng_batch_float(&sampler->batch);
+            *v = rng_batch_float(&sampler->batch);
+            return;
+    }
+}
+
+// Void-and-cluster blue-noise generation (Ulichney 1993)
+static float g_vc_kernel[BLUE_NOISE_PIXELS];
+
+// Add (sign = 1) or remove (sign = -1) the Gaussian footprint of pixel idx
+static void vc_splat(float* energy, uint32_t idx, float sign) {
+    uint32_t ix = idx % BLUE_NOISE_SIZE;
+    uint32_t iy = idx / BLUE_NOISE_SIZE;
+    for (uint32_t y = 0; y < BLUE_NOISE_SIZE; y++) {
+        uint32_t dy = (y - iy) & (BLUE_NOISE_SIZE - 1);
+        for (uint32_t x = 0; x < BLUE_NOISE_SIZE; x++) {
+            uint32_t dx = (x - ix) & (BLUE_NOISE_SIZE - 1);
+            energy[y * BLUE_NOISE_SIZE + x] += sign * g_vc_kernel[dy * BLUE_NOISE_SIZE + dx];
+        }
+    }
+}
+
+// Tightest cluster (max energy) among pixels equal to `value`, or largest void (min energy)
+static uint32_t vc_find(const float* energy, const uint8_t* pattern, uint8_t value, bool find_max) {
+    uint32_t best = 0;
+    float best_energy = find_max ? -INFINITY : INFINITY;
+    for (uint32_t i = 0; i < BLUE_NOISE_PIXELS; i++) {
+        if (pattern[i] != value) continue;
+        if (find_max ? energy[i] > best_energy : energy[i] < best_energy) {
+            best_energy = energy[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void generate_blue_noise(void) {
+    const float sigma = 1.5f;
+    static uint8_t pattern[BLUE_NOISE_PIXELS];
+    static uint8_t prototype[BLUE_NOISE_PIXELS];
+    static float energy[BLUE_NOISE_PIXELS];
+    static float prototype_energy[BLUE_NOISE_PIXELS];
+    static uint32_t ranks[BLUE_NOISE_PIXELS];
+
+    // Toroidal Gaussian kernel
+    for (int y = 0; y < BLUE_NOISE_SIZE; y++) {
+        for (int x = 0; x < BLUE_NOISE_SIZE; x++) {
+            int dx = x < BLUE_NOISE_SIZE / 2 ? x : BLUE_NOISE_SIZE - x;
+            int dy = y < BLUE_NOISE_SIZE / 2 ? y : BLUE_NOISE_SIZE - y;
+            g_vc_kernel[y * BLUE_NOISE_SIZE + x] = expf(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+        }
+    }
+
+    // Random initial pattern with ~10% minority pixels
+    RNG rng;
+    rng_init(&rng, 0xB1);
+    memset(pattern, 0, sizeof(pattern));
+    memset(energy, 0, sizeof(energy));
+    uint32_t ones = 0;
+    while (ones < BLUE_NOISE_PIXELS / 10) {
+        uint32_t idx = rng_uint32(&rng) % BLUE_NOISE_PIXELS;
+        if (!pattern[idx]) {
+            pattern[idx] = 1;
+            vc_splat(energy, idx, 1.0f);
+            ones++;
+        }
+    }
+
+    // Relax: move tightest cluster into largest void until stable
+    for (uint32_t iter = 0; iter < BLUE_NOISE_PIXELS; iter++) {
+        uint32_t cluster = vc_find(energy, pattern, 1, true);
+        pattern[cluster] = 0;
+        vc_splat(energy, cluster, -1.0f);
+        uint32_t void_idx = vc_find(energy, pattern, 0, false);
+        pattern[void_idx] = 1;
+        vc_splat(energy, void_idx, 1.0f);
+        if (void_idx == cluster) break;
+    }
+
+    memcpy(prototype, pattern, sizeof(pattern));
+    memcpy(prototype_energy, energy, sizeof(energy));
+
+    // Phase 1: rank the prototype's ones by removing tightest clusters
+    for (int32_t rank = (int32_t)ones - 1; rank >= 0; rank--) {
+        uint32_t cluster = vc_find(energy, pattern, 1, true);
+        pattern[cluster] = 0;
+        vc_splat(energy, cluster, -1.0f);
+        ranks[cluster] = (uint32_t)rank;
+    }
+
+    // Phase 2: fill largest voids up to half occupancy
+    memcpy(pattern, prototype, sizeof(pattern));
+    memcpy(energy, prototype_energy, sizeof(energy));
+    uint32_t rank = ones;
+    for (; rank < BLUE_NOISE_PIXELS / 2; rank++) {
+        uint32_t void_idx = vc_find(energy, pattern, 0, false);
+        pattern[void_idx] = 1;
+        vc_splat(energy, void_idx, 1.0f);
+        ranks[void_idx] = rank;
+    }
+
+    // Phase 3: zeros are now the minority; fill their tightest clusters
+    memset(energy, 0, sizeof(energy));
+    for (uint32_t i = 0; i < BLUE_NOISE_PIXELS; i++) {
+        if (!pattern[i]) vc_splat(energy, i, 1.0f);
+    }
+    for (; rank < BLUE_NOISE_PIXELS; rank++) {
+        uint32_t cluster = vc_find(energy, pattern, 0, true);
+        pattern[cluster] = 1;
+        vc_splat(energy, cluster, -1.0f);
+        ranks[cluster] = rank;
+    }
+
+    for (uint32_t i = 0; i < BLUE_NOISE_PIXELS; i++) {
+        g_blue_noise[i] = (ranks[i] + 0.5f) / BLUE_NOISE_PIXELS;
+    }
+}
+
+void sampler_prepare(SamplerType type) {
+    if (type != SAMPLER_BLUE_NOISE) return;
+
+    #pragma omp critical(sampler_prepare)
+    {
+        if (!g_blue_noise_ready) {
+            generate_blue_noise();
+            g_blue_noise_ready = true;
+        }
+    }
+}
@@ -0,0 +1,586 @@
+#define _POSIX_C_SOURCE 200809L
+#include "scene_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define SCENE_CACHE_MAGIC "PTSC"
+#define SCENE_CACHE_VERSION 2u  // 2: BVHNode.split_axis
+#define SCENE_CACHE_ALIGN 64u
+
+#define SCENE_CACHE_MESH_NORMALS 1u
+#define SCENE_CACHE_MESH_UVS 2u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t file_size;
+    uint32_t primitive_size;    // Struct layouts the file was written with
+    uint32_t node_size;
+    uint32_t vec3_size;
+    uint32_t prim_count;
+    uint32_t node_count;
+    uint32_t mesh_count;
+    uint32_t mesh_ref_count;    // PRIMITIVE_MESH primitives
+    float ambient[3];
+    uint64_t primitives_offset;
+    uint64_t nodes_offset;
+    uint64_t meshes_offset;     // SceneCacheMesh[mesh_count]
+    uint64_t mesh_refs_offset;  // (primitive, mesh) index pairs
+} SceneCacheHeader;
+
+typedef struct {
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+    uint32_t node_count;
+    uint32_t flags;             // SCENE_CACHE_MESH_*
+    AABB bounds;
+    uint64_t positions_offset;
+    uint64_t normals_offset;
+    uint64_t uvs_offset;
+    uint64_t indices_offset;
+    uint64_t nodes_offset;
+} SceneCacheMesh;
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+#define HASH_PRIME1 0x9E3779B97F4A7C15ull
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4Full
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t word) {
+    return rotl64(acc + word * HASH_PRIME2, 31) * HASH_PRIME1;
+}
+
+// Four independent lanes over 32-byte blocks keep the multiplier busy
+uint64_t hash_bytes(uint64_t seed, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    const size_t total = size;
+    uint64_t lanes[4] = {seed + HASH_PRIME1 + HASH_PRIME2, seed + HASH_PRIME2, seed, seed - HASH_PRIME1};
+
+    while (size >= 32) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t word;
+            memcpy(&word, p + 8 * i, 8);
+            lanes[i] = hash_round(lanes[i], word);
+        }
+        p += 32;
+        size -= 32;
+    }
+    uint64_t h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = hash_round(h, word);
+        p += 8;
+        size -= 8;
+    }
+    if (size > 0) {
+        uint64_t tail = 0;
+        memcpy(&tail, p, size);
+        h = hash_round(h, tail);
+    }
+
+    h ^= total;
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME1;
+    h ^= h >> 32;
+    return h;
+}
+
+bool hash_file(const char* path, uint64_t* hash) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    if (data) posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+    *hash = hash_bytes(SCENE_CACHE_VERSION, data, size);
+    if (data) munmap(data, size);
+    return true;
+}
+
+static inline uint32_t push_float(uint32_t* words, uint32_t n, float value) {
+    memcpy(&words[n], &value, sizeof(float));
+    return n + 1;
+}
+
+static inline uint32_t push_vec3(uint32_t* words, uint32_t n, Vec3 v) {
+    n = push_float(words, n, v.x);
+    n = push_float(words, n, v.y);
+    return push_float(words, n, v.z);
+}
+
+static uint32_t push_material(uint32_t* words, uint32_t n, const Material* m) {
+    words[n++] = (uint32_t)m->type;
+    n = push_vec3(words, n, m->albedo);
+    n = push_float(words, n, m->roughness);
+    n = push_float(words, n, m->ior);
+    n = push_vec3(words, n, m->emission);
+    words[n++] = (uint32_t)m->blend_type1;
+    words[n++] = (uint32_t)m->blend_type2;
+    n = push_vec3(words, n, m->albedo2);
+    n = push_float(words, n, m->roughness2);
+    n = push_float(words, n, m->ior2);
+    words[n++] = (uint32_t)m->blend_mode;
+    n = push_float(words, n, m->blend_min);
+    return push_float(words, n, m->blend_max);
+}
+
+static uint32_t scene_mesh_index(const Scene* scene, const Mesh* mesh) {
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        if (scene->meshes[i] == mesh) return i;
+    }
+    return UINT32_MAX;
+}
+
+static uint32_t scene_group_index(const Scene* scene, const Scene* group) {
+    for (uint32_t i = 0; i < scene->group_count; i++) {
+        if (scene->groups[i] == group) return i;
+    }
+    return UINT32_MAX;
+}
+
+// Primitives are hashed field by field: struct padding and the unused part
+// of the geometry union are indeterminate
+uint64_t scene_content_hash(const Scene* scene) {
+    uint64_t h = hash_bytes(SCENE_CACHE_VERSION, SCENE_CACHE_MAGIC, 4);
+    uint32_t words[40];
+
+    for (uint32_t i = 0; i < scene->prim_count; i++) {
+        const Primitive* prim = &scene->primitives[i];
+        uint32_t n = 0;
+        words[n++] = (uint32_t)prim->type;
+        n = push_material(words, n, &prim->material);
+        switch (prim->type) {
+            case PRIMITIVE_SPHERE:
+                n = push_vec3(words, n, prim->sphere.center);
+                n = push_float(words, n, prim->sphere.radius);
+                break;
+            case PRIMITIVE_TRIANGLE:
+                n = push_vec3(words, n, prim->triangle.v0);
+                n = push_vec3(words, n, prim->triangle.v1);
+                n = push_vec3(words, n, prim->triangle.v2);
+                break;
+            case PRIMITIVE_MESH:
+                words[n++] = scene_mesh_index(scene, prim->mesh);
+                break;
+            case PRIMITIVE_INSTANCE:
+                words[n++] = scene_group_index(scene, prim->instance->group);
+                words[n++] = prim->instance->override_material;
+                for (int row = 0; row < 3; row++) {
+                    for (int col = 0; col < 4; col++) {
+                        n = push_float(words, n, prim->instance->to_object.m[row][col]);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        if (prim->moving) n = push_vec3(words, n, prim->motion);
+        h = hash_bytes(h, words, n * sizeof(uint32_t));
+    }
+
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        const Mesh* mesh = scene->meshes[i];
+        uint32_t header[3] = {mesh->vertex_count, mesh->triangle_count,
+                              (mesh->normals ? SCENE_CACHE_MESH_NORMALS : 0) |
+                              (mesh->uvs ? SCENE_CACHE_MESH_UVS : 0)};
+        h = hash_bytes(h, header, sizeof(header));
+        h = hash_bytes(h, mesh->positions, (size_t)mesh->vertex_count * sizeof(Vec3));
+        if (mesh->normals) h = hash_bytes(h, mesh->normals, (size_t)mesh->vertex_count * sizeof(Vec3));
+        if (mesh->uvs) h = hash_bytes(h, mesh->uvs, (size_t)mesh->vertex_count * 2 * sizeof(float));
+        h = hash_bytes(h, mesh->indices, (size_t)mesh->triangle_count * 3 * sizeof(uint32_t));
+    }
+
+    for (uint32_t i = 0; i < scene->group_count; i++) {
+        uint64_t group_hash = scene_content_hash(scene->groups[i]);
+        h = hash_bytes(h, &group_hash, sizeof(group_hash));
+    }
+
+    uint32_t n = push_vec3(words, 0, scene->ambient_light);
+    return hash_bytes(h, words, n * sizeof(uint32_t));
+}
+
+static void scene_cache_path(const char* dir, uint64_t key, char* path, size_t size) {
+    snprintf(path, size, "%s/%016llx%s", dir, (unsigned long long)key, SCENE_CACHE_EXTENSION);
+}
+
+// ============================================================================
+// Save
+// ============================================================================
+
+static inline uint64_t align_offset(uint64_t offset) {
+    return (offset + SCENE_CACHE_ALIGN - 1) & ~(uint64_t)(SCENE_CACHE_ALIGN - 1);
+}
+
+// Reserve an aligned section of `size` bytes; returns its offset
+static uint64_t place_section(uint64_t* end, size_t size) {
+    uint64_t offset = align_offset(*end);
+    *end = offset + size;
+    return offset;
+}
+
+// Zero-pad from *pos to `offset`, then write the section
+static bool write_section(FILE* f, uint64_t* pos, uint64_t offset, const void* data, size_t size) {
+    static const char zeros[SCENE_CACHE_ALIGN];
+    while (*pos < offset) {
+        size_t pad = (size_t)(offset - *pos);
+        if (pad > sizeof(zeros)) pad = sizeof(zeros);
+        if (fwrite(zeros, 1, pad, f) != pad) return false;
+        *pos += pad;
+    }
+    if (size > 0 && fwrite(data, 1, size, f) != size) return false;
+    *pos += size;
+    return true;
+}
+
+bool scene_cache_save(const Scene* scene, const char* dir, uint64_t key) {
+    if (!scene->bvh) {
+        fprintf(stderr, "Cannot cache a scene without a BVH\n");
+        return false;
+    }
+    if (scene->group_count > 0) {
+        fprintf(stderr, "Scenes with instances are not cached\n");
+        return false;
+    }
+    if (scene->has_motion) {
+        fprintf(stderr, "Scenes with moving primitives are not cached\n");
+        return false;
+    }
+    bool spatial = scene->bvh->refs != NULL;
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        if (!scene->meshes[i]->bvh) {
+            fprintf(stderr, "Cannot cache a mesh without a BVH\n");
+            return false;
+        }
+        if (scene->meshes[i]->bvh->refs) spatial = true;
+    }
+    if (spatial) {
+        fprintf(stderr, "Scenes with spatial-split BVHs are not cached\n");
+        return false;
+    }
+
+    SceneCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SCENE_CACHE_MAGIC, 4);
+    header.version = SCENE_CACHE_VERSION;
+    header.key = key;
+    header.primitive_size = sizeof(Primitive);
+    header.node_size = sizeof(BVHNode);
+    header.vec3_size = sizeof(Vec3);
+    header.prim_count = scene->prim_count;
+    header.node_count = scene->bvh->node_count;
+    header.mesh_count = scene->mesh_count;
+    header.ambient[0] = scene->ambient_light.x;
+    header.ambient[1] = scene->ambient_light.y;
+    header.ambient[2] = scene->ambient_light.z;
+
+    // Pointers in PRIMITIVE_MESH primitives become (primitive, mesh) pairs
+    for (uint32_t i = 0; i < scene->prim_count; i++) {
+        if (scene->primitives[i].type == PRIMITIVE_MESH) header.mesh_ref_count++;
+    }
+    uint32_t* refs = (uint32_t*)malloc(((size_t)header.mesh_ref_count + 1) * 2 * sizeof(uint32_t));
+    SceneCacheMesh* records = (SceneCacheMesh*)calloc(scene->mesh_count + 1, sizeof(SceneCacheMesh));
+    if (!refs || !records) {
+        free(refs);
+        free(records);
+        return false;
+    }
+    for (uint32_t i = 0, r = 0; i < scene->prim_count; i++) {
+        if (scene->primitives[i].type == PRIMITIVE_MESH) {
+            refs[2 * r] = i;
+            refs[2 * r + 1] = scene_mesh_index(scene, scene->primitives[i].mesh);
+            r++;
+        }
+    }
+
+    uint64_t end = sizeof(header);
+    header.primitives_offset = place_section(&end, (size_t)scene->prim_count * sizeof(Primitive));
+    header.nodes_offset = place_section(&end, (size_t)scene->bvh->node_count * sizeof(BVHNode));
+    header.meshes_offset = place_section(&end, (size_t)scene->mesh_count * sizeof(SceneCacheMesh));
+    header.mesh_refs_offset = place_section(&end, (size_t)header.mesh_ref_count * 2 * sizeof(uint32_t));
+    for (uint32_t i = 0; i < scene->mesh_count; i++) {
+        const Mesh* mesh = scene->meshes[i];
+        SceneCacheMesh* record = &records[i];
+        size_t vertices = mesh->vertex_count;
+        record->vertex_count = mesh->vertex_count;
+        record->triangle_count = mesh->triangle_count;
+        record->node_count = mesh->bvh->node_count;
+        record->flags = (mesh->normals ? SCENE_CACHE_MESH_NORMALS : 0) | (mesh->uvs ? SCENE_CACHE_MESH_UVS : 0);
+        record->bounds = mesh->bounds;
+        record->positions_offset = place_section(&end, vertices * sizeof(Vec3));
+        record->normals_offset = mesh->normals ? place_section(&end, vertices * sizeof(Vec3)) : 0;
+        record->uvs_offset = mesh->uvs ? place_section(&end, vertices * 2 * sizeof(float)) : 0;
+        record->indices_offset = place_section(&end, (size_t)mesh->triangle_count * 3 * sizeof(uint32_t));
+        record->nodes_offset = place_section(&end, (size_t)mesh->bvh->node_count * sizeof(BVHNode));
+    }
+    header.file_size = end;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s: %s\n", dir, strerror(errno));
+        free(refs);
+        free(records);
+        return false;
+    }
+    char path[4096], tmp_path[4096 + 32];
+    scene_cache_path(dir, key, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp%ld", path, (long)getpid());
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to write %s: %s\n", tmp_path, strerror(errno));
+        free(refs);
+        free(records);
+        return false;
+    }
+
+    uint64_t pos = 0;
+    bool ok = write_section(f, &pos, 0, &header, sizeof(header)) &&
+              write_section(f, &pos, header.primitives_offset, scene->primitives,
+                            (size_t)scene->prim_count * sizeof(Primitive)) &&
+              write_section(f, &pos, header.nodes_offset, scene->bvh->nodes,
+                            (size_t)scene->bvh->node_count * sizeof(BVHNode)) &&
+              write_section(f, &pos, header.meshes_offset, records,
+                            (size_t)scene->mesh_count * sizeof(SceneCacheMesh)) &&
+              write_section(f, &pos, header.mesh_refs_offset, refs,
+                            (size_t)header.mesh_ref_count * 2 * sizeof(uint32_t));
+    for (uint32_t i = 0; i < scene->mesh_count && ok; i++) {
+        const Mesh* mesh = scene->meshes[i];
+        const SceneCacheMesh* record = &records[i];
+        size_t vertices = mesh->vertex_count;
+        ok = write_section(f, &pos, record->positions_offset, mesh->positions, vertices * sizeof(Vec3)) &&
+             (!mesh->normals ||
+              write_section(f, &pos, record->normals_offset, mesh->normals, vertices * sizeof(Vec3))) &&
+             (!mesh->uvs ||
+              write_section(f, &pos, record->uvs_offset, mesh->uvs, vertices * 2 * sizeof(float))) &&
+             write_section(f, &pos, record->indices_offset, mesh->indices,
+                           (size_t)mesh->triangle_count * 3 * sizeof(uint32_t)) &&
+             write_section(f, &pos, record->nodes_offset, mesh->bvh->nodes,
+                           (size_t)mesh->bvh->node_count * sizeof(BVHNode));
+    }
+    free(refs);
+    free(records);
+
+    ok = (fclose(f) == 0) && ok;
+    if (ok && rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Failed to rename %s to %s: %s\n", tmp_path, path, strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to write scene cache %s\n", path);
+        unlink(tmp_path);
+    }
+    return ok;
+}
+
+// ============================================================================
+// Load
+// ============================================================================
+
+// Section of `count` items of `item_size` bytes lies inside the file
+static bool section_ok(uint64_t offset, uint64_t count, size_t item_size, uint64_t file_size) {
+    if (offset % SCENE_CACHE_ALIGN != 0 || offset > file_size) return false;
+    return count <= (file_size - offset) / item_size;
+}
+
+// Node graph traversal can walk without leaving the arrays: children come
+// after their parent (so there are no cycles) and no deeper than
+// BVH_MAX_DEPTH, and leaves cover ranges of the `item_count` items
+static bool nodes_valid(const BVHNode* nodes, uint32_t node_count, uint32_t item_count) {
+    if (node_count == 0) return true;
+    uint8_t* depth = (uint8_t*)calloc(node_count, 1);
+    if (!depth) return false;
+    bool ok = true;
+    for (uint32_t i = 0; i < node_count && ok; i++) {
+        const BVHNode* node = &nodes[i];
+        if (node->is_leaf) {
+            ok = (uint64_t)node->first_prim_idx + node->prim_count <= item_count;
+        } else {
+            ok = node->left > i && node->left < node_count && node->right > i &&
+                 node->right < node_count && depth[i] < BVH_MAX_DEPTH;
+            if (ok) {
+                uint8_t child = (uint8_t)(depth[i] + 1);
+                if (depth[node->left] < child) depth[node->left] = child;
+                if (depth[node->right] < child) depth[node->right] = child;
+            }
+        }
+    }
+    free(depth);
+    return ok;
+}
+
+static bool indices_valid(const uint32_t* indices, uint32_t triangle_count, uint32_t vertex_count) {
+    for (size_t i = 0; i < (size_t)triangle_count * 3; i++) {
+        if (indices[i] >= vertex_count) return false;
+    }
+    return true;
+}
+
+static BVH* borrowed_bvh(Primitive* primitives, uint32_t prim_count, BVHNode* nodes, uint32_t node_count) {
+    BVH* bvh = (BVH*)calloc(1, sizeof(BVH));
+    if (!bvh) return NULL;
+    bvh->primitives = primitives;
+    bvh->prim_count = prim_count;
+    bvh->nodes = nodes;
+    bvh->node_count = node_count;
+    bvh->borrowed = true;
+    return bvh;
+}
+
+Scene* scene_cache_load(const char* dir, uint64_t key) {
+    char path[4096];
+    scene_cache_path(dir, key, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;  // Not cached yet
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SceneCacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    // Private writable mapping: patching mesh pointers copies only the pages
+    // that hold PRIMITIVE_MESH primitives
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    char* base = (char*)mapping;
+    const SceneCacheHeader* header = (const SceneCacheHeader*)base;
+    bool ok = memcmp(header->magic, SCENE_CACHE_MAGIC, 4) == 0 &&
+              header->version == SCENE_CACHE_VERSION && header->key == key &&
+              header->primitive_size == sizeof(Primitive) && header->node_size == sizeof(BVHNode) &&
+              header->vec3_size == sizeof(Vec3) && header->file_size == size &&
+              section_ok(header->primitives_offset, header->prim_count, sizeof(Primitive), size) &&
+              section_ok(header->nodes_offset, header->node_count, sizeof(BVHNode), size) &&
+              section_ok(header->meshes_offset, header->mesh_count, sizeof(SceneCacheMesh), size) &&
+              section_ok(header->mesh_refs_offset, header->mesh_ref_count, 2 * sizeof(uint32_t), size);
+    if (!ok) {
+        fprintf(stderr, "Ignoring stale or foreign scene cache %s\n", path);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    Scene* scene = (Scene*)calloc(1, sizeof(Scene));
+    if (!scene) {
+        munmap(mapping, size);
+        return NULL;
+    }
+    scene->mapping = mapping;
+    scene->mapping_size = size;
+    scene->primitives = (Primitive*)(base + header->primitives_offset);
+    scene->prim_count = header->prim_count;
+    scene->prim_capacity = header->prim_count;
+    scene->ambient_light = vec3_create(header->ambient[0], header->ambient[1], header->ambient[2]);
+    scene->meshes = (Mesh**)calloc((size_t)header->mesh_count + 1, sizeof(Mesh*));
+    ok = scene->meshes != NULL;
+
+    const SceneCacheMesh* records = (const SceneCacheMesh*)(base + header->meshes_offset);
+    for (uint32_t i = 0; i < header->mesh_count && ok; i++) {
+        const SceneCacheMesh* record = &records[i];
+        size_t vertices = record->vertex_count;
+        ok = section_ok(record->positions_offset, vertices, sizeof(Vec3), size) &&
+             (!(record->flags & SCENE_CACHE_MESH_NORMALS) ||
+              section_ok(record->normals_offset, vertices, sizeof(Vec3), size)) &&
+             (!(record->flags & SCENE_CACHE_MESH_UVS) ||
+              section_ok(record->uvs_offset, vertices, 2 * sizeof(float), size)) &&
+             section_ok(record->indices_offset, (uint64_t)record->triangle_count * 3, sizeof(uint32_t), size) &&
+             section_ok(record->nodes_offset, record->node_count, sizeof(BVHNode), size) &&
+             indices_valid((const uint32_t*)(base + record->indices_offset), record->triangle_count,
+                           record->vertex_count) &&
+             nodes_valid((const BVHNode*)(base + record->nodes_offset), record->node_count,
+                         record->triangle_count);
+        Mesh* mesh = ok ? (Mesh*)calloc(1, sizeof(Mesh)) : NULL;
+        if (!mesh) {
+            ok = false;
+            break;
+        }
+        mesh->borrowed = true;
+        mesh->vertex_count = record->vertex_count;
+        mesh->triangle_count = record->triangle_count;
+        mesh->bounds = record->bounds;
+        mesh->positions = (Vec3*)(base + record->positions_offset);
+        if (record->flags & SCENE_CACHE_MESH_NORMALS) mesh->normals = (Vec3*)(base + record->normals_offset);
+        if (record->flags & SCENE_CACHE_MESH_UVS) mesh->uvs = (float*)(base + record->uvs_offset);
+        mesh->indices = (uint32_t*)(base + record->indices_offset);
+        mesh->bvh = borrowed_bvh(NULL, record->triangle_count, (BVHNode*)(base + record->nodes_offset),
+                                 record->node_count);
+        scene->meshes[scene->mesh_count++] = mesh;
+        ok = mesh->bvh != NULL;
+    }
+
+    // Only spheres, triangles and meshes are stored, and the writer's mesh
+    // pointers are cleared, so a mesh the refs leave out is caught below
+    // rather than dereferenced
+    for (uint32_t i = 0; i < scene->prim_count && ok; i++) {
+        Primitive* prim = &scene->primitives[i];
+        ok = !prim->moving && (prim->type == PRIMITIVE_SPHERE || prim->type == PRIMITIVE_TRIANGLE ||
+                               prim->type == PRIMITIVE_MESH);
+        if (ok && prim->type == PRIMITIVE_MESH) prim->mesh = NULL;
+    }
+    const uint32_t* refs = (const uint32_t*)(base + header->mesh_refs_offset);
+    for (uint32_t r = 0; r < header->mesh_ref_count && ok; r++) {
+        uint32_t prim = refs[2 * r], mesh = refs[2 * r + 1];
+        ok = prim < scene->prim_count && mesh < scene->mesh_count &&
+             scene->primitives[prim].type == PRIMITIVE_MESH;
+        if (ok) scene->primitives[prim].mesh = scene->meshes[mesh];
+    }
+    for (uint32_t i = 0; i < scene->prim_count && ok; i++) {
+        ok = scene->primitives[i].type != PRIMITIVE_MESH || scene->primitives[i].mesh != NULL;
+    }
+    ok = ok && nodes_valid((const BVHNode*)(base + header->nodes_offset), header->node_count,
+                           header->prim_count);
+
+    if (ok) {
+        scene->bvh = borrowed_bvh(scene->primitives, scene->prim_count,
+                                  (BVHNode*)(base + header->nodes_offset), header->node_count);
+    }
+    if (!scene->bvh) {
+        fprintf(stderr, "Corrupt scene cache %s\n", path);
+        scene_destroy(scene);
+        return NULL;
+    }
+    return scene;
+}
+
+Scene* scene_cache_build(Scene* scene, const char* dir, bool* hit) {
+    uint64_t key = scene_content_hash(scene);
+    Scene* cached = scene_cache_load(dir, key);
+    *hit = cached != NULL;
+    if (cached) {
+        scene_destroy(scene);
+        return cached;
+    }
+
+    scene_build_bvh(scene);
+    scene_cache_save(scene, dir, key);  // A failed save only costs the next startup
+    return scene;
+}
@@ -0,0 +1,763 @@
+#define _POSIX_C_SOURCE 200809L
+#include "scene_file.h"
+#include "file_parse.h"
+#include "mesh_io.h"
+#include "scene_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <dirent.h>
+
+// Longest keyword, sampler or material type name
+#define SCENE_WORD_SIZE 32
+// Longest record written by scene_file_save
+#define SCENE_LINE_SIZE 512
+
+// Material defined in the file; the name points into the mapping
+typedef struct {
+    const char* name;
+    uint32_t length;
+    Material material;
+} NamedMaterial;
+
+typedef struct {
+    const char* path;
+    const char* end;
+    uint32_t line;
+    NamedMaterial* materials;
+    uint32_t material_count;
+    uint32_t* slots;  // Open-addressed name table: material index + 1, 0 = empty
+    uint32_t slot_mask;
+} SceneParser;
+
+static bool parse_error(const SceneParser* parser, const char* format, ...) {
+    fprintf(stderr, "%s:%u: ", parser->path, parser->line);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    return false;
+}
+
+// Next blank-separated word on the line; false at the end of the line
+static bool next_word(const char** p, const char* end, const char** word, uint32_t* length) {
+    const char* s = skip_blanks(*p, end);
+    const char* e = s;
+    while (e < end && !is_separator(*e)) e++;
+    *word = s;
+    *length = (uint32_t)(e - s);
+    *p = e;
+    return e > s;
+}
+
+static bool word_is(const char* word, uint32_t length, const char* keyword) {
+    return strlen(keyword) == length && memcmp(word, keyword, length) == 0;
+}
+
+// Next word as a NUL-terminated string, for the *_from_name lookups
+static bool next_word_copy(const char** p, const char* end, char* buffer, size_t size) {
+    const char* word;
+    uint32_t length;
+    if (!next_word(p, end, &word, &length) || length >= size) return false;
+    memcpy(buffer, word, length);
+    buffer[length] = '\0';
+    return true;
+}
+
+static bool next_floats(const char** p, const char* end, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        const char* s = skip_blanks(*p, end);
+        if (!parse_float(&s, end, &out[i]) || (s < end && !is_separator(*s))) return false;
+        *p = s;
+    }
+    return true;
+}
+
+static bool next_vec3(const char** p, const char* end, Vec3* out) {
+    float v[3];
+    if (!next_floats(p, end, v, 3)) return false;
+    *out = vec3_create(v[0], v[1], v[2]);
+    return true;
+}
+
+static bool next_uint64(const char** p, const char* end, uint64_t* out) {
+    char text[SCENE_WORD_SIZE];
+    if (!next_word_copy(p, end, text, sizeof(text)) || !is_digit(text[0])) return false;
+    char* text_end;
+    errno = 0;
+    *out = strtoull(text, &text_end, 10);
+    return *text_end == '\0' && errno == 0;
+}
+
+static bool line_done(const char* p, const char* end) {
+    p = skip_blanks(p, end);
+    return p == end || *p == '\r' || *p == '\n' || *p == '#';
+}
+
+// Slot holding `name`, or the empty slot where it would go
+static uint32_t* material_slot(const SceneParser* parser, const char* name, uint32_t length) {
+    uint32_t slot = (uint32_t)hash_bytes(0, name, length) & parser->slot_mask;
+    for (;; slot = (slot + 1) & parser->slot_mask) {
+        uint32_t index = parser->slots[slot];
+        if (index == 0) return &parser->slots[slot];
+        const NamedMaterial* named = &parser->materials[index - 1];
+        if (named->length == length && memcmp(named->name, name, length) == 0) {
+            return &parser->slots[slot];
+        }
+    }
+}
+
+static bool next_material_ref(SceneParser* parser, const char** p, Material* out) {
+    const char* name;
+    uint32_t length;
+    if (!next_word(p, parser->end, &name, &length)) {
+        return parse_error(parser, "missing material name");
+    }
+    uint32_t index = *material_slot(parser, name, length);
+    if (index == 0) {
+        return parse_error(parser, "undefined material '%.*s'", (int)length, name);
+    }
+    *out = parser->materials[index - 1].material;
+    return true;
+}
+
+static bool parse_settings(SceneParser* parser, const char** p, SceneDescription* desc) {
+    RenderSettings* settings = &desc->settings;
+    const char* key;
+    uint32_t length;
+    while (next_word(p, parser->end, &key, &length)) {
+        if (word_is(key, length, "sampler")) {
+            char name[SCENE_WORD_SIZE];
+            if (!next_word_copy(p, parser->end, name, sizeof(name)) ||
+                !sampler_type_from_name(name, &settings->sampler)) {
+                return parse_error(parser, "unknown sampler");
+            }
+            desc->settings_mask |= SCENE_SETTING_SAMPLER;
+            continue;
+        }
+
+        uint64_t value;
+        if (!next_uint64(p, parser->end, &value)) {
+            return parse_error(parser, "invalid value for setting '%.*s'", (int)length, key);
+        }
+        bool fits = value <= UINT32_MAX;
+        if (word_is(key, length, "width") && fits && value >= 2) {
+            settings->width = (uint32_t)value;
+            desc->settings_mask |= SCENE_SETTING_WIDTH;
+        } else if (word_is(key, length, "height") && fits && value >= 2) {
+            settings->height = (uint32_t)value;
+            desc->settings_mask |= SCENE_SETTING_HEIGHT;
+        } else if (word_is(key, length, "spp") && fits && value >= 1) {
+            settings->samples_per_pixel = (uint32_t)value;
+            desc->settings_mask |= SCENE_SETTING_SPP;
+        } else if (word_is(key, length, "depth") && fits) {
+            settings->max_depth = (uint32_t)value;
+            desc->settings_mask |= SCENE_SETTING_DEPTH;
+        } else if (word_is(key, length, "seed")) {
+            settings->seed = value;
+            desc->settings_mask |= SCENE_SETTING_SEED;
+        } else {
+            return parse_error(parser, "unknown setting or value out of range: '%.*s'",
+                               (int)length, key);
+        }
+    }
+    return true;
+}
+
+static bool parse_camera(SceneParser* parser, const char** p, CameraParams* camera) {
+    const char* key;
+    uint32_t length;
+    while (next_word(p, parser->end, &key, &length)) {
+        bool ok;
+        if (word_is(key, length, "lookfrom")) {
+            ok = next_vec3(p, parser->end, &camera->lookfrom);
+        } else if (word_is(key, length, "lookat")) {
+            ok = next_vec3(p, parser->end, &camera->lookat);
+        } else if (word_is(key, length, "vup")) {
+            ok = next_vec3(p, parser->end, &camera->vup);
+        } else if (word_is(key, length, "vfov")) {
+            ok = next_floats(p, parser->end, &camera->vfov, 1);
+        } else if (word_is(key, length, "aperture")) {
+            ok = next_floats(p, parser->end, &camera->aperture, 1);
+        } else if (word_is(key, length, "focus")) {
+            ok = next_floats(p, parser->end, &camera->focus_dist, 1);
+        } else {
+            return parse_error(parser, "unknown camera key '%.*s'", (int)length, key);
+        }
+        if (!ok) {
+            return parse_error(parser, "invalid value for camera '%.*s'", (int)length, key);
+        }
+    }
+    return true;
+}
+
+// One side of a blend: TYPE R G B ROUGHNESS IOR
+static bool parse_blend_side(SceneParser* parser, const char** p, MaterialType* type,
+                             Vec3* albedo, float* roughness, float* ior) {
+    char name[SCENE_WORD_SIZE];
+    if (!next_word_copy(p, parser->end, name, sizeof(name)) ||
+        !material_type_from_name(name, type) || *type == MATERIAL_BLEND) {
+        return parse_error(parser, "blend needs lambertian, metal, dielectric or emissive sides");
+    }
+    float params[2];
+    if (!next_vec3(p, parser->end, albedo) || !next_floats(p, parser->end, params, 2)) {
+        return parse_error(parser, "blend side needs R G B ROUGHNESS IOR");
+    }
+    *roughness = params[0];
+    *ior = params[1];
+    return true;
+}
+
+static bool parse_material(SceneParser* parser, const char** p) {
+    const char* name;
+    uint32_t length;
+    char type_name[SCENE_WORD_SIZE];
+    MaterialType type;
+    if (!next_word(p, parser->end, &name, &length)) {
+        return parse_error(parser, "missing material name");
+    }
+    if (!next_word_copy(p, parser->end, type_name, sizeof(type_name)) ||
+        !material_type_from_name(type_name, &type)) {
+        return parse_error(parser, "unknown material type for '%.*s'", (int)length, name);
+    }
+    uint32_t* slot = material_slot(parser, name, length);
+    if (*slot != 0) {
+        return parse_error(parser, "material '%.*s' is already defined", (int)length, name);
+    }
+
+    Material material;
+    Vec3 color;
+    float value;
+    bool ok = true;
+    switch (type) {
+        case MATERIAL_LAMBERTIAN:
+            ok = next_vec3(p, parser->end, &color);
+            material = material_lambertian(color);
+            break;
+        case MATERIAL_METAL:
+            ok = next_vec3(p, parser->end, &color) && next_floats(p, parser->end, &value, 1);
+            material = material_metal(color, value);
+            break;
+        case MATERIAL_DIELECTRIC:
+            ok = next_floats(p, parser->end, &value, 1);
+            material = material_dielectric(value);
+            break;
+        case MATERIAL_EMISSIVE:
+            ok = next_vec3(p, parser->end, &color);
+            material = material_emissive(color);
+            break;
+        default: {
+            MaterialType type1, type2;
+            Vec3 albedo1, albedo2;
+            float rough1, ior1, rough2, ior2, range[2];
+            char mode_name[SCENE_WORD_SIZE];
+            BlendMode mode;
+            if (!parse_blend_side(parser, p, &type1, &albedo1, &rough1, &ior1) ||
+                !parse_blend_side(parser, p, &type2, &albedo2, &rough2, &ior2)) {
+                return false;
+            }
+            if (!next_word_copy(p, parser->end, mode_name, sizeof(mode_name)) ||
+                !blend_mode_from_name(mode_name, &mode) ||
+                !next_floats(p, parser->end, range, 2)) {
+                return parse_error(parser, "blend needs MODE MIN MAX after its two sides");
+            }
+            material = material_blend(type1, albedo1, rough1, ior1, type2, albedo2, rough2, ior2,
+                                      mode, range[0], range[1]);
+            break;
+        }
+    }
+    if (!ok) {
+        return parse_error(parser, "invalid parameters for %s material '%.*s'",
+                           type_name, (int)length, name);
+    }
+
+    NamedMaterial* named = &parser->materials[parser->material_count++];
+    named->name = name;
+    named->length = length;
+    named->material = material;
+    *slot = parser->material_count;
+    return true;
+}
+
+static bool parse_mesh(SceneParser* parser, const char** p, Scene* scene) {
+    Material material;
+    if (!next_material_ref(parser, p, &material)) return false;
+
+    // The path runs to the end of the line and is relative to the scene file
+    const char* start = skip_blanks(*p, parser->end);
+    const char* stop = start;
+    while (stop < parser->end && *stop != '\n' && *stop != '\r') stop++;
+    while (stop > start && is_blank(stop[-1])) stop--;
+    if (stop == start) return parse_error(parser, "missing mesh path");
+    *p = stop;
+
+    const char* slash = strrchr(parser->path, '/');
+    size_t dir_length = (*start != '/' && slash) ? (size_t)(slash - parser->path) + 1 : 0;
+    size_t path_length = (size_t)(stop - start);
+    char* mesh_path = (char*)malloc(dir_length + path_length + 1);
+    if (!mesh_path) return parse_error(parser, "out of memory");
+    memcpy(mesh_path, parser->path, dir_length);
+    memcpy(mesh_path + dir_length, start, path_length);
+    mesh_path[dir_length + path_length] = '\0';
+
+    Mesh* mesh = mesh_load(mesh_path);
+    if (!mesh) {
+        parse_error(parser, "failed to load mesh %s", mesh_path);
+        free(mesh_path);
+        return false;
+    }
+    free(mesh_path);
+    scene_add_mesh(scene, mesh, material);
+    return true;
+}
+
+// keyframe FRAME camera KEY VALUE... | keyframe FRAME move PRIM X Y Z
+static bool parse_keyframe(SceneParser* parser, const char** p, SceneDescription* desc) {
+    Sequence* seq = &desc->sequence;
+    uint64_t frame;
+    const char* kind;
+    uint32_t length;
+    if (!next_uint64(p, parser->end, &frame) || frame >= UINT32_MAX) {
+        return parse_error(parser, "keyframe needs a frame number");
+    }
+    if (!next_word(p, parser->end, &kind, &length)) {
+        return parse_error(parser, "keyframe needs camera or move");
+    }
+    if (word_is(kind, length, "camera")) {
+        CameraKey* key = &seq->camera_keys[seq->camera_key_count];
+        if (seq->camera_key_count > 0 && key[-1].frame >= frame) {
+            return parse_error(parser, "camera keyframes must be in frame order");
+        }
+        key->frame = (uint32_t)frame;
+        key->camera = seq->camera_key_count > 0 ? key[-1].camera : desc->camera;
+        if (!parse_camera(parser, p, &key->camera)) return false;
+        seq->camera_key_count++;
+        return true;
+    }
+    if (word_is(kind, length, "move")) {
+        MoveKey* key = &seq->move_keys[seq->move_key_count];
+        uint64_t prim;
+        if (!next_uint64(p, parser->end, &prim) || prim >= UINT32_MAX ||
+            !next_vec3(p, parser->end, &key->offset)) {
+            return parse_error(parser, "move needs PRIM X Y Z");
+        }
+        key->frame = (uint32_t)frame;
+        key->prim = (uint32_t)prim;
+        seq->move_key_count++;
+        return true;
+    }
+    return parse_error(parser, "unknown keyframe type '%.*s'", (int)length, kind);
+}
+
+// Optional "motion DX DY DZ" after a sphere or triangle
+static bool parse_motion(SceneParser* parser, const char** p, Scene* scene) {
+    const char* word;
+    uint32_t length;
+    const char* start = *p;
+    if (!next_word(p, parser->end, &word, &length) || !word_is(word, length, "motion")) {
+        *p = start;
+        return true;
+    }
+    Vec3 motion;
+    if (!next_vec3(p, parser->end, &motion)) return parse_error(parser, "motion needs DX DY DZ");
+    scene_set_motion(scene, scene->prim_count - 1, motion);
+    return true;
+}
+
+// One record; *p is past the keyword and ends after the record's arguments
+static bool parse_record(SceneParser* parser, const char* keyword, uint32_t length,
+                         const char** p, SceneDescription* desc) {
+    Scene* scene = desc->scene;
+    if (word_is(keyword, length, "sphere")) {
+        Material material;
+        float values[4];
+        if (!next_material_ref(parser, p, &material)) return false;
+        if (!next_floats(p, parser->end, values, 4)) {
+            return parse_error(parser, "sphere needs X Y Z RADIUS");
+        }
+        scene_add_sphere(scene, vec3_create(values[0], values[1], values[2]), values[3], material);
+        return parse_motion(parser, p, scene);
+    }
+    if (word_is(keyword, length, "triangle")) {
+        Material material;
+        Vec3 v0, v1, v2;
+        if (!next_material_ref(parser, p, &material)) return false;
+        if (!next_vec3(p, parser->end, &v0) || !next_vec3(p, parser->end, &v1) ||
+            !next_vec3(p, parser->end, &v2)) {
+            return parse_error(parser, "triangle needs three X Y Z vertices");
+        }
+        scene_add_triangle(scene, v0, v1, v2, material);
+        return parse_motion(parser, p, scene);
+    }
+    if (word_is(keyword, length, "material")) return parse_material(parser, p);
+    if (word_is(keyword, length, "mesh")) return parse_mesh(parser, p, scene);
+    if (word_is(keyword, length, "camera")) return parse_camera(parser, p, &desc->camera);
+    if (word_is(keyword, length, "settings")) return parse_settings(parser, p, desc);
+    if (word_is(keyword, length, "keyframe")) return parse_keyframe(parser, p, desc);
+    if (word_is(keyword, length, "frames")) {
+        uint64_t frames;
+        if (!next_uint64(p, parser->end, &frames) || frames == 0 || frames > UINT32_MAX) {
+            return parse_error(parser, "frames needs a positive count");
+        }
+        desc->sequence.frame_count = (uint32_t)frames;
+        return true;
+    }
+    if (word_is(keyword, length, "ambient")) {
+        if (!next_vec3(p, parser->end, &scene->ambient_light)) {
+            return parse_error(parser, "ambient needs R G B");
+        }
+        return true;
+    }
+    return parse_error(parser, "unknown record '%.*s'", (int)length, keyword);
+}
+
+bool scene_file_load(const char* path, SceneDescription* desc) {
+    memset(desc, 0, sizeof(*desc));
+    desc->camera = camera_params_default();
+
+    MappedFile file;
+    if (!map_file(path, &file)) return false;
+    const char* end = file.data + file.size;
+
+    // Pass 1: size the primitive array and the material table
+    uint32_t material_count = 0;
+    uint32_t prim_count = 0;
+    uint32_t keyframe_count = 0;
+    for (const char* line = file.data; line < end; line = next_line(line, end)) {
+        const char* p = line;
+        const char* keyword;
+        uint32_t length;
+        if (!next_word(&p, end, &keyword, &length)) continue;
+        if (word_is(keyword, length, "material")) {
+            material_count++;
+        } else if (word_is(keyword, length, "sphere") || word_is(keyword, length, "triangle") ||
+                   word_is(keyword, length, "mesh")) {
+            prim_count++;
+        } else if (word_is(keyword, length, "keyframe")) {
+            keyframe_count++;
+        }
+    }
+
+    uint32_t slot_count = 16;
+    while (slot_count < 2 * material_count) slot_count *= 2;
+    SceneParser parser = {path, end, 0, NULL, 0, NULL, slot_count - 1};
+    parser.materials = (NamedMaterial*)malloc((material_count ? material_count : 1) *
+                                              sizeof(NamedMaterial));
+    parser.slots = (uint32_t*)calloc(slot_count, sizeof(uint32_t));
+    desc->scene = scene_create();
+    if (keyframe_count) {
+        desc->sequence.camera_keys = (CameraKey*)malloc(keyframe_count * sizeof(CameraKey));
+        desc->sequence.move_keys = (MoveKey*)malloc(keyframe_count * sizeof(MoveKey));
+    }
+    bool ok = parser.materials && parser.slots && desc->scene &&
+              scene_reserve(desc->scene, prim_count) &&
+              (!keyframe_count || (desc->sequence.camera_keys && desc->sequence.move_keys));
+    if (!ok) fprintf(stderr, "Failed to allocate scene for %s\n", path);
+
+    // Pass 2: fill them
+    for (const char* line = file.data; ok && line < end; line = next_line(line, end)) {
+        const char* p = line;
+        const char* keyword;
+        uint32_t length;
+        parser.line++;
+        if (!next_word(&p, end, &keyword, &length)) continue;
+        ok = parse_record(&parser, keyword, length, &p, desc);
+        if (ok && !line_done(p, end)) {
+            next_word(&p, end, &keyword, &length);
+            ok = parse_error(&parser, "unexpected '%.*s'", (int)length, keyword);
+        }
+    }
+    if (ok && desc->scene->prim_count == 0) {
+        fprintf(stderr, "%s has no spheres, triangles or meshes\n", path);
+        ok = false;
+    }
+
+    // Keyframes make it a sequence, which runs to the last one unless frames says otherwise
+    Sequence* seq = &desc->sequence;
+    sequence_sort(seq);
+    uint32_t last_key = 0;
+    if (seq->camera_key_count) last_key = seq->camera_keys[seq->camera_key_count - 1].frame;
+    for (uint32_t i = 0; i < seq->move_key_count; i++) {
+        if (seq->move_keys[i].frame > last_key) last_key = seq->move_keys[i].frame;
+    }
+    if (ok && keyframe_count && seq->frame_count == 0) {
+        seq->frame_count = last_key + 1;
+    } else if (ok && keyframe_count && last_key >= seq->frame_count) {
+        fprintf(stderr, "%s: keyframe %u is past the last of %u frames\n", path, last_key,
+                seq->frame_count);
+        ok = false;
+    }
+
+    free(parser.materials);
+    free(parser.slots);
+    unmap_file(&file);
+    if (!ok) {
+        scene_destroy(desc->scene);
+        desc->scene = NULL;
+        sequence_free(&desc->sequence);
+    }
+    return ok;
+}
+
+void scene_file_apply_settings(const SceneDescription* desc, RenderSettings* settings,
+                               uint32_t keep) {
+    uint32_t mask = desc->settings_mask & ~keep;
+    if (mask & SCENE_SETTING_WIDTH) settings->width = desc->settings.width;
+    if (mask & SCENE_SETTING_HEIGHT) settings->height = desc->settings.height;
+    if (mask & SCENE_SETTING_SPP) settings->samples_per_pixel = desc->settings.samples_per_pixel;
+    if (mask & SCENE_SETTING_DEPTH) settings->max_depth = desc->settings.max_depth;
+    if (mask & SCENE_SETTING_SEED) settings->seed = desc->settings.seed;
+    if (mask & SCENE_SETTING_SAMPLER) settings->sampler = desc->settings.sampler;
+}
+
+// Append to a NUL-terminated line buffer (truncating at `size`)
+static void append(char* text, size_t size, const char* format, ...) {
+    size_t used = strlen(text);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text + used, size - used, format, args);
+    va_end(args);
+}
+
+// Six significant digits when they read back as the same float (hand-written
+// values such as 0.35), else the nine that always do
+static void append_floats(char* text, size_t size, const float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        char number[32];
+        snprintf(number, sizeof(number), "%.6g", values[i]);
+        if (strtof(number, NULL) != values[i]) {
+            snprintf(number, sizeof(number), "%.9g", values[i]);
+        }
+        append(text, size, " %s", number);
+    }
+}
+
+static void append_vec3(char* text, size_t size, Vec3 v) {
+    float values[3] = {v.x, v.y, v.z};
+    append_floats(text, size, values, 3);
+}
+
+// Material definition as written after its name
+static void format_material(const Material* m, char* text, size_t size) {
+    text[0] = '\0';
+    append(text, size, "%s", material_type_name(m->type));
+    switch (m->type) {
+        case MATERIAL_LAMBERTIAN:
+            append_vec3(text, size, m->albedo);
+            break;
+        case MATERIAL_METAL:
+            append_vec3(text, size, m->albedo);
+            append_floats(text, size, &m->roughness, 1);
+            break;
+        case MATERIAL_DIELECTRIC:
+            append_floats(text, size, &m->ior, 1);
+            break;
+        case MATERIAL_EMISSIVE:
+            append_vec3(text, size, m->emission);
+            break;
+        default:
+            append(text, size, " %s", material_type_name(m->blend_type1));
+            append_vec3(text, size, m->albedo);
+            append_floats(text, size, &m->roughness, 1);
+            append_floats(text, size, &m->ior, 1);
+            append(text, size, " %s", material_type_name(m->blend_type2));
+            append_vec3(text, size, m->albedo2);
+            append_floats(text, size, &m->roughness2, 1);
+            append_floats(text, size, &m->ior2, 1);
+            append(text, size, " %s", blend_mode_name(m->blend_mode));
+            append_floats(text, size, &m->blend_min, 1);
+            append_floats(text, size, &m->blend_max, 1);
+            break;
+    }
+}
+
+// Every Material field, packed without padding, to find shared materials
+#define MATERIAL_KEY_SIZE 19
+
+static void material_key(const Material* m, float key[MATERIAL_KEY_SIZE]) {
+    const float values[MATERIAL_KEY_SIZE] = {
+        (float)m->type, m->albedo.x, m->albedo.y, m->albedo.z, m->roughness, m->ior,
+        m->emission.x, m->emission.y, m->emission.z,
+        (float)m->blend_type1, (float)m->blend_type2, m->albedo2.x, m->albedo2.y, m->albedo2.z,
+        m->roughness2, m->ior2, (float)m->blend_mode, m->blend_min, m->blend_max
+    };
+    memcpy(key, values, sizeof(values));
+}
+
+// Every camera key, appended to `text`
+static void append_camera(char* text, size_t size, const CameraParams* camera) {
+    float lens[3] = {camera->vfov, camera->aperture, camera->focus_dist};
+    append(text, size, " lookfrom");
+    append_vec3(text, size, camera->lookfrom);
+    append(text, size, " lookat");
+    append_vec3(text, size, camera->lookat);
+    append(text, size, " vup");
+    append_vec3(text, size, camera->vup);
+    append(text, size, " vfov");
+    append_floats(text, size, &lens[0], 1);
+    append(text, size, " aperture");
+    append_floats(text, size, &lens[1], 1);
+    append(text, size, " focus");
+    append_floats(text, size, &lens[2], 1);
+}
+
+bool scene_file_save(const char* path, const Scene* scene, const CameraParams* camera,
+                     const RenderSettings* settings, const Sequence* sequence) {
+    if (scene->mesh_count > 0 || scene->group_count > 0) {
+        fprintf(stderr, "Cannot write %s: scenes with meshes or instances have no scene file form\n", path);
+        return false;
+    }
+
+    // Primitives share one definition per distinct material
+    uint32_t count = scene->prim_count;
+    uint32_t slot_count = 16;
+    while (slot_count < 2 * count) slot_count *= 2;
+    uint32_t* prim_material = (uint32_t*)malloc((count ? count : 1) * sizeof(uint32_t));
+    uint32_t* unique = (uint32_t*)malloc((count ? count : 1) * sizeof(uint32_t));
+    uint64_t* unique_hash = (uint64_t*)malloc((count ? count : 1) * sizeof(uint64_t));
+    uint32_t* slots = (uint32_t*)calloc(slot_count, sizeof(uint32_t));
+    FILE* out = (prim_material && unique && unique_hash && slots) ? fopen(path, "w") : NULL;
+    if (!out) {
+        fprintf(stderr, "Failed to write %s: %s\n", path, strerror(errno));
+        free(prim_material);
+        free(unique);
+        free(unique_hash);
+        free(slots);
+        return false;
+    }
+
+    uint32_t unique_count = 0;
+    float key[MATERIAL_KEY_SIZE];
+    float other[MATERIAL_KEY_SIZE];
+    for (uint32_t i = 0; i < count; i++) {
+        material_key(&scene->primitives[i].material, key);
+        uint64_t hash = hash_bytes(0, key, sizeof(key));
+        uint32_t slot = (uint32_t)hash & (slot_count - 1);
+        for (; slots[slot] != 0; slot = (slot + 1) & (slot_count - 1)) {
+            uint32_t index = slots[slot] - 1;
+            if (unique_hash[index] != hash) continue;
+            material_key(&scene->primitives[unique[index]].material, other);
+            if (memcmp(key, other, sizeof(key)) == 0) break;
+        }
+        if (slots[slot] == 0) {
+            unique[unique_count] = i;
+            unique_hash[unique_count] = hash;
+            slots[slot] = ++unique_count;
+        }
+        prim_material[i] = slots[slot] - 1;
+    }
+
+    char text[SCENE_LINE_SIZE];
+    if (settings) {
+        fprintf(out, "settings width %u height %u spp %u depth %u seed %llu sampler %s\n",
+                settings->width, settings->height, settings->samples_per_pixel,
+                settings->max_depth, (unsigned long long)settings->seed,
+                sampler_type_name(settings->sampler));
+    }
+    snprintf(text, sizeof(text), "camera");
+    append_camera(text, sizeof(text), camera);
+    fprintf(out, "%s\n", text);
+    snprintf(text, sizeof(text), "ambient");
+    append_vec3(text, sizeof(text), scene->ambient_light);
+    fprintf(out, "%s\n\n", text);
+
+    for (uint32_t i = 0; i < unique_count; i++) {
+        format_material(&scene->primitives[unique[i]].material, text, sizeof(text));
+        fprintf(out, "material m%u %s\n", i, text);
+    }
+    fputc('\n', out);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Primitive* prim = &scene->primitives[i];
+        if (prim->type == PRIMITIVE_SPHERE) {
+            snprintf(text, sizeof(text), "sphere m%u", prim_material[i]);
+            append_vec3(text, sizeof(text), prim->sphere.center);
+            append_floats(text, sizeof(text), &prim->sphere.radius, 1);
+        } else {
+            snprintf(text, sizeof(text), "triangle m%u", prim_material[i]);
+            append_vec3(text, sizeof(text), prim->triangle.v0);
+            append_vec3(text, sizeof(text), prim->triangle.v1);
+            append_vec3(text, sizeof(text), prim->triangle.v2);
+        }
+        if (prim->moving) {
+            append(text, sizeof(text), " motion");
+            append_vec3(text, sizeof(text), prim->motion);
+        }
+        fprintf(out, "%s\n", text);
+    }
+
+    // Camera keyframes are written whole, so none depends on the one before
+    if (sequence && sequence->frame_count > 0) {
+        fprintf(out, "\nframes %u\n", sequence->frame_count);
+        for (uint32_t i = 0; i < sequence->camera_key_count; i++) {
+            const CameraKey* key = &sequence->camera_keys[i];
+            snprintf(text, sizeof(text), "keyframe %u camera", key->frame);
+            append_camera(text, sizeof(text), &key->camera);
+            fprintf(out, "%s\n", text);
+        }
+        for (uint32_t i = 0; i < sequence->move_key_count; i++) {
+            const MoveKey* key = &sequence->move_keys[i];
+            snprintf(text, sizeof(text), "keyframe %u move %u", key->frame, key->prim);
+            append_vec3(text, sizeof(text), key->offset);
+            fprintf(out, "%s\n", text);
+        }
+    }
+
+    free(prim_material);
+    free(unique);
+    free(unique_hash);
+    free(slots);
+    bool ok = !ferror(out);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+char** scene_file_list(const char* dir, uint32_t* count) {
+    *count = 0;
+    DIR* handle = opendir(dir);
+    if (!handle) return NULL;
+
+    uint32_t capacity = 16;
+    char** paths = (char**)malloc(capacity * sizeof(char*));
+    const size_t extension_length = strlen(SCENE_FILE_EXTENSION);
+    struct dirent* entry;
+    while (paths && (entry = readdir(handle)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length <= extension_length ||
+            strcmp(entry->d_name + length - extension_length, SCENE_FILE_EXTENSION) != 0) {
+            continue;
+        }
+        if (*count == capacity) {
+            capacity *= 2;
+            char** grown = (char**)realloc(paths, capacity * sizeof(char*));
+            if (!grown) break;
+            paths = grown;
+        }
+        size_t size = strlen(dir) + length + 2;
+        char* path = (char*)malloc(size);
+        if (!path) break;
+        snprintf(path, size, "%s/%s", dir, entry->d_name);
+        paths[(*count)++] = path;
+    }
+    closedir(handle);
+
+    if (paths) qsort(paths, *count, sizeof(char*), compare_paths);
+    return paths;
+}
+
+void scene_file_list_free(char** paths, uint32_t count) {
+    if (paths) {
+        for (uint32_t i = 0; i < count; i++) {
+            free(paths[i]);
+        }
+        free(paths);
+    }
+}
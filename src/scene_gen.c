@@ -0,0 +1,331 @@
+#include "scene_gen.h"
+#include "scenes.h"
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Largest COUNT a spec accepts (primitive and triangle indices are 32-bit)
+#define GENERATOR_MAX_COUNT (1u << 30)
+// Materials shared by the generated spheres
+#define GENERATOR_PALETTE_SIZE 64
+// Fractal octaves summed for terrain heights
+#define TERRAIN_OCTAVES 6
+
+static const char* const GENERATOR_NAMES[GENERATOR_TYPE_COUNT] = {
+    "spheres",
+    "sphere-mesh",
+    "terrain",
+    "grid",
+    "forest"
+};
+
+const char* generator_type_name(GeneratorType type) {
+    if (type < GENERATOR_TYPE_COUNT) {
+        return GENERATOR_NAMES[type];
+    }
+    return "unknown";
+}
+
+bool generator_spec_parse(const char* text, GeneratorSpec* spec) {
+    const char* colon = strchr(text, ':');
+    if (!colon) return false;
+    size_t name_length = (size_t)(colon - text);
+    int type = 0;
+    while (type < GENERATOR_TYPE_COUNT && (strlen(GENERATOR_NAMES[type]) != name_length ||
+                                           strncmp(text, GENERATOR_NAMES[type], name_length) != 0)) {
+        type++;
+    }
+    if (type == GENERATOR_TYPE_COUNT || colon[1] < '0' || colon[1] > '9') return false;
+
+    char* end;
+    unsigned long long count = strtoull(colon + 1, &end, 10);
+    if (*end == 'K' || *end == 'k') {
+        count *= 1000;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        count *= 1000000;
+        end++;
+    }
+    unsigned long long seed = 1;
+    if (*end == ':') {
+        const char* seed_text = end + 1;
+        if (*seed_text < '0' || *seed_text > '9') return false;
+        seed = strtoull(seed_text, &end, 10);
+    }
+    if (*end != '\0' || count == 0 || count > GENERATOR_MAX_COUNT) return false;
+
+    spec->type = (GeneratorType)type;
+    spec->count = (uint32_t)count;
+    spec->seed = seed;
+    return true;
+}
+
+// Mostly diffuse, some metal and glass, like the Random Spheres scene
+static void fill_palette(RNG* rng, Material* palette) {
+    for (int i = 0; i < GENERATOR_PALETTE_SIZE; i++) {
+        float choose = rng_float(rng);
+        Vec3 color = vec3_create(rng_float(rng), rng_float(rng), rng_float(rng));
+        if (choose < 0.7f) {
+            palette[i] = material_lambertian(vec3_mul(color, color));
+        } else if (choose < 0.9f) {
+            palette[i] = material_metal(vec3_add(vec3_scale(color, 0.5f), vec3_create(0.5f, 0.5f, 0.5f)),
+                                        0.3f * rng_float(rng));
+        } else {
+            palette[i] = material_dielectric(1.5f);
+        }
+    }
+}
+
+// Cube side for N spheres at roughly one per 8 cubic units
+static float spheres_extent(uint32_t count) {
+    return 2.0f * cbrtf((float)count);
+}
+
+static uint32_t grid_side(uint32_t count) {
+    uint32_t side = (uint32_t)cbrtf((float)count);
+    while ((uint64_t)side * side * side < count) side++;
+    return side;
+}
+
+static Scene* generate_spheres(const GeneratorSpec* spec) {
+    RNG rng;
+    rng_init(&rng, spec->seed);
+    Material palette[GENERATOR_PALETTE_SIZE];
+    fill_palette(&rng, palette);
+
+    Scene* scene = scene_create();
+    if (!scene_reserve(scene, spec->count)) {
+        scene_destroy(scene);
+        return NULL;
+    }
+    float half = 0.5f * spheres_extent(spec->count);
+    for (uint32_t i = 0; i < spec->count; i++) {
+        Vec3 center = vec3_create(rng_float_range(&rng, -half, half), rng_float_range(&rng, -half, half),
+                                  rng_float_range(&rng, -half, half));
+        float radius = rng_float_range(&rng, 0.2f, 0.6f);
+        scene_add_sphere(scene, center, radius, palette[rng_uint32(&rng) % GENERATOR_PALETTE_SIZE]);
+    }
+    scene->ambient_light = vec3_create(0.7f, 0.8f, 1.0f);
+    return scene;
+}
+
+// Instances of one shared sphere mesh on a cubic lattice, each recoloured
+// through its material override
+static Scene* generate_grid(const GeneratorSpec* spec) {
+    RNG rng;
+    rng_init(&rng, spec->seed);
+    Material palette[GENERATOR_PALETTE_SIZE];
+    fill_palette(&rng, palette);
+
+    Mesh* mesh = mesh_create_sphere(12, 24, 0.4f);
+    if (!mesh) return NULL;
+    Scene* group = scene_create();
+    scene_add_mesh(group, mesh, palette[0]);
+    Scene* scene = scene_create();
+    const Scene* ball = scene_add_group(scene, group);
+    if (!scene_reserve(scene, spec->count)) {
+        scene_destroy(scene);
+        return NULL;
+    }
+    uint32_t side = grid_side(spec->count);
+    float offset = 0.5f * (float)(side - 1);
+    for (uint32_t i = 0; i < spec->count; i++) {
+        uint32_t x = i % side, y = (i / side) % side, z = i / side / side;
+        Transform place = transform_translate(vec3_create((float)x - offset, (float)y - offset,
+                                                          (float)z - offset));
+        // Diagonal stripes of eight palette colours
+        if (!scene_add_instance(scene, ball, &place, &palette[(x + 2 * y + 3 * z) % 8])) {
+            scene_destroy(scene);
+            return NULL;
+        }
+    }
+    scene->ambient_light = vec3_create(0.7f, 0.8f, 1.0f);
+    return scene;
+}
+
+// Tree of about 1.2K triangles standing at the origin, 3.1 units tall: an
+// ellipsoid trunk under a round canopy
+static Scene* tree_group(void) {
+    Mesh* trunk = mesh_create_sphere(6, 12, 1.0f);
+    Mesh* canopy = mesh_create_sphere(16, 32, 0.9f);
+    if (!trunk || !canopy) {
+        mesh_destroy(trunk);
+        mesh_destroy(canopy);
+        return NULL;
+    }
+    const Vec3 trunk_scale = vec3_create(0.15f, 1.0f, 0.15f);
+    for (uint32_t v = 0; v < trunk->vertex_count; v++) {
+        trunk->positions[v] = vec3_add(vec3_mul(trunk->positions[v], trunk_scale), vec3_create(0, 1.0f, 0));
+        Vec3 n = trunk->normals[v];
+        trunk->normals[v] = vec3_normalize(vec3_create(n.x / trunk_scale.x, n.y / trunk_scale.y,
+                                                       n.z / trunk_scale.z));
+    }
+    for (uint32_t v = 0; v < canopy->vertex_count; v++) {
+        canopy->positions[v] = vec3_add(canopy->positions[v], vec3_create(0, 2.2f, 0));
+    }
+
+    Scene* group = scene_create();
+    scene_add_mesh(group, trunk, material_lambertian(vec3_create(0.35f, 0.22f, 0.12f)));
+    scene_add_mesh(group, canopy, material_lambertian(vec3_create(0.15f, 0.45f, 0.12f)));
+    return group;
+}
+
+// Side of the square a forest of `count` trees covers (one per 9 square units)
+static float forest_extent(uint32_t count) {
+    return 3.0f * sqrtf((float)count);
+}
+
+// Copies of one tree with random position, heading and size on a ground plane
+static Scene* generate_forest(const GeneratorSpec* spec) {
+    RNG rng;
+    rng_init(&rng, spec->seed);
+
+    Scene* group = tree_group();
+    if (!group) return NULL;
+    Scene* scene = scene_create();
+    const Scene* tree = scene_add_group(scene, group);
+    if (!scene_reserve(scene, spec->count + 2)) {
+        scene_destroy(scene);
+        return NULL;
+    }
+    // Flat ground quad reaching well past the trees (a sphere this large
+    // would lose too much precision)
+    float half = 0.5f * forest_extent(spec->count);
+    Material ground = material_lambertian(vec3_create(0.4f, 0.35f, 0.25f));
+    Vec3 corners[4] = {vec3_create(-4 * half, 0, -4 * half), vec3_create(4 * half, 0, -4 * half),
+                       vec3_create(4 * half, 0, 4 * half), vec3_create(-4 * half, 0, 4 * half)};
+    scene_add_triangle(scene, corners[0], corners[2], corners[1], ground);
+    scene_add_triangle(scene, corners[0], corners[3], corners[2], ground);
+
+    for (uint32_t i = 0; i < spec->count; i++) {
+        Vec3 position = vec3_create(rng_float_range(&rng, -half, half), 0.0f, rng_float_range(&rng, -half, half));
+        float size = rng_float_range(&rng, 0.7f, 1.3f);
+        Transform turn = transform_rotate(vec3_create(0, 1, 0), rng_float_range(&rng, 0.0f, 360.0f));
+        Transform scale = transform_scale(vec3_create(size, size, size));
+        Transform move = transform_translate(position);
+        Transform shape = transform_mul(&turn, &scale);
+        Transform place = transform_mul(&move, &shape);
+        if (!scene_add_instance(scene, tree, &place, NULL)) {
+            scene_destroy(scene);
+            return NULL;
+        }
+    }
+    scene->ambient_light = vec3_create(0.7f, 0.8f, 1.0f);
+    return scene;
+}
+
+// Smoothly interpolated hash values on the integer lattice, in [0, 1)
+static float value_noise(uint64_t seed, float x, float z) {
+    float fx = floorf(x), fz = floorf(z);
+    int32_t ix = (int32_t)fx, iz = (int32_t)fz;
+    float tx = x - fx, tz = z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+
+    float corner[4];
+    for (int c = 0; c < 4; c++) {
+        uint64_t key = ((uint64_t)(uint32_t)(ix + (c & 1)) << 32) | (uint32_t)(iz + (c >> 1));
+        corner[c] = (float)(rng_hash64(seed ^ key) >> 40) * (1.0f / 16777216.0f);
+    }
+    float front = corner[0] + (corner[1] - corner[0]) * tx;
+    float back = corner[2] + (corner[3] - corner[2]) * tx;
+    return front + (back - front) * tz;
+}
+
+static float terrain_height(uint64_t seed, float x, float z) {
+    float height = 0.0f, amplitude = 1.0f, frequency = 0.25f;
+    for (int octave = 0; octave < TERRAIN_OCTAVES; octave++) {
+        height += amplitude * value_noise(seed + (uint64_t)octave, x * frequency, z * frequency);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return height;
+}
+
+// Square heightfield of `cells` x `cells` quads over [-10, 10]^2
+static Mesh* terrain_mesh(uint32_t cells, uint64_t seed) {
+    uint32_t row = cells + 1;
+    Mesh* mesh = mesh_create(row * row, 2 * cells * cells, true, true);
+    if (!mesh) return NULL;
+
+    const float size = 20.0f, step = size / (float)cells;
+    #pragma omp parallel for schedule(static)
+    for (uint32_t j = 0; j < row; j++) {
+        for (uint32_t i = 0; i < row; i++) {
+            float x = -0.5f * size + (float)i * step;
+            float z = -0.5f * size + (float)j * step;
+            uint32_t v = j * row + i;
+            mesh->positions[v] = vec3_create(x, 3.0f * terrain_height(seed, x, z), z);
+            mesh->uvs[2 * v] = (float)i / (float)cells;
+            mesh->uvs[2 * v + 1] = (float)j / (float)cells;
+        }
+    }
+
+    // Central-difference normals (one-sided on the border)
+    #pragma omp parallel for schedule(static)
+    for (uint32_t j = 0; j < row; j++) {
+        for (uint32_t i = 0; i < row; i++) {
+            uint32_t i0 = i > 0 ? i - 1 : i, i1 = i < cells ? i + 1 : i;
+            uint32_t j0 = j > 0 ? j - 1 : j, j1 = j < cells ? j + 1 : j;
+            float dx = mesh->positions[j * row + i1].y - mesh->positions[j * row + i0].y;
+            float dz = mesh->positions[j1 * row + i].y - mesh->positions[j0 * row + i].y;
+            Vec3 n = vec3_create(-dx / ((float)(i1 - i0) * step), 1.0f, -dz / ((float)(j1 - j0) * step));
+            mesh->normals[j * row + i] = vec3_normalize(n);
+        }
+    }
+
+    uint32_t* idx = mesh->indices;
+    for (uint32_t j = 0; j < cells; j++) {
+        for (uint32_t i = 0; i < cells; i++) {
+            uint32_t a = j * row + i, b = a + row;
+            *idx++ = a; *idx++ = b; *idx++ = a + 1;
+            *idx++ = a + 1; *idx++ = b; *idx++ = b + 1;
+        }
+    }
+    return mesh;
+}
+
+Scene* generate_scene(const GeneratorSpec* spec) {
+    Mesh* mesh = NULL;
+    switch (spec->type) {
+        case GENERATOR_SPHERES:
+            return generate_spheres(spec);
+        case GENERATOR_GRID:
+            return generate_grid(spec);
+        case GENERATOR_FOREST:
+            return generate_forest(spec);
+        case GENERATOR_SPHERE_MESH: {
+            uint32_t stacks = (uint32_t)lroundf(sqrtf((float)spec->count / 4.0f));
+            stacks = stacks < 2 ? 2 : stacks;
+            mesh = mesh_create_sphere(stacks, 2 * stacks, 1.0f);
+            break;
+        }
+        default: {
+            uint32_t cells = (uint32_t)lroundf(sqrtf((float)spec->count / 2.0f));
+            mesh = terrain_mesh(cells < 1 ? 1 : cells, spec->seed);
+            break;
+        }
+    }
+    return mesh ? create_mesh_scene(mesh) : NULL;
+}
+
+CameraParams generator_camera(const GeneratorSpec* spec) {
+    if (spec->type == GENERATOR_SPHERE_MESH || spec->type == GENERATOR_TERRAIN) {
+        return camera_params_for_mesh_scene();
+    }
+    if (spec->type == GENERATOR_FOREST) {
+        // Over the near corner, looking down across the trees
+        float half = 0.5f * forest_extent(spec->count);
+        CameraParams params = {vec3_create(half + 4.0f, 0.25f * half + 6.0f, half + 4.0f),
+                               vec3_create(0.3f * half, 0, 0.3f * half), vec3_create(0, 1, 0), 40.0f, 0.0f,
+                               0.0f};
+        return params;
+    }
+    float half = spec->type == GENERATOR_GRID ? 0.5f * (float)grid_side(spec->count)
+                                              : 0.5f * spheres_extent(spec->count);
+    CameraParams params = {vec3_create(1.6f * half, 1.2f * half, 2.4f * half), vec3_create(0, 0, 0),
+                           vec3_create(0, 1, 0), 40.0f, 0.0f, 0.0f};
+    return params;
+}
@@ -1,6 +1,17 @@
 #include "scenes.h"
 #include "random.h"
 #include <math.h>
+#include <string.h>
+
+const char* const SCENE_NAMES[SCENE_COUNT] = {
+    "Cornell Box",
+    "Random Spheres",
+    "Glass Spheres",
+    "Metal Spheres",
+    "Studio Lighting",
+    "Material Blending",
+    "Motion Blur"
+};
 
 // Create Cornell Box scene
 Scene* create_cornell_box(void) {
@@ -144,6 +155,59 @@ Scene* create_random_spheres(void) {
     return scene;
 }
 
+// Create motion blur scene: a smaller random field whose diffuse balls
+// bounce up while the shutter is open, a rolling ball and a sweeping banner
+Scene* create_motion_blur(void) {
+    Scene* scene = scene_create();
+    RNG rng;
+    rng_init(&rng, 7);
+
+    scene_add_sphere(scene, vec3_create(0, -1000, 0), 1000,
+                    material_lambertian(vec3_create(0.5f, 0.5f, 0.5f)));
+
+    for (int a = -6; a < 6; a++) {
+        for (int b = -6; b < 6; b++) {
+            float choose_mat = rng_float(&rng);
+            Vec3 center = vec3_create(a + 0.9f * rng_float(&rng), 0.2f, b + 0.9f * rng_float(&rng));
+            if (vec3_length(vec3_sub(center, vec3_create(4, 0.2f, 0))) <= 0.9f) continue;
+
+            if (choose_mat < 0.8f) {
+                Vec3 albedo = vec3_mul(
+                    vec3_create(rng_float(&rng), rng_float(&rng), rng_float(&rng)),
+                    vec3_create(rng_float(&rng), rng_float(&rng), rng_float(&rng))
+                );
+                scene_add_sphere(scene, center, 0.2f, material_lambertian(albedo));
+                scene_set_motion(scene, scene->prim_count - 1,
+                                 vec3_create(0, 0.5f * rng_float(&rng), 0));
+            } else {
+                Vec3 albedo = vec3_create(0.5f * (1 + rng_float(&rng)), 0.5f * (1 + rng_float(&rng)),
+                                          0.5f * (1 + rng_float(&rng)));
+                scene_add_sphere(scene, center, 0.2f, material_metal(albedo, 0.2f * rng_float(&rng)));
+            }
+        }
+    }
+
+    // Static glass and metal, a rolling diffuse ball and a banner swept sideways
+    scene_add_sphere(scene, vec3_create(0, 1, 0), 1.0f, material_dielectric(1.5f));
+    scene_add_sphere(scene, vec3_create(4, 1, 0), 1.0f,
+                    material_metal(vec3_create(0.7f, 0.6f, 0.5f), 0.0f));
+    scene_add_sphere(scene, vec3_create(-4, 1, 0), 1.0f,
+                    material_lambertian(vec3_create(0.4f, 0.2f, 0.1f)));
+    scene_set_motion(scene, scene->prim_count - 1, vec3_create(0, 0, 0.8f));
+
+    Material banner = material_lambertian(vec3_create(0.8f, 0.1f, 0.1f));
+    Vec3 sweep = vec3_create(0, 0, -1.0f);
+    scene_add_triangle(scene, vec3_create(2, 1.5f, 1.5f), vec3_create(2, 1.5f, 2.5f),
+                       vec3_create(2, 2.5f, 2.5f), banner);
+    scene_set_motion(scene, scene->prim_count - 1, sweep);
+    scene_add_triangle(scene, vec3_create(2, 1.5f, 1.5f), vec3_create(2, 2.5f, 2.5f),
+                       vec3_create(2, 2.5f, 1.5f), banner);
+    scene_set_motion(scene, scene->prim_count - 1, sweep);
+
+    scene->ambient_light = vec3_create(0.7f, 0.8f, 1.0f);
+    return scene;
+}
+
 // Create glass spheres scene
 Scene* create_glass_spheres(void) {
     Scene* scene = scene_create();
@@ -342,4 +406,108 @@ Scene* create_material_blend(void) {
     scene->ambient_light = vec3_create(0.3f, 0.35f, 0.4f);
 
     return scene;
-}
\ No newline at end of file
+}
+
+Scene* create_mesh_scene(Mesh* mesh) {
+    Scene* scene = scene_create();
+
+    AABB box = aabb_empty();
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        box = aabb_expand(box, mesh->positions[i]);
+    }
+    Vec3 extent = vec3_sub(box.max, box.min);
+    float largest = fmaxf(extent.x, fmaxf(extent.y, extent.z));
+    float scale = largest > 0.0f ? 2.0f / largest : 1.0f;
+    Vec3 base = vec3_create(0.5f * (box.min.x + box.max.x), box.min.y, 0.5f * (box.min.z + box.max.z));
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        mesh->positions[i] = vec3_scale(vec3_sub(mesh->positions[i], base), scale);
+    }
+
+    Material ground = material_lambertian(vec3_create(0.5f, 0.5f, 0.5f));
+    scene_add_sphere(scene, vec3_create(0, -1000, 0), 1000, ground);
+    scene_add_mesh(scene, mesh, material_lambertian(vec3_create(0.75f, 0.75f, 0.72f)));
+
+    Material light = material_emissive(vec3_create(6.0f, 6.0f, 6.0f));
+    scene_add_sphere(scene, vec3_create(-3, 6, 3), 1.5f, light);
+    scene->ambient_light = vec3_create(0.3f, 0.35f, 0.4f);
+
+    return scene;
+}
+
+CameraParams camera_params_for_mesh_scene(void) {
+    CameraParams params = {vec3_create(0, 2.0f, 4.5f), vec3_create(0, 0.7f, 0),
+                           vec3_create(0, 1, 0), 35.0f, 0.0f, 4.5f};
+    return params;
+}
+
+Camera create_camera_for_mesh_scene(float aspect) {
+    CameraParams params = camera_params_for_mesh_scene();
+    return camera_from_params(&params, aspect);
+}
+
+// Create scene based on selection
+Scene* create_scene_by_name(const char* name) {
+    if (strcmp(name, "Cornell Box") == 0) {
+        return create_cornell_box();
+    } else if (strcmp(name, "Random Spheres") == 0) {
+        return create_random_spheres();
+    } else if (strcmp(name, "Glass Spheres") == 0) {
+        return create_glass_spheres();
+    } else if (strcmp(name, "Metal Spheres") == 0) {
+        return create_metal_spheres();
+    } else if (strcmp(name, "Studio Lighting") == 0) {
+        return create_studio_lighting();
+    } else if (strcmp(name, "Material Blending") == 0) {
+        return create_material_blend();
+    } else if (strcmp(name, "Motion Blur") == 0) {
+        return create_motion_blur();
+    }
+
+    return create_cornell_box();
+}
+
+// Create camera for scene
+// Cameras for the built-in scenes; focus distances are explicit so the
+// exported scene files reproduce the renders exactly
+static CameraParams camera_params(Vec3 lookfrom, Vec3 lookat, float vfov, float aperture,
+                                  float focus_dist) {
+    CameraParams params = {lookfrom, lookat, vec3_create(0, 1, 0), vfov, aperture, focus_dist};
+    return params;
+}
+
+CameraParams camera_params_for_scene(const char* name) {
+    if (strcmp(name, "Cornell Box") == 0) {
+        return camera_params(vec3_create(278, 278, -800), vec3_create(278, 278, 0),
+                             40.0f, 0.0f, 10.0f);
+    } else if (strcmp(name, "Random Spheres") == 0) {
+        // Wide angle view to capture the random field with hero spheres
+        return camera_params(vec3_create(13, 2, 3), vec3_create(0, 0.5f, 0),
+                             20.0f, 0.1f, 10.0f);
+    } else if (strcmp(name, "Glass Spheres") == 0) {
+        // Elevated view to see the 7x7 grid pattern
+        return camera_params(vec3_create(-8, 6, 8), vec3_create(0, 1, 0),
+                             45.0f, 0.0f, 15.0f);
+    } else if (strcmp(name, "Metal Spheres") == 0) {
+        // Side view to showcase the metallic lineup and reflections
+        return camera_params(vec3_create(0, 2.5f, -10), vec3_create(0, 1, 0),
+                             50.0f, 0.0f, 10.0f);
+    } else if (strcmp(name, "Studio Lighting") == 0) {
+        return camera_params(vec3_create(0, 2, 8), vec3_create(0, 1, -2),
+                             40.0f, 0.05f, 10.0f);
+    } else if (strcmp(name, "Material Blending") == 0) {
+        return camera_params(vec3_create(0, 2, 10), vec3_create(0, 1, 0),
+                             45.0f, 0.1f, 12.0f);
+    } else if (strcmp(name, "Motion Blur") == 0) {
+        // Pinhole, so all the blur comes from the shutter
+        return camera_params(vec3_create(13, 2, 3), vec3_create(0, 0.5f, 0),
+                             25.0f, 0.0f, 10.0f);
+    }
+
+    // Default camera for any future scenes
+    return camera_params_default();
+}
+
+Camera create_camera_for_scene(const char* name, float aspect) {
+    CameraParams params = camera_params_for_scene(name);
+    return camera_from_params(&params, aspect);
+}
@@ -0,0 +1,357 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sequence.h"
+#include "transform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+bool sequence_turntable(Sequence* seq, uint32_t frames, const CameraParams* camera) {
+    memset(seq, 0, sizeof(*seq));
+    seq->camera_keys = (CameraKey*)malloc((frames ? frames : 1) * sizeof(CameraKey));
+    if (!seq->camera_keys) return false;
+    seq->frame_count = frames;
+    seq->camera_key_count = frames;
+
+    Vec3 offset = vec3_sub(camera->lookfrom, camera->lookat);
+    for (uint32_t i = 0; i < frames; i++) {
+        Transform turn = transform_rotate(camera->vup, 360.0f * i / frames);
+        seq->camera_keys[i].frame = i;
+        seq->camera_keys[i].camera = *camera;
+        seq->camera_keys[i].camera.lookfrom = vec3_add(camera->lookat, transform_vector(&turn, offset));
+    }
+    return true;
+}
+
+void sequence_free(Sequence* seq) {
+    free(seq->camera_keys);
+    free(seq->move_keys);
+    memset(seq, 0, sizeof(*seq));
+}
+
+static int compare_camera_keys(const void* a, const void* b) {
+    uint32_t fa = ((const CameraKey*)a)->frame, fb = ((const CameraKey*)b)->frame;
+    return (fa > fb) - (fa < fb);
+}
+
+static int compare_move_keys(const void* a, const void* b) {
+    const MoveKey* ka = (const MoveKey*)a;
+    const MoveKey* kb = (const MoveKey*)b;
+    if (ka->prim != kb->prim) return ka->prim < kb->prim ? -1 : 1;
+    return (ka->frame > kb->frame) - (ka->frame < kb->frame);
+}
+
+void sequence_sort(Sequence* seq) {
+    if (seq->camera_key_count) {
+        qsort(seq->camera_keys, seq->camera_key_count, sizeof(CameraKey), compare_camera_keys);
+    }
+    if (seq->move_key_count) {
+        qsort(seq->move_keys, seq->move_key_count, sizeof(MoveKey), compare_move_keys);
+    }
+}
+
+// Keys lo and hi around `frame` and the weight of hi (lo == hi holds a key);
+// `frames` is the first key's frame field, `stride` the key size
+static void find_keys(const uint32_t* frames, size_t stride, uint32_t count, uint32_t frame,
+                      uint32_t* lo, uint32_t* hi, float* t) {
+#define KEY_FRAME(i) (*(const uint32_t*)((const char*)frames + (size_t)(i) * stride))
+    uint32_t first = 0, last = count;  // Last key at or before `frame`
+    while (last - first > 1) {
+        uint32_t mid = first + (last - first) / 2;
+        if (KEY_FRAME(mid) <= frame) {
+            first = mid;
+        } else {
+            last = mid;
+        }
+    }
+    *lo = *hi = first;
+    *t = 0.0f;
+    if (KEY_FRAME(first) < frame && first + 1 < count) {
+        *hi = first + 1;
+        *t = (float)(frame - KEY_FRAME(first)) / (float)(KEY_FRAME(first + 1) - KEY_FRAME(first));
+    }
+#undef KEY_FRAME
+}
+
+static Vec3 lerp_vec3(Vec3 a, Vec3 b, float t) {
+    return vec3_add(a, vec3_scale(vec3_sub(b, a), t));
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+CameraParams sequence_camera(const Sequence* seq, const CameraParams* base, uint32_t frame) {
+    if (seq->camera_key_count == 0) return *base;
+    uint32_t lo, hi;
+    float t;
+    find_keys(&seq->camera_keys[0].frame, sizeof(CameraKey), seq->camera_key_count, frame,
+              &lo, &hi, &t);
+    const CameraParams* a = &seq->camera_keys[lo].camera;
+    const CameraParams* b = &seq->camera_keys[hi].camera;
+    CameraParams params;
+    params.lookfrom = lerp_vec3(a->lookfrom, b->lookfrom, t);
+    params.lookat = lerp_vec3(a->lookat, b->lookat, t);
+    params.vup = lerp_vec3(a->vup, b->vup, t);
+    params.vfov = lerp(a->vfov, b->vfov, t);
+    params.aperture = lerp(a->aperture, b->aperture, t);
+    params.focus_dist = lerp(a->focus_dist, b->focus_dist, t);
+    return params;
+}
+
+bool sequence_pattern_valid(const char* pattern) {
+    int conversions = 0;
+    for (const char* p = pattern; *p; p++) {
+        if (*p != '%') continue;
+        p++;
+        if (*p == '%') continue;
+        if (*p == '0') p++;
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p != 'd') return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+// Keyframed primitive; `original` is kept so offsets never accumulate error
+typedef struct {
+    uint32_t position;  // Current index in scene->primitives
+    uint32_t first_key; // Its keys in seq->move_keys
+    uint32_t key_count;
+    Primitive original;
+} MovedPrim;
+
+static MovedPrim* collect_moves(const Scene* scene, const Sequence* seq, uint32_t* count) {
+    *count = 0;
+    if (scene->bvh) {
+        fprintf(stderr, "Object keyframes need an unbuilt scene (not one from the scene cache)\n");
+        return NULL;
+    }
+    uint32_t prims = 0;
+    for (uint32_t i = 0; i < seq->move_key_count; i++) {
+        if (i == 0 || seq->move_keys[i].prim != seq->move_keys[i - 1].prim) prims++;
+    }
+    MovedPrim* moved = (MovedPrim*)malloc(prims * sizeof(MovedPrim));
+    if (!moved) return NULL;
+
+    for (uint32_t i = 0; i < seq->move_key_count; i++) {
+        uint32_t id = seq->move_keys[i].prim;
+        if (*count > 0 && seq->move_keys[moved[*count - 1].first_key].prim == id) {
+            moved[*count - 1].key_count++;
+            continue;
+        }
+        if (id >= scene->prim_count || (scene->primitives[id].type != PRIMITIVE_SPHERE &&
+                                        scene->primitives[id].type != PRIMITIVE_TRIANGLE)) {
+            fprintf(stderr, "Keyframed primitive %u is not a sphere or triangle of the scene\n", id);
+            free(moved);
+            return NULL;
+        }
+        moved[*count].position = id;
+        moved[*count].first_key = i;
+        moved[*count].key_count = 1;
+        moved[*count].original = scene->primitives[id];
+        (*count)++;
+    }
+    return moved;
+}
+
+static void apply_moves(Scene* scene, const Sequence* seq, const MovedPrim* moved, uint32_t count,
+                        uint32_t frame) {
+    for (uint32_t m = 0; m < count; m++) {
+        const MoveKey* keys = &seq->move_keys[moved[m].first_key];
+        uint32_t lo, hi;
+        float t;
+        find_keys(&keys[0].frame, sizeof(MoveKey), moved[m].key_count, frame, &lo, &hi, &t);
+        Vec3 offset = lerp_vec3(keys[lo].offset, keys[hi].offset, t);
+
+        Primitive* prim = &scene->primitives[moved[m].position];
+        *prim = moved[m].original;
+        if (prim->type == PRIMITIVE_SPHERE) {
+            prim->sphere.center = vec3_add(prim->sphere.center, offset);
+            prim->bounds = sphere_bounds(&prim->sphere);
+        } else {
+            prim->triangle.v0 = vec3_add(prim->triangle.v0, offset);
+            prim->triangle.v1 = vec3_add(prim->triangle.v1, offset);
+            prim->triangle.v2 = vec3_add(prim->triangle.v2, offset);
+            prim->bounds = triangle_bounds(&prim->triangle);
+        }
+    }
+}
+
+// Follow the moved primitives through the reordering of a BVH build
+static bool track_moves(const BVH* bvh, MovedPrim* moved, uint32_t count) {
+    if (count == 0) return true;
+    uint32_t* position = (uint32_t*)malloc(bvh->prim_count * sizeof(uint32_t));
+    if (!position) return false;
+    for (uint32_t i = 0; i < bvh->prim_count; i++) position[bvh->indices[i]] = i;
+    for (uint32_t m = 0; m < count; m++) moved[m].position = position[moved[m].position];
+    free(position);
+    return true;
+}
+
+// Writes finished frames on its own thread; one frame in flight at a time,
+// so two framebuffers are enough
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    const Image* image;  // Frame being written, NULL when idle
+    char path[1024];
+    const TonemapSettings* tonemap;
+    bool verbose;
+    bool quit;
+    uint32_t failed;
+} FrameWriter;
+
+static void* frame_writer_thread(void* user_data) {
+    FrameWriter* writer = (FrameWriter*)user_data;
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->image && !writer->quit) pthread_cond_wait(&writer->changed, &writer->lock);
+        if (!writer->image) break;
+        pthread_mutex_unlock(&writer->lock);
+
+        bool saved = image_save(writer->image, writer->path, writer->tonemap);
+        if (saved && writer->verbose) printf("Saved %s\n", writer->path);
+
+        pthread_mutex_lock(&writer->lock);
+        if (!saved) writer->failed++;
+        writer->image = NULL;
+        pthread_cond_broadcast(&writer->changed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+// Hand over a frame once the previous one is written; false if a write failed
+static bool frame_writer_submit(FrameWriter* writer, const Image* image, const char* path) {
+    pthread_mutex_lock(&writer->lock);
+    while (writer->image) pthread_cond_wait(&writer->changed, &writer->lock);
+    bool ok = writer->failed == 0;
+    if (ok) {
+        snprintf(writer->path, sizeof(writer->path), "%s", path);
+        writer->image = image;
+        pthread_cond_broadcast(&writer->changed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+static void frame_writer_finish(FrameWriter* writer) {
+    pthread_mutex_lock(&writer->lock);
+    while (writer->image) pthread_cond_wait(&writer->changed, &writer->lock);
+    writer->quit = true;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+bool sequence_render(Scene* scene, const Sequence* seq, const CameraParams* base_camera,
+                     const RenderSettings* settings, const SequenceOutput* output,
+                     SequenceStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    uint32_t frame_end = output->frame_end ? output->frame_end : seq->frame_count;
+    if (output->frame_begin >= frame_end || frame_end > seq->frame_count) {
+        fprintf(stderr, "Frames %u-%u are outside the sequence's %u frames\n", output->frame_begin,
+                frame_end, seq->frame_count);
+        return false;
+    }
+    if (!sequence_pattern_valid(output->pattern)) {
+        fprintf(stderr, "Sequence output %s needs one %%d for the frame number\n", output->pattern);
+        return false;
+    }
+
+    uint32_t moved_count = 0;
+    MovedPrim* moved = NULL;
+    if (seq->move_key_count) {
+        moved = collect_moves(scene, seq, &moved_count);
+        if (!moved) return false;
+    }
+    double start = now_seconds();
+    if (!scene->bvh) {
+        scene_build_bvh(scene);
+        if (!track_moves(scene->bvh, moved, moved_count)) {
+            free(moved);
+            return false;
+        }
+    }
+
+    RenderSettings frame_settings = *settings;
+    RenderStats* own_stats = settings->stats ? NULL : render_stats_create(settings->num_threads);
+    if (own_stats) frame_settings.stats = own_stats;
+    Image* images[2] = {image_create_format(settings->width, settings->height, output->format),
+                        image_create_format(settings->width, settings->height, output->format)};
+
+    FrameWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.tonemap = output->tonemap;
+    writer.verbose = output->verbose;
+    pthread_mutex_init(&writer.lock, NULL);
+    pthread_cond_init(&writer.changed, NULL);
+    pthread_t writer_thread;
+    bool ok = frame_settings.stats && images[0] && images[1] &&
+              pthread_create(&writer_thread, NULL, frame_writer_thread, &writer) == 0;
+    bool writing = ok;
+    if (!ok) fprintf(stderr, "Failed to set up the sequence render\n");
+
+    float aspect = (float)settings->width / settings->height;
+    for (uint32_t frame = output->frame_begin; ok && frame < frame_end; frame++) {
+        if (moved_count) {
+            double update_start = now_seconds();
+            apply_moves(scene, seq, moved, moved_count, frame);
+            if (scene_refit_bvh(scene, SCENE_REBUILD_THRESHOLD)) {
+                stats->rebuilds++;
+                ok = track_moves(scene->bvh, moved, moved_count);
+            }
+            stats->update_time += now_seconds() - update_start;
+        }
+
+        CameraParams params = sequence_camera(seq, base_camera, frame);
+        Camera camera = camera_from_params(&params, aspect);
+        Image* image = images[frame & 1];
+        frame_settings.seed = settings->seed + frame;
+        render_parallel(scene, &camera, &frame_settings, image);
+        if (render_cancelled(&frame_settings)) break;
+
+        RenderStatsSnapshot snap;
+        render_stats_snapshot(frame_settings.stats, &snap);
+        stats->render_time += snap.elapsed;
+        stats->rays += snap.totals.rays;
+        if (output->verbose) {
+            printf("Frame %u (%u/%u): %.2f s, %.2f Mrays/s\n", frame, frame - output->frame_begin + 1,
+                   frame_end - output->frame_begin, snap.elapsed, snap.mrays_per_sec);
+        }
+
+        char path[1024];
+        int n = snprintf(path, sizeof(path), output->pattern, (int)frame);
+        if (n < 0 || (size_t)n >= sizeof(path)) {
+            fprintf(stderr, "Output path for frame %u is too long\n", frame);
+            ok = false;
+        } else if (frame_writer_submit(&writer, image, path)) {
+            stats->frames++;
+        } else {
+            ok = false;
+        }
+    }
+
+    if (writing) {
+        frame_writer_finish(&writer);
+        pthread_join(writer_thread, NULL);
+        stats->frames -= writer.failed;
+        if (writer.failed) ok = false;
+    }
+    stats->elapsed = now_seconds() - start;
+
+    pthread_cond_destroy(&writer.changed);
+    pthread_mutex_destroy(&writer.lock);
+    image_destroy(images[0]);
+    image_destroy(images[1]);
+    render_stats_destroy(own_stats);
+    free(moved);
+    return ok;
+}
@@ -0,0 +1,179 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+_Thread_local RenderCounters render_thread_counters;
+
+#ifdef PATHTRACER_STATS
+_Thread_local RenderDetailCounters render_thread_details;
+#endif
+
+uint64_t render_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+RenderStats* render_stats_create(uint32_t thread_count) {
+    if (thread_count == 0) thread_count = 1;
+
+    RenderStats* stats = (RenderStats*)calloc(1, sizeof(RenderStats));
+    if (!stats) return NULL;
+    stats->slots = (RenderStatsSlot*)aligned_alloc(_Alignof(RenderStatsSlot),
+                                                   thread_count * sizeof(RenderStatsSlot));
+    if (!stats->slots) {
+        free(stats);
+        return NULL;
+    }
+    stats->slot_count = thread_count;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        atomic_init(&stats->slots[i].pixels, 0);
+        atomic_init(&stats->slots[i].samples, 0);
+        atomic_init(&stats->slots[i].rays, 0);
+        atomic_init(&stats->slots[i].bvh_nodes, 0);
+    }
+    atomic_init(&stats->start_ns, 0);
+    atomic_init(&stats->end_ns, 0);
+    return stats;
+}
+
+void render_stats_destroy(RenderStats* stats) {
+    if (stats) {
+        free(stats->slots);
+        free(stats);
+    }
+}
+
+void render_stats_begin(RenderStats* stats, uint64_t total_pixels) {
+    for (uint32_t i = 0; i < stats->slot_count; i++) {
+        atomic_store_explicit(&stats->slots[i].pixels, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->slots[i].samples, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->slots[i].rays, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->slots[i].bvh_nodes, 0, memory_order_relaxed);
+    }
+    stats->total_pixels = total_pixels;
+#ifdef PATHTRACER_STATS
+    memset(&stats->details, 0, sizeof(stats->details));
+#endif
+    atomic_store_explicit(&stats->end_ns, 0, memory_order_relaxed);
+    // Readers that see the start time also see the reset slots and total
+    atomic_store_explicit(&stats->start_ns, render_stats_now_ns(), memory_order_release);
+}
+
+void render_stats_end(RenderStats* stats) {
+    atomic_store_explicit(&stats->end_ns, render_stats_now_ns(), memory_order_release);
+}
+
+static inline void slot_add(atomic_uint_fast64_t* counter, uint64_t value) {
+    // Single writer per slot: no need for an atomic read-modify-write
+    uint64_t current = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, current + value, memory_order_relaxed);
+}
+
+void render_stats_publish(RenderStats* stats, uint32_t thread, RenderCounters* counters) {
+    RenderStatsSlot* slot = &stats->slots[thread % stats->slot_count];
+    slot_add(&slot->samples, counters->samples);
+    slot_add(&slot->rays, counters->rays);
+    slot_add(&slot->bvh_nodes, counters->bvh_nodes);
+    slot_add(&slot->pixels, counters->pixels);
+    memset(counters, 0, sizeof(*counters));
+}
+
+void render_stats_snapshot(const RenderStats* stats, RenderStatsSnapshot* out) {
+    memset(out, 0, sizeof(*out));
+    uint64_t start = atomic_load_explicit(&stats->start_ns, memory_order_acquire);
+    if (start == 0) return;
+
+    for (uint32_t i = 0; i < stats->slot_count; i++) {
+        const RenderStatsSlot* slot = &stats->slots[i];
+        out->totals.pixels += atomic_load_explicit(&slot->pixels, memory_order_relaxed);
+        out->totals.samples += atomic_load_explicit(&slot->samples, memory_order_relaxed);
+        out->totals.rays += atomic_load_explicit(&slot->rays, memory_order_relaxed);
+        out->totals.bvh_nodes += atomic_load_explicit(&slot->bvh_nodes, memory_order_relaxed);
+    }
+
+    uint64_t end = atomic_load_explicit(&stats->end_ns, memory_order_acquire);
+    out->finished = end != 0;
+    out->elapsed = (double)((out->finished ? end : render_stats_now_ns()) - start) * 1e-9;
+    out->total_pixels = stats->total_pixels;
+    if (out->total_pixels > 0) {
+        out->progress = (double)out->totals.pixels / (double)out->total_pixels;
+        if (out->progress > 1.0) out->progress = 1.0;
+    }
+    if (out->elapsed > 0.0) {
+        out->mrays_per_sec = (double)out->totals.rays / out->elapsed * 1e-6;
+    }
+}
+
+void render_stats_thread_begin(void) {
+#ifdef PATHTRACER_STATS
+    memset(&render_thread_details, 0, sizeof(render_thread_details));
+#endif
+}
+
+void render_stats_thread_merge(RenderStats* stats) {
+#ifdef PATHTRACER_STATS
+    // The struct is all uint64_t counters, so merge it as a flat array
+    uint64_t* dst = (uint64_t*)&stats->details;
+    const uint64_t* src = (const uint64_t*)&render_thread_details;
+    for (size_t i = 0; i < sizeof(RenderDetailCounters) / sizeof(uint64_t); i++) {
+        dst[i] += src[i];
+    }
+    memset(&render_thread_details, 0, sizeof(render_thread_details));
+#else
+    (void)stats;
+#endif
+}
+
+#ifdef PATHTRACER_STATS
+static double per(uint64_t count, uint64_t total) {
+    return total ? (double)count / (double)total : 0.0;
+}
+#endif
+
+void render_stats_report(const RenderStats* stats, FILE* out) {
+#ifdef PATHTRACER_STATS
+    const RenderDetailCounters* d = &stats->details;
+    RenderStatsSnapshot snap;
+    render_stats_snapshot(stats, &snap);
+    uint64_t rays = snap.totals.rays;
+
+    fprintf(out, "Render statistics (%.2f s, %llu samples, %llu rays)\n", snap.elapsed,
+            (unsigned long long)snap.totals.samples, (unsigned long long)rays);
+
+    fprintf(out, "  Rays by depth:\n");
+    for (int i = 0; i < STATS_DEPTH_BUCKETS; i++) {
+        if (d->rays_by_depth[i] == 0) continue;
+        fprintf(out, "    %2d%s %14llu  %5.1f%%\n", i, (i == STATS_DEPTH_BUCKETS - 1) ? "+" : " ",
+                (unsigned long long)d->rays_by_depth[i], 100.0 * per(d->rays_by_depth[i], rays));
+    }
+
+    fprintf(out, "  BVH: %.2f box tests/ray, %.2f nodes entered/ray, %.2f leaves/ray\n",
+            per(d->aabb_tests, rays), per(d->aabb_hits, rays), per(d->leaf_visits, rays));
+
+    fprintf(out, "  Primitive tests:\n");
+    for (int i = 0; i < PRIMITIVE_TYPE_COUNT; i++) {
+        if (d->prim_tests[i] == 0) continue;
+        fprintf(out, "    %-10s %14llu  %.2f/ray, %5.1f%% hit\n", primitive_type_name((PrimitiveType)i),
+                (unsigned long long)d->prim_tests[i], per(d->prim_tests[i], rays),
+                100.0 * per(d->prim_hits[i], d->prim_tests[i]));
+    }
+
+    fprintf(out, "  Scatter by material:\n");
+    for (int i = 0; i < MATERIAL_TYPE_COUNT; i++) {
+        if (d->scatters[i] == 0) continue;
+        fprintf(out, "    %-10s %14llu\n", material_type_name((MaterialType)i),
+                (unsigned long long)d->scatters[i]);
+    }
+
+    fprintf(out, "  Path ends: %llu misses, %llu emitters, %llu absorbed, %llu roulette, %llu depth limit\n",
+            (unsigned long long)d->misses, (unsigned long long)d->emitter_hits,
+            (unsigned long long)d->absorbed, (unsigned long long)d->rr_terminations,
+            (unsigned long long)d->depth_terminations);
+#else
+    (void)stats;
+    (void)out;
+#endif
+}
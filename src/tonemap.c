@@ -0,0 +1,227 @@
+#include "tonemap.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// ACES filmic fit coefficients
+#define ACES_A 2.51f
+#define ACES_B 0.03f
+#define ACES_C 2.43f
+#define ACES_D 0.59f
+#define ACES_E 0.14f
+
+// sRGB encode table over [0, 1]; fine enough that the linear toe (slope
+// 12.92) stays within a fraction of an 8-bit step. Padded so 32-bit gathers
+// at the last entry stay in bounds.
+#define SRGB_LUT_SIZE 16384
+static uint8_t srgb_lut[SRGB_LUT_SIZE + 3];
+static pthread_once_t srgb_lut_once = PTHREAD_ONCE_INIT;
+
+// Pixels converted per block when the framebuffer is not planar float
+#define TONEMAP_BLOCK 64
+
+static const char* const OPERATOR_NAMES[TONEMAP_OPERATOR_COUNT] = {"aces", "reinhard", "linear"};
+
+// Byte offsets of R, G, B within one output pixel
+static const uint8_t LAYOUT_OFFSETS[PIXEL_LAYOUT_COUNT][3] = {
+    {0, 1, 2},  // RGB8
+    {2, 1, 0},  // BGR8
+    {2, 1, 0},  // BGRX8 (padding byte at offset 3)
+};
+
+static void build_srgb_lut(void) {
+    for (int i = 0; i < SRGB_LUT_SIZE; i++) {
+        double v = (double)i / (SRGB_LUT_SIZE - 1);
+        double encoded = (v <= 0.0031308) ? 12.92 * v : 1.055 * pow(v, 1.0 / 2.4) - 0.055;
+        srgb_lut[i] = (uint8_t)(encoded * 255.0 + 0.5);
+    }
+}
+
+TonemapSettings tonemap_default(void) {
+    TonemapSettings settings = {TONEMAP_ACES, 0.0f, false};
+    return settings;
+}
+
+const char* tonemap_operator_name(TonemapOperator op) {
+    return (op < TONEMAP_OPERATOR_COUNT) ? OPERATOR_NAMES[op] : "unknown";
+}
+
+bool tonemap_operator_from_name(const char* name, TonemapOperator* op) {
+    for (int i = 0; i < TONEMAP_OPERATOR_COUNT; i++) {
+        if (strcmp(name, OPERATOR_NAMES[i]) == 0) {
+            *op = (TonemapOperator)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t pixel_layout_bytes(PixelLayout layout) {
+    return (layout == PIXEL_LAYOUT_BGRX8) ? 4 : 3;
+}
+
+Vec3 aces_tonemap(Vec3 color) {
+    color.x = (color.x * (ACES_A * color.x + ACES_B)) / (color.x * (ACES_C * color.x + ACES_D) + ACES_E);
+    color.y = (color.y * (ACES_A * color.y + ACES_B)) / (color.y * (ACES_C * color.y + ACES_D) + ACES_E);
+    color.z = (color.z * (ACES_A * color.z + ACES_B)) / (color.z * (ACES_C * color.z + ACES_D) + ACES_E);
+    return color;
+}
+
+// Scalar kernel: exposure, curve, clamp, encode, quantize
+static inline uint8_t tonemap_channel(const TonemapSettings* settings, float scale, float x) {
+    x *= scale;
+    switch (settings->op) {
+        case TONEMAP_ACES:
+            x = (x * (ACES_A * x + ACES_B)) / (x * (ACES_C * x + ACES_D) + ACES_E);
+            break;
+        case TONEMAP_REINHARD:
+            x = x / (1.0f + x);
+            break;
+        default:
+            break;
+    }
+    // fmaxf first so NaN maps to 0, like the vector max below
+    x = fminf(fmaxf(x, 0.0f), 1.0f);
+    if (settings->srgb) {
+        return srgb_lut[(int)(x * (float)(SRGB_LUT_SIZE - 1) + 0.5f)];
+    }
+    return (uint8_t)(int)(x * 255.0f + 0.5f);
+}
+
+#ifdef __AVX2__
+static inline __m256i tonemap_channel8(const TonemapSettings* settings, __m256 scale, __m256 x) {
+    x = _mm256_mul_ps(x, scale);
+    if (settings->op == TONEMAP_ACES) {
+        __m256 num = _mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ACES_A), x),
+                                                    _mm256_set1_ps(ACES_B)));
+        __m256 den = _mm256_add_ps(_mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ACES_C), x),
+                                                                  _mm256_set1_ps(ACES_D))),
+                                   _mm256_set1_ps(ACES_E));
+        x = _mm256_div_ps(num, den);
+    } else if (settings->op == TONEMAP_REINHARD) {
+        x = _mm256_div_ps(x, _mm256_add_ps(_mm256_set1_ps(1.0f), x));
+    }
+    // max(x, 0) returns the second operand for NaN
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    if (settings->srgb) {
+        __m256i idx = _mm256_cvttps_epi32(_mm256_add_ps(
+            _mm256_mul_ps(x, _mm256_set1_ps((float)(SRGB_LUT_SIZE - 1))), _mm256_set1_ps(0.5f)));
+        __m256i bytes = _mm256_i32gather_epi32((const int*)srgb_lut, idx, 1);
+        return _mm256_and_si256(bytes, _mm256_set1_epi32(0xFF));
+    }
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(255.0f)),
+                                             _mm256_set1_ps(0.5f)));
+}
+#endif
+
+// Tonemap `count` pixels given as planar R, G, B floats
+static void tonemap_span(const TonemapSettings* settings, float scale,
+                         const float* r, const float* g, const float* b, uint32_t count,
+                         uint8_t* out, PixelLayout layout) {
+    const uint8_t* offsets = LAYOUT_OFFSETS[layout];
+    size_t bpp = pixel_layout_bytes(layout);
+    uint32_t i = 0;
+
+#ifdef __AVX2__
+    // Each 128-bit lane packs to r0-3 g0-3 b0-3 0000 (pixels 0-3 | 4-7); a byte
+    // shuffle interleaves that into 4 * bpp output bytes. Index 12 is a zero
+    // byte, and the padding byte of 4-byte layouts is then set to 0xFF.
+    uint8_t shuffle[16];
+    memset(shuffle, 0x80, sizeof(shuffle));
+    for (int k = 0; k < 4; k++) {
+        shuffle[k * bpp + offsets[0]] = (uint8_t)k;
+        shuffle[k * bpp + offsets[1]] = (uint8_t)(4 + k);
+        shuffle[k * bpp + offsets[2]] = (uint8_t)(8 + k);
+    }
+    __m256i shuffle8 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuffle));
+    __m256i padding = _mm256_set1_epi32(bpp == 4 ? (int)0xFF000000u : 0);
+    __m256 scale8 = _mm256_set1_ps(scale);
+
+    // With 3-byte pixels the second 16-byte store overruns its 12 bytes by 4,
+    // so keep two pixels of slack before the end of the span
+    uint32_t slack = (bpp == 3) ? 2 : 0;
+    for (; i + 8 + slack <= count; i += 8) {
+        __m256i qr = tonemap_channel8(settings, scale8, _mm256_loadu_ps(r + i));
+        __m256i qg = tonemap_channel8(settings, scale8, _mm256_loadu_ps(g + i));
+        __m256i qb = tonemap_channel8(settings, scale8, _mm256_loadu_ps(b + i));
+        __m256i rg = _mm256_packus_epi32(qr, qg);
+        __m256i b0 = _mm256_packus_epi32(qb, _mm256_setzero_si256());
+        __m256i bytes = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_packus_epi16(rg, b0), shuffle8),
+                                        padding);
+
+        uint8_t* p = out + i * bpp;
+        _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(bytes));
+        _mm_storeu_si128((__m128i*)(p + 4 * bpp), _mm256_extracti128_si256(bytes, 1));
+    }
+#endif
+
+    for (; i < count; i++) {
+        uint8_t* p = out + i * bpp;
+        p[offsets[0]] = tonemap_channel(settings, scale, r[i]);
+        p[offsets[1]] = tonemap_channel(settings, scale, g[i]);
+        p[offsets[2]] = tonemap_channel(settings, scale, b[i]);
+        if (bpp == 4) {
+            p[3] = 0xFF;
+        }
+    }
+}
+
+// Pixels [x_begin, x_end) of row y; `out` receives pixel x_begin
+static void tonemap_row_span(const TonemapSettings* settings, const Image* img, uint32_t y,
+                             uint32_t x_begin, uint32_t x_end, uint8_t* out, PixelLayout layout) {
+    if (settings->srgb) {
+        pthread_once(&srgb_lut_once, build_srgb_lut);
+    }
+    float scale = exp2f(settings->exposure);
+    size_t row = (size_t)y * img->width;
+
+    if (img->format == IMAGE_FORMAT_RGB32F) {
+        tonemap_span(settings, scale, img->planes[0] + row + x_begin, img->planes[1] + row + x_begin,
+                     img->planes[2] + row + x_begin, x_end - x_begin, out, layout);
+        return;
+    }
+
+    // Half-float: deinterleave a block at a time into planar scratch
+    size_t bpp = pixel_layout_bytes(layout);
+    for (uint32_t x0 = x_begin; x0 < x_end; x0 += TONEMAP_BLOCK) {
+        uint32_t count = (x_end - x0 < TONEMAP_BLOCK) ? x_end - x0 : TONEMAP_BLOCK;
+        float r[TONEMAP_BLOCK], g[TONEMAP_BLOCK], b[TONEMAP_BLOCK];
+        const uint16_t* src = img->half + (row + x0) * 4;
+        for (uint32_t i = 0; i < count; i++) {
+            r[i] = half_to_float(src[i * 4 + 0]);
+            g[i] = half_to_float(src[i * 4 + 1]);
+            b[i] = half_to_float(src[i * 4 + 2]);
+        }
+        tonemap_span(settings, scale, r, g, b, count, out + (x0 - x_begin) * bpp, layout);
+    }
+}
+
+void tonemap_row(const TonemapSettings* settings, const Image* img, uint32_t y,
+                 uint8_t* out, PixelLayout layout) {
+    tonemap_row_span(settings, img, y, 0, img->width, out, layout);
+}
+
+void tonemap_rows(const TonemapSettings* settings, const Image* img,
+                  uint32_t y_begin, uint32_t y_end,
+                  uint8_t* out, size_t stride, PixelLayout layout) {
+    if (settings->srgb) {
+        pthread_once(&srgb_lut_once, build_srgb_lut);
+    }
+
+    #pragma omp parallel for schedule(static) if (y_end - y_begin >= 16)
+    for (uint32_t y = y_begin; y < y_end; y++) {
+        tonemap_row(settings, img, y, out + (size_t)(y - y_begin) * stride, layout);
+    }
+}
+
+void tonemap_rect(const TonemapSettings* settings, const Image* img,
+                  uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                  uint8_t* out, size_t stride, PixelLayout layout) {
+    for (uint32_t y = y0; y < y1; y++) {
+        tonemap_row_span(settings, img, y, x0, x1, out + (size_t)(y - y0) * stride, layout);
+    }
+}